@@ -415,7 +415,8 @@ NS_ASSUME_NONNULL_BEGIN
       // Change params to collect all possible garbages
       gc->set_lru_params(LruParams{/*min_bytes_threshold*/ threshold.longValue,
                                    /*percentile_to_collect*/ 100,
-                                   /*maximum_sequence_numbers_to_collect*/ 1000});
+                                   /*maximum_sequence_numbers_to_collect*/ 1000,
+                                   /*maximum_removals_per_slice*/ 1000});
       _localStore->CollectGarbage(gc);
     });
   }
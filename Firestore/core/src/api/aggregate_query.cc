@@ -16,12 +16,15 @@
 
 #include "Firestore/core/src/api/aggregate_query.h"
 
+#include <memory>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/api/api_fwd.h"
 #include "Firestore/core/src/api/firestore.h"
 #include "Firestore/core/src/core/firestore_client.h"
 #include "Firestore/core/src/model/aggregate_field.h"
+#include "Firestore/core/src/util/hard_assert.h"
 
 using firebase::firestore::model::AggregateAlias;
 using firebase::firestore::model::AggregateField;
@@ -48,6 +51,42 @@ void AggregateQuery::GetAggregate(AggregateQueryCallback&& callback) {
                                                   std::move(callback));
 }
 
+void AggregateQuery::GetAggregate(Source source,
+                                  AggregateQueryCallback&& callback) {
+  std::shared_ptr<core::FirestoreClient> client =
+      query_.firestore()->client();
+  switch (source) {
+    case Source::Server:
+      GetAggregate(std::move(callback));
+      return;
+
+    case Source::Cache:
+      client->RunAggregateQueryFromLocalCache(query_.query(), aggregates_,
+                                              std::move(callback));
+      return;
+
+    case Source::Default: {
+      core::Query query = query_.query();
+      std::vector<AggregateField> aggregates = aggregates_;
+      client->RunAggregateQuery(
+          query, aggregates,
+          [client, query, aggregates,
+           callback](const StatusOr<ObjectValue>& result) mutable {
+            if (!result.ok() &&
+                result.status().code() == Error::kErrorUnavailable) {
+              // The backend cannot be reached: answer from the cache instead.
+              client->RunAggregateQueryFromLocalCache(query, aggregates,
+                                                      std::move(callback));
+              return;
+            }
+            callback(result);
+          });
+      return;
+    }
+  }
+  UNREACHABLE();
+}
+
 // TODO(b/280805906) Remove this count specific API after the c++ SDK migrates
 // to the new Aggregate API
 void AggregateQuery::Get(CountQueryCallback&& callback) {
@@ -19,6 +19,7 @@
 #include <vector>
 
 #include "Firestore/core/src/api/query_core.h"
+#include "Firestore/core/src/api/source.h"
 
 using firebase::firestore::model::AggregateField;
 
@@ -53,6 +54,14 @@ class AggregateQuery {
   // when the tests and mocking are removed.
   virtual void GetAggregate(AggregateQueryCallback&& callback);
 
+  /**
+   * Runs the aggregation against the given source: `Source::Server` always
+   * asks the backend, `Source::Cache` evaluates the aggregation over the local
+   * cache (including pending writes) and `Source::Default` asks the backend
+   * and falls back to the cache if the backend cannot be reached.
+   */
+  void GetAggregate(Source source, AggregateQueryCallback&& callback);
+
   // TODO(b/280805906) Remove this count specific API after the c++ SDK migrates
   // to the new Aggregate API Backward-compatible getter for count result
   void Get(CountQueryCallback&& callback);
@@ -36,6 +36,10 @@ class EventListener;
 class Query;
 }  // namespace core
 
+namespace local {
+class QueryPlan;
+}  // namespace local
+
 namespace api {
 
 class CollectionReference;
@@ -62,6 +66,9 @@ using QueryCallback = std::function<void(core::Query, bool)>;
 using AggregateQueryCallback =
     std::function<void(const StatusOr<ObjectValue>&)>;
 
+using QueryExplainCallback =
+    std::function<void(const StatusOr<local::QueryPlan>&)>;
+
 // TODO(b/280805906) Remove this count specific API after the c++ SDK migrates
 // to the new Aggregate API
 using CountQueryCallback = std::function<void(const util::StatusOr<int64_t>&)>;
@@ -180,6 +180,11 @@ void Query::GetDocuments(Source source, QuerySnapshotListener&& callback) {
   listener_unowned->Resolve(std::move(registration));
 }
 
+void Query::Explain(QueryExplainCallback&& callback) {
+  ValidateHasExplicitOrderByForLimitToLast();
+  firestore_->client()->ExplainQueryFromLocalCache(*this, std::move(callback));
+}
+
 std::unique_ptr<ListenerRegistration> Query::AddSnapshotListener(
     ListenOptions options, QuerySnapshotListener&& user_listener) {
   ValidateHasExplicitOrderByForLimitToLast();
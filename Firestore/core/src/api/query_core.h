@@ -77,6 +77,15 @@ class Query {
    */
   void GetDocuments(Source source, QuerySnapshotListener&& callback);
 
+  /**
+   * Executes this query against the local cache and reports how it was
+   * executed: the strategies the query engine considered with their estimated
+   * costs, the strategy it chose, and the documents it actually read.
+   *
+   * @param callback a callback to execute with the query plan.
+   */
+  void Explain(QueryExplainCallback&& callback);
+
   /**
    * Attaches a listener for QuerySnapshot events.
    *
@@ -31,12 +31,14 @@ constexpr bool Settings::DefaultSslEnabled;
 constexpr bool Settings::DefaultPersistenceEnabled;
 constexpr int64_t Settings::DefaultCacheSizeBytes;
 constexpr int64_t Settings::MinimumCacheSizeBytes;
+constexpr int64_t Settings::DefaultWriteCoalescingWindowMs;
 
 Settings::Settings(const Settings& other)
     : host_(other.host_),
       ssl_enabled_(other.ssl_enabled_),
       persistence_enabled_(other.persistence_enabled_),
-      cache_size_bytes_(other.cache_size_bytes_) {
+      cache_size_bytes_(other.cache_size_bytes_),
+      write_coalescing_window_ms_(other.write_coalescing_window_ms_) {
   if (other.cache_settings_ != nullptr) {
     cache_settings_ = CopyCacheSettings(*other.cache_settings_);
   }
@@ -51,6 +53,7 @@ Settings& Settings::operator=(const Settings& other) {
   ssl_enabled_ = other.ssl_enabled_;
   persistence_enabled_ = other.persistence_enabled_;
   cache_size_bytes_ = other.cache_size_bytes_;
+  write_coalescing_window_ms_ = other.write_coalescing_window_ms_;
   if (other.cache_settings_ != nullptr) {
     cache_settings_ = CopyCacheSettings(*other.cache_settings_);
   }
@@ -115,13 +118,15 @@ MemoryCacheSettings MemoryCacheSettings::WithMemoryGarbageCollectorSettings(
 
 size_t Settings::Hash() const {
   return util::Hash(host_, ssl_enabled_, persistence_enabled_,
-                    cache_size_bytes_, cache_settings_);
+                    cache_size_bytes_, write_coalescing_window_ms_,
+                    cache_settings_);
 }
 
 bool operator==(const Settings& lhs, const Settings& rhs) {
   bool eq = lhs.host_ == rhs.host_ && lhs.ssl_enabled_ == rhs.ssl_enabled_ &&
             lhs.persistence_enabled_ == rhs.persistence_enabled_ &&
-            lhs.cache_size_bytes_ == rhs.cache_size_bytes_;
+            lhs.cache_size_bytes_ == rhs.cache_size_bytes_ &&
+            lhs.write_coalescing_window_ms_ == rhs.write_coalescing_window_ms_;
   if (!eq) {
     return eq;
   }
@@ -184,7 +189,9 @@ size_t MemoryCacheSettings::Hash() const {
 }
 
 size_t PersistentCacheSettings::Hash() const {
-  return util::Hash(kind_, size_bytes_);
+  return util::Hash(kind_, size_bytes_, block_cache_size_bytes_,
+                    bloom_filter_bits_per_key_, write_buffer_size_bytes_,
+                    compression_enabled_);
 }
 
 size_t MemoryEagerGcSettings::Hash() const {
@@ -207,7 +214,11 @@ bool operator!=(const MemoryCacheSettings& lhs,
 
 bool operator==(const PersistentCacheSettings& lhs,
                 const PersistentCacheSettings& rhs) {
-  return lhs.kind() == rhs.kind() && lhs.size_bytes() == rhs.size_bytes();
+  return lhs.kind() == rhs.kind() && lhs.size_bytes() == rhs.size_bytes() &&
+         lhs.block_cache_size_bytes() == rhs.block_cache_size_bytes() &&
+         lhs.bloom_filter_bits_per_key() == rhs.bloom_filter_bits_per_key() &&
+         lhs.write_buffer_size_bytes() == rhs.write_buffer_size_bytes() &&
+         lhs.compression_enabled() == rhs.compression_enabled();
 }
 
 bool operator!=(const PersistentCacheSettings& lhs,
@@ -299,6 +310,12 @@ bool Settings::gc_enabled() const {
   return cache_size_bytes_ != CacheSizeUnlimited;
 }
 
+void Settings::set_write_coalescing_window_ms(int64_t value) {
+  HARD_ASSERT(value >= 0, "Write coalescing window must not be negative: %s",
+              value);
+  write_coalescing_window_ms_ = value;
+}
+
 const LocalCacheSettings* Settings::local_cache_settings() const {
   return cache_settings_.get();
 }
@@ -322,6 +339,38 @@ PersistentCacheSettings PersistentCacheSettings::WithSizeBytes(
   return new_settings;
 }
 
+PersistentCacheSettings PersistentCacheSettings::WithBlockCacheSizeBytes(
+    int64_t size) const {
+  HARD_ASSERT(size >= 0, "Block cache size must not be negative: %s", size);
+  PersistentCacheSettings new_settings{*this};
+  new_settings.block_cache_size_bytes_ = size;
+  return new_settings;
+}
+
+PersistentCacheSettings PersistentCacheSettings::WithBloomFilterBitsPerKey(
+    int bits) const {
+  HARD_ASSERT(bits >= 0, "Bloom filter bits per key must not be negative: %s",
+              bits);
+  PersistentCacheSettings new_settings{*this};
+  new_settings.bloom_filter_bits_per_key_ = bits;
+  return new_settings;
+}
+
+PersistentCacheSettings PersistentCacheSettings::WithWriteBufferSizeBytes(
+    int64_t size) const {
+  HARD_ASSERT(size > 0, "Write buffer size must be positive: %s", size);
+  PersistentCacheSettings new_settings{*this};
+  new_settings.write_buffer_size_bytes_ = size;
+  return new_settings;
+}
+
+PersistentCacheSettings PersistentCacheSettings::WithCompressionEnabled(
+    bool enabled) const {
+  PersistentCacheSettings new_settings{*this};
+  new_settings.compression_enabled_ = enabled;
+  return new_settings;
+}
+
 }  // namespace api
 }  // namespace firestore
 }  // namespace firebase
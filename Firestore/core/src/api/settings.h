@@ -23,6 +23,7 @@
 #include <utility>
 
 #include "absl/memory/memory.h"
+#include "absl/types/optional.h"
 
 namespace firebase {
 namespace firestore {
@@ -46,6 +47,7 @@ class Settings {
   static constexpr int64_t DefaultCacheSizeBytes = 100 * 1024 * 1024;
   static constexpr int64_t MinimumCacheSizeBytes = 1 * 1024 * 1024;
   static constexpr int64_t CacheSizeUnlimited = -1;
+  static constexpr int64_t DefaultWriteCoalescingWindowMs = 0;
 
   Settings() = default;
   Settings(const Settings& other);
@@ -75,6 +77,17 @@ class Settings {
   int64_t cache_size_bytes() const;
   bool gc_enabled() const;
 
+  /**
+   * How long, in milliseconds, writes are buffered so that several of them can
+   * be committed locally and sent to the backend together. Each write is still
+   * applied atomically and acknowledged on its own. 0 (the default) disables
+   * coalescing.
+   */
+  void set_write_coalescing_window_ms(int64_t value);
+  int64_t write_coalescing_window_ms() const {
+    return write_coalescing_window_ms_;
+  }
+
   const LocalCacheSettings* local_cache_settings() const;
   void set_local_cache_settings(const LocalCacheSettings& settings);
 
@@ -90,6 +103,7 @@ class Settings {
   bool ssl_enabled_ = DefaultSslEnabled;
   bool persistence_enabled_ = DefaultPersistenceEnabled;
   int64_t cache_size_bytes_ = DefaultCacheSizeBytes;
+  int64_t write_coalescing_window_ms_ = DefaultWriteCoalescingWindowMs;
   std::unique_ptr<LocalCacheSettings> cache_settings_ = nullptr;
 };
 
@@ -123,14 +137,43 @@ class PersistentCacheSettings : public LocalCacheSettings {
   }
   PersistentCacheSettings WithSizeBytes(int64_t size) const;
 
+  /**
+   * Storage engine tuning. Options that are not set use the SDK's defaults
+   * (see `local::LevelDbOptions::Default()`).
+   */
+  PersistentCacheSettings WithBlockCacheSizeBytes(int64_t size) const;
+  PersistentCacheSettings WithBloomFilterBitsPerKey(int bits) const;
+  PersistentCacheSettings WithWriteBufferSizeBytes(int64_t size) const;
+  PersistentCacheSettings WithCompressionEnabled(bool enabled) const;
+
   int64_t size_bytes() const {
     return size_bytes_;
   }
 
+  const absl::optional<int64_t>& block_cache_size_bytes() const {
+    return block_cache_size_bytes_;
+  }
+
+  const absl::optional<int>& bloom_filter_bits_per_key() const {
+    return bloom_filter_bits_per_key_;
+  }
+
+  const absl::optional<int64_t>& write_buffer_size_bytes() const {
+    return write_buffer_size_bytes_;
+  }
+
+  const absl::optional<bool>& compression_enabled() const {
+    return compression_enabled_;
+  }
+
   size_t Hash() const override;
 
  private:
   int64_t size_bytes_;
+  absl::optional<int64_t> block_cache_size_bytes_;
+  absl::optional<int> bloom_filter_bits_per_key_;
+  absl::optional<int64_t> write_buffer_size_bytes_;
+  absl::optional<bool> compression_enabled_;
 };
 
 class MemoryGarbageCollectorSettings {
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/bundle/binary_bundle_converter.h"
+
+#include <memory>
+
+#include "Firestore/core/src/bundle/bundle_metadata.h"
+#include "Firestore/core/src/nanopb/message.h"
+#include "Firestore/core/src/nanopb/writer.h"
+#include "Firestore/core/src/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace bundle {
+
+using nanopb::Message;
+using nanopb::StringWriter;
+using util::StatusOr;
+
+namespace {
+
+/** Appends `element` to `out`, prefixed with its size as a varint. */
+void AppendElement(const Message<firestore_BundleElement>& element,
+                   std::string* out) {
+  StringWriter writer;
+  writer.Write(element.fields(), element.get());
+  std::string bytes = writer.Release();
+
+  pb_byte_t prefix[10];
+  pb_ostream_t stream = pb_ostream_from_buffer(prefix, sizeof(prefix));
+  bool ok = pb_encode_varint(&stream, bytes.size());
+  HARD_ASSERT(ok, "Failed to encode length prefix: %s", PB_GET_ERROR(&stream));
+
+  out->append(reinterpret_cast<const char*>(prefix), stream.bytes_written);
+  out->append(bytes);
+}
+
+}  // namespace
+
+StatusOr<std::string> ConvertToBinaryBundle(
+    BundleReader& reader, const BinaryBundleSerializer& serializer) {
+  BundleMetadata metadata = reader.GetBundleMetadata();
+  if (!reader.reader_status().ok()) {
+    return reader.reader_status();
+  }
+
+  std::string elements;
+  std::unique_ptr<BundleElement> element = reader.GetNextElement();
+  while (element) {
+    AppendElement(serializer.EncodeBundleElement(*element), &elements);
+    element = reader.GetNextElement();
+  }
+  if (!reader.reader_status().ok()) {
+    return reader.reader_status();
+  }
+
+  std::string result(kBinaryBundleHeader, kBinaryBundleHeaderSize);
+  AppendElement(serializer.EncodeBundleElement(BundleMetadata(
+                    metadata.bundle_id(), metadata.version(),
+                    metadata.create_time(), metadata.total_documents(),
+                    elements.size())),
+                &result);
+  result.append(elements);
+  return result;
+}
+
+}  // namespace bundle
+}  // namespace firestore
+}  // namespace firebase
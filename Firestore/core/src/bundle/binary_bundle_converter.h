@@ -0,0 +1,43 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_BUNDLE_BINARY_BUNDLE_CONVERTER_H_
+#define FIRESTORE_CORE_SRC_BUNDLE_BINARY_BUNDLE_CONVERTER_H_
+
+#include <string>
+
+#include "Firestore/core/src/bundle/binary_bundle_serializer.h"
+#include "Firestore/core/src/bundle/bundle_reader.h"
+#include "Firestore/core/src/util/statusor.h"
+
+namespace firebase {
+namespace firestore {
+namespace bundle {
+
+/**
+ * Reads all elements of the bundle `reader` reads, and returns the same bundle
+ * in the binary format, with its `total_bytes` updated to match.
+ *
+ * Returns the status of `reader` if reading the bundle fails.
+ */
+util::StatusOr<std::string> ConvertToBinaryBundle(
+    BundleReader& reader, const BinaryBundleSerializer& serializer);
+
+}  // namespace bundle
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_BUNDLE_BINARY_BUNDLE_CONVERTER_H_
@@ -0,0 +1,203 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/bundle/binary_bundle_serializer.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/bundle/bundle_document.h"
+#include "Firestore/core/src/bundle/bundle_metadata.h"
+#include "Firestore/core/src/bundle/bundled_document_metadata.h"
+#include "Firestore/core/src/bundle/named_query.h"
+#include "Firestore/core/src/model/mutable_document.h"
+#include "Firestore/core/src/model/object_value.h"
+#include "Firestore/core/src/nanopb/nanopb_util.h"
+#include "Firestore/core/src/util/hard_assert.h"
+#include "Firestore/core/src/util/string_format.h"
+#include "absl/memory/memory.h"
+
+namespace firebase {
+namespace firestore {
+namespace bundle {
+
+using model::DocumentKey;
+using model::MutableDocument;
+using model::ObjectValue;
+using model::SnapshotVersion;
+using nanopb::MakeString;
+using nanopb::Message;
+using nanopb::Reader;
+using nanopb::SafeReadBoolean;
+using nanopb::SetRepeatedField;
+using remote::Serializer;
+using util::StringFormat;
+
+Message<firestore_BundleElement> BinaryBundleSerializer::EncodeBundleElement(
+    const BundleElement& element) const {
+  Message<firestore_BundleElement> result;
+
+  switch (element.element_type()) {
+    case BundleElement::Type::Metadata: {
+      const auto& metadata = static_cast<const BundleMetadata&>(element);
+      result->which_element_type = firestore_BundleElement_metadata_tag;
+      result->metadata.id = Serializer::EncodeString(metadata.bundle_id());
+      result->metadata.create_time =
+          Serializer::EncodeVersion(metadata.create_time());
+      result->metadata.version = metadata.version();
+      result->metadata.total_documents = metadata.total_documents();
+      result->metadata.total_bytes = metadata.total_bytes();
+      break;
+    }
+
+    case BundleElement::Type::NamedQuery: {
+      const auto& query = static_cast<const NamedQuery&>(element);
+      result->which_element_type = firestore_BundleElement_named_query_tag;
+      result->named_query.name = Serializer::EncodeString(query.query_name());
+      result->named_query.bundled_query =
+          EncodeBundledQuery(query.bundled_query());
+      result->named_query.read_time =
+          Serializer::EncodeVersion(query.read_time());
+      break;
+    }
+
+    case BundleElement::Type::DocumentMetadata: {
+      const auto& metadata =
+          static_cast<const BundledDocumentMetadata&>(element);
+      firestore_BundledDocumentMetadata& proto = result->document_metadata;
+      result->which_element_type =
+          firestore_BundleElement_document_metadata_tag;
+      proto.name = rpc_serializer_.EncodeKey(metadata.key());
+      proto.read_time = Serializer::EncodeVersion(metadata.read_time());
+      proto.exists = metadata.exists();
+      SetRepeatedField(&proto.queries, &proto.queries_count,
+                       metadata.queries(), [](const std::string& query) {
+                         return Serializer::EncodeString(query);
+                       });
+      break;
+    }
+
+    case BundleElement::Type::Document: {
+      const MutableDocument& document =
+          static_cast<const BundleDocument&>(element).document();
+      result->which_element_type = firestore_BundleElement_document_tag;
+      result->document =
+          rpc_serializer_.EncodeDocument(document.key(), document.data());
+      result->document.update_time =
+          Serializer::EncodeVersion(document.version());
+      break;
+    }
+  }
+
+  return result;
+}
+
+std::unique_ptr<BundleElement> BinaryBundleSerializer::DecodeBundleElement(
+    Reader* reader, firestore_BundleElement& proto) const {
+  switch (proto.which_element_type) {
+    case firestore_BundleElement_metadata_tag: {
+      const firestore_BundleMetadata& metadata = proto.metadata;
+      return absl::make_unique<BundleMetadata>(
+          Serializer::DecodeString(metadata.id), metadata.version,
+          Serializer::DecodeVersion(reader->context(), metadata.create_time),
+          metadata.total_documents, metadata.total_bytes);
+    }
+
+    case firestore_BundleElement_named_query_tag: {
+      firestore_NamedQuery& query = proto.named_query;
+      BundledQuery bundled_query =
+          DecodeBundledQuery(reader, query.bundled_query);
+      return absl::make_unique<NamedQuery>(
+          Serializer::DecodeString(query.name), std::move(bundled_query),
+          Serializer::DecodeVersion(reader->context(), query.read_time));
+    }
+
+    case firestore_BundleElement_document_metadata_tag: {
+      const firestore_BundledDocumentMetadata& metadata =
+          proto.document_metadata;
+      DocumentKey key = rpc_serializer_.DecodeKey(reader->context(),
+                                                  metadata.name);
+      std::vector<std::string> queries;
+      for (pb_size_t i = 0; i < metadata.queries_count; ++i) {
+        queries.push_back(MakeString(metadata.queries[i]));
+      }
+      return absl::make_unique<BundledDocumentMetadata>(
+          std::move(key),
+          Serializer::DecodeVersion(reader->context(), metadata.read_time),
+          SafeReadBoolean(metadata.exists), std::move(queries));
+    }
+
+    case firestore_BundleElement_document_tag: {
+      google_firestore_v1_Document& document = proto.document;
+      DocumentKey key =
+          rpc_serializer_.DecodeKey(reader->context(), document.name);
+      SnapshotVersion update_time =
+          Serializer::DecodeVersion(reader->context(), document.update_time);
+      ObjectValue fields =
+          ObjectValue::FromFieldsEntry(document.fields, document.fields_count);
+      return absl::make_unique<BundleDocument>(MutableDocument::FoundDocument(
+          std::move(key), update_time, std::move(fields)));
+    }
+
+    default:
+      reader->Fail(StringFormat("Unknown bundle element type: %s",
+                                proto.which_element_type));
+      return nullptr;
+  }
+}
+
+firestore_BundledQuery BinaryBundleSerializer::EncodeBundledQuery(
+    const BundledQuery& query) const {
+  firestore_BundledQuery result{};
+
+  result.limit_type = query.limit_type() == core::LimitType::First
+                          ? _firestore_BundledQuery_LimitType::
+                                firestore_BundledQuery_LimitType_FIRST
+                          : _firestore_BundledQuery_LimitType::
+                                firestore_BundledQuery_LimitType_LAST;
+
+  auto query_target = rpc_serializer_.EncodeQueryTarget(query.target());
+  result.parent = query_target.parent;
+  result.which_query_type = firestore_BundledQuery_structured_query_tag;
+  result.structured_query = query_target.structured_query;
+
+  return result;
+}
+
+BundledQuery BinaryBundleSerializer::DecodeBundledQuery(
+    Reader* reader, firestore_BundledQuery& query) const {
+  // The QueryTarget oneof only has a single valid value.
+  if (query.which_query_type != firestore_BundledQuery_structured_query_tag) {
+    reader->Fail(
+        StringFormat("Unknown bundled query_type: %s", query.which_query_type));
+    return BundledQuery();
+  }
+
+  auto limit_type = query.limit_type ==
+                            _firestore_BundledQuery_LimitType::
+                                firestore_BundledQuery_LimitType_FIRST
+                        ? core::LimitType::First
+                        : core::LimitType::Last;
+  return BundledQuery(
+      rpc_serializer_.DecodeStructuredQuery(reader->context(), query.parent,
+                                            query.structured_query),
+      limit_type);
+}
+
+}  // namespace bundle
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_BUNDLE_BINARY_BUNDLE_SERIALIZER_H_
+#define FIRESTORE_CORE_SRC_BUNDLE_BINARY_BUNDLE_SERIALIZER_H_
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+#include "Firestore/Protos/nanopb/firestore/bundle.nanopb.h"
+#include "Firestore/core/src/bundle/bundle_element.h"
+#include "Firestore/core/src/bundle/bundled_query.h"
+#include "Firestore/core/src/nanopb/message.h"
+#include "Firestore/core/src/nanopb/reader.h"
+#include "Firestore/core/src/remote/serializer.h"
+
+namespace firebase {
+namespace firestore {
+namespace bundle {
+
+/**
+ * The bytes a binary bundle starts with.
+ *
+ * A binary bundle is this header followed by `firestore.BundleElement` protos,
+ * each prefixed with its size encoded as a varint. As in JSON bundles, the
+ * first element is the bundle metadata, and its `total_bytes` counts the bytes
+ * of the elements that follow it, size prefixes included.
+ *
+ * JSON bundles start with the decimal size of their first element, so the
+ * first byte of the header is enough to tell the two formats apart.
+ */
+constexpr char kBinaryBundleHeader[] = "\xff" "FSB1";
+constexpr size_t kBinaryBundleHeaderSize = sizeof(kBinaryBundleHeader) - 1;
+
+/**
+ * Converts between bundle elements and the nanopb protos binary bundles are
+ * made of.
+ */
+class BinaryBundleSerializer {
+ public:
+  explicit BinaryBundleSerializer(remote::Serializer serializer)
+      : rpc_serializer_(std::move(serializer)) {
+  }
+
+  nanopb::Message<firestore_BundleElement> EncodeBundleElement(
+      const BundleElement& element) const;
+
+  /**
+   * Decodes a bundle element. Modifies the provided proto to release ownership
+   * of any Value messages.
+   *
+   * Failures are reported to `reader`, in which case the result is `nullptr`
+   * or an element that should not be used.
+   */
+  std::unique_ptr<BundleElement> DecodeBundleElement(
+      nanopb::Reader* reader, firestore_BundleElement& proto) const;
+
+ private:
+  firestore_BundledQuery EncodeBundledQuery(const BundledQuery& query) const;
+  BundledQuery DecodeBundledQuery(nanopb::Reader* reader,
+                                  firestore_BundledQuery& query) const;
+
+  remote::Serializer rpc_serializer_;
+};
+
+}  // namespace bundle
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_BUNDLE_BINARY_BUNDLE_SERIALIZER_H_
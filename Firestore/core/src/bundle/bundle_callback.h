@@ -44,6 +44,24 @@ class BundleCallback {
       const model::MutableDocumentMap& documents,
       const std::string& bundle_id) = 0;
 
+  /**
+   * Applies a chunk of the documents from a bundle to the "ground-state"
+   * (remote) documents, in a transaction of its own.
+   *
+   * Unlike `ApplyBundledDocuments`, this does not add the documents to the
+   * target that keeps the documents of the bundle from being garbage
+   * collected; that is up to `SaveBundledDocumentKeys`.
+   */
+  virtual model::DocumentMap ApplyBundledDocumentChunk(
+      const model::MutableDocumentMap& documents) = 0;
+
+  /**
+   * Makes the target that keeps the documents of the bundle from being garbage
+   * collected hold exactly the given keys.
+   */
+  virtual void SaveBundledDocumentKeys(const model::DocumentKeySet& keys,
+                                       const std::string& bundle_id) = 0;
+
   /** Saves the given NamedQuery to local persistence. */
   virtual void SaveNamedQuery(const NamedQuery& query,
                               const model::DocumentKeySet& keys) = 0;
@@ -0,0 +1,764 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/bundle/bundle_document_decoder.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/bundle/bundle_serializer.h"
+#include "Firestore/core/src/model/document_key.h"
+#include "Firestore/core/src/model/mutable_document.h"
+#include "Firestore/core/src/model/object_value.h"
+#include "Firestore/core/src/model/resource_path.h"
+#include "Firestore/core/src/model/snapshot_version.h"
+#include "Firestore/core/src/nanopb/message.h"
+#include "Firestore/core/src/nanopb/nanopb_util.h"
+#include "Firestore/core/src/timestamp_internal.h"
+#include "Firestore/core/src/util/statusor.h"
+#include "Firestore/third_party/nlohmann_json/json.hpp"
+#include "absl/strings/escaping.h"
+#include "absl/strings/numbers.h"
+#include "absl/time/time.h"
+
+namespace firebase {
+namespace firestore {
+namespace bundle {
+
+using model::DocumentKey;
+using model::MutableDocument;
+using model::ObjectValue;
+using model::ResourcePath;
+using model::SnapshotVersion;
+using nanopb::Message;
+using nlohmann::json;
+using util::JsonReader;
+using util::StatusOr;
+
+namespace {
+
+/** The JSON objects and arrays that make up a bundled document. */
+enum class Scope {
+  kRoot,        // The whole input.
+  kElement,     // {"document": ...}
+  kDocument,    // {"name": ..., "updateTime": ..., "fields": ...}
+  kTimestamp,   // {"seconds": ..., "nanos": ...}
+  kFields,      // {"<field>": <value>, ...}
+  kValue,       // {"<type>Value": ...}
+  kArrayValue,  // {"values": [...]}
+  kValues,      // [<value>, ...]
+  kMapValue,    // {"fields": {...}}
+  kGeoPoint,    // {"latitude": ..., "longitude": ...}
+  kIgnored,     // Any object or array the decoder has no use for.
+};
+
+/** What the next JSON value read in a scope is decoded into. */
+enum class Slot {
+  kIgnored,
+  kElement,
+  kDocument,
+  kName,
+  kUpdateTime,
+  kFields,
+  kSeconds,
+  kNanos,
+  kValue,
+  kNullValue,
+  kBooleanValue,
+  kIntegerValue,
+  kDoubleValue,
+  kTimestampValue,
+  kStringValue,
+  kBytesValue,
+  kReferenceValue,
+  kGeoPointValue,
+  kArrayValue,
+  kMapValue,
+  kValues,
+  kLatitude,
+  kLongitude,
+};
+
+Slot ValueSlot(const std::string& key) {
+  if (key == "nullValue") {
+    return Slot::kNullValue;
+  } else if (key == "booleanValue") {
+    return Slot::kBooleanValue;
+  } else if (key == "integerValue") {
+    return Slot::kIntegerValue;
+  } else if (key == "doubleValue") {
+    return Slot::kDoubleValue;
+  } else if (key == "timestampValue") {
+    return Slot::kTimestampValue;
+  } else if (key == "stringValue") {
+    return Slot::kStringValue;
+  } else if (key == "bytesValue") {
+    return Slot::kBytesValue;
+  } else if (key == "referenceValue") {
+    return Slot::kReferenceValue;
+  } else if (key == "geoPointValue") {
+    return Slot::kGeoPointValue;
+  } else if (key == "arrayValue") {
+    return Slot::kArrayValue;
+  } else if (key == "mapValue") {
+    return Slot::kMapValue;
+  }
+  return Slot::kIgnored;
+}
+
+/** A JSON object or array that is being decoded. */
+struct Frame {
+  Frame(Scope scope, Slot slot) : scope(scope), slot(slot) {
+  }
+
+  Scope scope;
+  Slot slot;
+
+  // The last key read in an object.
+  std::string key;
+
+  // The value decoded so far, for scopes that decode into a value.
+  Message<google_firestore_v1_Value> value;
+
+  // The decoded entries of `kFields` and `kValues` scopes. `keys` is only used
+  // by `kFields`.
+  std::vector<std::string> keys;
+  std::vector<Message<google_firestore_v1_Value>> values;
+
+  int64_t seconds = 0;
+  int32_t nanos = 0;
+  google_type_LatLng lat_lng{};
+};
+
+/**
+ * Decodes a bundled document from the SAX events of `nlohmann::json`.
+ *
+ * Every event either completes a scalar, which is decoded right away into
+ * the innermost scope, or opens or closes a scope. Closing a scope hands its
+ * decoded value to the enclosing one. Returning `false` from an event stops
+ * the parser; this happens on failure, when the input turns out not to hold a
+ * document, and when a value has more than one type. `BundleSerializer` picks
+ * the type of such a value by a fixed priority, which is only known once the
+ * whole value has been read, so those documents are left to it.
+ */
+class DocumentDecodingHandler : public json::json_sax_t {
+ public:
+  DocumentDecodingHandler(const remote::Serializer& serializer,
+                          JsonReader& reader,
+                          Slot root)
+      : serializer_(serializer), reader_(reader) {
+    stack_.emplace_back(Scope::kRoot, root);
+  }
+
+  bool is_document() const {
+    return is_document_;
+  }
+
+  /** Whether the document has to be decoded by `BundleSerializer`. */
+  bool needs_dom() const {
+    return needs_dom_;
+  }
+
+  BundleDocument TakeDocument() {
+    return std::move(document_);
+  }
+
+  bool null() override {
+    switch (CurrentSlot()) {
+      case Slot::kNullValue:
+        return SetType(google_firestore_v1_Value_null_value_tag);
+      case Slot::kIgnored:
+      case Slot::kLatitude:
+      case Slot::kLongitude:
+        return true;
+      default:
+        return UnexpectedType();
+    }
+  }
+
+  bool boolean(bool val) override {
+    switch (CurrentSlot()) {
+      case Slot::kBooleanValue:
+        SetType(google_firestore_v1_Value_boolean_value_tag);
+        current().value->boolean_value = val;
+        return true;
+      case Slot::kNullValue:
+        return SetType(google_firestore_v1_Value_null_value_tag);
+      case Slot::kIgnored:
+      case Slot::kLatitude:
+      case Slot::kLongitude:
+        return true;
+      default:
+        return UnexpectedType();
+    }
+  }
+
+  bool number_integer(number_integer_t val) override {
+    switch (CurrentSlot()) {
+      case Slot::kSeconds:
+      case Slot::kNanos:
+      case Slot::kIntegerValue:
+        return SetInteger(val);
+      case Slot::kDoubleValue:
+      case Slot::kLatitude:
+      case Slot::kLongitude:
+        return SetDouble(static_cast<double>(val));
+      case Slot::kNullValue:
+        return SetType(google_firestore_v1_Value_null_value_tag);
+      case Slot::kIgnored:
+        return true;
+      default:
+        return UnexpectedType();
+    }
+  }
+
+  bool number_unsigned(number_unsigned_t val) override {
+    switch (CurrentSlot()) {
+      case Slot::kDoubleValue:
+      case Slot::kLatitude:
+      case Slot::kLongitude:
+        return SetDouble(static_cast<double>(val));
+      case Slot::kSeconds:
+      case Slot::kNanos:
+      case Slot::kIntegerValue:
+        if (val > static_cast<number_unsigned_t>(
+                      std::numeric_limits<int64_t>::max())) {
+          return Fail("Failed to parse into integer: " + std::to_string(val));
+        }
+        return SetInteger(static_cast<int64_t>(val));
+      default:
+        return number_integer(static_cast<number_integer_t>(val));
+    }
+  }
+
+  bool number_float(number_float_t val, const string_t&) override {
+    switch (CurrentSlot()) {
+      case Slot::kDoubleValue:
+      case Slot::kLatitude:
+      case Slot::kLongitude:
+        return SetDouble(val);
+      case Slot::kSeconds:
+      case Slot::kNanos:
+      case Slot::kIntegerValue:
+        return Fail("Only integer and string can be parsed into int type");
+      case Slot::kNullValue:
+        return SetType(google_firestore_v1_Value_null_value_tag);
+      case Slot::kIgnored:
+        return true;
+      default:
+        return UnexpectedType();
+    }
+  }
+
+  bool string(string_t& val) override {
+    switch (CurrentSlot()) {
+      case Slot::kName:
+        name_ = std::move(val);
+        return true;
+      case Slot::kSeconds:
+      case Slot::kNanos:
+      case Slot::kIntegerValue:
+        return SetInteger(val);
+      case Slot::kDoubleValue:
+      case Slot::kLatitude:
+      case Slot::kLongitude:
+        return SetDouble(val);
+      case Slot::kUpdateTime:
+      case Slot::kTimestampValue:
+        return SetTimestamp(val);
+      case Slot::kStringValue:
+        SetType(google_firestore_v1_Value_string_value_tag);
+        current().value->string_value = nanopb::MakeBytesArray(val);
+        return true;
+      case Slot::kBytesValue:
+        return SetBytes(val);
+      case Slot::kReferenceValue:
+        return SetReference(val);
+      case Slot::kNullValue:
+        return SetType(google_firestore_v1_Value_null_value_tag);
+      case Slot::kIgnored:
+        return true;
+      default:
+        return UnexpectedType();
+    }
+  }
+
+  bool binary(binary_t&) override {
+    // Only produced by binary formats, never by JSON text.
+    return UnexpectedType();
+  }
+
+  bool start_object(std::size_t) override {
+    switch (CurrentSlot()) {
+      case Slot::kElement:
+        return Push(Scope::kElement);
+      case Slot::kDocument:
+        return Push(Scope::kDocument);
+      case Slot::kUpdateTime:
+      case Slot::kTimestampValue:
+        return Push(Scope::kTimestamp);
+      case Slot::kFields:
+        return Push(Scope::kFields);
+      case Slot::kValue:
+        return Push(Scope::kValue);
+      case Slot::kGeoPointValue:
+        return Push(Scope::kGeoPoint);
+      case Slot::kArrayValue:
+        return Push(Scope::kArrayValue);
+      case Slot::kMapValue:
+        return Push(Scope::kMapValue);
+      case Slot::kNullValue:
+        SetType(google_firestore_v1_Value_null_value_tag);
+        return Push(Scope::kIgnored);
+      case Slot::kIgnored:
+      case Slot::kLatitude:
+      case Slot::kLongitude:
+        return Push(Scope::kIgnored);
+      default:
+        return UnexpectedType();
+    }
+  }
+
+  bool key(string_t& val) override {
+    Frame& frame = current();
+    switch (frame.scope) {
+      case Scope::kElement:
+        if (val == "document") {
+          frame.slot = Slot::kDocument;
+        } else if (has_document_) {
+          frame.slot = Slot::kIgnored;
+        } else {
+          // Leave other kinds of elements to `BundleSerializer`.
+          is_document_ = false;
+          return false;
+        }
+        break;
+      case Scope::kDocument:
+        frame.slot = val == "name"         ? Slot::kName
+                     : val == "updateTime" ? Slot::kUpdateTime
+                     : val == "fields"     ? Slot::kFields
+                                           : Slot::kIgnored;
+        break;
+      case Scope::kTimestamp:
+        frame.slot = val == "seconds" ? Slot::kSeconds
+                     : val == "nanos" ? Slot::kNanos
+                                      : Slot::kIgnored;
+        break;
+      case Scope::kFields:
+        frame.slot = Slot::kValue;
+        break;
+      case Scope::kValue:
+        frame.slot = ValueSlot(val);
+        if (frame.slot != Slot::kIgnored && frame.value->which_value_type) {
+          needs_dom_ = true;
+          return false;
+        }
+        break;
+      case Scope::kArrayValue:
+        frame.slot = val == "values" ? Slot::kValues : Slot::kIgnored;
+        break;
+      case Scope::kMapValue:
+        frame.slot = val == "fields" ? Slot::kFields : Slot::kIgnored;
+        break;
+      case Scope::kGeoPoint:
+        frame.slot = val == "latitude"    ? Slot::kLatitude
+                     : val == "longitude" ? Slot::kLongitude
+                                          : Slot::kIgnored;
+        break;
+      default:
+        frame.slot = Slot::kIgnored;
+        break;
+    }
+    frame.key = std::move(val);
+    return true;
+  }
+
+  bool end_object() override {
+    Frame done = Pop();
+    switch (done.scope) {
+      case Scope::kElement:
+        if (!has_document_) {
+          is_document_ = false;
+          return false;
+        }
+        return true;
+      case Scope::kDocument:
+        return FinishDocument(std::move(done));
+      case Scope::kTimestamp:
+        return FinishTimestamp(done);
+      case Scope::kFields:
+        return Deliver(FinishMap(std::move(done)));
+      case Scope::kValue:
+        if (!done.value->which_value_type) {
+          return Fail("Failed to decode value, no type is recognized");
+        }
+        return Deliver(std::move(done.value));
+      case Scope::kArrayValue:
+        if (!done.value->which_value_type) {
+          done.value->which_value_type =
+              google_firestore_v1_Value_array_value_tag;
+        }
+        return Deliver(std::move(done.value));
+      case Scope::kMapValue:
+        if (!done.value->which_value_type) {
+          done.value->which_value_type =
+              google_firestore_v1_Value_map_value_tag;
+        }
+        return Deliver(std::move(done.value));
+      case Scope::kGeoPoint: {
+        Message<google_firestore_v1_Value> value;
+        value->which_value_type = google_firestore_v1_Value_geo_point_value_tag;
+        value->geo_point_value = done.lat_lng;
+        return Deliver(std::move(value));
+      }
+      default:
+        return true;
+    }
+  }
+
+  bool start_array(std::size_t) override {
+    switch (CurrentSlot()) {
+      case Slot::kValues:
+        return Push(Scope::kValues);
+      case Slot::kNullValue:
+        SetType(google_firestore_v1_Value_null_value_tag);
+        return Push(Scope::kIgnored);
+      case Slot::kIgnored:
+      case Slot::kLatitude:
+      case Slot::kLongitude:
+        return Push(Scope::kIgnored);
+      default:
+        return UnexpectedType();
+    }
+  }
+
+  bool end_array() override {
+    Frame done = Pop();
+    if (done.scope != Scope::kValues) {
+      return true;
+    }
+
+    Message<google_firestore_v1_Value> result;
+    result->which_value_type = google_firestore_v1_Value_array_value_tag;
+    auto& array = result->array_value;
+    array.values_count = nanopb::CheckedSize(done.values.size());
+    array.values =
+        nanopb::MakeArray<google_firestore_v1_Value>(array.values_count);
+    for (pb_size_t i = 0; i < array.values_count; ++i) {
+      array.values[i] = *done.values[i].release();
+    }
+    return Deliver(std::move(result));
+  }
+
+  bool parse_error(std::size_t,
+                   const std::string&,
+                   const nlohmann::detail::exception&) override {
+    return Fail("Failed to parse string into json");
+  }
+
+ private:
+  Frame& current() {
+    return stack_.back();
+  }
+
+  Slot CurrentSlot() {
+    return current().slot;
+  }
+
+  bool Push(Scope scope) {
+    // Elements of arrays have no keys, so their slot never changes.
+    Slot slot = scope == Scope::kValues ? Slot::kValue : Slot::kIgnored;
+    stack_.emplace_back(scope, slot);
+    return true;
+  }
+
+  Frame Pop() {
+    Frame result = std::move(stack_.back());
+    stack_.pop_back();
+    return result;
+  }
+
+  bool Fail(const std::string& message) {
+    reader_.Fail(message);
+    return false;
+  }
+
+  bool UnexpectedType() {
+    const Frame& frame = current();
+    if (frame.slot == Slot::kValue) {
+      return Fail("'value' is not encoded as JSON object");
+    }
+    return Fail("'" + frame.key + "' is not encoded as expected");
+  }
+
+  bool SetType(pb_size_t tag) {
+    current().value->which_value_type = tag;
+    return true;
+  }
+
+  bool SetInteger(int64_t val) {
+    Frame& frame = current();
+    switch (frame.slot) {
+      case Slot::kSeconds:
+        frame.seconds = val;
+        break;
+      case Slot::kNanos:
+        // Like the string form, fail instead of truncating out of range nanos.
+        if (val < std::numeric_limits<int32_t>::min() ||
+            val > std::numeric_limits<int32_t>::max()) {
+          return Fail("Failed to parse into integer: " + std::to_string(val));
+        }
+        frame.nanos = static_cast<int32_t>(val);
+        break;
+      default:
+        SetType(google_firestore_v1_Value_integer_value_tag);
+        frame.value->integer_value = val;
+        break;
+    }
+    return true;
+  }
+
+  bool SetInteger(const std::string& val) {
+    if (CurrentSlot() == Slot::kNanos) {
+      // Nanos are parsed as an `int32_t`, so that they fail when out of range.
+      if (!absl::SimpleAtoi<int32_t>(val, &current().nanos)) {
+        return Fail("Failed to parse into integer: " + val);
+      }
+      return true;
+    }
+
+    int64_t result = 0;
+    if (!absl::SimpleAtoi<int64_t>(val, &result)) {
+      return Fail("Failed to parse into integer: " + val);
+    }
+    return SetInteger(result);
+  }
+
+  bool SetDouble(double val) {
+    Frame& frame = current();
+    switch (frame.slot) {
+      case Slot::kLatitude:
+        frame.lat_lng.latitude = val;
+        break;
+      case Slot::kLongitude:
+        frame.lat_lng.longitude = val;
+        break;
+      default:
+        SetType(google_firestore_v1_Value_double_value_tag);
+        frame.value->double_value = val;
+        break;
+    }
+    return true;
+  }
+
+  bool SetDouble(const std::string& val) {
+    double result = 0;
+    if (!absl::SimpleAtod(val, &result)) {
+      return Fail("Failed to parse into double: " + val);
+    }
+    return SetDouble(result);
+  }
+
+  bool SetTimestamp(const std::string& val) {
+    absl::Time time;
+    std::string err;
+    if (!absl::ParseTime(absl::RFC3339_full, val, &time, &err)) {
+      return Fail("Parsing timestamp failed with error: " + err);
+    }
+    return SetTimestamp(TimestampInternal::FromUntrustedTime(time));
+  }
+
+  /**
+   * Sets the timestamp for the current slot, which is either the update time
+   * of the document or a timestamp value.
+   */
+  bool SetTimestamp(const StatusOr<Timestamp>& timestamp) {
+    if (!timestamp.ok()) {
+      return Fail(
+          "Failed to decode json into valid protobuf Timestamp with error '" +
+          timestamp.status().error_message() + "'");
+    }
+
+    Frame& frame = current();
+    if (frame.slot == Slot::kUpdateTime) {
+      update_time_ = timestamp.ValueOrDie();
+    } else {
+      SetType(google_firestore_v1_Value_timestamp_value_tag);
+      frame.value->timestamp_value.seconds = timestamp.ValueOrDie().seconds();
+      frame.value->timestamp_value.nanos =
+          timestamp.ValueOrDie().nanoseconds();
+    }
+    return true;
+  }
+
+  bool SetBytes(const std::string& val) {
+    std::string decoded;
+    if (!absl::Base64Unescape(val, &decoded)) {
+      return Fail("Failed to decode bytesValue string into binary form");
+    }
+    SetType(google_firestore_v1_Value_bytes_value_tag);
+    current().value->bytes_value = nanopb::MakeBytesArray(decoded);
+    return true;
+  }
+
+  bool SetReference(const std::string& val) {
+    if (!serializer_.IsLocalDocumentKey(val)) {
+      return Fail("Tried to deserialize an invalid key: " + val);
+    }
+    SetType(google_firestore_v1_Value_reference_value_tag);
+    current().value->reference_value = nanopb::MakeBytesArray(val);
+    return true;
+  }
+
+  /** Hands a decoded value to the scope that encloses it. */
+  bool Deliver(Message<google_firestore_v1_Value> value) {
+    Frame& frame = current();
+    switch (frame.scope) {
+      case Scope::kFields:
+        frame.keys.push_back(std::move(frame.key));
+        frame.values.push_back(std::move(value));
+        break;
+      case Scope::kValues:
+        frame.values.push_back(std::move(value));
+        break;
+      default:
+        frame.value = std::move(value);
+        break;
+    }
+    return true;
+  }
+
+  bool FinishTimestamp(const Frame& done) {
+    return SetTimestamp(TimestampInternal::FromUntrustedSecondsAndNanos(
+        done.seconds, done.nanos));
+  }
+
+  /**
+   * Builds a map value out of the fields in `done`, sorted by name. Like in a
+   * `nlohmann::json` object, the last of several fields with the same name
+   * wins.
+   */
+  Message<google_firestore_v1_Value> FinishMap(Frame done) {
+    std::vector<size_t> order(done.keys.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+      return done.keys[lhs] < done.keys[rhs];
+    });
+
+    std::vector<size_t> indexes;
+    indexes.reserve(order.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+      bool overridden = i + 1 < order.size() &&
+                        done.keys[order[i]] == done.keys[order[i + 1]];
+      if (!overridden) {
+        indexes.push_back(order[i]);
+      }
+    }
+
+    Message<google_firestore_v1_Value> result;
+    result->which_value_type = google_firestore_v1_Value_map_value_tag;
+    auto& map = result->map_value;
+    map.fields_count = nanopb::CheckedSize(indexes.size());
+    map.fields = nanopb::MakeArray<google_firestore_v1_MapValue_FieldsEntry>(
+        map.fields_count);
+    for (pb_size_t i = 0; i < map.fields_count; ++i) {
+      size_t index = indexes[i];
+      map.fields[i].key = nanopb::MakeBytesArray(done.keys[index]);
+      map.fields[i].value = *done.values[index].release();
+    }
+    return result;
+  }
+
+  bool FinishDocument(Frame done) {
+    if (name_.empty()) {
+      return Fail("'name' is missing or is not a string");
+    }
+    if (!update_time_) {
+      return Fail("Missing child 'updateTime'");
+    }
+
+    auto path = ResourcePath::FromString(name_);
+    if (!serializer_.IsLocalResourceName(path)) {
+      return Fail("Resource name is not valid for current instance: " +
+                  path.CanonicalString());
+    }
+    path = path.PopFirst(5);
+    if (!DocumentKey::IsDocumentKey(path)) {
+      return Fail("Invalid document key: " + path.CanonicalString());
+    }
+
+    // A document without fields has no `fields`, like an empty map value.
+    Message<google_firestore_v1_MapValue> fields;
+    if (done.value->which_value_type) {
+      fields = Message<google_firestore_v1_MapValue>(done.value->map_value);
+      done.value.release();
+    }
+
+    document_ = BundleDocument(MutableDocument::FoundDocument(
+        DocumentKey(std::move(path)), SnapshotVersion(*update_time_),
+        ObjectValue::FromMapValue(std::move(fields))));
+    has_document_ = true;
+    return true;
+  }
+
+  const remote::Serializer& serializer_;
+  JsonReader& reader_;
+
+  std::vector<Frame> stack_;
+
+  std::string name_;
+  absl::optional<Timestamp> update_time_;
+
+  BundleDocument document_;
+  bool has_document_ = false;
+  bool is_document_ = true;
+  bool needs_dom_ = false;
+};
+
+}  // namespace
+
+absl::optional<BundleDocument> BundleDocumentDecoder::DecodeElement(
+    JsonReader& reader, absl::string_view element) const {
+  DocumentDecodingHandler handler(rpc_serializer_, reader, Slot::kElement);
+  json::sax_parse(element.begin(), element.end(), &handler);
+  if (!handler.is_document() || handler.needs_dom()) {
+    return absl::nullopt;
+  }
+  return handler.TakeDocument();
+}
+
+BundleDocument BundleDocumentDecoder::DecodeDocument(
+    JsonReader& reader, absl::string_view document) const {
+  DocumentDecodingHandler handler(rpc_serializer_, reader, Slot::kDocument);
+  json::sax_parse(document.begin(), document.end(), &handler);
+  if (handler.needs_dom()) {
+    json parsed = json::parse(document.begin(), document.end(),
+                              /*callback=*/nullptr, /*allow_exceptions=*/false);
+    if (parsed.is_discarded()) {
+      reader.Fail("Failed to parse string into json");
+      return {};
+    }
+    return BundleSerializer(rpc_serializer_).DecodeDocument(reader, parsed);
+  }
+  return handler.TakeDocument();
+}
+
+}  // namespace bundle
+}  // namespace firestore
+}  // namespace firebase
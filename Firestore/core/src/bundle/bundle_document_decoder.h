@@ -0,0 +1,77 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_BUNDLE_BUNDLE_DOCUMENT_DECODER_H_
+#define FIRESTORE_CORE_SRC_BUNDLE_BUNDLE_DOCUMENT_DECODER_H_
+
+#include <utility>
+
+#include "Firestore/core/src/bundle/bundle_document.h"
+#include "Firestore/core/src/remote/serializer.h"
+#include "Firestore/core/src/util/json_reader.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+
+namespace firebase {
+namespace firestore {
+namespace bundle {
+
+/**
+ * Decodes bundled documents straight from their JSON text.
+ *
+ * `BundleSerializer` decodes from a parsed `nlohmann::json` DOM, so every
+ * document is materialized twice: once as JSON and once as nanopb protos.
+ * This decoder instead consumes the events of the JSON parser, and builds the
+ * nanopb values of a document as they are parsed. Documents make up most of a
+ * bundle, while the other elements are small, so only documents are decoded
+ * this way.
+ *
+ * The decoded documents are the same as the ones `BundleSerializer` decodes.
+ * Documents with values of more than one type are rare, and are decoded by
+ * `BundleSerializer`, which picks one of the types by a fixed priority.
+ */
+class BundleDocumentDecoder {
+ public:
+  explicit BundleDocumentDecoder(remote::Serializer serializer)
+      : rpc_serializer_(std::move(serializer)) {
+  }
+
+  /**
+   * Decodes `element` if it is a bundle element holding a document, that is
+   * `{"document": {...}}`. Returns `nullopt` if it holds a different kind of
+   * element, or a document with values of more than one type; the element
+   * should then be decoded by `BundleSerializer`.
+   *
+   * Failures are reported to `reader`.
+   */
+  absl::optional<BundleDocument> DecodeElement(util::JsonReader& reader,
+                                               absl::string_view element) const;
+
+  /**
+   * Decodes a `document` JSON object. Failures are reported to `reader`.
+   */
+  BundleDocument DecodeDocument(util::JsonReader& reader,
+                                absl::string_view document) const;
+
+ private:
+  remote::Serializer rpc_serializer_;
+};
+
+}  // namespace bundle
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_BUNDLE_BUNDLE_DOCUMENT_DECODER_H_
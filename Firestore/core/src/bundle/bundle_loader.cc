@@ -55,7 +55,10 @@ Status BundleLoader::AddElementInternal(const BundleElement& element) {
       const auto& document_metadata =
           static_cast<const BundledDocumentMetadata&>(element);
       current_document_ = document_metadata.key();
-      documents_metadata_.emplace(document_metadata.key(), document_metadata);
+      for (const auto& query : document_metadata.queries()) {
+        query_documents_[query] =
+            query_documents_[query].insert(document_metadata.key());
+      }
 
       if (!document_metadata.exists()) {
         documents_ = documents_.insert(
@@ -103,18 +106,50 @@ StatusOr<absl::optional<LoadBundleTaskProgress>> BundleLoader::AddElement(
   }
 
   bytes_loaded_ += byte_size;
+  chunk_bytes_ += byte_size;
 
   // Document has only been partially loaded, no progress to report.
   if (before_count == documents_.size()) {
     return {absl::nullopt};
   }
+  documents_loaded_ += static_cast<uint32_t>(documents_.size() - before_count);
+
+  if (loads_in_chunks() && chunk_bytes_ >= *chunk_byte_size_) {
+    ApplyChunk();
+  }
 
   LoadBundleTaskProgress progress{
-      documents_.size(), metadata_.total_documents(), bytes_loaded_,
+      documents_loaded_, metadata_.total_documents(), bytes_loaded_,
       metadata_.total_bytes(), LoadBundleTaskState::kInProgress};
   return {absl::make_optional(std::move(progress))};
 }
 
+void BundleLoader::ApplyChunk() {
+  for (const auto& kv : documents_) {
+    if (kv.second.is_found_document()) {
+      applied_keys_ = applied_keys_.insert(kv.first);
+    }
+  }
+
+  DocumentMap changes = callback_->ApplyBundledDocumentChunk(documents_);
+  if (chunk_changes_.empty()) {
+    chunk_changes_ = std::move(changes);
+  } else {
+    for (const auto& kv : changes) {
+      chunk_changes_ = chunk_changes_.insert(kv.first, kv.second);
+    }
+  }
+
+  documents_ = model::MutableDocumentMap{};
+  chunk_bytes_ = 0;
+}
+
+DocumentMap BundleLoader::TakeChunkChanges() {
+  DocumentMap result = std::move(chunk_changes_);
+  chunk_changes_ = DocumentMap{};
+  return result;
+}
+
 StatusOr<DocumentMap> BundleLoader::ApplyChanges() {
   if (current_document_ != absl::nullopt) {
     return StatusOr<DocumentMap>(
@@ -122,14 +157,24 @@ StatusOr<DocumentMap> BundleLoader::ApplyChanges() {
                "Bundled documents end with a document metadata "
                "element instead of a document."));
   }
-  if (metadata_.total_documents() != documents_.size()) {
+  if (metadata_.total_documents() != documents_loaded_) {
     return StatusOr<DocumentMap>(
         Status(Error::kErrorInvalidArgument,
                "Loaded documents count is not the same as in metadata."));
   }
 
-  auto changes =
-      callback_->ApplyBundledDocuments(documents_, metadata_.bundle_id());
+  DocumentMap changes;
+  if (loads_in_chunks()) {
+    if (!documents_.empty()) {
+      ApplyChunk();
+    }
+    callback_->SaveBundledDocumentKeys(applied_keys_, metadata_.bundle_id());
+    changes = TakeChunkChanges();
+  } else {
+    changes =
+        callback_->ApplyBundledDocuments(documents_, metadata_.bundle_id());
+  }
+
   auto query_document_map = GetQueryDocumentMapping();
   for (const auto& named_query : queries_) {
     const auto& matching_keys = query_document_map[named_query.query_name()];
@@ -141,6 +186,12 @@ StatusOr<DocumentMap> BundleLoader::ApplyChanges() {
   return changes;
 }
 
+void BundleLoader::SaveAppliedDocumentKeys() {
+  if (!applied_keys_.empty()) {
+    callback_->SaveBundledDocumentKeys(applied_keys_, metadata_.bundle_id());
+  }
+}
+
 std::unordered_map<std::string, DocumentKeySet>
 BundleLoader::GetQueryDocumentMapping() {
   std::unordered_map<std::string, DocumentKeySet> result;
@@ -148,12 +199,8 @@ BundleLoader::GetQueryDocumentMapping() {
     result.emplace(named_query.query_name(), DocumentKeySet{});
   }
 
-  for (const auto& doc_metadata : documents_metadata_) {
-    const auto& metadata = doc_metadata.second;
-    for (const auto& query : doc_metadata.second.queries()) {
-      auto inserted = result[query].insert(metadata.key());
-      result[query] = std::move(inserted);
-    }
+  for (const auto& entry : query_documents_) {
+    result[entry.first] = entry.second;
   }
 
   return result;
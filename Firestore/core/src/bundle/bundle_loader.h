@@ -29,6 +29,7 @@
 #include "Firestore/core/src/bundle/bundled_document_metadata.h"
 #include "Firestore/core/src/immutable/sorted_map.h"
 #include "Firestore/core/src/model/document_key.h"
+#include "Firestore/core/src/model/document_key_set.h"
 #include "Firestore/core/src/model/model_fwd.h"
 #include "Firestore/core/src/util/statusor.h"
 #include "absl/types/optional.h"
@@ -55,13 +56,42 @@ class BundleLoader {
   using AddElementResult =
       util::StatusOr<absl::optional<api::LoadBundleTaskProgress>>;
 
+  /**
+   * Creates a loader that holds on to all documents of the bundle, and applies
+   * them in a single transaction in `ApplyChanges`.
+   */
   BundleLoader(BundleCallback* callback, BundleMetadata metadata)
       : callback_(callback), metadata_(std::move(metadata)) {
   }
 
+  /**
+   * Creates a loader that applies the documents of the bundle in chunks, so
+   * that memory use does not grow with the size of the bundle.
+   *
+   * Whenever the elements added since the last chunk take up at least
+   * `chunk_byte_size` bytes of the bundle, `AddElement` applies their
+   * documents in a transaction of their own. The target that keeps the
+   * documents from being garbage collected and the named queries are only
+   * saved by `ApplyChanges`, once the whole bundle has been read.
+   *
+   * Chunks stay applied if loading fails later on, since their documents have
+   * already been raised to listeners; see `SaveAppliedDocumentKeys`.
+   */
+  BundleLoader(BundleCallback* callback,
+               BundleMetadata metadata,
+               uint64_t chunk_byte_size)
+      : callback_(callback),
+        metadata_(std::move(metadata)),
+        chunk_byte_size_(chunk_byte_size) {
+  }
+
   /**
    * Adds an element from the bundle to the loader.
    *
+   * When loading in chunks, adding the document that completes a chunk also
+   * applies the chunk, whose view changes can then be taken with
+   * `TakeChunkChanges`.
+   *
    * @return a new progress if adding the element leads to a new progress,
    * otherwise returns `nullopt`. If an error occurred, returns a not `ok()`
    * status.
@@ -69,12 +99,31 @@ class BundleLoader {
   AddElementResult AddElement(std::unique_ptr<BundleElement> element,
                               uint64_t byte_size);
 
+  /**
+   * Returns the document view changes of the chunks applied since the last
+   * call, and forgets them.
+   */
+  model::DocumentMap TakeChunkChanges();
+
   /**
    * Applies the loaded documents and queries to local store. Returns the
    * document view changes. If an error occurred, returns a not `ok()` status.
+   *
+   * When loading in chunks, this applies the documents added since the last
+   * chunk, and only returns their view changes.
    */
   util::StatusOr<model::DocumentMap> ApplyChanges();
 
+  /**
+   * Keeps the documents of the chunks applied so far from being garbage
+   * collected. To be called when loading the bundle fails after chunks have
+   * been applied.
+   *
+   * The named queries and the bundle metadata are not saved, so loading the
+   * bundle again applies all of it.
+   */
+  void SaveAppliedDocumentKeys();
+
  private:
   /**
    * @return A map whose keys are the query names in the loading bundle, and
@@ -89,14 +138,29 @@ class BundleLoader {
    */
   util::Status AddElementInternal(const BundleElement& element);
 
+  bool loads_in_chunks() const {
+    return chunk_byte_size_.has_value();
+  }
+
+  /** Applies the documents added since the last chunk. */
+  void ApplyChunk();
+
   BundleCallback* callback_ = nullptr;
   BundleMetadata metadata_;
   std::vector<NamedQuery> queries_;
-  std::unordered_map<model::DocumentKey,
-                     BundledDocumentMetadata,
-                     model::DocumentKeyHash>
-      documents_metadata_;
+
+  // The keys of the documents each query name in the bundle matches.
+  std::unordered_map<std::string, model::DocumentKeySet> query_documents_;
+
+  // The documents that have not been applied yet.
   model::MutableDocumentMap documents_;
+  uint32_t documents_loaded_ = 0;
+
+  // Only set when loading in chunks.
+  absl::optional<uint64_t> chunk_byte_size_;
+  uint64_t chunk_bytes_ = 0;
+  model::DocumentKeySet applied_keys_;
+  model::DocumentMap chunk_changes_;
 
   uint64_t bytes_loaded_ = 0;
   absl::optional<model::DocumentKey> current_document_;
@@ -18,6 +18,8 @@
 
 #include <algorithm>
 
+#include "Firestore/core/src/nanopb/message.h"
+#include "Firestore/core/src/nanopb/reader.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/numbers.h"
 #include "absl/strings/string_view.h"
@@ -26,12 +28,22 @@ namespace firebase {
 namespace firestore {
 namespace bundle {
 
+using nanopb::Message;
+using nanopb::StringReader;
 using nlohmann::json;
 using util::ByteStream;
 using util::StreamReadResult;
 
 namespace {
 
+// Large enough that reading is not dominated by the overhead of each read, and
+// small enough not to allocate a huge buffer when corruption leads to a large
+// length prefix.
+const size_t kReadChunkSize = 64 * 1024;
+
+// The most bytes a varint of up to 64 bits takes.
+const size_t kMaxVarintSize = 10;
+
 json Parse(absl::string_view s) {
   return json::parse(s.begin(), s.end(), /*callback=*/nullptr,
                      /*allow_exceptions=*/false);
@@ -41,7 +53,10 @@ json Parse(absl::string_view s) {
 
 BundleReader::BundleReader(BundleSerializer serializer,
                            std::unique_ptr<ByteStream> input)
-    : serializer_(std::move(serializer)), input_(std::move(input)) {
+    : serializer_(std::move(serializer)),
+      document_decoder_(serializer_.rpc_serializer()),
+      binary_serializer_(serializer_.rpc_serializer()),
+      input_(std::move(input)) {
 }
 
 BundleMetadata BundleReader::GetBundleMetadata() {
@@ -67,7 +82,44 @@ std::unique_ptr<BundleElement> BundleReader::GetNextElement() {
   return ReadNextElement();
 }
 
+void BundleReader::DetectFormat() {
+  StreamReadResult result = input_->Read(1);
+  if (!result.ok()) {
+    reader_status_.Update(result.status());
+    return;
+  }
+
+  std::string first_byte = std::move(result).ValueOrDie();
+  if (first_byte.empty() || first_byte[0] != kBinaryBundleHeader[0]) {
+    format_ = Format::kJson;
+    pending_prefix_ = std::move(first_byte);
+    return;
+  }
+
+  buffer_.clear();
+  ReadToBuffer(kBinaryBundleHeaderSize - 1);
+  if (!reader_status_.ok()) {
+    return;
+  }
+  if (buffer_ != absl::string_view(kBinaryBundleHeader + 1,
+                                   kBinaryBundleHeaderSize - 1)) {
+    Fail("Bundle does not start with a valid header");
+    return;
+  }
+  format_ = Format::kBinary;
+}
+
 std::unique_ptr<BundleElement> BundleReader::ReadNextElement() {
+  if (format_ == Format::kUnknown) {
+    DetectFormat();
+    if (!reader_status_.ok()) {
+      return nullptr;
+    }
+  }
+  if (format_ == Format::kBinary) {
+    return ReadNextBinaryElement();
+  }
+
   auto length_prefix = ReadLengthPrefix();
   if (!length_prefix.has_value()) {
     return nullptr;
@@ -81,7 +133,7 @@ std::unique_ptr<BundleElement> BundleReader::ReadNextElement() {
   }
 
   buffer_.clear();
-  ReadJsonToBuffer(prefix_value);
+  ReadToBuffer(prefix_value);
   if (!reader_status_.ok()) {
     return nullptr;
   }
@@ -105,23 +157,94 @@ absl::optional<std::string> BundleReader::ReadLengthPrefix() {
     return absl::nullopt;
   }
 
+  std::string prefix = std::move(pending_prefix_);
+  pending_prefix_.clear();
+  prefix.append(std::move(result).ValueOrDie());
+
   // Underlying stream is closed, and there happens to be no more data to
   // process.
-  if (result.eof() && result.ValueOrDie().empty()) {
+  if (result.eof() && prefix.empty()) {
     return absl::nullopt;
   }
 
-  return absl::make_optional(std::move(result).ValueOrDie());
+  return absl::make_optional(std::move(prefix));
 }
 
-void BundleReader::ReadJsonToBuffer(size_t required_size) {
+std::unique_ptr<BundleElement> BundleReader::ReadNextBinaryElement() {
+  auto length_prefix = ReadVarintPrefix();
+  if (!length_prefix.has_value()) {
+    return nullptr;
+  }
+
+  uint64_t prefix_value = 0;
+  pb_istream_t prefix_stream = pb_istream_from_buffer(
+      reinterpret_cast<const pb_byte_t*>(length_prefix.value().data()),
+      length_prefix.value().size());
+  if (!pb_decode_varint(&prefix_stream, &prefix_value)) {
+    Fail("Prefix is not a valid varint");
+    return nullptr;
+  }
+
+  buffer_.clear();
+  ReadToBuffer(static_cast<size_t>(prefix_value));
+  if (!reader_status_.ok()) {
+    return nullptr;
+  }
+
+  // metadata's size does not count in `bytes_read_`.
+  if (metadata_loaded_) {
+    bytes_read_ += length_prefix.value().size() + buffer_.size();
+  }
+
+  StringReader reader{absl::string_view(buffer_)};
+  auto proto = Message<firestore_BundleElement>::TryParse(&reader);
+  std::unique_ptr<BundleElement> result;
+  if (reader.ok()) {
+    result = binary_serializer_.DecodeBundleElement(&reader, *proto);
+  }
+  if (!reader.ok()) {
+    reader_status_.Update(reader.status());
+    return nullptr;
+  }
+
+  return result;
+}
+
+absl::optional<std::string> BundleReader::ReadVarintPrefix() {
+  // Every byte of a varint but the last one has its most significant bit set.
+  std::string result;
+  while (result.size() < kMaxVarintSize) {
+    StreamReadResult byte = input_->Read(1);
+    if (!byte.ok()) {
+      reader_status_.Update(byte.status());
+      return absl::nullopt;
+    }
+
+    // Underlying stream is closed, and there happens to be no more data to
+    // process.
+    if (byte.ValueOrDie().empty()) {
+      if (!result.empty()) {
+        Fail("Bundle ends within a length prefix");
+      }
+      return absl::nullopt;
+    }
+
+    result.append(byte.ValueOrDie());
+    if ((static_cast<uint8_t>(result.back()) & 0x80) == 0) {
+      return absl::make_optional(std::move(result));
+    }
+  }
+
+  Fail("Prefix is not a valid varint");
+  return absl::nullopt;
+}
+
+void BundleReader::ReadToBuffer(size_t required_size) {
   if (!reader_status_.ok()) {
     return;
   }
   while (buffer_.size() < required_size) {
-    // Read at most 1024 bytes every time, to avoid allocating a huge buffer
-    // when corruption leads to large `required_size`.
-    auto size = std::min<size_t>(1024ul, required_size - buffer_.size());
+    auto size = std::min(kReadChunkSize, required_size - buffer_.size());
     StreamReadResult result = input_->Read(size);
     if (!result.ok()) {
       reader_status_.Update(result.status());
@@ -140,6 +263,15 @@ void BundleReader::ReadJsonToBuffer(size_t required_size) {
 }
 
 std::unique_ptr<BundleElement> BundleReader::DecodeBundleElementFromBuffer() {
+  absl::optional<BundleDocument> document =
+      document_decoder_.DecodeElement(json_reader_, buffer_);
+  if (document) {
+    if (!json_reader_.ok()) {
+      return nullptr;
+    }
+    return absl::make_unique<BundleDocument>(std::move(*document));
+  }
+
   auto json_object = Parse(buffer_);
   if (json_object.is_discarded()) {
     Fail("Failed to parse string into json");
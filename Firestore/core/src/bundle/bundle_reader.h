@@ -21,6 +21,8 @@
 #include <string>
 #include <utility>
 
+#include "Firestore/core/src/bundle/binary_bundle_serializer.h"
+#include "Firestore/core/src/bundle/bundle_document_decoder.h"
 #include "Firestore/core/src/bundle/bundle_metadata.h"
 #include "Firestore/core/src/bundle/bundle_serializer.h"
 #include "Firestore/core/src/util/byte_stream.h"
@@ -36,6 +38,9 @@ namespace bundle {
  *
  * The class takes a bundle stream and presents abstractions to read bundled
  * elements out of the underlying content.
+ *
+ * Bundles in the binary format described by `kBinaryBundleHeader` are read as
+ * well, the format being detected from the first byte of the stream.
  */
 class BundleReader {
  public:
@@ -76,6 +81,14 @@ class BundleReader {
   }
 
  private:
+  enum class Format { kUnknown, kJson, kBinary };
+
+  /**
+   * Reads the first byte of the stream to tell whether it holds a JSON or a
+   * binary bundle, and reads the header of binary bundles.
+   */
+  void DetectFormat();
+
   /**
    * Reads from the head of internal buffer, pulls more data from underlying
    * stream until a complete element is found (including the prefixed length and
@@ -98,25 +111,45 @@ class BundleReader {
    */
   absl::optional<std::string> ReadLengthPrefix();
 
+  /** Reads the next element of a binary bundle. */
+  std::unique_ptr<BundleElement> ReadNextBinaryElement();
+
+  /**
+   * Reads the varint length prefix of an element of a binary bundle. Returns
+   * `nullopt` when at the end of stream, or if the prefix is not valid.
+   */
+  absl::optional<std::string> ReadVarintPrefix();
+
   /**
    * Reads `required_size` number of chars from stream into internal `buffer_`.
    */
-  void ReadJsonToBuffer(size_t required_size);
+  void ReadToBuffer(size_t required_size);
 
   /**
    * Decodes internal `buffer_` into a `BundleElement`, returned as a unique_ptr
    * pointing to the element. Returns nullptr if fails.
    *
+   * Documents are decoded straight from `buffer_` by `document_decoder_`. The
+   * other elements are small, and are decoded from a parsed JSON object.
+   *
    * Note this method will leave `buffer_` unchanged.
    */
   std::unique_ptr<BundleElement> DecodeBundleElementFromBuffer();
 
   BundleSerializer serializer_;
+  BundleDocumentDecoder document_decoder_;
+  BinaryBundleSerializer binary_serializer_;
   util::JsonReader json_reader_;
 
   // Input stream holding bundle data.
   std::unique_ptr<util::ByteStream> input_;
 
+  Format format_ = Format::kUnknown;
+
+  // The first byte of a JSON bundle, read by `DetectFormat`, which starts the
+  // length prefix of its metadata.
+  std::string pending_prefix_;
+
   // Cached bundle metadata.
   BundleMetadata metadata_;
   bool metadata_loaded_ = false;
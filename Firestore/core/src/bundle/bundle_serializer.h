@@ -46,6 +46,11 @@ class BundleSerializer {
   explicit BundleSerializer(remote::Serializer serializer)
       : rpc_serializer_(std::move(serializer)) {
   }
+
+  const remote::Serializer& rpc_serializer() const {
+    return rpc_serializer_;
+  }
+
   BundleMetadata DecodeBundleMetadata(util::JsonReader& reader,
                                       const nlohmann::json& metadata) const;
 
@@ -34,15 +34,20 @@
 #include "Firestore/core/src/core/sync_engine.h"
 #include "Firestore/core/src/core/view.h"
 #include "Firestore/core/src/credentials/credentials_provider.h"
+#include "Firestore/core/src/local/index_backfiller.h"
 #include "Firestore/core/src/local/leveldb_opener.h"
+#include "Firestore/core/src/local/leveldb_options.h"
 #include "Firestore/core/src/local/leveldb_persistence.h"
+#include "Firestore/core/src/local/leveldb_snapshot_reader.h"
 #include "Firestore/core/src/local/local_documents_view.h"
 #include "Firestore/core/src/local/local_serializer.h"
 #include "Firestore/core/src/local/local_store.h"
+#include "Firestore/core/src/local/lru_garbage_collector.h"
 #include "Firestore/core/src/local/memory_lru_reference_delegate.h"
 #include "Firestore/core/src/local/memory_persistence.h"
 #include "Firestore/core/src/local/proto_sizer.h"
 #include "Firestore/core/src/local/query_engine.h"
+#include "Firestore/core/src/local/query_planner.h"
 #include "Firestore/core/src/local/query_result.h"
 #include "Firestore/core/src/model/aggregate_field.h"
 #include "Firestore/core/src/model/database_id.h"
@@ -80,6 +85,7 @@ using credentials::AuthCredentialsProvider;
 using credentials::User;
 using firestore::Error;
 using local::LevelDbOpener;
+using local::LevelDbOptions;
 using local::LocalStore;
 using local::LruParams;
 using local::MemoryPersistence;
@@ -114,11 +120,106 @@ static const size_t kMaxConcurrentLimboResolutions = 100;
 
 static const auto kInitialGCDelay = std::chrono::minutes(1);
 static const auto kRegularGCDelay = std::chrono::minutes(5);
+/**
+ * Time between garbage collection slices while a pass is in progress. Each
+ * slice removes a bounded number of targets and documents, so this keeps GC
+ * from holding the worker queue for long stretches.
+ */
+static const auto kGCSliceDelay = std::chrono::seconds(1);
 
 /** How long we wait to try running index backfill after SDK initialization. */
 static const auto kInitialBackfillDelay = std::chrono::seconds(15);
 /** Minimum amount of time between backfill checks, after the first one. */
 static const auto kRegularBackfillDelay = std::chrono::minutes(1);
+/**
+ * Time between backfill runs while the backfiller has not caught up. Each run
+ * is bounded by the backfiller's time budget, so this keeps its share of the
+ * worker queue small while still making steady progress.
+ */
+static const auto kCatchUpBackfillDelay = std::chrono::seconds(1);
+
+/**
+ * The maximum number of writes buffered by write coalescing. Reaching it
+ * commits the buffered writes without waiting for the window to end.
+ */
+static const size_t kMaxCoalescedWrites = 100;
+
+/** The number of threads serving cache-only reads off the worker queue. */
+static const int kSnapshotReaderThreads = 4;
+
+/**
+ * Returns the default LevelDB options, overridden by any storage options set in
+ * the persistent cache settings.
+ */
+LevelDbOptions MakeLevelDbOptions(const Settings& settings) {
+  LevelDbOptions options = LevelDbOptions::Default();
+  const api::LocalCacheSettings* cache_settings =
+      settings.local_cache_settings();
+  if (cache_settings == nullptr ||
+      cache_settings->kind() != api::LocalCacheSettings::Kind::kPersistent) {
+    return options;
+  }
+
+  const auto& persistent_settings =
+      static_cast<const api::PersistentCacheSettings&>(*cache_settings);
+  if (persistent_settings.block_cache_size_bytes()) {
+    options.block_cache_size_bytes =
+        *persistent_settings.block_cache_size_bytes();
+  }
+  if (persistent_settings.bloom_filter_bits_per_key()) {
+    options.bloom_filter_bits_per_key =
+        *persistent_settings.bloom_filter_bits_per_key();
+  }
+  if (persistent_settings.write_buffer_size_bytes()) {
+    options.write_buffer_size_bytes =
+        *persistent_settings.write_buffer_size_bytes();
+  }
+  if (persistent_settings.compression_enabled()) {
+    options.compression_enabled = *persistent_settings.compression_enabled();
+  }
+  return options;
+}
+
+StatusOr<DocumentSnapshot> DocumentSnapshotFromCache(
+    const DocumentReference& doc, const Document& document) {
+  if (document->is_found_document()) {
+    return DocumentSnapshot::FromDocument(
+        doc.firestore(), document,
+        SnapshotMetadata{document->has_local_mutations(),
+                         /*from_cache=*/true});
+  } else if (document->is_no_document()) {
+    return DocumentSnapshot::FromNoDocument(
+        doc.firestore(), doc.key(),
+        SnapshotMetadata{/*pending_writes=*/false,
+                         /*from_cache=*/true});
+  } else {
+    return Status{
+        Error::kErrorUnavailable,
+        "Failed to get document from cache. (However, this document "
+        "may exist on the server. Run again without setting source to "
+        "FirestoreSourceCache to attempt to retrieve the document "};
+  }
+}
+
+QuerySnapshot QuerySnapshotFromCache(const api::Query& query,
+                                     const DocumentMap& documents,
+                                     const DocumentKeySet& remote_keys) {
+  View view(query.query(), remote_keys);
+  ViewDocumentChanges view_doc_changes = view.ComputeDocumentChanges(documents);
+  ViewChange view_change = view.ApplyChanges(view_doc_changes);
+  HARD_ASSERT(
+      view_change.limbo_changes().empty(),
+      "View returned limbo documents during local-only query execution.");
+
+  HARD_ASSERT(view_change.snapshot().has_value(), "Expected a snapshot");
+
+  ViewSnapshot snapshot = std::move(view_change.snapshot()).value();
+  SnapshotMetadata metadata(snapshot.has_pending_writes(),
+                            snapshot.from_cache());
+
+  return QuerySnapshot(query.firestore(), query.query(), std::move(snapshot),
+                       std::move(metadata));
+}
 
 }  // namespace
 
@@ -158,7 +259,10 @@ std::shared_ptr<FirestoreClient> FirestoreClient::Create(
         shared_client->worker_queue_->VerifyIsCurrentQueue();
 
         LOG_DEBUG("Credential Changed. Current user: %s", user.uid());
+        // Buffered writes belong to the previous user.
+        shared_client->FlushPendingWrites();
         shared_client->sync_engine_->HandleCredentialChange(user);
+        shared_client->ResetSnapshotReader(user);
       });
     }
   };
@@ -208,7 +312,8 @@ void FirestoreClient::Initialize(const User& user, const Settings& settings) {
     LevelDbOpener opener(database_info_);
 
     auto created =
-        opener.Create(LruParams::WithCacheSize(settings.cache_size_bytes()));
+        opener.Create(LruParams::WithCacheSize(settings.cache_size_bytes()),
+                      MakeLevelDbOptions(settings));
     // If leveldb fails to start then just throw up our hands: the error is
     // unrecoverable. There's nothing an end-user can do and nearly all
     // failures indicate the developer is doing something grossly wrong so we
@@ -218,6 +323,9 @@ void FirestoreClient::Initialize(const User& user, const Settings& settings) {
 
     auto ldb = std::move(created).ValueOrDie();
     lru_delegate_ = ldb->reference_delegate();
+    leveldb_persistence_ = ldb.get();
+    reader_executor_ = Executor::CreateConcurrent(
+        "com.google.firebase.firestore.reader", kSnapshotReaderThreads);
 
     persistence_ = std::move(ldb);
     if (settings.gc_enabled()) {
@@ -256,6 +364,11 @@ void FirestoreClient::Initialize(const User& user, const Settings& settings) {
         sync_engine_->HandleOnlineStateChange(online_state);
       });
 
+  write_coalescing_window_ =
+      std::chrono::milliseconds(settings.write_coalescing_window_ms());
+  remote_store_->set_write_coalescing_enabled(
+      write_coalescing_window_.count() > 0);
+
   sync_engine_ =
       absl::make_unique<SyncEngine>(local_store_.get(), remote_store_.get(),
                                     user, kMaxConcurrentLimboResolutions);
@@ -270,6 +383,10 @@ void FirestoreClient::Initialize(const User& user, const Settings& settings) {
   local_store_->Start();
   remote_store_->Start();
 
+  if (leveldb_persistence_) {
+    ResetSnapshotReader(user);
+  }
+
   ScheduleIndexBackfiller();
 }
 
@@ -333,6 +450,19 @@ void FirestoreClient::TerminateInternal() {
 
   backfiller_callback_.Cancel();
 
+  // Commit buffered writes locally so that they are sent once the client is
+  // restarted.
+  FlushPendingWrites();
+
+  // Wait for in-flight snapshot reads, which use the database directly.
+  if (reader_executor_) {
+    {
+      std::lock_guard<std::mutex> lock(snapshot_reader_mutex_);
+      snapshot_reader_.reset();
+    }
+    reader_executor_->Dispose();
+  }
+
   remote_store_->Shutdown();
   persistence_->Shutdown();
 
@@ -345,20 +475,28 @@ void FirestoreClient::TerminateInternal() {
 }
 
 void FirestoreClient::ScheduleLruGarbageCollection() {
-  std::chrono::milliseconds delay =
-      gc_has_run_ ? kRegularGCDelay : kInitialGCDelay;
+  std::chrono::milliseconds delay = kInitialGCDelay;
+  if (gc_has_run_) {
+    delay = lru_delegate_->garbage_collector()->pass_in_progress()
+                ? std::chrono::milliseconds(kGCSliceDelay)
+                : std::chrono::milliseconds(kRegularGCDelay);
+  }
 
   lru_callback_ = worker_queue_->EnqueueAfterDelay(
       delay, TimerId::GarbageCollectionDelay, [this] {
-        local_store_->CollectGarbage(lru_delegate_->garbage_collector());
+        local_store_->CollectGarbageSlice(lru_delegate_->garbage_collector());
         gc_has_run_ = true;
         ScheduleLruGarbageCollection();
       });
 }
 
 void FirestoreClient::ScheduleIndexBackfiller() {
-  std::chrono::milliseconds delay =
-      backfiller_has_run_ ? kRegularBackfillDelay : kInitialBackfillDelay;
+  std::chrono::milliseconds delay = kInitialBackfillDelay;
+  if (backfiller_has_run_) {
+    delay = local_store_->GetIndexBackfillProgress().caught_up
+                ? std::chrono::milliseconds(kRegularBackfillDelay)
+                : std::chrono::milliseconds(kCatchUpBackfillDelay);
+  }
 
   backfiller_callback_ = worker_queue_->EnqueueAfterDelay(
       delay, TimerId::IndexBackfillDelay, [this] {
@@ -401,10 +539,35 @@ void FirestoreClient::WaitForPendingWrites(StatusCallback callback) {
   };
 
   worker_queue_->Enqueue([this, async_callback] {
+    FlushPendingWrites();
     sync_engine_->RegisterPendingWritesCallback(std::move(async_callback));
   });
 }
 
+void FirestoreClient::WaitForIndexBackfill(StatusCallback callback) {
+  VerifyNotTerminated();
+
+  worker_queue_->Enqueue(
+      [this, callback] { RunIndexBackfillUntilCaughtUp(callback); });
+}
+
+void FirestoreClient::RunIndexBackfillUntilCaughtUp(StatusCallback callback) {
+  local_store_->Backfill();
+  backfiller_has_run_ = true;
+
+  if (local_store_->GetIndexBackfillProgress().caught_up) {
+    if (callback) {
+      user_executor_->Execute([=] { callback(Status::OK()); });
+    }
+    return;
+  }
+
+  // Yield between runs so that other operations on the worker queue aren't
+  // blocked until the whole cache is indexed.
+  worker_queue_->EnqueueRelaxed(
+      [this, callback] { RunIndexBackfillUntilCaughtUp(callback); });
+}
+
 void FirestoreClient::VerifyNotTerminated() const {
   if (is_terminated()) {
     ThrowIllegalState("The client has already been terminated.");
@@ -428,6 +591,7 @@ std::shared_ptr<QueryListener> FirestoreClient::ListenToQuery(
       std::move(query), std::move(options), std::move(listener));
 
   worker_queue_->Enqueue([this, query_listener] {
+    FlushPendingWrites();
     event_manager_->AddQueryListener(std::move(query_listener));
   });
 
@@ -451,27 +615,26 @@ void FirestoreClient::GetDocumentFromLocalCache(
 
   // TODO(c++14): move `callback` into lambda.
   auto shared_callback = absl::ShareUniquePtr(std::move(callback));
+
+  std::shared_ptr<local::LevelDbSnapshotReader> reader =
+      SnapshotReaderForRead();
+  if (reader) {
+    std::shared_ptr<Executor> user_executor = user_executor_;
+    reader_executor_->Execute([reader, user_executor, doc, shared_callback] {
+      StatusOr<DocumentSnapshot> maybe_snapshot =
+          DocumentSnapshotFromCache(doc, reader->ReadDocument(doc.key()));
+      if (shared_callback) {
+        user_executor->Execute(
+            [=] { shared_callback->OnEvent(std::move(maybe_snapshot)); });
+      }
+    });
+    return;
+  }
+
   worker_queue_->Enqueue([this, doc, shared_callback] {
-    Document document = local_store_->ReadDocument(doc.key());
-    StatusOr<DocumentSnapshot> maybe_snapshot;
-
-    if (document->is_found_document()) {
-      maybe_snapshot = DocumentSnapshot::FromDocument(
-          doc.firestore(), document,
-          SnapshotMetadata{document->has_local_mutations(),
-                           /*from_cache=*/true});
-    } else if (document->is_no_document()) {
-      maybe_snapshot = DocumentSnapshot::FromNoDocument(
-          doc.firestore(), doc.key(),
-          SnapshotMetadata{/*pending_writes=*/false,
-                           /*from_cache=*/true});
-    } else {
-      maybe_snapshot =
-          Status{Error::kErrorUnavailable,
-                 "Failed to get document from cache. (However, this document "
-                 "may exist on the server. Run again without setting source to "
-                 "FirestoreSourceCache to attempt to retrieve the document "};
-    }
+    FlushPendingWrites();
+    StatusOr<DocumentSnapshot> maybe_snapshot =
+        DocumentSnapshotFromCache(doc, local_store_->ReadDocument(doc.key()));
 
     if (shared_callback) {
       user_executor_->Execute(
@@ -486,26 +649,30 @@ void FirestoreClient::GetDocumentsFromLocalCache(
 
   // TODO(c++14): move `callback` into lambda.
   auto shared_callback = absl::ShareUniquePtr(std::move(callback));
+
+  std::shared_ptr<local::LevelDbSnapshotReader> reader =
+      SnapshotReaderForRead();
+  if (reader) {
+    std::shared_ptr<Executor> user_executor = user_executor_;
+    reader_executor_->Execute([reader, user_executor, query, shared_callback] {
+      // Remote keys only matter for limbo resolution, which local-only views
+      // never do, so the snapshot doesn't need the target's previous results.
+      QuerySnapshot result = QuerySnapshotFromCache(
+          query, reader->ExecuteQuery(query.query()), DocumentKeySet{});
+      if (shared_callback) {
+        user_executor->Execute(
+            [=] { shared_callback->OnEvent(std::move(result)); });
+      }
+    });
+    return;
+  }
+
   worker_queue_->Enqueue([this, query, shared_callback] {
+    FlushPendingWrites();
     QueryResult query_result = local_store_->ExecuteQuery(
         query.query(), /* use_previous_results= */ true);
-
-    View view(query.query(), query_result.remote_keys());
-    ViewDocumentChanges view_doc_changes =
-        view.ComputeDocumentChanges(query_result.documents());
-    ViewChange view_change = view.ApplyChanges(view_doc_changes);
-    HARD_ASSERT(
-        view_change.limbo_changes().empty(),
-        "View returned limbo documents during local-only query execution.");
-
-    HARD_ASSERT(view_change.snapshot().has_value(), "Expected a snapshot");
-
-    ViewSnapshot snapshot = std::move(view_change.snapshot()).value();
-    SnapshotMetadata metadata(snapshot.has_pending_writes(),
-                              snapshot.from_cache());
-
-    QuerySnapshot result(query.firestore(), query.query(), std::move(snapshot),
-                         std::move(metadata));
+    QuerySnapshot result = QuerySnapshotFromCache(
+        query, query_result.documents(), query_result.remote_keys());
 
     if (shared_callback) {
       user_executor_->Execute(
@@ -514,28 +681,101 @@ void FirestoreClient::GetDocumentsFromLocalCache(
   });
 }
 
+void FirestoreClient::ExplainQueryFromLocalCache(
+    const api::Query& query, api::QueryExplainCallback&& callback) {
+  VerifyNotTerminated();
+
+  worker_queue_->Enqueue([this, query, callback] {
+    FlushPendingWrites();
+    local::QueryPlan plan;
+    local_store_->ExecuteQuery(query.query(), /* use_previous_results= */ true,
+                               &plan);
+
+    if (callback) {
+      user_executor_->Execute([=] { callback(plan); });
+    }
+  });
+}
+
 void FirestoreClient::WriteMutations(std::vector<Mutation>&& mutations,
                                      StatusCallback callback) {
   VerifyNotTerminated();
 
+  ++unapplied_writes_;
   // TODO(c++14): move `mutations` into lambda (C++14).
   worker_queue_->Enqueue([this, mutations, callback]() mutable {
     if (mutations.empty()) {
+      --unapplied_writes_;
       if (callback) {
         user_executor_->Execute([=] { callback(Status::OK()); });
       }
     } else {
-      sync_engine_->WriteMutations(
-          std::move(mutations), [this, callback](Status error) {
-            // Dispatch the result back onto the user dispatch queue.
-            if (callback) {
-              user_executor_->Execute([=] { callback(std::move(error)); });
-            }
-          });
+      auto async_callback = [this, callback](Status error) {
+        // Dispatch the result back onto the user dispatch queue.
+        if (callback) {
+          user_executor_->Execute([=] { callback(std::move(error)); });
+        }
+      };
+      if (write_coalescing_window_.count() > 0) {
+        BufferWrite(std::move(mutations), std::move(async_callback));
+      } else {
+        sync_engine_->WriteMutations(std::move(mutations),
+                                     std::move(async_callback));
+        --unapplied_writes_;
+      }
     }
   });
 }
 
+void FirestoreClient::BufferWrite(std::vector<Mutation>&& mutations,
+                                  StatusCallback callback) {
+  pending_writes_.push_back(std::move(mutations));
+  pending_write_callbacks_.push_back(std::move(callback));
+
+  if (pending_writes_.size() >= kMaxCoalescedWrites) {
+    FlushPendingWrites();
+  } else if (pending_writes_.size() == 1) {
+    write_coalescing_callback_ = worker_queue_->EnqueueAfterDelay(
+        write_coalescing_window_, TimerId::WriteCoalescingDelay,
+        [this] { FlushPendingWrites(); });
+  }
+}
+
+void FirestoreClient::FlushPendingWrites() {
+  write_coalescing_callback_.Cancel();
+  if (pending_writes_.empty()) {
+    return;
+  }
+
+  std::vector<std::vector<Mutation>> batches = std::move(pending_writes_);
+  std::vector<StatusCallback> callbacks = std::move(pending_write_callbacks_);
+  pending_writes_.clear();
+  pending_write_callbacks_.clear();
+  int flushed = static_cast<int>(batches.size());
+  sync_engine_->WriteMutations(std::move(batches), std::move(callbacks));
+  unapplied_writes_ -= flushed;
+}
+
+void FirestoreClient::ResetSnapshotReader(const User& user) {
+  std::shared_ptr<local::LevelDbSnapshotReader> reader;
+  if (leveldb_persistence_) {
+    reader = leveldb_persistence_->CreateSnapshotReader(user);
+  }
+  std::lock_guard<std::mutex> lock(snapshot_reader_mutex_);
+  snapshot_reader_ = std::move(reader);
+}
+
+std::shared_ptr<local::LevelDbSnapshotReader>
+FirestoreClient::SnapshotReaderForRead() {
+  // Reads issued after a write must observe it, so they go through the worker
+  // queue (behind the write) until it has been written to the local store.
+  if (unapplied_writes_ > 0) {
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> lock(snapshot_reader_mutex_);
+  return snapshot_reader_;
+}
+
 void FirestoreClient::Transaction(int max_attempts,
                                   TransactionUpdateCallback update_callback,
                                   TransactionResultCallback result_callback) {
@@ -549,6 +789,7 @@ void FirestoreClient::Transaction(int max_attempts,
   };
 
   worker_queue_->Enqueue([this, max_attempts, update_callback, async_callback] {
+    FlushPendingWrites();
     sync_engine_->Transaction(max_attempts, worker_queue_,
                               std::move(update_callback),
                               std::move(async_callback));
@@ -575,6 +816,23 @@ void FirestoreClient::RunAggregateQuery(
   });
 }
 
+void FirestoreClient::RunAggregateQueryFromLocalCache(
+    const Query& query,
+    const std::vector<AggregateField>& aggregates,
+    api::AggregateQueryCallback&& result_callback) {
+  VerifyNotTerminated();
+
+  worker_queue_->Enqueue([this, query, aggregates, result_callback] {
+    FlushPendingWrites();
+    StatusOr<ObjectValue> result =
+        local_store_->RunAggregateQuery(query, aggregates);
+
+    if (result_callback) {
+      user_executor_->Execute([=] { result_callback(std::move(result)); });
+    }
+  });
+}
+
 void FirestoreClient::AddSnapshotsInSyncListener(
     const std::shared_ptr<EventListener<Empty>>& user_listener) {
   worker_queue_->Enqueue([this, user_listener] {
@@ -619,6 +877,7 @@ void FirestoreClient::LoadBundle(
   auto reader = std::make_shared<bundle::BundleReader>(
       std::move(bundle_serializer), std::move(bundle_data));
   worker_queue_->Enqueue([this, reader, result_task] {
+    FlushPendingWrites();
     sync_engine_->LoadBundle(std::move(reader), std::move(result_task));
   });
 }
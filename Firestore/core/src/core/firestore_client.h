@@ -17,7 +17,10 @@
 #ifndef FIRESTORE_CORE_SRC_CORE_FIRESTORE_CLIENT_H_
 #define FIRESTORE_CORE_SRC_CORE_FIRESTORE_CLIENT_H_
 
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
 #include <memory>
+#include <mutex>  // NOLINT(build/c++11)
 #include <string>
 #include <vector>
 
@@ -40,6 +43,8 @@ namespace firebase {
 namespace firestore {
 
 namespace local {
+class LevelDbPersistence;
+class LevelDbSnapshotReader;
 class LocalStore;
 class LruDelegate;
 class Persistence;
@@ -108,6 +113,13 @@ class FirestoreClient : public std::enable_shared_from_this<FirestoreClient> {
    */
   void WaitForPendingWrites(util::StatusCallback callback);
 
+  /**
+   * Passes a callback that is triggered once the index backfiller has indexed
+   * every document in the local cache, for all configured field indexes.
+   * Until then, the backfiller runs back to back on the worker queue.
+   */
+  void WaitForIndexBackfill(util::StatusCallback callback);
+
   /** Disables the network connection. Pending operations will not complete. */
   void DisableNetwork(util::StatusCallback callback);
 
@@ -137,6 +149,13 @@ class FirestoreClient : public std::enable_shared_from_this<FirestoreClient> {
   void GetDocumentsFromLocalCache(const api::Query& query,
                                   api::QuerySnapshotListener&& callback);
 
+  /**
+   * Executes the query against the local cache and passes a description of
+   * the query plan (estimated and actual costs) to the given callback.
+   */
+  void ExplainQueryFromLocalCache(const api::Query& query,
+                                  api::QueryExplainCallback&& callback);
+
   /**
    * Write mutations. callback will be notified when it's written to the
    * backend.
@@ -159,6 +178,15 @@ class FirestoreClient : public std::enable_shared_from_this<FirestoreClient> {
                          const std::vector<model::AggregateField>& aggregates,
                          api::AggregateQueryCallback&& result_callback);
 
+  /**
+   * Evaluates the aggregations over the results of the given query in the
+   * local cache, without contacting the backend.
+   */
+  void RunAggregateQueryFromLocalCache(
+      const Query& query,
+      const std::vector<model::AggregateField>& aggregates,
+      api::AggregateQueryCallback&& result_callback);
+
   /**
    * Adds a listener to be called when a snapshots-in-sync event fires.
    */
@@ -231,6 +259,36 @@ class FirestoreClient : public std::enable_shared_from_this<FirestoreClient> {
    */
   void ScheduleIndexBackfiller();
 
+  /**
+   * Runs the index backfiller, re-enqueueing itself until the backfiller is
+   * caught up, and then calls `callback`.
+   */
+  void RunIndexBackfillUntilCaughtUp(util::StatusCallback callback);
+
+  /**
+   * Buffers a write while write coalescing is enabled. The buffered writes are
+   * committed together when the coalescing window ends, when too many writes
+   * are buffered or before any operation that needs to observe them.
+   */
+  void BufferWrite(std::vector<model::Mutation>&& mutations,
+                   util::StatusCallback callback);
+
+  /** Commits all buffered writes in a single local transaction. */
+  void FlushPendingWrites();
+
+  /**
+   * Replaces the reader that serves cache-only reads off the worker queue with
+   * one for `user`. Only has an effect with LevelDB persistence.
+   */
+  void ResetSnapshotReader(const credentials::User& user);
+
+  /**
+   * Returns the reader to serve a cache-only read on `reader_executor_`, or
+   * nullptr if the read has to be served on the worker queue instead. May be
+   * called from any thread.
+   */
+  std::shared_ptr<local::LevelDbSnapshotReader> SnapshotReaderForRead();
+
   DatabaseInfo database_info_;
   std::shared_ptr<credentials::AppCheckCredentialsProvider>
       app_check_credentials_provider_;
@@ -262,6 +320,26 @@ class FirestoreClient : public std::enable_shared_from_this<FirestoreClient> {
   local::LruDelegate* _Nullable lru_delegate_;
   util::DelayedOperation lru_callback_;
   util::DelayedOperation backfiller_callback_;
+
+  /** How long writes are buffered for, or 0 if writes aren't coalesced. */
+  std::chrono::milliseconds write_coalescing_window_{0};
+  std::vector<std::vector<model::Mutation>> pending_writes_;
+  std::vector<util::StatusCallback> pending_write_callbacks_;
+  util::DelayedOperation write_coalescing_callback_;
+
+  /**
+   * The number of writes passed to `WriteMutations` that haven't been written
+   * to the local store yet. Incremented on the calling thread and decremented
+   * on the worker queue.
+   */
+  std::atomic<int> unapplied_writes_{0};
+
+  /** Set if persistence is backed by LevelDB, which supports snapshot reads. */
+  local::LevelDbPersistence* _Nullable leveldb_persistence_ = nullptr;
+  /** Serves cache-only reads concurrently, off the worker queue. */
+  std::unique_ptr<util::Executor> reader_executor_;
+  std::mutex snapshot_reader_mutex_;
+  std::shared_ptr<local::LevelDbSnapshotReader> snapshot_reader_;
 };
 
 }  // namespace core
@@ -16,6 +16,10 @@
 
 #include "Firestore/core/src/core/sync_engine.h"
 
+#include <algorithm>
+#include <thread>  // NOLINT(build/c++11)
+#include <unordered_map>
+
 #include "Firestore/core/include/firebase/firestore/firestore_errors.h"
 #include "Firestore/core/src/bundle/bundle_element.h"
 #include "Firestore/core/src/bundle/bundle_loader.h"
@@ -35,6 +39,8 @@
 #include "Firestore/core/src/model/mutable_document.h"
 #include "Firestore/core/src/model/mutation_batch_result.h"
 #include "Firestore/core/src/util/async_queue.h"
+#include "Firestore/core/src/util/background_queue.h"
+#include "Firestore/core/src/util/executor.h"
 #include "Firestore/core/src/util/log.h"
 #include "Firestore/core/src/util/status.h"
 #include "absl/strings/match.h"
@@ -66,11 +72,13 @@ using model::DocumentUpdateMap;
 using model::kBatchIdUnknown;
 using model::ListenSequenceNumber;
 using model::MutableDocument;
+using model::ResourcePath;
 using model::SnapshotVersion;
 using model::TargetId;
 using remote::RemoteEvent;
 using remote::TargetChange;
 using util::AsyncQueue;
+using util::Executor;
 using util::Status;
 using util::StatusCallback;
 
@@ -78,6 +86,19 @@ using util::StatusCallback;
 // them don't need real sequence numbers.
 const ListenSequenceNumber kIrrelevantSequenceNumber = -1;
 
+/**
+ * The default number of views below which the changes for a remote event are
+ * computed serially, since scheduling them on the executor costs more than it
+ * saves.
+ */
+const size_t kDefaultMinViewsForParallelComputation = 8;
+
+/**
+ * The number of bundle bytes whose documents are applied at a time, so that
+ * loading a large bundle does not hold all of its documents in memory.
+ */
+const uint64_t kBundleChunkByteSize = 8 * 1024 * 1024;
+
 bool ErrorIsInteresting(const Status& error) {
   bool missing_index =
       (error.code() == Error::kErrorFailedPrecondition &&
@@ -96,9 +117,21 @@ SyncEngine::SyncEngine(LocalStore* local_store,
       remote_store_(remote_store),
       current_user_(initial_user),
       target_id_generator_(TargetIdGenerator::SyncEngineTargetIdGenerator()),
-      max_concurrent_limbo_resolutions_(max_concurrent_limbo_resolutions) {
+      max_concurrent_limbo_resolutions_(max_concurrent_limbo_resolutions),
+      min_views_for_parallel_computation_(
+          kDefaultMinViewsForParallelComputation) {
+  auto hw_concurrency = std::thread::hardware_concurrency();
+  if (hw_concurrency == 0) {
+    // If the standard library doesn't know, guess something reasonable.
+    hw_concurrency = 4;
+  }
+  view_executor_ = Executor::CreateConcurrent(
+      "com.google.firebase.firestore.views", static_cast<int>(hw_concurrency));
 }
 
+// Out of line because of the unique_ptr to an incomplete type.
+SyncEngine::~SyncEngine() = default;
+
 void SyncEngine::AssertCallbackExists(absl::string_view source) {
   HARD_ASSERT(sync_engine_callback_,
               "Tried to call '%s' before callback was registered.", source);
@@ -154,6 +187,7 @@ ViewSnapshot SyncEngine::InitializeViewAndComputeSnapshot(
   auto query_view =
       std::make_shared<QueryView>(query, target_id, std::move(view));
   query_views_by_query_[query] = query_view;
+  query_view_router_.Add(query_view.get());
 
   queries_by_target_[target_id].push_back(query);
 
@@ -188,6 +222,7 @@ void SyncEngine::StopListeningAndReleaseTarget(
   HARD_ASSERT(query_view, "Trying to stop listening to a query not found");
 
   if (last_listen) {
+    query_view_router_.Remove(query_view.get());
     query_views_by_query_.erase(query);
   }
 
@@ -211,7 +246,11 @@ void SyncEngine::StopListeningAndReleaseTarget(
 
 void SyncEngine::RemoveAndCleanupTarget(TargetId target_id, Status status) {
   for (const Query& query : queries_by_target_.at(target_id)) {
-    query_views_by_query_.erase(query);
+    auto it = query_views_by_query_.find(query);
+    if (it != query_views_by_query_.end()) {
+      query_view_router_.Remove(it->second.get());
+      query_views_by_query_.erase(it);
+    }
     if (!status.ok()) {
       sync_engine_callback_->OnError(query, status);
       if (ErrorIsInteresting(status)) {
@@ -244,6 +283,34 @@ void SyncEngine::WriteMutations(std::vector<model::Mutation>&& mutations,
   remote_store_->FillWritePipeline();
 }
 
+void SyncEngine::WriteMutations(
+    std::vector<std::vector<model::Mutation>>&& batches,
+    std::vector<StatusCallback>&& callbacks) {
+  AssertCallbackExists("WriteMutations");
+  HARD_ASSERT(batches.size() == callbacks.size(),
+              "Expected one callback per batch, got %s batches and %s "
+              "callbacks",
+              batches.size(), callbacks.size());
+
+  std::vector<LocalWriteResult> results =
+      local_store_->WriteLocally(std::move(batches));
+
+  // Later batches see the effects of earlier ones, so the last change to each
+  // document wins.
+  DocumentMap changes;
+  auto& user_callbacks = mutation_callbacks_[current_user_];
+  for (size_t i = 0; i < results.size(); ++i) {
+    for (const auto& kv : results[i].changes()) {
+      changes = changes.insert(kv.first, kv.second);
+    }
+    user_callbacks.insert(
+        std::make_pair(results[i].batch_id(), std::move(callbacks[i])));
+  }
+
+  EmitNewSnapshotsAndNotifyLocalStore(changes, absl::nullopt);
+  remote_store_->FillWritePipeline();
+}
+
 void SyncEngine::RegisterPendingWritesCallback(StatusCallback callback) {
   if (!remote_store_->CanUseNetwork()) {
     LOG_DEBUG(
@@ -505,43 +572,99 @@ void SyncEngine::FailOutstandingPendingWriteCallbacks(
 void SyncEngine::EmitNewSnapshotsAndNotifyLocalStore(
     const DocumentMap& changes,
     const absl::optional<RemoteEvent>& maybe_remote_event) {
+  // Only update the views that the changes can affect: views that neither
+  // match a changed document nor have target changes would end up unchanged.
+  std::vector<PendingViewChange> pending_changes;
+  std::unordered_map<QueryView*, size_t> pending_index;
+  auto pending_change_for = [&](QueryView* query_view) -> PendingViewChange& {
+    auto inserted = pending_index.emplace(query_view, pending_changes.size());
+    if (inserted.second) {
+      pending_changes.emplace_back();
+      pending_changes.back().query_view = query_view;
+    }
+    return pending_changes[inserted.first->second];
+  };
+
+  for (const auto& kv : changes) {
+    query_view_router_.ForEachCandidateView(
+        kv.first, [&](QueryView* query_view) {
+          PendingViewChange& pending = pending_change_for(query_view);
+          pending.changes = pending.changes.insert(kv.first, kv.second);
+        });
+  }
+
+  for (TargetId target_id : targets_pending_reset_) {
+    query_view_router_.ForEachTargetView(target_id, pending_change_for);
+  }
+  targets_pending_reset_.clear();
+
+  if (maybe_remote_event.has_value()) {
+    const RemoteEvent& remote_event = maybe_remote_event.value();
+    for (const auto& entry : remote_event.target_changes()) {
+      query_view_router_.ForEachTargetView(
+          entry.first, [&](QueryView* query_view) {
+            pending_change_for(query_view).target_changes = entry.second;
+          });
+    }
+
+    for (const auto& entry : remote_event.target_mismatches()) {
+      query_view_router_.ForEachTargetView(
+          entry.first, [&](QueryView* query_view) {
+            pending_change_for(query_view).target_is_pending_reset = true;
+          });
+      targets_pending_reset_.push_back(entry.first);
+    }
+  }
+
+  // Computing and applying the changes only touches the view itself, so the
+  // views are independent of each other and can be updated in parallel.
+  // Everything that touches shared state (refills, limbo tracking and the
+  // snapshots) happens below on this queue, in the same order as before.
+  auto compute_view_change = [](PendingViewChange* pending) {
+    View& view = pending->query_view->view();
+    pending->doc_changes = view.ComputeDocumentChanges(pending->changes);
+    if (!pending->doc_changes->needs_refill()) {
+      pending->view_change =
+          view.ApplyChanges(*pending->doc_changes, pending->target_changes,
+                            pending->target_is_pending_reset);
+    }
+  };
+
+  if (pending_changes.size() >= min_views_for_parallel_computation_) {
+    util::BackgroundQueue tasks(view_executor_.get());
+    for (PendingViewChange& pending : pending_changes) {
+      PendingViewChange* pending_ptr = &pending;
+      tasks.Execute([compute_view_change, pending_ptr] {
+        compute_view_change(pending_ptr);
+      });
+    }
+    tasks.AwaitAll();
+  } else {
+    for (PendingViewChange& pending : pending_changes) {
+      compute_view_change(&pending);
+    }
+  }
+
   std::vector<ViewSnapshot> new_snapshots;
   std::vector<LocalViewChanges> document_changes_in_all_views;
 
-  for (const auto& entry : query_views_by_query_) {
-    const auto& query_view = entry.second;
-    View& view = query_view->view();
-    ViewDocumentChanges view_doc_changes = view.ComputeDocumentChanges(changes);
-    if (view_doc_changes.needs_refill()) {
+  for (PendingViewChange& pending : pending_changes) {
+    QueryView* query_view = pending.query_view;
+    if (!pending.view_change.has_value()) {
       // The query has a limit and some docs were removed/updated, so we need to
       // re-run the query against the local store to make sure we didn't lose
       // any good docs that had been past the limit.
+      View& view = query_view->view();
       QueryResult query_result = local_store_->ExecuteQuery(
           query_view->query(), /* use_previous_results= */ false);
-      view_doc_changes = view.ComputeDocumentChanges(query_result.documents(),
-                                                     view_doc_changes);
+      ViewDocumentChanges view_doc_changes = view.ComputeDocumentChanges(
+          query_result.documents(), pending.doc_changes);
+      pending.view_change =
+          view.ApplyChanges(view_doc_changes, pending.target_changes,
+                            pending.target_is_pending_reset);
     }
 
-    absl::optional<TargetChange> target_changes;
-    bool targetIsPendingReset = false;
-    if (maybe_remote_event.has_value()) {
-      const RemoteEvent& remote_event = maybe_remote_event.value();
-      auto changes_iter =
-          remote_event.target_changes().find(query_view->target_id());
-      if (changes_iter != remote_event.target_changes().end()) {
-        target_changes = changes_iter->second;
-      }
-
-      auto mismatches_iter =
-          remote_event.target_mismatches().find(query_view->target_id());
-      if (mismatches_iter != remote_event.target_mismatches().end()) {
-        targetIsPendingReset = true;
-      }
-    }
-
-    ViewChange view_change = view.ApplyChanges(view_doc_changes, target_changes,
-                                               targetIsPendingReset);
-
+    const ViewChange& view_change = *pending.view_change;
     UpdateTrackedLimboDocuments(view_change.limbo_changes(),
                                 query_view->target_id());
 
@@ -557,6 +680,68 @@ void SyncEngine::EmitNewSnapshotsAndNotifyLocalStore(
   local_store_->NotifyLocalViewChanges(document_changes_in_all_views);
 }
 
+void SyncEngine::QueryViewRouter::Add(QueryView* query_view) {
+  const Query& query = query_view->query();
+  if (query.IsCollectionGroupQuery()) {
+    views_by_collection_group_[*query.collection_group()].push_back(
+        query_view);
+  } else {
+    views_by_path_[query.path()].push_back(query_view);
+  }
+  views_by_target_[query_view->target_id()].push_back(query_view);
+}
+
+void SyncEngine::QueryViewRouter::Remove(QueryView* query_view) {
+  auto remove_from = [query_view](auto& index, const auto& index_key) {
+    auto it = index.find(index_key);
+    if (it == index.end()) return;
+    auto& views = it->second;
+    views.erase(std::remove(views.begin(), views.end(), query_view),
+                views.end());
+    if (views.empty()) {
+      index.erase(it);
+    }
+  };
+
+  const Query& query = query_view->query();
+  if (query.IsCollectionGroupQuery()) {
+    remove_from(views_by_collection_group_, *query.collection_group());
+  } else {
+    remove_from(views_by_path_, query.path());
+  }
+  remove_from(views_by_target_, query_view->target_id());
+}
+
+void SyncEngine::QueryViewRouter::ForEachCandidateView(
+    const DocumentKey& key,
+    const std::function<void(QueryView*)>& callback) const {
+  auto visit = [&callback](const auto& index, const auto& index_key) {
+    auto it = index.find(index_key);
+    if (it != index.end()) {
+      for (QueryView* query_view : it->second) {
+        callback(query_view);
+      }
+    }
+  };
+
+  // Every query is indexed under a single entry, so no view is visited twice.
+  const ResourcePath& path = key.path();
+  ResourcePath collection_path = path.PopLast();
+  visit(views_by_path_, path);
+  visit(views_by_path_, collection_path);
+  visit(views_by_collection_group_, collection_path.last_segment());
+}
+
+void SyncEngine::QueryViewRouter::ForEachTargetView(
+    TargetId target_id, const std::function<void(QueryView*)>& callback) const {
+  auto it = views_by_target_.find(target_id);
+  if (it != views_by_target_.end()) {
+    for (QueryView* query_view : it->second) {
+      callback(query_view);
+    }
+  }
+}
+
 void SyncEngine::UpdateTrackedLimboDocuments(
     const std::vector<LimboDocumentChange>& limbo_changes, TargetId target_id) {
   for (const LimboDocumentChange& limbo_change : limbo_changes) {
@@ -627,7 +812,7 @@ absl::optional<BundleLoader> SyncEngine::ReadIntoLoader(
     const bundle::BundleMetadata& metadata,
     bundle::BundleReader& reader,
     api::LoadBundleTask& result_task) {
-  BundleLoader loader(local_store_, metadata);
+  BundleLoader loader(local_store_, metadata, kBundleChunkByteSize);
   int64_t current_bytes_read = 0;
   // Breaks when either error happened, or when there is no more element to
   // read.
@@ -636,6 +821,7 @@ absl::optional<BundleLoader> SyncEngine::ReadIntoLoader(
     if (!reader.reader_status().ok()) {
       LOG_WARN("Failed to GetNextElement() from bundle with error %s",
                reader.reader_status().error_message());
+      loader.SaveAppliedDocumentKeys();
       result_task.SetError(reader.reader_status());
       return absl::nullopt;
     }
@@ -652,11 +838,17 @@ absl::optional<BundleLoader> SyncEngine::ReadIntoLoader(
     if (!maybe_progress.ok()) {
       LOG_WARN("Failed to AddElement() to bundle loader with error %s",
                maybe_progress.status().error_message());
+      loader.SaveAppliedDocumentKeys();
       result_task.SetError(maybe_progress.status());
       return absl::nullopt;
     }
 
     if (maybe_progress.ValueOrDie().has_value()) {
+      // Raise snapshots for a chunk of documents the loader has applied.
+      DocumentMap chunk_changes = loader.TakeChunkChanges();
+      if (!chunk_changes.empty()) {
+        EmitNewSnapshotsAndNotifyLocalStore(chunk_changes, absl::nullopt);
+      }
       result_task.UpdateProgress(maybe_progress.ConsumeValueOrDie().value());
     }
   }
@@ -692,6 +884,7 @@ void SyncEngine::LoadBundle(std::shared_ptr<bundle::BundleReader> reader,
   if (!changes.ok()) {
     LOG_WARN("Failed to ApplyChanges() for bundle elements with error %s",
              changes.status().error_message());
+    maybe_loader.value().SaveAppliedDocumentKeys();
     result_task->SetError(changes.status());
     return;
   }
@@ -19,6 +19,7 @@
 
 #include <cstddef>
 #include <deque>
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
@@ -34,6 +35,7 @@
 #include "Firestore/core/src/core/view.h"
 #include "Firestore/core/src/local/reference_set.h"
 #include "Firestore/core/src/model/model_fwd.h"
+#include "Firestore/core/src/model/resource_path.h"
 #include "Firestore/core/src/remote/remote_store.h"
 #include "Firestore/core/src/util/random_access_queue.h"
 #include "Firestore/core/src/util/status.h"
@@ -51,6 +53,10 @@ namespace model {
 class AggregateField;
 }  // namespace model
 
+namespace util {
+class Executor;
+}  // namespace util
+
 namespace core {
 
 class SyncEngineCallback;
@@ -120,6 +126,8 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
              const credentials::User& initial_user,
              size_t max_concurrent_limbo_resolutions);
 
+  ~SyncEngine() override;
+
   // Implements `QueryEventSource`.
   void SetCallback(SyncEngineCallback* callback) override {
     sync_engine_callback_ = callback;
@@ -141,6 +149,16 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
   void WriteMutations(std::vector<model::Mutation>&& mutations,
                       util::StatusCallback callback);
 
+  /**
+   * Like `WriteMutations`, but writes several batches at once: all batches are
+   * added to the mutation queue in a single local transaction and raise a
+   * single round of events. Each batch keeps its own batch ID and its callback
+   * (`callbacks[i]` for `batches[i]`) is called once that batch alone has been
+   * acked or rejected.
+   */
+  void WriteMutations(std::vector<std::vector<model::Mutation>>&& batches,
+                      std::vector<util::StatusCallback>&& callbacks);
+
   /**
    * Registers a user callback that is called when all pending mutations at the
    * moment of calling are acknowledged .
@@ -197,6 +215,14 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
     return enqueued_limbo_resolutions_.elements();
   }
 
+  /**
+   * Sets the number of active views from which the view changes for a single
+   * event are computed in parallel. For tests and benchmarks only.
+   */
+  void SetMinViewsForParallelComputation(size_t min_views) {
+    min_views_for_parallel_computation_ = min_views;
+  }
+
  private:
   /**
    * QueryView contains all of the info that SyncEngine needs to track for a
@@ -238,6 +264,56 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
     View view_;
   };
 
+  /**
+   * The changes to a single view that are computed while emitting new
+   * snapshots. `view_change` is empty if the view needs to be refilled from
+   * the local store.
+   */
+  struct PendingViewChange {
+    QueryView* query_view = nullptr;
+    /** The changed documents that could affect the view. */
+    model::DocumentMap changes;
+    absl::optional<remote::TargetChange> target_changes;
+    bool target_is_pending_reset = false;
+    absl::optional<ViewDocumentChanges> doc_changes;
+    absl::optional<ViewChange> view_change;
+  };
+
+  /**
+   * Indexes the active views by what they listen to, so that a change only
+   * has to be dispatched to the views it can affect.
+   *
+   * A document can only match queries whose path is the document's parent
+   * collection (or the document itself, for document queries), or collection
+   * group queries for the document's collection ID. Changes to a target only
+   * affect the views of that target.
+   */
+  class QueryViewRouter {
+   public:
+    void Add(QueryView* query_view);
+    void Remove(QueryView* query_view);
+
+    /**
+     * Calls `callback` with each view whose query may match the document
+     * identified by `key`.
+     */
+    void ForEachCandidateView(
+        const model::DocumentKey& key,
+        const std::function<void(QueryView*)>& callback) const;
+
+    /** Calls `callback` with each view of the target `target_id`. */
+    void ForEachTargetView(
+        model::TargetId target_id,
+        const std::function<void(QueryView*)>& callback) const;
+
+   private:
+    std::map<model::ResourcePath, std::vector<QueryView*>> views_by_path_;
+    std::unordered_map<std::string, std::vector<QueryView*>>
+        views_by_collection_group_;
+    std::unordered_map<model::TargetId, std::vector<QueryView*>>
+        views_by_target_;
+  };
+
   /** Tracks a limbo resolution. */
   class LimboResolution {
    public:
@@ -342,6 +418,16 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
   /** Queries mapped to Targets, indexed by target ID. */
   std::unordered_map<model::TargetId, std::vector<Query>> queries_by_target_;
 
+  /** The views in `query_views_by_query_`, indexed for dispatching changes. */
+  QueryViewRouter query_view_router_;
+
+  /**
+   * Targets whose views were last updated while pending a reset. The views
+   * didn't update their limbo documents and sync state then, so they are
+   * updated again on the next change even if nothing else affects them.
+   */
+  std::vector<model::TargetId> targets_pending_reset_;
+
   const size_t max_concurrent_limbo_resolutions_;
 
   /**
@@ -366,6 +452,10 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
 
   /** Used to track any documents that are currently in limbo. */
   local::ReferenceSet limbo_document_refs_;
+
+  /** Computes the changes of independent views in parallel. */
+  std::unique_ptr<util::Executor> view_executor_;
+  size_t min_views_for_parallel_computation_ = 0;
 };
 
 }  // namespace core
@@ -39,8 +39,12 @@ namespace bundle {
 class BundleSerializer;
 }  // namespace bundle
 
+namespace core {
+class Target;
+}  // namespace core
+
 namespace local {
-class LevelDbIndexManager;
+std::vector<core::Target> GetDnfSubTargets(const core::Target& target);
 }  // namespace local
 
 namespace core {
@@ -192,7 +196,7 @@ class Target {
   }
   friend class Query;
   friend class remote::Serializer;
-  friend class local::LevelDbIndexManager;
+  friend std::vector<Target> local::GetDnfSubTargets(const Target& target);
 
   /** Returns the field filters that target the given field path. */
   std::vector<FieldFilter> GetFieldFiltersForPath(
@@ -152,6 +152,22 @@ class ArraySortedMap : public SortedMapBase {
       : array_{SortedArray(entries, comparator)}, comparator_{comparator} {
   }
 
+  /**
+   * Creates an ArraySortedMap from a range of entries whose keys are already
+   * sorted and unique according to the comparator. The range can contain at
+   * most kFixedSize entries.
+   */
+  template <typename Iterator>
+  static ArraySortedMap FromSortedRange(Iterator first,
+                                        Iterator last,
+                                        const C& comparator = C()) {
+    if (first == last) {
+      return ArraySortedMap{comparator};
+    }
+    return ArraySortedMap{std::make_shared<const array_type>(first, last),
+                          comparator};
+  }
+
   /** Returns true if the map contains no elements. */
   bool empty() const {
     return size() == 0;
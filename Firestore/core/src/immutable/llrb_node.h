@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_IMMUTABLE_LLRB_NODE_H_
 #define FIRESTORE_CORE_SRC_IMMUTABLE_LLRB_NODE_H_
 
+#include <cstdint>
 #include <memory>
 #include <utility>
 
@@ -58,6 +59,13 @@ class LlrbNode : public SortedMapBase {
   LlrbNode() : LlrbNode{EmptyRep()} {
   }
 
+  /**
+   * Builds a tree from a random access range of entries whose keys are sorted
+   * in strictly ascending order, without any rebalancing.
+   */
+  template <typename Iterator>
+  static LlrbNode FromSortedRange(Iterator first, Iterator last);
+
   /** Returns true if this is an empty node--a leaf node in the tree. */
   bool empty() const {
     return size() == 0;
@@ -221,6 +229,11 @@ class LlrbNode : public SortedMapBase {
   template <typename Comparator>
   LlrbNode InnerErase(const K& key, const Comparator& comparator) const;
 
+  template <typename Iterator>
+  static LlrbNode BuildSubtree(Iterator first,
+                               uint64_t size,
+                               uint64_t max_size);
+
   void FixUp();
   void FixRootColor();
 
@@ -336,6 +349,71 @@ LlrbNode<K, V> LlrbNode<K, V>::InnerErase(const K& key,
   return n;
 }
 
+/**
+ * Builds the tree bottom-up as the 2-3 tree that the LLRB tree represents: all
+ * leaves are at the same depth, which is the largest depth at which `size`
+ * entries can fill every level. Each 2-3 node is a black LlrbNode; a 3-node
+ * additionally gets a red left child. The result therefore satisfies all
+ * invariants that `insert` and `erase` rely upon.
+ */
+template <typename K, typename V>
+template <typename Iterator>
+LlrbNode<K, V> LlrbNode<K, V>::FromSortedRange(Iterator first, Iterator last) {
+  auto size = static_cast<uint64_t>(last - first);
+
+  // A 2-3 tree of height h holds between 2^h - 1 (all 2-nodes) and 3^h - 1
+  // (all 3-nodes) entries. Pick the tallest h that can be filled, which also
+  // guarantees that `size` fits.
+  uint64_t min_size = 0;
+  uint64_t max_size = 0;
+  while (min_size * 2 + 1 <= size) {
+    min_size = min_size * 2 + 1;
+    max_size = max_size * 3 + 2;
+  }
+  return BuildSubtree(first, size, max_size);
+}
+
+/**
+ * Builds a black-rooted subtree out of `size` entries starting at `first`,
+ * whose 2-3 tree height is the one that holds at most `max_size` entries.
+ */
+template <typename K, typename V>
+template <typename Iterator>
+LlrbNode<K, V> LlrbNode<K, V>::BuildSubtree(Iterator first,
+                                            uint64_t size,
+                                            uint64_t max_size) {
+  if (size == 0) {
+    return LlrbNode{};
+  }
+
+  uint64_t max_child_size = (max_size + 1) / 3 - 1;
+  if (size - 1 <= 2 * max_child_size) {
+    // A 2-node: split the remaining entries evenly between both children.
+    uint64_t left_size = (size - 1) / 2;
+    uint64_t right_size = size - 1 - left_size;
+    LlrbNode left = BuildSubtree(first, left_size, max_child_size);
+    LlrbNode right =
+        BuildSubtree(first + left_size + 1, right_size, max_child_size);
+    return LlrbNode{Rep{value_type(first[left_size]), Color::Black,
+                        std::move(left), std::move(right)}};
+  }
+
+  // A 3-node: a black node with a red left child, with the remaining entries
+  // split evenly among the three grandchildren.
+  uint64_t remaining = size - 2;
+  uint64_t a_size = remaining / 3;
+  uint64_t b_size = (remaining - a_size) / 2;
+  uint64_t c_size = remaining - a_size - b_size;
+  LlrbNode a = BuildSubtree(first, a_size, max_child_size);
+  LlrbNode b = BuildSubtree(first + a_size + 1, b_size, max_child_size);
+  LlrbNode red_left{Rep{value_type(first[a_size]), Color::Red, std::move(a),
+                        std::move(b)}};
+  LlrbNode c =
+      BuildSubtree(first + a_size + b_size + 2, c_size, max_child_size);
+  return LlrbNode{Rep{value_type(first[a_size + b_size + 1]), Color::Black,
+                      std::move(red_left), std::move(c)}};
+}
+
 template <typename K, typename V>
 void LlrbNode<K, V>::FixUp() {
   set_size(left().size() + 1 + right().size());
@@ -17,7 +17,10 @@
 #ifndef FIRESTORE_CORE_SRC_IMMUTABLE_SORTED_MAP_H_
 #define FIRESTORE_CORE_SRC_IMMUTABLE_SORTED_MAP_H_
 
+#include <algorithm>
+#include <iterator>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/immutable/array_sorted_map.h"
 #include "Firestore/core/src/immutable/keys_view.h"
@@ -73,6 +76,24 @@ class SortedMap : public SortedMapBase {
     }
   }
 
+  /**
+   * Creates a SortedMap from a random access range of entries whose keys are
+   * already sorted and unique according to the comparator. This is O(n),
+   * whereas inserting the entries one at a time is O(n log n).
+   */
+  template <typename Iterator>
+  static SortedMap FromSortedRange(Iterator first,
+                                   Iterator last,
+                                   const C& comparator = {}) {
+    if (static_cast<size_type>(last - first) <= kFixedSize) {
+      return SortedMap{array_type::FromSortedRange(first, last, comparator)};
+    } else {
+      return SortedMap{tree_type::FromSortedRange(first, last, comparator)};
+    }
+  }
+
+  class Builder;
+
   SortedMap(const SortedMap& other) : tag_{other.tag_} {
     switch (tag_) {
       case Tag::Array:
@@ -387,6 +408,95 @@ class SortedMap : public SortedMapBase {
   };
 };
 
+/**
+ * Collects entries in a mutable buffer and creates a SortedMap out of all of
+ * them at once. Prefer this over repeated calls to `SortedMap::insert` when
+ * adding many entries: each `insert` copies O(log n) nodes of the persistent
+ * tree, while `Build` allocates every node exactly once.
+ *
+ * Entries can be added in any order; `Build` only sorts them if necessary. If
+ * a key is added more than once, the value added last wins.
+ */
+template <typename K, typename V, typename C>
+class SortedMap<K, V, C>::Builder {
+ public:
+  explicit Builder(const C& comparator = {}) : comparator_{comparator} {
+  }
+
+  /**
+   * Creates a Builder whose entries start out as the contents of `base`.
+   * Values added to the builder replace the values in `base`.
+   */
+  explicit Builder(const SortedMap& base)
+      : comparator_{base.comparator()}, base_size_{base.size()} {
+    entries_.reserve(base.size());
+    entries_.insert(entries_.end(), base.begin(), base.end());
+  }
+
+  /** Reserves room for `size` additional entries. */
+  void reserve(size_t size) {
+    entries_.reserve(entries_.size() + size);
+  }
+
+  void insert(const K& key, const V& value) {
+    entries_.emplace_back(key, value);
+  }
+
+  void insert(K&& key, V&& value) {
+    entries_.emplace_back(std::move(key), std::move(value));
+  }
+
+  /** Returns the number of entries added so far, including duplicates. */
+  size_t size() const {
+    return entries_.size();
+  }
+
+  /**
+   * Creates a SortedMap containing all entries added to this builder and
+   * leaves the builder empty.
+   */
+  SortedMap Build() {
+    auto less = [this](const value_type& lhs, const value_type& rhs) {
+      return util::Ascending(comparator_.Compare(lhs.first, rhs.first));
+    };
+
+    // The entries of `base_` are already sorted, so only the added entries
+    // may need sorting before the two sequences are merged. Both steps are
+    // stable, so later entries follow earlier ones with the same key.
+    auto added = entries_.begin() + base_size_;
+    if (!std::is_sorted(added, entries_.end(), less)) {
+      std::stable_sort(added, entries_.end(), less);
+    }
+    std::inplace_merge(entries_.begin(), added, entries_.end(), less);
+
+    // Keep only the last entry of every run of equal keys.
+    auto out = entries_.begin();
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+      auto next = it + 1;
+      if (next != entries_.end() && !less(*it, *next)) {
+        continue;
+      }
+      if (out != it) {
+        *out = std::move(*it);
+      }
+      ++out;
+    }
+    entries_.erase(out, entries_.end());
+
+    SortedMap result =
+        FromSortedRange(std::make_move_iterator(entries_.begin()),
+                        std::make_move_iterator(entries_.end()), comparator_);
+    entries_.clear();
+    base_size_ = 0;
+    return result;
+  }
+
+ private:
+  C comparator_;
+  std::vector<value_type> entries_;
+  size_type base_size_ = 0;
+};
+
 }  // namespace immutable
 }  // namespace firestore
 }  // namespace firebase
@@ -19,6 +19,7 @@
 
 #include <algorithm>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/immutable/sorted_container.h"
 #include "Firestore/core/src/immutable/sorted_map.h"
@@ -58,6 +59,25 @@ class SortedSet : public SortedContainer {
     }
   }
 
+  /**
+   * Creates a SortedSet from a random access range of keys that are already
+   * sorted and unique according to the comparator.
+   */
+  template <typename Iterator>
+  static SortedSet FromSortedRange(Iterator first,
+                                   Iterator last,
+                                   const C& comparator = C()) {
+    std::vector<typename map_type::value_type> entries;
+    entries.reserve(static_cast<size_t>(last - first));
+    for (; first != last; ++first) {
+      entries.emplace_back(*first, util::Empty{});
+    }
+    return SortedSet{map_type::FromSortedRange(entries.begin(), entries.end(),
+                                               comparator)};
+  }
+
+  class Builder;
+
   bool empty() const {
     return map_.empty();
   }
@@ -84,6 +104,23 @@ class SortedSet : public SortedContainer {
       other_ptr = this;
     }
 
+    // Inserting costs O(log n) node copies per key, while rebuilding the set
+    // allocates every node once. Only rebuild if that is cheaper.
+    size_t depth = 0;
+    for (size_type n = result_ptr->size(); n > 0; n >>= 1) {
+      ++depth;
+    }
+    size_t insert_cost = other_ptr->size() * depth;
+    size_t rebuild_cost = size_t{result_ptr->size()} + other_ptr->size();
+    if (insert_cost > rebuild_cost) {
+      Builder builder{*result_ptr};
+      builder.reserve(other_ptr->size());
+      for (const auto& k : *other_ptr) {
+        builder.insert(k);
+      }
+      return builder.Build();
+    }
+
     auto result = *result_ptr;
     for (const auto& k : *other_ptr) {
       result = result.insert(k);
@@ -143,11 +180,12 @@ class SortedSet : public SortedContainer {
 
   template <typename MapType>
   static SortedSet FromKeysOf(const MapType& map) {
-    SortedSet result;
+    Builder builder;
+    builder.reserve(map.size());
     for (const K& key : map.keys()) {
-      result = result.insert(key);
+      builder.insert(key);
     }
-    return result;
+    return builder.Build();
   }
 
   friend bool operator==(const SortedSet& lhs, const SortedSet& rhs) {
@@ -165,6 +203,50 @@ class SortedSet : public SortedContainer {
   map_type map_;
 };
 
+/**
+ * Collects keys in a mutable buffer and creates a SortedSet out of all of them
+ * at once. See `SortedMap::Builder`.
+ */
+template <typename K, typename C>
+class SortedSet<K, C>::Builder {
+ public:
+  explicit Builder(const C& comparator = C()) : builder_{comparator} {
+  }
+
+  /** Creates a Builder whose keys start out as the contents of `base`. */
+  explicit Builder(const SortedSet& base) : builder_{base.map_} {
+  }
+
+  /** Reserves room for `size` additional keys. */
+  void reserve(size_t size) {
+    builder_.reserve(size);
+  }
+
+  void insert(const K& key) {
+    builder_.insert(key, {});
+  }
+
+  void insert(K&& key) {
+    builder_.insert(std::move(key), {});
+  }
+
+  /** Returns the number of keys added so far, including duplicates. */
+  size_t size() const {
+    return builder_.size();
+  }
+
+  /**
+   * Creates a SortedSet containing all keys added to this builder and leaves
+   * the builder empty.
+   */
+  SortedSet Build() {
+    return SortedSet{builder_.Build()};
+  }
+
+ private:
+  typename map_type::Builder builder_;
+};
+
 }  // namespace immutable
 }  // namespace firestore
 }  // namespace firebase
@@ -74,6 +74,20 @@ class TreeSortedMap : public SortedMapBase, private util::CompressedMember<C> {
     return TreeSortedMap{std::move(node), comparator};
   }
 
+  /**
+   * Creates a TreeSortedMap from a random access range of entries whose keys
+   * are already sorted and unique according to the comparator.
+   *
+   * Unlike `Create`, this builds the balanced tree directly in O(n) time,
+   * allocating each node exactly once.
+   */
+  template <typename Iterator>
+  static TreeSortedMap FromSortedRange(Iterator first,
+                                       Iterator last,
+                                       const C& comparator = {}) {
+    return TreeSortedMap{node_type::FromSortedRange(first, last), comparator};
+  }
+
   /** Returns true if the map contains no elements. */
   bool empty() const {
     return root_.empty();
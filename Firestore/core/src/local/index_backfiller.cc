@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <algorithm>
+#include <limits>
 #include <string>
 #include <unordered_set>
 #include <utility>
@@ -34,35 +35,126 @@ namespace {
 
 using model::IndexOffset;
 
+using Clock = std::chrono::steady_clock;
+
+/** The number of documents requested by the first batch. */
+const size_t kInitialBatchSize = 50;
+
+/** Bounds for the adaptive batch size. */
+const size_t kMinBatchSize = 10;
+const size_t kMaxBatchSize = 2000;
+
+/**
+ * The default time a single call to `WriteIndexEntries` may spend indexing.
+ * Since the backfiller runs on the worker queue, this bounds the latency it
+ * adds to user operations.
+ */
+const auto kDefaultTimeBudget = std::chrono::milliseconds(100);
+
 /**
- * The maximum number of documents to process each time Backfill() is called.
+ * Batches are sized to take about this fraction of the time budget, so that
+ * the last batch of a run overshoots the budget by at most that much.
  */
-static const size_t kMaxDocumentsToProcess = 50;
+const double kBatchFractionOfTimeBudget = 0.25;
+
+/**
+ * The weight of the most recent batch in the smoothed throughput estimate.
+ */
+const double kThroughputSmoothing = 0.5;
 
 }  // namespace
 
-IndexBackfiller::IndexBackfiller() {
-  max_documents_to_process_ = kMaxDocumentsToProcess;
+IndexBackfiller::IndexBackfiller()
+    : max_documents_to_process_(std::numeric_limits<size_t>::max()),
+      time_budget_(kDefaultTimeBudget) {
+  progress_.batch_size = kInitialBatchSize;
 }
 
 size_t IndexBackfiller::WriteIndexEntries(const LocalStore* local_store) {
   IndexManager* index_manager = local_store->index_manager();
-  std::unordered_set<std::string> processed_collection_groups;
-  size_t documents_remaining = max_documents_to_process_;
-  while (documents_remaining > 0) {
-    const auto collection_group =
-        index_manager->GetNextCollectionGroupToUpdate();
-    if (!collection_group ||
-        (processed_collection_groups.find(collection_group.value()) !=
-         processed_collection_groups.end())) {
-      break;
+  Clock::time_point deadline = Clock::now() + time_budget_;
+
+  size_t documents_processed = 0;
+  size_t collection_groups_processed = 0;
+  bool caught_up = false;
+  bool out_of_budget = false;
+  while (!caught_up && !out_of_budget) {
+    // Visit each collection group at most once per round. A round in which no
+    // collection group filled its batch leaves nothing to index.
+    std::unordered_set<std::string> processed_collection_groups;
+    bool has_more = false;
+    while (true) {
+      const auto collection_group =
+          index_manager->GetNextCollectionGroupToUpdate();
+      if (!collection_group ||
+          (processed_collection_groups.find(collection_group.value()) !=
+           processed_collection_groups.end())) {
+        caught_up = !has_more;
+        break;
+      }
+
+      size_t limit = std::min(progress_.batch_size,
+                              max_documents_to_process_ - documents_processed);
+      LOG_DEBUG("Processing collection: %s", collection_group.value());
+      Clock::time_point batch_start = Clock::now();
+      size_t processed = WriteEntriesForCollectionGroup(
+          local_store, collection_group.value(), limit);
+      RecordBatch(processed, Clock::now() - batch_start);
+
+      documents_processed += processed;
+      processed_collection_groups.insert(collection_group.value());
+      ++collection_groups_processed;
+      if (processed >= limit) {
+        has_more = true;
+      }
+
+      if (documents_processed >= max_documents_to_process_ ||
+          Clock::now() >= deadline) {
+        out_of_budget = true;
+        break;
+      }
     }
-    LOG_DEBUG("Processing collection: %s", collection_group.value());
-    documents_remaining -= WriteEntriesForCollectionGroup(
-        local_store, collection_group.value(), documents_remaining);
-    processed_collection_groups.insert(collection_group.value());
   }
-  return max_documents_to_process_ - documents_remaining;
+
+  progress_.documents_processed_in_last_run = documents_processed;
+  progress_.total_documents_processed += documents_processed;
+  progress_.collection_groups_processed_in_last_run =
+      collection_groups_processed;
+  progress_.caught_up = caught_up;
+  LOG_DEBUG(
+      "Index backfill processed %s documents in %s collection groups "
+      "(%s total, next batch size %s, caught up: %s)",
+      documents_processed, collection_groups_processed,
+      progress_.total_documents_processed, progress_.batch_size, caught_up);
+
+  return documents_processed;
+}
+
+void IndexBackfiller::RecordBatch(size_t documents_processed,
+                                  Clock::duration elapsed) {
+  double elapsed_ms =
+      std::chrono::duration<double, std::milli>(elapsed).count();
+  if (documents_processed == 0 || elapsed_ms <= 0) {
+    // Nothing was indexed, so this batch says nothing about throughput.
+    return;
+  }
+
+  double throughput = documents_processed / elapsed_ms;
+  if (progress_.documents_per_millisecond == 0) {
+    progress_.documents_per_millisecond = throughput;
+  } else {
+    progress_.documents_per_millisecond =
+        kThroughputSmoothing * throughput +
+        (1 - kThroughputSmoothing) * progress_.documents_per_millisecond;
+  }
+
+  double target_batch_size = progress_.documents_per_millisecond *
+                             static_cast<double>(time_budget_.count()) *
+                             kBatchFractionOfTimeBudget;
+  progress_.batch_size = static_cast<size_t>(
+      std::max(static_cast<double>(kMinBatchSize),
+               std::min(static_cast<double>(kMaxBatchSize),
+                        target_batch_size)));
 }
 
 size_t IndexBackfiller::WriteEntriesForCollectionGroup(
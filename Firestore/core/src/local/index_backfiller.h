@@ -15,6 +15,7 @@
 #ifndef FIRESTORE_CORE_SRC_LOCAL_INDEX_BACKFILLER_H_
 #define FIRESTORE_CORE_SRC_LOCAL_INDEX_BACKFILLER_H_
 
+#include <chrono>  // NOLINT(build/c++11)
 #include <cstddef>
 #include <string>
 
@@ -35,17 +36,62 @@ class LocalStore;
 class LocalWriteResult;
 class IndexManager;
 
-/** Implements the steps for backfilling indexes. */
+/** Describes the work done by the IndexBackfiller. */
+struct IndexBackfillProgress {
+  /** The number of documents indexed by the most recent run. */
+  size_t documents_processed_in_last_run = 0;
+
+  /** The number of documents indexed since the backfiller was created. */
+  size_t total_documents_processed = 0;
+
+  /** The number of collection groups visited by the most recent run. */
+  size_t collection_groups_processed_in_last_run = 0;
+
+  /**
+   * The observed indexing throughput, smoothed across batches, or 0 if it
+   * hasn't been measured yet.
+   */
+  double documents_per_millisecond = 0;
+
+  /** The number of documents the next batch will request. */
+  size_t batch_size = 0;
+
+  /**
+   * Whether the most recent run found every collection group caught up, i.e.
+   * there were no more documents left to index.
+   */
+  bool caught_up = false;
+};
+
+/**
+ * Implements the steps for backfilling indexes.
+ *
+ * Each call to `WriteIndexEntries` indexes documents for up to a fixed time
+ * budget. Collection groups are visited round-robin in batches, and the size
+ * of a batch adapts to the throughput observed in previous batches so that a
+ * run overshoots its budget by no more than a fraction of it.
+ */
 class IndexBackfiller {
  public:
   IndexBackfiller();
 
   /**
-   * Writes index entries until the cap is reached. Returns the number of
-   * documents processed.
+   * Writes index entries until the time budget or the document cap is
+   * reached, or until all collection groups are caught up. Returns the number
+   * of documents processed.
    */
   size_t WriteIndexEntries(const LocalStore* local_store);
 
+  /** Returns the progress made by the backfiller so far. */
+  const IndexBackfillProgress& progress() const {
+    return progress_;
+  }
+
+  /** Sets the time each call to `WriteIndexEntries` may spend indexing. */
+  void SetTimeBudget(std::chrono::milliseconds budget) {
+    time_budget_ = budget;
+  }
+
  private:
   friend class IndexBackfillerTest;
   friend class LocalStoreTestBase;
@@ -63,12 +109,21 @@ class IndexBackfiller {
   model::IndexOffset GetNewOffset(const model::IndexOffset& existing_offset,
                                   const LocalWriteResult& lookup_result) const;
 
+  /**
+   * Folds the throughput of a batch into the running estimate and resizes
+   * the next batch accordingly.
+   */
+  void RecordBatch(size_t documents_processed,
+                   std::chrono::steady_clock::duration elapsed);
+
   // For testing
   void SetMaxDocumentsToProcess(size_t new_max) {
     max_documents_to_process_ = new_max;
   }
 
   size_t max_documents_to_process_;
+  std::chrono::milliseconds time_budget_;
+  IndexBackfillProgress progress_;
 };
 
 }  // namespace local
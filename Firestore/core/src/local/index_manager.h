@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_LOCAL_INDEX_MANAGER_H_
 #define FIRESTORE_CORE_SRC_LOCAL_INDEX_MANAGER_H_
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -39,6 +40,24 @@ class ResourcePath;
 
 namespace local {
 
+/**
+ * Iterates over the keys of the documents in one range of a field index, in
+ * the order of the index.
+ */
+class IndexCursor {
+ public:
+  virtual ~IndexCursor() = default;
+
+  /** Returns whether the cursor is positioned at an entry in its range. */
+  virtual bool Valid() const = 0;
+
+  /** Returns the key of the document at the current entry. */
+  virtual const model::DocumentKey& key() const = 0;
+
+  /** Advances the cursor to the next entry. */
+  virtual void Next() = 0;
+};
+
 /**
  * Represents a set of indexes that are used to execute queries efficiently.
  *
@@ -129,8 +148,11 @@ class IndexManager {
   virtual model::IndexOffset GetMinOffset(
       const std::string& collection_group) const = 0;
 
-  /** Returns the type of index (if any) that can be used to serve the given
-   * target */
+  /**
+   * Returns the type of index (if any) that can be used to serve the given
+   * target. An OR target with a limit is FULL when all of its sub-targets
+   * are, since `ScanDocumentsMatchingTarget` can merge their scans in order.
+   */
   virtual IndexType GetIndexType(const core::Target& target) = 0;
 
   /**
@@ -140,6 +162,34 @@ class IndexManager {
   virtual absl::optional<std::vector<model::DocumentKey>>
   GetDocumentsMatchingTarget(const core::Target& target) = 0;
 
+  /**
+   * Like `GetDocumentsMatchingTarget`, but returns the matching documents
+   * lazily: one cursor per index range scanned for `target`, each producing
+   * keys in index order. Unlike `GetDocumentsMatchingTarget`, neither applies
+   * the target's limit, and a document can be produced by several cursors.
+   *
+   * Returns `nullopt` if the target is not fully indexed or if its indexes
+   * don't produce keys in the order of the target.
+   *
+   * The cursors read from the current transaction and must not be used after
+   * it ends.
+   */
+  virtual absl::optional<std::vector<std::unique_ptr<IndexCursor>>>
+  ScanDocumentsMatchingTarget(const core::Target& target) = 0;
+
+  /**
+   * Returns the number of documents that matched `target` the last time it was
+   * served by `GetDocumentsMatchingTarget()`, or `nullopt` if it has not been
+   * served from an index since the index configuration last changed. Used as
+   * a statistic for query planning.
+   *
+   * Counts are only recorded for targets without a limit, since a limit caps
+   * the number of documents served. Implementations only keep the counts of
+   * the most recently used targets.
+   */
+  virtual absl::optional<size_t> GetIndexMatchCount(
+      const core::Target& target) const = 0;
+
   /**
    * Returns the next collection group to update. Returns `nullopt` if no
    * group exists.
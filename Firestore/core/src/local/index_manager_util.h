@@ -0,0 +1,104 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_LOCAL_INDEX_MANAGER_UTIL_H_
+#define FIRESTORE_CORE_SRC_LOCAL_INDEX_MANAGER_UTIL_H_
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/core/target.h"
+#include "Firestore/core/src/index/index_entry.h"
+#include "Firestore/core/src/model/field_index.h"
+#include "Firestore/core/src/model/model_fwd.h"
+#include "absl/types/optional.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+// Storage-independent helpers shared by the LevelDB and in-memory field index
+// implementations.
+
+/**
+ * A range of index entries to scan. Both bounds have empty document keys:
+ * entries whose array and directional values sort at or after `lower` and
+ * before `upper` are part of the range.
+ */
+struct IndexEntryRange {
+  index::IndexEntry lower;
+  index::IndexEntry upper;
+};
+
+/**
+ * Returns the sub-targets of `target`, one for each term of its disjunctive
+ * normal form (DNF).
+ */
+std::vector<core::Target> GetDnfSubTargets(const core::Target& target);
+
+/**
+ * Returns the index among `indexes` that serves `target` with the most
+ * segments, or `nullopt` if none of them can serve it.
+ */
+absl::optional<model::FieldIndex> SelectFieldIndex(
+    const core::Target& target, std::vector<model::FieldIndex> indexes);
+
+/**
+ * Returns the offset that all of `indexes` have been backfilled to, combined
+ * with the largest batch id any of them has seen. `indexes` must not be empty.
+ */
+model::IndexOffset GetLeastRecentOffset(
+    const std::vector<model::FieldIndex>& indexes);
+
+/**
+ * Returns whether scanning `index` yields the documents of `sub_target` in
+ * the order of the sub-target.
+ *
+ * Entries with equal values are ordered by their document key, encoded in the
+ * direction of the index's last segment. When that segment serves an equality
+ * its direction is arbitrary, and may differ from the one of the target.
+ */
+bool IsScannedInTargetOrder(const model::FieldIndex& index,
+                            const core::Target& sub_target);
+
+/**
+ * Returns the sorted, non-overlapping ranges of entries of `index` that
+ * contain the documents matching `sub_target`.
+ */
+std::vector<IndexEntryRange> GetIndexEntryRanges(
+    const core::Target& sub_target, const model::FieldIndex& index);
+
+/**
+ * Returns the entries of `index` for `document`. Documents that lack one of
+ * the indexed fields have no entries.
+ */
+std::set<index::IndexEntry> ComputeIndexEntries(
+    const model::Document& document, const model::FieldIndex& index);
+
+/**
+ * Returns an encoded form of the document key that sorts based on the key
+ * ordering of the field index.
+ */
+std::string EncodeDirectionalKey(const model::DatabaseId& database_id,
+                                 const model::FieldIndex& index,
+                                 const model::DocumentKey& key);
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_LOCAL_INDEX_MANAGER_UTIL_H_
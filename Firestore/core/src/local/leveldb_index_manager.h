@@ -28,6 +28,7 @@
 #include "Firestore/core/src/local/leveldb_key.h"
 #include "Firestore/core/src/local/memory_index_manager.h"
 #include "Firestore/core/src/model/field_index.h"
+#include "Firestore/core/src/util/lru_cache.h"
 
 namespace firebase {
 namespace firestore {
@@ -83,6 +84,12 @@ class LevelDbIndexManager : public IndexManager {
   absl::optional<std::vector<model::DocumentKey>> GetDocumentsMatchingTarget(
       const core::Target& target) override;
 
+  absl::optional<std::vector<std::unique_ptr<IndexCursor>>>
+  ScanDocumentsMatchingTarget(const core::Target& target) override;
+
+  absl::optional<size_t> GetIndexMatchCount(
+      const core::Target& target) const override;
+
   absl::optional<std::string> GetNextCollectionGroupToUpdate() const override;
 
   void UpdateCollectionGroup(const std::string& collection_group,
@@ -114,10 +121,6 @@ class LevelDbIndexManager : public IndexManager {
   std::set<index::IndexEntry> GetExistingIndexEntries(
       const model::DocumentKey& key, const model::FieldIndex& index);
 
-  /** Creates the index entries for the given document. */
-  std::set<index::IndexEntry> ComputeIndexEntries(
-      const model::Document& document, const model::FieldIndex& index);
-
   /**
    * Updates the index entries for the provided document by deleting entries
    * that are no longer referenced in `new_entries` and adding all newly added
@@ -136,71 +139,15 @@ class LevelDbIndexManager : public IndexManager {
                         const model::FieldIndex& index,
                         const index::IndexEntry& entry);
 
-  /**
-   * Returns the byte encoded form of the directional values in the field index.
-   * Returns `nullopt` if the document does not have all fields specified in the
-   * index.
-   */
-  absl::optional<std::string> EncodeDirectionalElements(
-      const model::FieldIndex& index, const model::Document& document);
-
-  /** Encodes a single value to the ascending index format. */
-  std::string EncodeSingleElement(const _google_firestore_v1_Value& value);
-
-  /**
-   * Returns an encoded form of the document key that sorts based on the key
-   * ordering of the field index.
-   */
-  std::string EncodedDirectionalKey(const model::FieldIndex& index,
-                                    const model::DocumentKey& key);
-
   std::vector<core::Target> GetSubTargets(const core::Target& target);
 
-  model::IndexOffset GetMinOffset(
-      const std::vector<model::FieldIndex>& indexes) const;
-
   /**
-   * Encodes the given bounds according to the specification in `target`. For IN
-   * queries, a list of possible values is returned.
-   */
-  std::vector<std::string> EncodeBound(
-      const model::FieldIndex& index,
-      const core::Target& target,
-      const core::IndexBoundValues& bound_values);
-
-  /**
-   * Encodes the given field values according to the specification in `target`.
-   * For IN queries, a list of possible values is returned.
-   */
-  std::vector<std::string> EncodeValues(const model::FieldIndex& index,
-                                        const core::Target& target,
-                                        core::IndexedValues values);
-
-  /**
-   * Constructs a vector of LevelDb key ranges that unions all bounds.
-   *
-   * These ranges represent the sections in the index entry table that contain
-   * the given bounds.
-   */
-  std::vector<IndexRange> GenerateIndexRanges(
-      int32_t index_id,
-      core::IndexedValues array_values,
-      const std::vector<std::string>& lower_bounds,
-      bool lower_bounds_inclusive,
-      const std::vector<std::string>& upper_bounds,
-      bool upper_bounds_inclusive,
-      std::vector<std::string> not_in_values);
-
-  /**
-   * Returns a new set of LeveDb ranges that splits the existing range and
-   * excludes any values that match the `not_in_values` from these ranges. As an
-   * example,
-   * '[foo > 2 && foo != 3]` becomes  `[foo > 2 && < 3, foo > 3]`.
+   * Returns the index ranges that have to be scanned to serve `target`, in
+   * the order of its sub-targets, or `nullopt` if some sub-target has no
+   * index.
    */
-  std::vector<IndexRange> CreateRange(
-      const index::IndexEntry& lower_bound,
-      const index::IndexEntry& upper_bound,
-      std::vector<index::IndexEntry> not_in_bounds) const;
+  absl::optional<std::vector<IndexRange>> GetIndexRanges(
+      const core::Target& target);
 
   /**
    * Returns an index that can be used to serve the provided target. Returns
@@ -221,6 +168,13 @@ class LevelDbIndexManager : public IndexManager {
   std::unordered_map<core::Target, std::vector<core::Target>>
       target_to_dnf_subtargets_;
 
+  /**
+   * The number of documents each unlimited target matched the last time it was
+   * served from an index, for the most recently used targets. Cleared whenever
+   * the index configuration changes.
+   */
+  mutable util::LruCache<core::Target, size_t> index_match_counts_;
+
   /**
    * An in-memory copy of the index entries we've already written since the SDK
    * launched. Used to avoid re-writing the same entry repeatedly.
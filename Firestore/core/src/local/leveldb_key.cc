@@ -42,15 +42,20 @@ const char* kVersionGlobalTable = "version";
 const char* kGlobalsTable = "globals";
 const char* kMutationsTable = "mutation";
 const char* kDocumentMutationsTable = "document_mutation";
+const char* kDocumentMutationsCollectionIndexTable =
+    "document_mutation_collection_index";
 const char* kMutationQueuesTable = "mutation_queue";
 const char* kTargetGlobalTable = "target_global";
 const char* kTargetsTable = "target";
 const char* kQueryTargetsTable = "query_target";
+const char* kTargetFingerprintsTable = "target_fingerprint";
 const char* kTargetDocumentsTable = "target_document";
 const char* kDocumentTargetsTable = "document_target";
 const char* kRemoteDocumentsTable = "remote_document";
 const char* kCollectionParentsTable = "collection_parent";
 const char* kRemoteDocumentReadTimeTable = "remote_document_read_time";
+const char* kRemoteDocumentCollectionGroupReadTimeTable =
+    "remote_document_collection_group_read_time";
 const char* kBundlesTable = "bundles";
 const char* kNamedQueriesTable = "named_queries";
 const char* kIndexConfigurationTable = "index_configuration";
@@ -165,6 +170,9 @@ enum ComponentLabel {
    */
   GlobalName = 26,
 
+  /** A component containing the fingerprint of a target's canonical id. */
+  TargetFingerprint = 27,
+
   /**
    * A path segment describes just a single segment in a resource path. Path
    * segments that occur sequentially in a key represent successive segments in
@@ -283,6 +291,11 @@ class Reader {
     return ReadLabeledString(ComponentLabel::DataMigrationName);
   }
 
+  uint64_t ReadTargetFingerprint() {
+    return static_cast<uint64_t>(
+        ReadLabeledInt64(ComponentLabel::TargetFingerprint));
+  }
+
   /**
    * Reads a snapshot version, encoded as a component label and a pair of
    * seconds (int64) and nanoseconds (int32).
@@ -697,6 +710,12 @@ std::string Reader::Describe() {
         absl::StrAppend(&description,
                         " data_migration_name=", std::move(value));
       }
+    } else if (label == ComponentLabel::TargetFingerprint) {
+      uint64_t fingerprint = ReadTargetFingerprint();
+      if (ok_) {
+        absl::StrAppend(&description, " target_fingerprint=",
+                        absl::Hex(fingerprint, absl::kZeroPad16));
+      }
     } else {
       absl::StrAppend(&description, " unknown label=", static_cast<int>(label));
       Fail();
@@ -812,6 +831,11 @@ class Writer {
     WriteLabeledString(ComponentLabel::DataMigrationName, name);
   }
 
+  void WriteTargetFingerprint(uint64_t fingerprint) {
+    WriteLabeledInt64(ComponentLabel::TargetFingerprint,
+                      static_cast<int64_t>(fingerprint));
+  }
+
  private:
   /** Writes a component label to the given key destination. */
   void WriteComponentLabel(ComponentLabel label) {
@@ -948,6 +972,55 @@ bool LevelDbDocumentMutationKey::Decode(absl::string_view key) {
   return reader.ok();
 }
 
+std::string LevelDbDocumentMutationCollectionIndexKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kDocumentMutationsCollectionIndexTable);
+  return writer.result();
+}
+
+std::string LevelDbDocumentMutationCollectionIndexKey::KeyPrefix(
+    absl::string_view user_id) {
+  Writer writer;
+  writer.WriteTableName(kDocumentMutationsCollectionIndexTable);
+  writer.WriteUserId(user_id);
+  return writer.result();
+}
+
+std::string LevelDbDocumentMutationCollectionIndexKey::KeyPrefix(
+    absl::string_view user_id, const ResourcePath& collection) {
+  Writer writer;
+  writer.WriteTableName(kDocumentMutationsCollectionIndexTable);
+  writer.WriteUserId(user_id);
+  writer.WriteResourcePath(collection);
+  return writer.result();
+}
+
+std::string LevelDbDocumentMutationCollectionIndexKey::Key(
+    absl::string_view user_id,
+    const ResourcePath& collection,
+    model::BatchId batch_id,
+    absl::string_view document_id) {
+  Writer writer;
+  writer.WriteTableName(kDocumentMutationsCollectionIndexTable);
+  writer.WriteUserId(user_id);
+  writer.WriteResourcePath(collection);
+  writer.WriteBatchId(batch_id);
+  writer.WriteDocumentId(document_id);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbDocumentMutationCollectionIndexKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kDocumentMutationsCollectionIndexTable);
+  user_id_ = reader.ReadUserId();
+  collection_ = reader.ReadResourcePath();
+  batch_id_ = reader.ReadBatchId();
+  document_id_ = reader.ReadDocumentId();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
 std::string LevelDbMutationQueueKey::KeyPrefix() {
   Writer writer;
   writer.WriteTableName(kMutationQueuesTable);
@@ -1038,6 +1111,51 @@ bool LevelDbQueryTargetKey::Decode(absl::string_view key) {
   return reader.ok();
 }
 
+uint64_t LevelDbTargetFingerprintKey::Fingerprint(
+    absl::string_view canonical_id) {
+  // 64-bit FNV-1a. The fingerprint is persisted, so it must not depend on the
+  // platform or the standard library (as `std::hash` does).
+  uint64_t fingerprint = 14695981039346656037ULL;
+  for (char c : canonical_id) {
+    fingerprint ^= static_cast<uint8_t>(c);
+    fingerprint *= 1099511628211ULL;
+  }
+  return fingerprint;
+}
+
+std::string LevelDbTargetFingerprintKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kTargetFingerprintsTable);
+  return writer.result();
+}
+
+std::string LevelDbTargetFingerprintKey::KeyPrefix(
+    absl::string_view canonical_id) {
+  Writer writer;
+  writer.WriteTableName(kTargetFingerprintsTable);
+  writer.WriteTargetFingerprint(Fingerprint(canonical_id));
+  return writer.result();
+}
+
+std::string LevelDbTargetFingerprintKey::Key(absl::string_view canonical_id,
+                                             model::TargetId target_id) {
+  Writer writer;
+  writer.WriteTableName(kTargetFingerprintsTable);
+  writer.WriteTargetFingerprint(Fingerprint(canonical_id));
+  writer.WriteTargetId(target_id);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbTargetFingerprintKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kTargetFingerprintsTable);
+  fingerprint_ = reader.ReadTargetFingerprint();
+  target_id_ = reader.ReadTargetId();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
 std::string LevelDbTargetDocumentKey::KeyPrefix() {
   Writer writer;
   writer.WriteTableName(kTargetDocumentsTable);
@@ -1187,6 +1305,12 @@ bool LevelDbCollectionParentKey::Decode(absl::string_view key) {
   return reader.ok();
 }
 
+std::string LevelDbRemoteDocumentReadTimeKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kRemoteDocumentReadTimeTable);
+  return writer.result();
+}
+
 std::string LevelDbRemoteDocumentReadTimeKey::KeyPrefix(
     const model::ResourcePath& collection_path,
     model::SnapshotVersion read_time) {
@@ -1220,6 +1344,45 @@ bool LevelDbRemoteDocumentReadTimeKey::Decode(absl::string_view key) {
   return reader.ok();
 }
 
+std::string LevelDbRemoteDocumentCollectionGroupReadTimeKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kRemoteDocumentCollectionGroupReadTimeTable);
+  return writer.result();
+}
+
+std::string LevelDbRemoteDocumentCollectionGroupReadTimeKey::KeyPrefix(
+    absl::string_view collection_group, model::SnapshotVersion read_time) {
+  Writer writer;
+  writer.WriteTableName(kRemoteDocumentCollectionGroupReadTimeTable);
+  writer.WriteCollectionGroup(collection_group);
+  writer.WriteSnapshotVersion(read_time);
+  return writer.result();
+}
+
+std::string LevelDbRemoteDocumentCollectionGroupReadTimeKey::Key(
+    absl::string_view collection_group,
+    model::SnapshotVersion read_time,
+    const model::DocumentKey& document_key) {
+  Writer writer;
+  writer.WriteTableName(kRemoteDocumentCollectionGroupReadTimeTable);
+  writer.WriteCollectionGroup(collection_group);
+  writer.WriteSnapshotVersion(read_time);
+  writer.WriteResourcePath(document_key.path());
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbRemoteDocumentCollectionGroupReadTimeKey::Decode(
+    absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kRemoteDocumentCollectionGroupReadTimeTable);
+  collection_group_ = reader.ReadCollectionGroup();
+  read_time_ = reader.ReadSnapshotVersion();
+  document_key_ = reader.ReadDocumentKey();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
 std::string LevelDbGlobalKey::KeyPrefix() {
   Writer writer;
   writer.WriteTableName(kGlobalsTable);
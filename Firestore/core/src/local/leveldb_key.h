@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_LOCAL_LEVELDB_KEY_H_
 #define FIRESTORE_CORE_SRC_LOCAL_LEVELDB_KEY_H_
 
+#include <cstdint>
 #include <string>
 #include <utility>
 
@@ -283,6 +284,97 @@ class LevelDbDocumentMutationKey {
   model::BatchId batch_id_ = model::kBatchIdUnknown;
 };
 
+/**
+ * A key in the collection index of the document mutations table, which stores
+ * the batches in which documents are mutated, grouped by the documents'
+ * immediate parent collection.
+ *
+ * Within a single collection, rows are ordered by batch_id and sort before
+ * the rows of any subcollection, so a scan over a collection prefix visits the
+ * collection's own rows first and can stop at the first row for a different
+ * collection.
+ */
+class LevelDbDocumentMutationCollectionIndexKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key in the table.
+   */
+  static std::string KeyPrefix();
+
+  /**
+   * Creates a key prefix that points just before the first key for the given
+   * user_id.
+   */
+  static std::string KeyPrefix(absl::string_view user_id);
+
+  /**
+   * Creates a key prefix that points just before the first key for the given
+   * user_id and collection.
+   *
+   * Like `LevelDbDocumentMutationKey::KeyPrefix(user_id, resource_path)`, this
+   * prefix also matches the rows of any subcollection of `collection`.
+   */
+  static std::string KeyPrefix(absl::string_view user_id,
+                               const model::ResourcePath& collection);
+
+  /**
+   * Creates a complete key that points to a specific user_id, collection,
+   * batch_id and document_id.
+   */
+  static std::string Key(absl::string_view user_id,
+                         const model::ResourcePath& collection,
+                         model::BatchId batch_id,
+                         absl::string_view document_id);
+
+  /**
+   * Creates a complete key for the row that indexes the given document key in
+   * the given batch.
+   */
+  static std::string Key(absl::string_view user_id,
+                         const model::DocumentKey& document_key,
+                         model::BatchId batch_id) {
+    return Key(user_id, document_key.path().PopLast(), batch_id,
+               document_key.path().last_segment());
+  }
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The user that owns the mutation batches. */
+  const std::string& user_id() const {
+    return user_id_;
+  }
+
+  /** The immediate parent collection of the document. */
+  const model::ResourcePath& collection() const {
+    return collection_;
+  }
+
+  /** The batch_id in which the document participates. */
+  model::BatchId batch_id() const {
+    return batch_id_;
+  }
+
+  /** The ID of the document within its collection. */
+  const std::string& document_id() const {
+    return document_id_;
+  }
+
+ private:
+  std::string user_id_;
+  model::ResourcePath collection_;
+  model::BatchId batch_id_ = model::kBatchIdUnknown;
+  std::string document_id_;
+};
+
 /**
  * A key in the mutation_queues table.
  *
@@ -419,6 +511,61 @@ class LevelDbQueryTargetKey {
   model::TargetId target_id_ = 0;
 };
 
+/**
+ * A key in the target fingerprints table, an index of fixed-width fingerprints
+ * of canonical_ids to the targets they may match.
+ *
+ * This serves the same purpose as the query targets table, but its keys don't
+ * grow with the size of the query. Like canonical_ids, fingerprints are not
+ * unique, so callers must still compare the targets they point to.
+ */
+class LevelDbTargetFingerprintKey {
+ public:
+  /** Returns the persisted fingerprint of the given canonical_id. */
+  static uint64_t Fingerprint(absl::string_view canonical_id);
+
+  /**
+   * Creates a key that contains just the target fingerprints table prefix and
+   * points just before the first key.
+   */
+  static std::string KeyPrefix();
+
+  /**
+   * Creates a key that points to the first fingerprint-target association for
+   * the fingerprint of a canonical_id.
+   */
+  static std::string KeyPrefix(absl::string_view canonical_id);
+
+  /** Creates a key that points to a specific fingerprint-target entry. */
+  static std::string Key(absl::string_view canonical_id,
+                         model::TargetId target_id);
+
+  /**
+   * Decodes the contents of a target fingerprint key, storing the decoded
+   * values in this instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The fingerprint of the canonical_id derived from the query. */
+  uint64_t fingerprint() const {
+    return fingerprint_;
+  }
+
+  /** The target_id identifying a target. */
+  model::TargetId target_id() const {
+    return target_id_;
+  }
+
+ private:
+  uint64_t fingerprint_ = 0;
+  model::TargetId target_id_ = 0;
+};
+
 /**
  * A key in the target documents table, an index of target_ids to the documents
  * they contain.
@@ -652,6 +799,11 @@ class LevelDbCollectionParentKey {
  */
 class LevelDbRemoteDocumentReadTimeKey {
  public:
+  /**
+   * Creates a key prefix that points just before the first key of the table.
+   */
+  static std::string KeyPrefix();
+
   /**
    * Creates a key prefix that points just before the first key for the given
    * collection_path and read_time.
@@ -698,6 +850,66 @@ class LevelDbRemoteDocumentReadTimeKey {
   model::SnapshotVersion read_time_;
 };
 
+/**
+ * A key in the remote documents collection group read time table, storing the
+ * collection group, read time and document key for each entry. Unlike the
+ * remote documents read time table, the documents of all collections with the
+ * same ID are in a single range, in read time order.
+ */
+class LevelDbRemoteDocumentCollectionGroupReadTimeKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key of the table.
+   */
+  static std::string KeyPrefix();
+
+  /**
+   * Creates a key prefix that points just before the first key for the given
+   * collection_group and read_time.
+   */
+  static std::string KeyPrefix(absl::string_view collection_group,
+                               model::SnapshotVersion read_time);
+
+  /**
+   * Creates a key that points to the key for the given collection_group,
+   * read_time and document_key.
+   */
+  static std::string Key(absl::string_view collection_group,
+                         model::SnapshotVersion read_time,
+                         const model::DocumentKey& document_key);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The collection group for this entry. */
+  const std::string& collection_group() const {
+    return collection_group_;
+  }
+
+  /** The read time for for this entry. */
+  model::SnapshotVersion read_time() const {
+    return read_time_;
+  }
+
+  /** The document key for this entry. */
+  const model::DocumentKey& document_key() const {
+    return document_key_;
+  }
+
+ private:
+  std::string collection_group_;
+  model::SnapshotVersion read_time_;
+  model::DocumentKey document_key_;
+};
+
 /**
  * A key in the bundles table, storing the bundle Id for each entry.
  */
@@ -107,7 +107,7 @@ LruGarbageCollector* LevelDbLruReferenceDelegate::garbage_collector() {
 }
 
 StatusOr<int64_t> LevelDbLruReferenceDelegate::CalculateByteSize() {
-  return db_->CalculateByteSize();
+  return db_->EstimateByteSize();
 }
 
 size_t LevelDbLruReferenceDelegate::GetSequenceNumberCount() {
@@ -130,9 +130,9 @@ void LevelDbLruReferenceDelegate::EnumerateOrphanedDocuments(
 }
 
 int LevelDbLruReferenceDelegate::RemoveOrphanedDocuments(
-    ListenSequenceNumber upper_bound) {
-  int count = 0;
-  db_->target_cache()->EnumerateOrphanedDocuments(
+    ListenSequenceNumber upper_bound, absl::optional<size_t> limit) {
+  size_t count = 0;
+  db_->target_cache()->EnumerateOrphanedDocumentsWhile(
       [&](const DocumentKey& key, ListenSequenceNumber sequence_number) {
         if (sequence_number <= upper_bound) {
           if (!IsPinned(key)) {
@@ -141,14 +141,17 @@ int LevelDbLruReferenceDelegate::RemoveOrphanedDocuments(
             RemoveSentinel(key);
           }
         }
+        return !limit || count < *limit;
       });
-  return count;
+  return static_cast<int>(count);
 }
 
 int LevelDbLruReferenceDelegate::RemoveTargets(
-    ListenSequenceNumber sequence_number, const LiveQueryMap& live_queries) {
-  return static_cast<int>(
-      db_->target_cache()->RemoveTargets(sequence_number, live_queries));
+    ListenSequenceNumber sequence_number,
+    const LiveQueryMap& live_queries,
+    absl::optional<size_t> limit) {
+  return static_cast<int>(db_->target_cache()->RemoveTargets(
+      sequence_number, live_queries, limit));
 }
 
 bool LevelDbLruReferenceDelegate::IsPinned(const DocumentKey& key) {
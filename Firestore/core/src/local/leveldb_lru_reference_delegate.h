@@ -65,9 +65,11 @@ class LevelDbLruReferenceDelegate : public LruDelegate {
   void EnumerateOrphanedDocuments(
       const OrphanedDocumentCallback& callback) override;
 
-  int RemoveOrphanedDocuments(model::ListenSequenceNumber upper_bound) override;
+  int RemoveOrphanedDocuments(model::ListenSequenceNumber upper_bound,
+                              absl::optional<size_t> limit) override;
   int RemoveTargets(model::ListenSequenceNumber sequence_number,
-                    const LiveQueryMap& live_queries) override;
+                    const LiveQueryMap& live_queries,
+                    absl::optional<size_t> limit) override;
 
  private:
   bool IsPinned(const model::DocumentKey& key);
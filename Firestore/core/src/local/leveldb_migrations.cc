@@ -279,6 +279,27 @@ void EnsureCollectionParentsIndex(leveldb::DB* db) {
   transaction.Commit();
 }
 
+/** Decodes a `TargetData` from a value in the `targets` table. */
+util::StatusOr<TargetData> DecodeTargetData(absl::string_view value,
+                                            const LocalSerializer& serializer) {
+  StringReader reader{value};
+  auto message = Message<firestore_client_Target>::TryParse(&reader);
+  if (!reader.ok()) {
+    return util::Status(kErrorDataLoss,
+                        util::StringFormat("Target proto failed to parse: %s",
+                                           reader.status().ToString()));
+  }
+  auto target_data = serializer.DecodeTargetData(&reader, *message);
+  if (!reader.ok()) {
+    return util::Status(
+        kErrorDataLoss,
+        util::StringFormat("Target failed to parse: %s, message: %s",
+                           reader.status().ToString(), message.ToString()));
+  }
+
+  return target_data;
+}
+
 /**
  * Returns a `TargetData` by reading the `targets` table, using the given key
  * for `query_targets` as a foreign key.
@@ -298,22 +319,7 @@ util::StatusOr<TargetData> ReadTargetData(
             DescribeKey(target_key), DescribeKey(target_it)));
   }
 
-  StringReader reader{target_it->value()};
-  auto message = Message<firestore_client_Target>::TryParse(&reader);
-  if (!reader.ok()) {
-    return util::Status(kErrorDataLoss,
-                        util::StringFormat("Target proto failed to parse: %s",
-                                           reader.status().ToString()));
-  }
-  auto target_data = serializer.DecodeTargetData(&reader, *message);
-  if (!reader.ok()) {
-    return util::Status(
-        kErrorDataLoss,
-        util::StringFormat("Target failed to parse: %s, message: %s",
-                           reader.status().ToString(), message.ToString()));
-  }
-
-  return target_data;
+  return DecodeTargetData(target_it->value(), serializer);
 }
 
 /**
@@ -370,6 +376,109 @@ void EnsureOverlayDataMigrationIsRequired(leveldb::DB* db) {
   transaction.Commit();
 }
 
+/**
+ * Migration 9.
+ *
+ * Rebuilds the LevelDbDocumentMutationCollectionIndexKey rows from the
+ * document-mutation index.
+ */
+void EnsureDocumentMutationCollectionIndex(leveldb::DB* db) {
+  DeleteEverythingWithPrefix(
+      LevelDbDocumentMutationCollectionIndexKey::KeyPrefix(), db);
+
+  LevelDbTransaction transaction(db,
+                                 "Ensure document-mutation collection index");
+
+  std::string mutations_prefix = LevelDbDocumentMutationKey::KeyPrefix();
+  auto it = transaction.NewIterator();
+  it->Seek(mutations_prefix);
+  LevelDbDocumentMutationKey key;
+  std::string empty_buffer;
+  for (; it->Valid() && absl::StartsWith(it->key(), mutations_prefix);
+       it->Next()) {
+    HARD_ASSERT(key.Decode(it->key()),
+                "Failed to decode document-mutation key");
+
+    transaction.Put(LevelDbDocumentMutationCollectionIndexKey::Key(
+                        key.user_id(), key.document_key(), key.batch_id()),
+                    empty_buffer);
+  }
+
+  SaveVersion(9, &transaction);
+  transaction.Commit();
+}
+
+/**
+ * Migration 10.
+ *
+ * Rebuilds the LevelDbTargetFingerprintKey rows from the targets in the
+ * target cache.
+ */
+void EnsureTargetFingerprintIndex(leveldb::DB* db,
+                                  const LocalSerializer& serializer) {
+  DeleteEverythingWithPrefix(LevelDbTargetFingerprintKey::KeyPrefix(), db);
+
+  LevelDbTransaction transaction(db, "Ensure target fingerprint index");
+
+  std::string targets_prefix = LevelDbTargetKey::KeyPrefix();
+  auto it = transaction.NewIterator();
+  it->Seek(targets_prefix);
+  std::string empty_buffer;
+  for (; it->Valid() && absl::StartsWith(it->key(), targets_prefix);
+       it->Next()) {
+    util::StatusOr<TargetData> target_data =
+        DecodeTargetData(it->value(), serializer);
+    if (!target_data.ok()) {
+      LOG_WARN("Reading target data failed: %s",
+               target_data.status().error_message());
+      continue;
+    }
+
+    transaction.Put(LevelDbTargetFingerprintKey::Key(
+                        target_data.ValueOrDie().target().CanonicalId(),
+                        target_data.ValueOrDie().target_id()),
+                    empty_buffer);
+  }
+
+  SaveVersion(10, &transaction);
+  transaction.Commit();
+}
+
+/**
+ * Migration 11.
+ *
+ * Rebuilds the LevelDbRemoteDocumentCollectionGroupReadTimeKey rows from the
+ * remote document read time index.
+ */
+void EnsureRemoteDocumentCollectionGroupReadTimeIndex(leveldb::DB* db) {
+  DeleteEverythingWithPrefix(
+      LevelDbRemoteDocumentCollectionGroupReadTimeKey::KeyPrefix(), db);
+
+  LevelDbTransaction transaction(
+      db, "Ensure remote document collection group read time index");
+
+  std::string read_time_prefix = LevelDbRemoteDocumentReadTimeKey::KeyPrefix();
+  auto it = transaction.NewIterator();
+  it->Seek(read_time_prefix);
+  LevelDbRemoteDocumentReadTimeKey key;
+  std::string empty_buffer;
+  for (; it->Valid() && absl::StartsWith(it->key(), read_time_prefix);
+       it->Next()) {
+    HARD_ASSERT(key.Decode(it->key()),
+                "Failed to decode remote document read time key");
+
+    const ResourcePath& collection_path = key.collection_path();
+    transaction.Put(
+        LevelDbRemoteDocumentCollectionGroupReadTimeKey::Key(
+            collection_path.last_segment(), key.read_time(),
+            DocumentKey(collection_path.Append(key.document_id()))),
+        empty_buffer);
+  }
+
+  SaveVersion(11, &transaction);
+  transaction.Commit();
+}
+
 }  // namespace
 
 LevelDbMigrations::SchemaVersion LevelDbMigrations::ReadSchemaVersion(
@@ -399,7 +508,8 @@ void LevelDbMigrations::RunMigrations(leveldb::DB* db,
   SchemaVersion from_version = ReadSchemaVersion(db);
   // If this is a downgrade, just save the downgrade version so we can
   // detect it when we go to upgrade again, allowing us to rerun the
-  // data migrations.
+  // data migrations. The downgraded client doesn't maintain indexes added by
+  // later versions, so migrations that build an index rebuild it from scratch.
   if (from_version > to_version) {
     LevelDbTransaction transaction(db, "Save downgrade version");
     SaveVersion(to_version, &transaction);
@@ -433,6 +543,18 @@ void LevelDbMigrations::RunMigrations(leveldb::DB* db,
   if (from_version < 8 && to_version >= 8) {
     EnsureOverlayDataMigrationIsRequired(db);
   }
+
+  if (from_version < 9 && to_version >= 9) {
+    EnsureDocumentMutationCollectionIndex(db);
+  }
+
+  if (from_version < 10 && to_version >= 10) {
+    EnsureTargetFingerprintIndex(db, serializer);
+  }
+
+  if (from_version < 11 && to_version >= 11) {
+    EnsureRemoteDocumentCollectionGroupReadTimeIndex(db);
+  }
 }
 
 }  // namespace local
@@ -73,8 +73,13 @@ class LevelDbMigrations {
  *   * Migration 6 populates the collection_parents index.
  *   * Migration 7 rewrites query_targets canonical ids in new format.
  *   * Migration 8 kicks off overlay data migration.
+ *   * Migration 9 populates the collection index of the document_mutation
+ *     table.
+ *   * Migration 10 populates the target_fingerprint index.
+ *   * Migration 11 populates the collection group index of the
+ *     remote_document_read_time table.
  */
-const LevelDbMigrations::SchemaVersion kSchemaVersion = 8;
+const LevelDbMigrations::SchemaVersion kSchemaVersion = 11;
 
 }  // namespace local
 }  // namespace firestore
@@ -179,6 +179,10 @@ MutationBatch LevelDbMutationQueue::AddMutationBatch(
     key = LevelDbDocumentMutationKey::Key(user_id_, mutation.key(), batch_id);
     db_->current_transaction()->Put(key, empty_buffer);
 
+    key = LevelDbDocumentMutationCollectionIndexKey::Key(
+        user_id_, mutation.key(), batch_id);
+    db_->current_transaction()->Put(key, empty_buffer);
+
     index_manager_->AddToCollectionParentIndex(mutation.key().path().PopLast());
   }
 
@@ -206,6 +210,9 @@ void LevelDbMutationQueue::RemoveMutationBatch(const MutationBatch& batch) {
   for (const Mutation& mutation : batch.mutations()) {
     key = LevelDbDocumentMutationKey::Key(user_id_, mutation.key(), batch_id);
     db_->current_transaction()->Delete(key);
+    key = LevelDbDocumentMutationCollectionIndexKey::Key(
+        user_id_, mutation.key(), batch_id);
+    db_->current_transaction()->Delete(key);
     db_->reference_delegate()->RemoveMutationReference(mutation.key());
   }
 }
@@ -276,57 +283,35 @@ LevelDbMutationQueue::AllMutationBatchesAffectingQuery(const Query& query) {
       "CollectionGroup queries should be handled in LocalDocumentsView");
 
   const ResourcePath& query_path = query.path();
-  size_t immediate_children_path_length = query_path.size() + 1;
 
-  // TODO(mcg): Actually implement a single-collection query
-  //
-  // This is actually executing an ancestor query, traversing the whole subtree
-  // below the collection which can be horrifically inefficient for some
-  // structures. The right way to solve this is to implement the full value
-  // index, but that's not in the cards in the near future so this is the best
-  // we can do for the moment.
-  //
   // Since we don't yet index the actual properties in the mutations, our
   // current approach is to just return all mutation batches that affect
   // documents in the collection being queried.
   //
-  // Unlike AllMutationBatchesAffectingDocumentKey, this iteration will scan the
-  // document-mutation index for more than a single document so the associated
-  // batch_ids will be neither necessarily unique nor in order. This means an
-  // efficient simultaneous scan isn't possible.
+  // The collection index holds one row per document in each batch, keyed by
+  // the document's immediate parent collection. Within a collection the rows
+  // are ordered by batch_id and sort before the rows of any subcollection, so
+  // the scan only touches rows for the queried collection and can stop as soon
+  // as it reaches a row for a different one.
   std::string index_prefix =
-      LevelDbDocumentMutationKey::KeyPrefix(user_id_, query_path);
+      LevelDbDocumentMutationCollectionIndexKey::KeyPrefix(user_id_,
+                                                           query_path);
   auto index_iterator = db_->current_transaction()->NewIterator();
   index_iterator->Seek(index_prefix);
 
-  LevelDbDocumentMutationKey row_key;
+  LevelDbDocumentMutationCollectionIndexKey row_key;
 
-  // Collect up unique batch_ids encountered during a scan of the index. Use a
-  // set<BatchId> to accumulate the IDs so they can be traversed in order in a
-  // scan of the main table.
-  //
-  // This method is faster than performing lookups of the keys with _db->Get and
-  // keeping a hash of batch_ids that have already been looked up. The
-  // performance difference is minor for small numbers of keys but > 30% faster
-  // for larger numbers of keys.
+  // Batches that mutate several documents in the collection appear in
+  // consecutive rows, so the set only ever receives batch_ids in order.
   std::set<BatchId> unique_batch_ids;
   for (; index_iterator->Valid(); index_iterator->Next()) {
     if (!absl::StartsWith(index_iterator->key(), index_prefix) ||
-        !row_key.Decode(index_iterator->key())) {
+        !row_key.Decode(index_iterator->key()) ||
+        row_key.collection() != query_path) {
       break;
     }
 
-    // Rows with document keys more than one segment longer than the query path
-    // can't be matches. For example, a query on 'rooms' can't match the
-    // document /rooms/abc/messages/xyx.
-    // TODO(mcg): we'll need a different scanner when we implement ancestor
-    // queries.
-    if (row_key.document_key().path().size() !=
-        immediate_children_path_length) {
-      continue;
-    }
-
-    unique_batch_ids.insert(row_key.batch_id());
+    unique_batch_ids.insert(unique_batch_ids.end(), row_key.batch_id());
   }
 
   return AllMutationBatchesWithIds(unique_batch_ids);
@@ -414,6 +399,16 @@ void LevelDbMutationQueue::PerformConsistencyCheck() {
     dangling_mutation_references.push_back(DescribeKey(index_iterator));
   }
 
+  // The same holds for the collection index of the document-mutation table.
+  index_prefix = LevelDbDocumentMutationCollectionIndexKey::KeyPrefix(user_id_);
+  index_iterator = db_->current_transaction()->NewIterator();
+  for (index_iterator->Seek(index_prefix);
+       index_iterator->Valid() &&
+       absl::StartsWith(index_iterator->key(), index_prefix);
+       index_iterator->Next()) {
+    dangling_mutation_references.push_back(DescribeKey(index_iterator));
+  }
+
   HARD_ASSERT(dangling_mutation_references.empty(),
               "Document leak -- detected dangling mutation references when "
               "queue is empty. Dangling keys: %s",
@@ -0,0 +1,52 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/local/leveldb_options.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+namespace {
+
+/** LevelDB's default. */
+const int64_t kDefaultWriteBufferSizeBytes = 4 * 1024 * 1024;
+
+/** Twice LevelDB's internal block cache. */
+const int64_t kTunedBlockCacheSizeBytes = 16 * 1024 * 1024;
+
+/** Roughly a 1% false positive rate, as recommended by LevelDB. */
+const int kTunedBloomFilterBitsPerKey = 10;
+
+}  // namespace
+
+LevelDbOptions LevelDbOptions::Default() {
+  return LevelDbOptions{/* block_cache_size_bytes= */ 0,
+                        /* bloom_filter_bits_per_key= */ 0,
+                        kDefaultWriteBufferSizeBytes,
+                        /* compression_enabled= */ true};
+}
+
+LevelDbOptions LevelDbOptions::Tuned() {
+  LevelDbOptions options = Default();
+  options.block_cache_size_bytes = kTunedBlockCacheSizeBytes;
+  options.bloom_filter_bits_per_key = kTunedBloomFilterBitsPerKey;
+  return options;
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_LOCAL_LEVELDB_OPTIONS_H_
+#define FIRESTORE_CORE_SRC_LOCAL_LEVELDB_OPTIONS_H_
+
+#include <cstdint>
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/** Storage engine options for the LevelDB database behind the local cache. */
+struct LevelDbOptions {
+  /**
+   * The options used unless the app configures its own: LevelDB's own
+   * defaults, with no bloom filter and only LevelDB's internal block cache.
+   */
+  static LevelDbOptions Default();
+
+  /**
+   * A larger block cache and a bloom filter, which should speed up point
+   * lookups in large caches. Only used by leveldb_storage_benchmark until its
+   * results on caches of about 1 GB show whether these should be the defaults.
+   */
+  static LevelDbOptions Tuned();
+
+  /**
+   * The capacity of the LRU cache for uncompressed table blocks, in bytes. 0
+   * uses LevelDB's internal 8 MB cache.
+   */
+  int64_t block_cache_size_bytes;
+
+  /**
+   * The number of bits per key of the bloom filter stored in each table, which
+   * lets point lookups for missing keys skip reading data blocks. 0 disables
+   * the filter. Tables written without a filter remain readable.
+   */
+  int bloom_filter_bits_per_key;
+
+  /**
+   * The amount of data to buffer in memory (and in the log) before converting
+   * it to a sorted table on disk, in bytes.
+   */
+  int64_t write_buffer_size_bytes;
+
+  /**
+   * Whether table blocks are compressed with Snappy. Ignored if LevelDB was
+   * built without Snappy support.
+   */
+  bool compression_enabled;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_LOCAL_LEVELDB_OPTIONS_H_
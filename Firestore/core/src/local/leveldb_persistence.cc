@@ -25,17 +25,21 @@
 #include "Firestore/core/src/local/leveldb_lru_reference_delegate.h"
 #include "Firestore/core/src/local/leveldb_migrations.h"
 #include "Firestore/core/src/local/leveldb_opener.h"
+#include "Firestore/core/src/local/leveldb_snapshot_reader.h"
 #include "Firestore/core/src/local/leveldb_util.h"
 #include "Firestore/core/src/local/listen_sequence.h"
 #include "Firestore/core/src/local/lru_garbage_collector.h"
 #include "Firestore/core/src/local/reference_delegate.h"
 #include "Firestore/core/src/local/sizer.h"
+#include "Firestore/core/src/util/background_queue.h"
 #include "Firestore/core/src/util/filesystem.h"
 #include "Firestore/core/src/util/hard_assert.h"
 #include "Firestore/core/src/util/log.h"
 #include "Firestore/core/src/util/string_util.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/match.h"
+#include "leveldb/cache.h"
+#include "leveldb/filter_policy.h"
 
 namespace firebase {
 namespace firestore {
@@ -45,12 +49,25 @@ namespace {
 using credentials::User;
 using leveldb::DB;
 using model::ListenSequenceNumber;
+using util::BackgroundQueue;
+using util::Executor;
 using util::Filesystem;
 using util::Path;
 using util::Status;
 using util::StatusOr;
 using util::StringFormat;
 
+/**
+ * The read-only transaction started by `RunAtSnapshot` on the current thread,
+ * if any, and the persistence it reads from.
+ */
+struct SnapshotTransaction {
+  const LevelDbPersistence* persistence;
+  LevelDbTransaction* transaction;
+};
+
+thread_local SnapshotTransaction current_snapshot_transaction = {};
+
 /**
  * Finds all user ids in the database based on the existence of a mutation
  * queue.
@@ -74,13 +91,29 @@ std::set<std::string> CollectUserSet(LevelDbTransaction* transaction) {
   return result;
 }
 
+leveldb::Options MakeOptions(const LevelDbOptions& options,
+                             leveldb::Cache* block_cache,
+                             const leveldb::FilterPolicy* filter_policy) {
+  leveldb::Options result;
+  result.create_if_missing = true;
+  result.block_cache = block_cache;
+  result.filter_policy = filter_policy;
+  result.write_buffer_size =
+      static_cast<size_t>(options.write_buffer_size_bytes);
+  result.compression = options.compression_enabled
+                           ? leveldb::kSnappyCompression
+                           : leveldb::kNoCompression;
+  return result;
+}
+
 }  // namespace
 
 StatusOr<std::unique_ptr<LevelDbPersistence>> LevelDbPersistence::Create(
     util::Path dir,
     LevelDbMigrations::SchemaVersion version,
     LocalSerializer serializer,
-    const LruParams& lru_params) {
+    const LruParams& lru_params,
+    const LevelDbOptions& options) {
   auto* fs = Filesystem::Default();
   Status status = EnsureDirectory(dir);
   if (!status.ok()) return status;
@@ -88,7 +121,29 @@ StatusOr<std::unique_ptr<LevelDbPersistence>> LevelDbPersistence::Create(
   status = fs->ExcludeFromBackups(dir);
   if (!status.ok()) return status;
 
-  StatusOr<std::unique_ptr<DB>> created = OpenDb(dir);
+  HARD_ASSERT(options.block_cache_size_bytes >= 0,
+              "Invalid LevelDB block cache size: %s",
+              options.block_cache_size_bytes);
+  HARD_ASSERT(options.bloom_filter_bits_per_key >= 0,
+              "Invalid LevelDB bloom filter bits per key: %s",
+              options.bloom_filter_bits_per_key);
+  HARD_ASSERT(options.write_buffer_size_bytes > 0,
+              "Invalid LevelDB write buffer size: %s",
+              options.write_buffer_size_bytes);
+
+  std::unique_ptr<leveldb::Cache> block_cache;
+  if (options.block_cache_size_bytes > 0) {
+    block_cache.reset(leveldb::NewLRUCache(
+        static_cast<size_t>(options.block_cache_size_bytes)));
+  }
+  std::unique_ptr<const leveldb::FilterPolicy> filter_policy;
+  if (options.bloom_filter_bits_per_key > 0) {
+    filter_policy.reset(
+        leveldb::NewBloomFilterPolicy(options.bloom_filter_bits_per_key));
+  }
+
+  StatusOr<std::unique_ptr<DB>> created = OpenDb(
+      dir, MakeOptions(options, block_cache.get(), filter_policy.get()));
   if (!created.ok()) return created.status();
 
   std::unique_ptr<DB> db = std::move(created).ValueOrDie();
@@ -99,24 +154,32 @@ StatusOr<std::unique_ptr<LevelDbPersistence>> LevelDbPersistence::Create(
   transaction.Commit();
 
   // Explicit conversion is required to allow the StatusOr to be created.
-  std::unique_ptr<LevelDbPersistence> result(
-      new LevelDbPersistence(std::move(db), std::move(dir), std::move(users),
-                             std::move(serializer), lru_params));
+  std::unique_ptr<LevelDbPersistence> result(new LevelDbPersistence(
+      std::move(block_cache), std::move(filter_policy), std::move(db),
+      std::move(dir), std::move(users), std::move(serializer), lru_params));
   return {std::move(result)};
 }
 
 StatusOr<std::unique_ptr<LevelDbPersistence>> LevelDbPersistence::Create(
-    util::Path dir, LocalSerializer serializer, const LruParams& lru_params) {
+    util::Path dir,
+    LocalSerializer serializer,
+    const LruParams& lru_params,
+    const LevelDbOptions& options) {
   return Create(std::move(dir), kSchemaVersion, std::move(serializer),
-                lru_params);
+                lru_params, options);
 }
 
-LevelDbPersistence::LevelDbPersistence(std::unique_ptr<leveldb::DB> db,
-                                       util::Path directory,
-                                       std::set<std::string> users,
-                                       LocalSerializer serializer,
-                                       const LruParams& lru_params)
-    : db_(std::move(db)),
+LevelDbPersistence::LevelDbPersistence(
+    std::unique_ptr<leveldb::Cache> block_cache,
+    std::unique_ptr<const leveldb::FilterPolicy> filter_policy,
+    std::unique_ptr<leveldb::DB> db,
+    util::Path directory,
+    std::set<std::string> users,
+    LocalSerializer serializer,
+    const LruParams& lru_params)
+    : block_cache_(std::move(block_cache)),
+      filter_policy_(std::move(filter_policy)),
+      db_(std::move(db)),
       directory_(std::move(directory)),
       users_(std::move(users)),
       serializer_(std::move(serializer)) {
@@ -151,10 +214,8 @@ Status LevelDbPersistence::EnsureDirectory(const Path& dir) {
   return Status::OK();
 }
 
-StatusOr<std::unique_ptr<DB>> LevelDbPersistence::OpenDb(const Path& dir) {
-  leveldb::Options options;
-  options.create_if_missing = true;
-
+StatusOr<std::unique_ptr<DB>> LevelDbPersistence::OpenDb(
+    const Path& dir, const leveldb::Options& options) {
   DB* database = nullptr;
   leveldb::Status status = DB::Open(options, dir.ToUtf8String(), &database);
   if (!status.ok()) {
@@ -170,6 +231,9 @@ StatusOr<std::unique_ptr<DB>> LevelDbPersistence::OpenDb(const Path& dir) {
 // MARK: - LevelDB utilities
 
 LevelDbTransaction* LevelDbPersistence::current_transaction() {
+  if (current_snapshot_transaction.persistence == this) {
+    return current_snapshot_transaction.transaction;
+  }
   HARD_ASSERT(transaction_ != nullptr,
               "Attempting to access transaction before one has started");
   return transaction_.get();
@@ -218,9 +282,26 @@ StatusOr<int64_t> LevelDbPersistence::CalculateByteSize() {
     return Status::FromCause("Failed to iterate over LevelDB files",
                              iter->status());
   }
+
+  measured_byte_size_ = static_cast<int64_t>(count);
+  bytes_committed_since_measured_ = 0;
   return static_cast<int64_t>(count);
 }
 
+StatusOr<int64_t> LevelDbPersistence::EstimateByteSize() {
+  // Committed bytes only approximate how much the files grow: tables are
+  // compressed, and overwritten or deleted rows take up space until they are
+  // compacted. Measure again before the estimate drifts too far.
+  if (!measured_byte_size_ ||
+      bytes_committed_since_measured_ > *measured_byte_size_ / 10) {
+    StatusOr<int64_t> maybe_size = CalculateByteSize();
+    if (!maybe_size.ok()) {
+      return maybe_size;
+    }
+  }
+  return *measured_byte_size_ + bytes_committed_since_measured_;
+}
+
 // MARK: - Persistence
 
 model::ListenSequenceNumber LevelDbPersistence::current_sequence_number()
@@ -334,10 +415,71 @@ void LevelDbPersistence::RunInternal(absl::string_view label,
   block();
 
   reference_delegate_->OnTransactionCommitted();
+  bytes_committed_since_measured_ +=
+      static_cast<int64_t>(transaction_->changed_bytes());
   transaction_->Commit();
   transaction_.reset();
 }
 
+void LevelDbPersistence::RunAtSnapshotInternal(
+    absl::string_view label, const std::function<void()>& block) {
+  const leveldb::Snapshot* snapshot = db_->GetSnapshot();
+  RunWithSnapshot(label, snapshot, block);
+  db_->ReleaseSnapshot(snapshot);
+}
+
+void LevelDbPersistence::RunConcurrentlyAtCurrentSnapshot(
+    absl::string_view label,
+    Executor* executor,
+    const std::vector<std::function<void()>>& blocks) {
+  LevelDbTransaction* transaction = current_transaction();
+  HARD_ASSERT(transaction->changed_keys() == 0,
+              "Snapshot reads cannot see the changes of the current "
+              "transaction");
+
+  // Outside of a snapshot read, the current transaction reads the latest
+  // committed data. Only the worker queue commits, and it is busy running the
+  // current transaction, so a new snapshot holds the same data.
+  const leveldb::Snapshot* snapshot = transaction->snapshot();
+  bool owns_snapshot = snapshot == nullptr;
+  if (owns_snapshot) {
+    snapshot = db_->GetSnapshot();
+  }
+
+  BackgroundQueue tasks(executor);
+  for (const std::function<void()>& block : blocks) {
+    tasks.Execute([this, label, snapshot, &block] {
+      RunWithSnapshot(label, snapshot, block);
+    });
+  }
+  tasks.AwaitAll();
+
+  if (owns_snapshot) {
+    db_->ReleaseSnapshot(snapshot);
+  }
+}
+
+void LevelDbPersistence::RunWithSnapshot(absl::string_view label,
+                                         const leveldb::Snapshot* snapshot,
+                                         const std::function<void()>& block) {
+  HARD_ASSERT(current_snapshot_transaction.persistence == nullptr,
+              "Starting a snapshot read while one is already in progress");
+
+  leveldb::ReadOptions read_options = LevelDbTransaction::DefaultReadOptions();
+  read_options.snapshot = snapshot;
+  LevelDbTransaction transaction(db_.get(), label, read_options);
+  current_snapshot_transaction = {this, &transaction};
+
+  block();
+
+  current_snapshot_transaction = {};
+}
+
+std::unique_ptr<LevelDbSnapshotReader> LevelDbPersistence::CreateSnapshotReader(
+    const User& user) {
+  return absl::make_unique<LevelDbSnapshotReader>(this, &serializer_, user);
+}
+
 leveldb::ReadOptions StandardReadOptions() {
   // For now this is paranoid, but perhaps disable that in production builds.
   leveldb::ReadOptions options;
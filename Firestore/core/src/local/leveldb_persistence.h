@@ -17,10 +17,12 @@
 #ifndef FIRESTORE_CORE_SRC_LOCAL_LEVELDB_PERSISTENCE_H_
 #define FIRESTORE_CORE_SRC_LOCAL_LEVELDB_PERSISTENCE_H_
 
+#include <functional>
 #include <memory>
 #include <set>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "Firestore/core/src/credentials/user.h"
 #include "Firestore/core/src/local/leveldb_bundle_cache.h"
@@ -30,6 +32,7 @@
 #include "Firestore/core/src/local/leveldb_lru_reference_delegate.h"
 #include "Firestore/core/src/local/leveldb_migrations.h"
 #include "Firestore/core/src/local/leveldb_mutation_queue.h"
+#include "Firestore/core/src/local/leveldb_options.h"
 #include "Firestore/core/src/local/leveldb_overlay_migration_manager.h"
 #include "Firestore/core/src/local/leveldb_remote_document_cache.h"
 #include "Firestore/core/src/local/leveldb_target_cache.h"
@@ -38,6 +41,13 @@
 #include "Firestore/core/src/local/persistence.h"
 #include "Firestore/core/src/util/path.h"
 #include "Firestore/core/src/util/statusor.h"
+#include "absl/types/optional.h"
+
+namespace leveldb {
+class Cache;
+class FilterPolicy;
+class Snapshot;
+}  // namespace leveldb
 
 namespace firebase {
 namespace firestore {
@@ -46,9 +56,14 @@ namespace core {
 class DatabaseInfo;
 }  // namespace core
 
+namespace util {
+class Executor;
+}  // namespace util
+
 namespace local {
 
 class LevelDbLruReferenceDelegate;
+class LevelDbSnapshotReader;
 struct LruParams;
 
 /** A LevelDB-backed implementation of the Persistence interface. */
@@ -59,7 +74,10 @@ class LevelDbPersistence : public Persistence {
    * containing details of the failure.
    */
   static util::StatusOr<std::unique_ptr<LevelDbPersistence>> Create(
-      util::Path dir, LocalSerializer serializer, const LruParams& lru_params);
+      util::Path dir,
+      LocalSerializer serializer,
+      const LruParams& lru_params,
+      const LevelDbOptions& options = LevelDbOptions::Default());
 
   ~LevelDbPersistence();
 
@@ -75,8 +93,59 @@ class LevelDbPersistence : public Persistence {
 
   static util::Status ClearPersistence(const core::DatabaseInfo& database_info);
 
+  /** Measures the size of the database by summing the sizes of its files. */
   util::StatusOr<int64_t> CalculateByteSize();
 
+  /**
+   * Returns a running estimate of the size of the database: the size measured
+   * by the last call to `CalculateByteSize`, plus the bytes committed since.
+   * The files are only measured again once the bytes committed since make up
+   * a significant fraction of the estimate.
+   */
+  util::StatusOr<int64_t> EstimateByteSize();
+
+  /**
+   * Runs `block` in a read-only transaction against a snapshot of the data
+   * committed to the database when the call starts. Since transactions are
+   * committed atomically, the snapshot never observes part of a transaction.
+   *
+   * Unlike `Run`, this may be called from any thread, including concurrently
+   * with other snapshot reads and with transactions started by `Run`: the
+   * read-only transaction is only returned by `current_transaction()` on the
+   * calling thread. `block` must not write, and may only use components that
+   * have no in-memory state shared with the worker queue (see
+   * `LevelDbSnapshotReader`). Must not be called after `Shutdown`.
+   */
+  template <typename F>
+  auto RunAtSnapshot(absl::string_view label, F block) -> decltype(block()) {
+    decltype(block()) result;
+
+    RunAtSnapshotInternal(label, [&] { result = block(); });
+
+    return result;
+  }
+
+  /**
+   * Runs all `blocks` concurrently on `executor`, each in a read-only
+   * transaction against the data the current transaction reads, and waits for
+   * them to finish.
+   *
+   * The current transaction must not have written anything, since the blocks
+   * would not see its changes. The blocks are subject to the same restrictions
+   * as the ones passed to `RunAtSnapshot`.
+   */
+  void RunConcurrentlyAtCurrentSnapshot(
+      absl::string_view label,
+      util::Executor* executor,
+      const std::vector<std::function<void()>>& blocks);
+
+  /**
+   * Creates a reader that executes cache-only reads for `user` through
+   * `RunAtSnapshot`.
+   */
+  std::unique_ptr<LevelDbSnapshotReader> CreateSnapshotReader(
+      const credentials::User& user);
+
   // MARK: Persistence overrides
 
   model::ListenSequenceNumber current_sequence_number() const override;
@@ -114,7 +183,9 @@ class LevelDbPersistence : public Persistence {
   friend class LevelDbLocalStoreTest;
   friend class LevelDbIndexManager;
 
-  LevelDbPersistence(std::unique_ptr<leveldb::DB> db,
+  LevelDbPersistence(std::unique_ptr<leveldb::Cache> block_cache,
+                     std::unique_ptr<const leveldb::FilterPolicy> filter_policy,
+                     std::unique_ptr<leveldb::DB> db,
                      util::Path directory,
                      std::set<std::string> users,
                      LocalSerializer serializer,
@@ -132,16 +203,25 @@ class LevelDbPersistence : public Persistence {
 
   /** Opens the database within the given directory. */
   static util::StatusOr<std::unique_ptr<leveldb::DB>> OpenDb(
-      const util::Path& dir);
+      const util::Path& dir, const leveldb::Options& options);
 
   static util::StatusOr<std::unique_ptr<LevelDbPersistence>> Create(
       util::Path dir,
       LevelDbMigrations::SchemaVersion schema_version,
       LocalSerializer serializer,
-      const LruParams& lru_params);
+      const LruParams& lru_params,
+      const LevelDbOptions& options = LevelDbOptions::Default());
 
   void DeleteAllFieldIndexes() override;
 
+  void RunAtSnapshotInternal(absl::string_view label,
+                             const std::function<void()>& block);
+
+  /** Runs `block` in a read-only transaction against `snapshot`. */
+  void RunWithSnapshot(absl::string_view label,
+                       const leveldb::Snapshot* snapshot,
+                       const std::function<void()>& block);
+
   /**
    * Remove the database entry (if any) for all "key" starting with given
    * prefix. It is a no-op if the key does not exist.
@@ -149,6 +229,9 @@ class LevelDbPersistence : public Persistence {
   void DeleteEverythingWithPrefix(absl::string_view label,
                                   const std::string& prefix);
 
+  // The block cache and filter policy must outlive `db_`.
+  std::unique_ptr<leveldb::Cache> block_cache_;
+  std::unique_ptr<const leveldb::FilterPolicy> filter_policy_;
   std::unique_ptr<leveldb::DB> db_;
 
   util::Path directory_;
@@ -172,6 +255,9 @@ class LevelDbPersistence : public Persistence {
   std::unique_ptr<LevelDbLruReferenceDelegate> reference_delegate_;
 
   std::unique_ptr<LevelDbTransaction> transaction_;
+
+  absl::optional<int64_t> measured_byte_size_;
+  int64_t bytes_committed_since_measured_ = 0;
 };
 
 /** Returns a standard set of read options. */
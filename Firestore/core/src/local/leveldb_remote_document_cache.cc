@@ -16,9 +16,18 @@
 
 #include "Firestore/core/src/local/leveldb_remote_document_cache.h"
 
+#include <pb_decode.h>
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
 #include <string>
 #include <thread>  // NOLINT(build/c++11)
 #include <utility>
+#include <vector>
 
 #include "Firestore/Protos/nanopb/firestore/local/maybe_document.nanopb.h"
 #include "Firestore/core/src/core/query.h"
@@ -29,13 +38,19 @@
 #include "Firestore/core/src/model/document_key_set.h"
 #include "Firestore/core/src/model/model_fwd.h"
 #include "Firestore/core/src/model/mutable_document.h"
+#include "Firestore/core/src/model/object_value.h"
 #include "Firestore/core/src/model/overlay.h"
+#include "Firestore/core/src/nanopb/arena.h"
 #include "Firestore/core/src/nanopb/message.h"
 #include "Firestore/core/src/nanopb/reader.h"
 #include "Firestore/core/src/util/background_queue.h"
 #include "Firestore/core/src/util/executor.h"
+#include "Firestore/core/src/util/hard_assert.h"
 #include "Firestore/core/src/util/status.h"
 #include "Firestore/core/src/util/string_util.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
 #include "leveldb/db.h"
 
 namespace firebase {
@@ -50,6 +65,7 @@ using model::DocumentKeySet;
 using model::DocumentVersionMap;
 using model::MutableDocument;
 using model::MutableDocumentMap;
+using model::ObjectValue;
 using model::ResourcePath;
 using model::SnapshotVersion;
 using nanopb::Message;
@@ -57,43 +73,208 @@ using nanopb::StringReader;
 using util::BackgroundQueue;
 using util::Executor;
 
+/** The default number of documents decoded by a single background task. */
+const size_t kDefaultDecodeBatchSize = 64;
+
+/**
+ * The default number of collections from which multi-collection reads scan
+ * collections concurrently. Below it, scheduling costs more than it saves.
+ */
+const size_t kDefaultMinCollectionsForConcurrentScan = 16;
+
+/**
+ * A collection's size estimate is no longer reported once documents have been
+ * added to or removed from it more than `size / kMaxCollectionSizeDrift` times
+ * since it was measured, so that the planner doesn't keep costing strategies
+ * against a collection that has since grown or shrunk.
+ */
+const size_t kMaxCollectionSizeDrift = 4;
+
+/**
+ * Returns whether `contents`, an encoded MaybeDocument, holds a found document.
+ * Only the tag of the first field is read: nanopb writes fields in tag order,
+ * so it is the one of the set document type.
+ */
+bool IsEncodedFoundDocument(absl::string_view contents) {
+  pb_istream_t stream = pb_istream_from_buffer(
+      reinterpret_cast<const pb_byte_t*>(contents.data()), contents.size());
+  pb_wire_type_t wire_type;
+  uint32_t tag = 0;
+  bool eof = false;
+  return pb_decode_tag(&stream, &wire_type, &tag, &eof) &&
+         tag == firestore_client_MaybeDocument_document_tag;
+}
+
+/**
+ * Returns the collection group of `queries` if they are all collection queries
+ * of the same collection group, as the collection queries that a collection
+ * group query is executed as are.
+ */
+absl::optional<std::string> SharedCollectionGroup(
+    const std::vector<Query>& queries) {
+  if (queries.size() < 2) {
+    return absl::nullopt;
+  }
+  for (const Query& query : queries) {
+    if (query.IsCollectionGroupQuery() || query.IsDocumentQuery() ||
+        query.path().empty() ||
+        query.path().last_segment() != queries[0].path().last_segment()) {
+      return absl::nullopt;
+    }
+  }
+  return queries[0].path().last_segment();
+}
+
 /**
- * An accumulator for results produced asynchronously. This accumulates
- * values in a vector to avoid contention caused by accumulating into more
- * complex structures like immutable::SortedMap.
+ * Decodes documents read from LevelDB on a concurrent executor while the
+ * caller keeps reading.
+ *
+ * Documents are added in key order and grouped into batches, so that the
+ * scheduling cost of each background task is amortized over many documents.
+ * Every batch writes its results into its own slots, which avoids contention
+ * between the decoders, and the results are merged in the order in which they
+ * were added, so the resulting map can be built without sorting.
  */
-template <typename T>
-class AsyncResults {
+class DecodePipeline {
  public:
-  void Insert(T&& value) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    values_.push_back(std::move(value));
+  /**
+   * Decodes the document with the given key and contents. Returns nullopt if
+   * the document should not be part of the result.
+   */
+  using Decoder = std::function<absl::optional<MutableDocument>(
+      const DocumentKey& key,
+      absl::string_view contents,
+      const SnapshotVersion& read_time)>;
+
+  DecodePipeline(Executor* executor,
+                 size_t batch_size,
+                 bool arena_allocation,
+                 Decoder decoder)
+      : tasks_(executor),
+        batch_size_(batch_size),
+        arena_allocation_(arena_allocation),
+        decoder_(std::move(decoder)) {
+  }
+
+  /** Adds an encoded document, which is decoded in the background. */
+  void Add(DocumentKey key,
+           std::string contents,
+           SnapshotVersion read_time = SnapshotVersion::None()) {
+    OpenBatch().push_back(
+        Entry{std::move(key), std::move(contents), read_time, absl::nullopt});
+    if (++undecoded_ >= batch_size_) {
+      Dispatch();
+    }
   }
 
-  void Insert(const T& value) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    values_.push_back(value);
+  /** Adds a document that doesn't need to be decoded. */
+  void AddDecoded(MutableDocument document) {
+    DocumentKey key = document.key();
+    OpenBatch().push_back(Entry{std::move(key), std::string(),
+                                SnapshotVersion::None(), std::move(document)});
   }
 
   /**
-   * Returns the accumulated result, moving it out of AsyncResults. The
-   * AsyncResults object should not be reused.
+   * Waits for all documents to be decoded and returns them. The pipeline
+   * should not be reused.
    */
-  std::vector<T> Result() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return std::move(values_);
+  MutableDocumentMap Finish() {
+    if (open_batch_ != nullptr) {
+      if (dispatched_) {
+        Dispatch();
+      } else {
+        // Everything fits into a single batch: decoding it on this thread is
+        // cheaper than handing it off to the executor.
+        Decode(open_batch_);
+        open_batch_ = nullptr;
+      }
+    }
+    tasks_.AwaitAll();
+
+    std::vector<std::pair<DocumentKey, MutableDocument>> documents;
+    documents.reserve(added_);
+    for (const auto& batch : batches_) {
+      for (Entry& entry : *batch) {
+        if (entry.document.has_value()) {
+          documents.emplace_back(std::move(entry.key),
+                                 std::move(entry.document).value());
+        }
+      }
+    }
+    return MutableDocumentMap::FromSortedRange(
+        std::make_move_iterator(documents.begin()),
+        std::make_move_iterator(documents.end()));
   }
 
  private:
-  std::vector<T> values_;
-  std::mutex mutex_;
+  struct Entry {
+    DocumentKey key;
+    std::string contents;
+    SnapshotVersion read_time;
+    absl::optional<MutableDocument> document;
+  };
+
+  using Batch = std::vector<Entry>;
+
+  Batch& OpenBatch() {
+    ++added_;
+    if (open_batch_ == nullptr) {
+      batches_.push_back(absl::make_unique<Batch>());
+      open_batch_ = batches_.back().get();
+      open_batch_->reserve(batch_size_);
+    }
+    return *open_batch_;
+  }
+
+  void Dispatch() {
+    Batch* batch = open_batch_;
+    tasks_.Execute([this, batch] { Decode(batch); });
+    open_batch_ = nullptr;
+    undecoded_ = 0;
+    dispatched_ = true;
+  }
+
+  void Decode(Batch* batch) const {
+    std::shared_ptr<nanopb::Arena> arena;
+    for (Entry& entry : *batch) {
+      if (!entry.document.has_value()) {
+        entry.document = decoder_(entry.key, entry.contents, entry.read_time);
+        // The encoded contents are no longer needed.
+        std::string().swap(entry.contents);
+
+        if (arena_allocation_ && entry.document.has_value() &&
+            entry.document->is_found_document()) {
+          // All documents of a batch share one arena, so that copying them is
+          // cheap and releasing them is a single deallocation.
+          if (!arena) arena = std::make_shared<nanopb::Arena>();
+          ObjectValue& data = entry.document->data();
+          data = data.CloneToArena(arena);
+        }
+      }
+    }
+  }
+
+  BackgroundQueue tasks_;
+  size_t batch_size_ = 0;
+  bool arena_allocation_ = false;
+  Decoder decoder_;
+
+  std::vector<std::unique_ptr<Batch>> batches_;
+  Batch* open_batch_ = nullptr;
+  size_t undecoded_ = 0;
+  size_t added_ = 0;
+  bool dispatched_ = false;
 };
 
 }  // namespace
 
 LevelDbRemoteDocumentCache::LevelDbRemoteDocumentCache(
     LevelDbPersistence* db, LocalSerializer* serializer)
-    : db_(db), serializer_(NOT_NULL(serializer)) {
+    : db_(db),
+      serializer_(NOT_NULL(serializer)),
+      decode_batch_size_(kDefaultDecodeBatchSize),
+      min_collections_for_concurrent_scan_(
+          kDefaultMinCollectionsForConcurrentScan) {
   auto hw_concurrency = std::thread::hardware_concurrency();
   if (hw_concurrency == 0) {
     // If the standard library doesn't know, guess something reasonable.
@@ -101,6 +282,10 @@ LevelDbRemoteDocumentCache::LevelDbRemoteDocumentCache(
   }
   executor_ = Executor::CreateConcurrent("com.google.firebase.firestore.query",
                                          static_cast<int>(hw_concurrency));
+  scan_executor_ = Executor::CreateConcurrent(
+      "com.google.firebase.firestore.query.scan",
+      static_cast<int>(hw_concurrency));
+  scan_concurrency_ = hw_concurrency;
 }
 
 // Out of line because of unique_ptrs to incomplete types.
@@ -112,6 +297,7 @@ void LevelDbRemoteDocumentCache::Add(const MutableDocument& document,
   const ResourcePath& path = key.path();
 
   std::string ldb_document_key = LevelDbRemoteDocumentKey::Key(key);
+  RecordDocumentCountChange(key, ldb_document_key, /*adding=*/true);
   db_->current_transaction()->Put(ldb_document_key,
                                   serializer_->EncodeMaybeDocument(document));
 
@@ -119,15 +305,46 @@ void LevelDbRemoteDocumentCache::Add(const MutableDocument& document,
       path.PopLast(), read_time, path.last_segment());
   db_->current_transaction()->Put(ldb_read_time_key, "");
 
+  std::string ldb_collection_group_read_time_key =
+      LevelDbRemoteDocumentCollectionGroupReadTimeKey::Key(
+          path[path.size() - 2], read_time, key);
+  db_->current_transaction()->Put(ldb_collection_group_read_time_key, "");
+
   NOT_NULL(index_manager_);
   index_manager_->AddToCollectionParentIndex(document.key().path().PopLast());
 }
 
 void LevelDbRemoteDocumentCache::Remove(const DocumentKey& key) {
   std::string ldb_key = LevelDbRemoteDocumentKey::Key(key);
+  RecordDocumentCountChange(key, ldb_key, /*adding=*/false);
   db_->current_transaction()->Delete(ldb_key);
 }
 
+void LevelDbRemoteDocumentCache::RecordDocumentCountChange(
+    const DocumentKey& key, const std::string& ldb_key, bool adding) {
+  std::string collection = key.path().PopLast().CanonicalString();
+  {
+    std::lock_guard<std::mutex> lock(collection_sizes_mutex_);
+    if (collection_sizes_.find(collection) == collection_sizes_.end()) {
+      return;
+    }
+  }
+
+  // Overwriting a document, or removing one that is not cached, leaves the
+  // collection's size unchanged.
+  std::string value;
+  bool exists = db_->current_transaction()->Get(ldb_key, &value).ok();
+  if (exists == adding) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(collection_sizes_mutex_);
+  auto it = collection_sizes_.find(collection);
+  if (it != collection_sizes_.end()) {
+    ++it->second.writes_since_scan;
+  }
+}
+
 MutableDocument LevelDbRemoteDocumentCache::Get(const DocumentKey& key) const {
   std::string ldb_key = LevelDbRemoteDocumentKey::Key(key);
   std::string value;
@@ -144,8 +361,12 @@ MutableDocument LevelDbRemoteDocumentCache::Get(const DocumentKey& key) const {
 
 MutableDocumentMap LevelDbRemoteDocumentCache::GetAll(
     const DocumentKeySet& keys) const {
-  BackgroundQueue tasks(executor_.get());
-  AsyncResults<std::pair<DocumentKey, MutableDocument>> results;
+  DecodePipeline pipeline(
+      executor_.get(), decode_batch_size_, arena_allocation_,
+      [this](const DocumentKey& key, absl::string_view contents,
+             const SnapshotVersion&) -> absl::optional<MutableDocument> {
+        return DecodeMaybeDocument(contents, key);
+      });
 
   LevelDbRemoteDocumentKey current_key;
   auto it = db_->current_transaction()->NewIterator();
@@ -154,49 +375,122 @@ MutableDocumentMap LevelDbRemoteDocumentCache::GetAll(
     it->Seek(LevelDbRemoteDocumentKey::Key(key));
     if (!it->Valid() || !current_key.Decode(it->key()) ||
         current_key.document_key() != key) {
-      results.Insert(
-          std::make_pair(key, MutableDocument::InvalidDocument(key)));
+      pipeline.AddDecoded(MutableDocument::InvalidDocument(key));
     } else {
-      const std::string& contents = it->value();
-      tasks.Execute([this, &results, &key, contents] {
-        results.Insert(std::make_pair(key, DecodeMaybeDocument(contents, key)));
-      });
+      pipeline.Add(key, it->value());
     }
   }
 
-  tasks.AwaitAll();
+  return pipeline.Finish();
+}
+
+DocumentKeySet LevelDbRemoteDocumentCache::GetFoundDocumentKeys(
+    const DocumentKeySet& keys) const {
+  DocumentKeySet result;
+  LevelDbRemoteDocumentKey current_key;
+  auto it = db_->current_transaction()->NewIterator();
 
-  MutableDocumentMap map;
-  for (const auto& entry : results.Result()) {
-    map = map.insert(entry.first, entry.second);
+  for (const DocumentKey& key : keys) {
+    it->Seek(LevelDbRemoteDocumentKey::Key(key));
+    if (it->Valid() && current_key.Decode(it->key()) &&
+        current_key.document_key() == key &&
+        IsEncodedFoundDocument(it->value())) {
+      result = result.insert(key);
+    }
   }
-  return map;
+  return result;
 }
 
 MutableDocumentMap LevelDbRemoteDocumentCache::GetAllExisting(
     DocumentVersionMap&& remote_map,
     const core::Query& query,
     const model::OverlayByDocumentKeyMap& mutated_docs) const {
-  BackgroundQueue tasks(executor_.get());
-  AsyncResults<std::pair<DocumentKey, MutableDocument>> results;
+  DecodePipeline pipeline(
+      executor_.get(), decode_batch_size_, arena_allocation_,
+      [this, &query, &mutated_docs](
+          const DocumentKey& key, absl::string_view contents,
+          const SnapshotVersion& read_time) -> absl::optional<MutableDocument> {
+        MutableDocument document = DecodeMaybeDocument(contents, key);
+        document.WithReadTime(read_time);
+        if (document.is_found_document() &&
+            // Either the document matches the given query, or it is mutated.
+            (query.Matches(document) ||
+             mutated_docs.find(key) != mutated_docs.end())) {
+          return document;
+        }
+        return absl::nullopt;
+      });
+
+  LevelDbRemoteDocumentKey current_key;
+  auto it = db_->current_transaction()->NewIterator();
+
   for (const auto& key_version : remote_map) {
-    tasks.Execute([this, &results, &key_version, query, &mutated_docs] {
-      auto document = Get(key_version.first).WithReadTime(key_version.second);
-      if (document.is_found_document() &&
-          // Either the document matches the given query, or it is mutated.
-          (query.Matches(document) ||
-           mutated_docs.find(key_version.first) != mutated_docs.end())) {
-        results.Insert(std::make_pair(key_version.first, std::move(document)));
+    const DocumentKey& key = key_version.first;
+    it->Seek(LevelDbRemoteDocumentKey::Key(key));
+    if (it->Valid() && current_key.Decode(it->key()) &&
+        current_key.document_key() == key) {
+      pipeline.Add(key, it->value(), key_version.second);
+    }
+  }
+
+  return pipeline.Finish();
+}
+
+void LevelDbRemoteDocumentCache::set_decode_batch_size(size_t batch_size) {
+  HARD_ASSERT(batch_size > 0, "Decode batch size must be at least 1");
+  decode_batch_size_ = batch_size;
+}
+
+void LevelDbRemoteDocumentCache::set_arena_allocation(bool enabled) {
+  arena_allocation_ = enabled;
+}
+
+void LevelDbRemoteDocumentCache::set_min_collections_for_concurrent_scan(
+    size_t min_collections) {
+  min_collections_for_concurrent_scan_ = min_collections;
+}
+
+bool LevelDbRemoteDocumentCache::ScansConcurrently(size_t count) const {
+  return count > 1 && count >= min_collections_for_concurrent_scan_ &&
+         db_->current_transaction()->changed_keys() == 0;
+}
+
+void LevelDbRemoteDocumentCache::ScanCollections(
+    size_t count,
+    absl::optional<QueryContext>& context,
+    const CollectionScan& scan) const {
+  if (!ScansConcurrently(count)) {
+    for (size_t i = 0; i < count; ++i) {
+      scan(i, context);
+    }
+    return;
+  }
+
+  // Every task scans every `tasks`-th collection, which spreads runs of large
+  // collections across tasks. Each task counts its reads separately.
+  size_t tasks = std::min(count, scan_concurrency_);
+  std::vector<absl::optional<QueryContext>> contexts(tasks);
+  std::vector<std::function<void()>> blocks;
+  blocks.reserve(tasks);
+  for (size_t task = 0; task < tasks; ++task) {
+    if (context.has_value()) {
+      contexts[task] = QueryContext();
+    }
+    blocks.push_back([task, tasks, count, &contexts, &scan] {
+      for (size_t i = task; i < count; i += tasks) {
+        scan(i, contexts[task]);
       }
     });
   }
-  tasks.AwaitAll();
+  db_->RunConcurrentlyAtCurrentSnapshot("Scan collections",
+                                        scan_executor_.get(), blocks);
 
-  MutableDocumentMap map;
-  for (const auto& entry : results.Result()) {
-    map = map.insert(entry.first, entry.second);
+  if (context.has_value()) {
+    for (const absl::optional<QueryContext>& task_context : contexts) {
+      context->IncrementDocumentReadCount(
+          task_context->GetDocumentReadCount());
+    }
   }
-  return map;
 }
 
 MutableDocumentMap LevelDbRemoteDocumentCache::GetAll(
@@ -204,23 +498,30 @@ MutableDocumentMap LevelDbRemoteDocumentCache::GetAll(
     const model::IndexOffset& offset,
     size_t limit) const {
   HARD_ASSERT(limit > 0u, "Limit should be at least 1");
-  const auto parents = index_manager_->GetCollectionParents(collection_group);
-  std::vector<ResourcePath> collections;
-  collections.reserve(parents.size());
-  for (const auto& parent : parents) {
-    collections.push_back(parent.Append(collection_group));
-  }
-
-  MutableDocumentMap result;
-  for (auto path = collections.cbegin();
-       path != collections.cend() && result.size() < limit; path++) {
-    const auto remote_docs =
-        GetDocumentsMatchingQuery(Query(*path), offset, limit - result.size());
-    for (const auto& doc : remote_docs) {
-      result = result.insert(doc.first, doc.second);
+
+  // The collection group read time index holds the documents of every
+  // collection of the group in read time and key order, so the documents
+  // after the offset are a single range.
+  DocumentVersionMap remote_map;
+  auto it = db_->current_transaction()->NewIterator();
+  it->Seek(LevelDbRemoteDocumentCollectionGroupReadTimeKey::Key(
+      collection_group, offset.read_time(), offset.document_key()));
+
+  LevelDbRemoteDocumentCollectionGroupReadTimeKey current_key;
+  for (; it->Valid() && remote_map.size() < limit &&
+         current_key.Decode(it->key()) &&
+         current_key.collection_group() == collection_group;
+       it->Next()) {
+    if (current_key.read_time() == offset.read_time() &&
+        current_key.document_key() == offset.document_key()) {
+      // The offset itself is excluded.
+      continue;
     }
+    remote_map[current_key.document_key()] = current_key.read_time();
   }
-  return result;
+
+  return GetAllExisting(std::move(remote_map),
+                        Query(ResourcePath::Empty(), collection_group));
 }
 
 MutableDocumentMap LevelDbRemoteDocumentCache::GetDocumentsMatchingQuery(
@@ -279,10 +580,101 @@ MutableDocumentMap LevelDbRemoteDocumentCache::GetDocumentsMatchingQuery(
     context.value().IncrementDocumentReadCount(remote_map.size());
   }
 
+  if (!limit.has_value() &&
+      offset.CompareTo(model::IndexOffset::None()) ==
+          util::ComparisonResult::Same) {
+    std::lock_guard<std::mutex> lock(collection_sizes_mutex_);
+    collection_sizes_[path.CanonicalString()] = {remote_map.size(), 0};
+  }
+
   return LevelDbRemoteDocumentCache::GetAllExisting(std::move(remote_map),
                                                     query, mutated_docs);
 }
 
+std::vector<MutableDocumentMap>
+LevelDbRemoteDocumentCache::GetDocumentsMatchingQueries(
+    const std::vector<Query>& queries,
+    const model::IndexOffset& offset,
+    absl::optional<QueryContext>& context,
+    const std::vector<model::OverlayByDocumentKeyMap>& mutated_docs) const {
+  HARD_ASSERT(queries.size() == mutated_docs.size(),
+              "Expected mutated documents for each query");
+  absl::optional<std::string> collection_group =
+      SharedCollectionGroup(queries);
+  if (collection_group.has_value()) {
+    return GetDocumentsMatchingCollectionGroup(*collection_group, queries,
+                                               offset, context, mutated_docs);
+  }
+
+  std::vector<MutableDocumentMap> results(queries.size());
+  ScanCollections(
+      queries.size(), context,
+      [&](size_t i, absl::optional<QueryContext>& scan_context) {
+        results[i] = GetDocumentsMatchingQuery(
+            queries[i], offset, scan_context, absl::nullopt, mutated_docs[i]);
+      });
+  return results;
+}
+
+std::vector<MutableDocumentMap>
+LevelDbRemoteDocumentCache::GetDocumentsMatchingCollectionGroup(
+    const std::string& collection_group,
+    const std::vector<Query>& queries,
+    const model::IndexOffset& offset,
+    absl::optional<QueryContext>& context,
+    const std::vector<model::OverlayByDocumentKeyMap>& mutated_docs) const {
+  std::map<ResourcePath, size_t> query_indexes;
+  for (size_t i = 0; i < queries.size(); ++i) {
+    query_indexes.emplace(queries[i].path(), i);
+  }
+
+  // A single scan of the collection group read time index finds the documents
+  // of all collections, instead of one seek per collection.
+  std::vector<DocumentVersionMap> remote_maps(queries.size());
+  auto it = db_->current_transaction()->NewIterator();
+  it->Seek(LevelDbRemoteDocumentCollectionGroupReadTimeKey::Key(
+      collection_group, offset.read_time(), offset.document_key()));
+
+  LevelDbRemoteDocumentCollectionGroupReadTimeKey current_key;
+  size_t read_count = 0;
+  for (; it->Valid() && current_key.Decode(it->key()) &&
+         current_key.collection_group() == collection_group;
+       it->Next()) {
+    const DocumentKey& document_key = current_key.document_key();
+    if (current_key.read_time() == offset.read_time() &&
+        document_key == offset.document_key()) {
+      continue;
+    }
+    auto query_index = query_indexes.find(document_key.path().PopLast());
+    if (query_index != query_indexes.end()) {
+      remote_maps[query_index->second][document_key] = current_key.read_time();
+      ++read_count;
+    }
+  }
+
+  if (context.has_value()) {
+    context.value().IncrementDocumentReadCount(read_count);
+  }
+
+  if (offset.CompareTo(model::IndexOffset::None()) ==
+      util::ComparisonResult::Same) {
+    std::lock_guard<std::mutex> lock(collection_sizes_mutex_);
+    for (size_t i = 0; i < queries.size(); ++i) {
+      collection_sizes_[queries[i].path().CanonicalString()] = {
+          remote_maps[i].size(), 0};
+    }
+  }
+
+  // The documents were already counted, so the scans' contexts are unused.
+  std::vector<MutableDocumentMap> results(queries.size());
+  ScanCollections(queries.size(), context,
+                  [&](size_t i, absl::optional<QueryContext>&) {
+                    results[i] = GetAllExisting(std::move(remote_maps[i]),
+                                                queries[i], mutated_docs[i]);
+                  });
+  return results;
+}
+
 MutableDocument LevelDbRemoteDocumentCache::DecodeMaybeDocument(
     absl::string_view encoded, const DocumentKey& key) const {
   StringReader reader{encoded};
@@ -302,6 +694,20 @@ MutableDocument LevelDbRemoteDocumentCache::DecodeMaybeDocument(
   return maybe_document;
 }
 
+absl::optional<size_t> LevelDbRemoteDocumentCache::GetCollectionSize(
+    const model::ResourcePath& collection_path) const {
+  std::lock_guard<std::mutex> lock(collection_sizes_mutex_);
+  auto it = collection_sizes_.find(collection_path.CanonicalString());
+  if (it == collection_sizes_.end()) {
+    return absl::nullopt;
+  }
+  const CollectionSizeEstimate& estimate = it->second;
+  if (estimate.writes_since_scan > estimate.size / kMaxCollectionSizeDrift) {
+    return absl::nullopt;
+  }
+  return estimate.size;
+}
+
 void LevelDbRemoteDocumentCache::SetIndexManager(IndexManager* manager) {
   index_manager_ = NOT_NULL(manager);
 }
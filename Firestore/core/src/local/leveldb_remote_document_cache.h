@@ -17,9 +17,12 @@
 #ifndef FIRESTORE_CORE_SRC_LOCAL_LEVELDB_REMOTE_DOCUMENT_CACHE_H_
 #define FIRESTORE_CORE_SRC_LOCAL_LEVELDB_REMOTE_DOCUMENT_CACHE_H_
 
+#include <functional>
 #include <memory>
+#include <mutex>  // NOLINT(build/c++11)
 #include <string>
 #include <thread>  // NOLINT(build/c++11)
+#include <unordered_map>
 #include <vector>
 
 #include "Firestore/core/src/core/query.h"
@@ -62,6 +65,8 @@ class LevelDbRemoteDocumentCache : public RemoteDocumentCache {
   model::MutableDocument Get(const model::DocumentKey& key) const override;
   model::MutableDocumentMap GetAll(
       const model::DocumentKeySet& keys) const override;
+  model::DocumentKeySet GetFoundDocumentKeys(
+      const model::DocumentKeySet& keys) const override;
   model::MutableDocumentMap GetAll(const std::string& collection_group,
                                    const model::IndexOffset& offset,
                                    size_t limit) const override;
@@ -76,10 +81,70 @@ class LevelDbRemoteDocumentCache : public RemoteDocumentCache {
       absl::optional<QueryContext>& context,
       absl::optional<size_t> limit = absl::nullopt,
       const model::OverlayByDocumentKeyMap& mutated_docs = {}) const override;
+  std::vector<model::MutableDocumentMap> GetDocumentsMatchingQueries(
+      const std::vector<core::Query>& queries,
+      const model::IndexOffset& offset,
+      absl::optional<QueryContext>& context,
+      const std::vector<model::OverlayByDocumentKeyMap>& mutated_docs)
+      const override;
+
+  absl::optional<size_t> GetCollectionSize(
+      const model::ResourcePath& collection_path) const override;
 
   void SetIndexManager(IndexManager* manager) override;
 
+  /**
+   * Sets the number of documents that `GetAll` and `GetDocumentsMatchingQuery`
+   * hand to each background decoding task. Larger batches have less
+   * scheduling overhead, smaller batches spread small reads across more
+   * threads.
+   */
+  void set_decode_batch_size(size_t batch_size);
+
+  /**
+   * Sets whether documents decoded by `GetAll` and `GetDocumentsMatchingQuery`
+   * are compacted into arenas shared by each decoding batch. Arena-backed
+   * documents are cheap to copy and to release, at the cost of one extra copy
+   * when they are decoded.
+   */
+  void set_arena_allocation(bool enabled);
+
+  /**
+   * Sets the number of collections from which `GetDocumentsMatchingQueries`
+   * reads collections concurrently, each on a snapshot of the data the current
+   * transaction reads.
+   */
+  void set_min_collections_for_concurrent_scan(size_t min_collections);
+
  private:
+  /** The size of a collection as measured by its most recent full scan. */
+  struct CollectionSizeEstimate {
+    size_t size = 0;
+
+    /** The number of documents inserted or removed since the scan. */
+    size_t writes_since_scan = 0;
+  };
+
+  /** A scan of the collection at `index` of a multi-collection read. */
+  using CollectionScan =
+      std::function<void(size_t index, absl::optional<QueryContext>& context)>;
+
+  /**
+   * Returns whether `ScanCollections` would scan `count` collections
+   * concurrently: there must be enough of them, and the current transaction
+   * must not have written anything, since snapshots would miss its changes.
+   */
+  bool ScansConcurrently(size_t count) const;
+
+  /**
+   * Calls `scan` for every index below `count`, concurrently if
+   * `ScansConcurrently(count)` and serially otherwise. Documents read by
+   * concurrent scans are added to `context` once all of them are done.
+   */
+  void ScanCollections(size_t count,
+                       absl::optional<QueryContext>& context,
+                       const CollectionScan& scan) const;
+
   /**
    * Looks up a set of entries in the cache, returning only existing entries of
    * Type::Document together with its SnapshotVersion.
@@ -89,6 +154,18 @@ class LevelDbRemoteDocumentCache : public RemoteDocumentCache {
       const core::Query& query,
       const model::OverlayByDocumentKeyMap& mutated_docs = {}) const;
 
+  /**
+   * Implements `GetDocumentsMatchingQueries` for collection queries of
+   * `collection_group` with a single scan of the collection group read time
+   * index, which skips the documents of the group's other collections.
+   */
+  std::vector<model::MutableDocumentMap> GetDocumentsMatchingCollectionGroup(
+      const std::string& collection_group,
+      const std::vector<core::Query>& queries,
+      const model::IndexOffset& offset,
+      absl::optional<QueryContext>& context,
+      const std::vector<model::OverlayByDocumentKeyMap>& mutated_docs) const;
+
   model::MutableDocument DecodeMaybeDocument(
       absl::string_view encoded, const model::DocumentKey& key) const;
 
@@ -100,6 +177,35 @@ class LevelDbRemoteDocumentCache : public RemoteDocumentCache {
   LocalSerializer* serializer_ = nullptr;
 
   std::unique_ptr<util::Executor> executor_;
+  size_t decode_batch_size_ = 0;
+  bool arena_allocation_ = false;
+
+  // Collection scans decode on `executor_` and block until they are done, so
+  // they run on a separate executor.
+  std::unique_ptr<util::Executor> scan_executor_;
+  size_t scan_concurrency_ = 0;
+  size_t min_collections_for_concurrent_scan_ = 0;
+
+  /**
+   * Records that the document at `key` (stored under `ldb_key`) is about to be
+   * added or removed, if that changes the number of documents of a collection
+   * with a size estimate. Such changes make the estimate less reliable.
+   */
+  void RecordDocumentCountChange(const model::DocumentKey& key,
+                                 const std::string& ldb_key,
+                                 bool adding);
+
+  /**
+   * The number of read-time index entries found in each collection (keyed by
+   * canonical path) by its most recent full scan. This approximates the cost
+   * of scanning the collection and is refreshed by every full scan. Writes to
+   * the collection are counted so that estimates that have drifted too far
+   * are no longer reported. Guarded by `collection_sizes_mutex_`, since scans
+   * also run on snapshot reader threads.
+   */
+  mutable std::unordered_map<std::string, CollectionSizeEstimate>
+      collection_sizes_;
+  mutable std::mutex collection_sizes_mutex_;
 };
 
 }  // namespace local
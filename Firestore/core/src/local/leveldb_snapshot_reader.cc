@@ -0,0 +1,69 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/local/leveldb_snapshot_reader.h"
+
+#include "Firestore/core/src/core/query.h"
+#include "Firestore/core/src/credentials/user.h"
+#include "Firestore/core/src/local/leveldb_persistence.h"
+#include "Firestore/core/src/model/document.h"
+#include "Firestore/core/src/model/document_key.h"
+#include "Firestore/core/src/model/field_index.h"
+#include "absl/memory/memory.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using credentials::User;
+using model::Document;
+using model::DocumentKey;
+using model::DocumentMap;
+using model::IndexOffset;
+
+LevelDbSnapshotReader::LevelDbSnapshotReader(LevelDbPersistence* persistence,
+                                             LocalSerializer* serializer,
+                                             const User& user)
+    : persistence_(persistence),
+      index_manager_(absl::make_unique<LevelDbIndexManager>(
+          user, persistence, serializer)),
+      mutation_queue_(absl::make_unique<LevelDbMutationQueue>(
+          user, persistence, index_manager_.get(), serializer)),
+      document_overlay_cache_(absl::make_unique<LevelDbDocumentOverlayCache>(
+          user, persistence, serializer)),
+      local_documents_(absl::make_unique<LocalDocumentsView>(
+          persistence->remote_document_cache(),
+          mutation_queue_.get(),
+          document_overlay_cache_.get(),
+          index_manager_.get())) {
+}
+
+Document LevelDbSnapshotReader::ReadDocument(const DocumentKey& key) const {
+  return persistence_->RunAtSnapshot(
+      "ReadDocument", [&] { return local_documents_->GetDocument(key); });
+}
+
+DocumentMap LevelDbSnapshotReader::ExecuteQuery(
+    const core::Query& query) const {
+  return persistence_->RunAtSnapshot("ExecuteQuery", [&] {
+    return local_documents_->GetDocumentsMatchingQuery(query,
+                                                       IndexOffset::None());
+  });
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
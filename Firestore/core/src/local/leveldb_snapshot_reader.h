@@ -0,0 +1,89 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_LOCAL_LEVELDB_SNAPSHOT_READER_H_
+#define FIRESTORE_CORE_SRC_LOCAL_LEVELDB_SNAPSHOT_READER_H_
+
+#include <memory>
+
+#include "Firestore/core/src/local/leveldb_document_overlay_cache.h"
+#include "Firestore/core/src/local/leveldb_index_manager.h"
+#include "Firestore/core/src/local/leveldb_mutation_queue.h"
+#include "Firestore/core/src/local/local_documents_view.h"
+#include "Firestore/core/src/model/model_fwd.h"
+
+namespace firebase {
+namespace firestore {
+
+namespace core {
+class Query;
+}  // namespace core
+
+namespace credentials {
+class User;
+}  // namespace credentials
+
+namespace local {
+
+class LevelDbPersistence;
+class LocalSerializer;
+
+/**
+ * Executes cache-only reads against a consistent snapshot of a LevelDB-backed
+ * local cache, without going through the worker queue.
+ *
+ * A reader is created (on the worker queue) for the current user and can then
+ * be used from any thread, by any number of threads at once. Each read runs
+ * against its own LevelDB snapshot via `LevelDbPersistence::RunAtSnapshot`,
+ * so reads never block, or are blocked by, the transactions run on the worker.
+ *
+ * The reader owns its user-specific components rather than sharing the ones
+ * used by the LocalStore: those carry in-memory state that is only safe to
+ * touch on the worker queue, and are released when the user changes.
+ *
+ * Reads are served by scanning the remote document cache and applying
+ * overlays; they don't use field indexes or previous target results, which
+ * both rely on state owned by the worker queue.
+ */
+class LevelDbSnapshotReader {
+ public:
+  LevelDbSnapshotReader(LevelDbPersistence* persistence,
+                        LocalSerializer* serializer,
+                        const credentials::User& user);
+
+  /**
+   * Returns the local view of the document identified by `key`, or an invalid
+   * document if nothing is cached for it.
+   */
+  model::Document ReadDocument(const model::DocumentKey& key) const;
+
+  /** Returns the local view of all cached documents that match `query`. */
+  model::DocumentMap ExecuteQuery(const core::Query& query) const;
+
+ private:
+  LevelDbPersistence* persistence_;
+
+  std::unique_ptr<LevelDbIndexManager> index_manager_;
+  std::unique_ptr<LevelDbMutationQueue> mutation_queue_;
+  std::unique_ptr<LevelDbDocumentOverlayCache> document_overlay_cache_;
+  std::unique_ptr<LocalDocumentsView> local_documents_;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_LOCAL_LEVELDB_SNAPSHOT_READER_H_
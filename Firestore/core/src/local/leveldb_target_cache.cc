@@ -48,6 +48,16 @@ using model::TargetId;
 using nanopb::Message;
 using nanopb::StringReader;
 
+namespace {
+
+/**
+ * The maximum number of targets held by the lookup cache. When the cache is
+ * full, the least recently used target is evicted to make room for a new one.
+ */
+const size_t kMaxTargetLookupCacheSize = 1000;
+
+}  // namespace
+
 absl::optional<Message<firestore_client_TargetGlobal>>
 LevelDbTargetCache::TryReadMetadata(leveldb::DB* db) {
   std::string key = LevelDbTargetGlobalKey::Key();
@@ -83,7 +93,9 @@ Message<firestore_client_TargetGlobal> LevelDbTargetCache::ReadMetadata(
 
 LevelDbTargetCache::LevelDbTargetCache(LevelDbPersistence* db,
                                        LocalSerializer* serializer)
-    : db_(NOT_NULL(db)), serializer_(NOT_NULL(serializer)) {
+    : db_(NOT_NULL(db)),
+      serializer_(NOT_NULL(serializer)),
+      target_lookup_cache_(kMaxTargetLookupCacheSize) {
 }
 
 void LevelDbTargetCache::Start() {
@@ -108,6 +120,10 @@ void LevelDbTargetCache::AddTarget(const TargetData& target_data) {
   std::string empty_buffer;
   db_->current_transaction()->Put(index_key, empty_buffer);
 
+  index_key =
+      LevelDbTargetFingerprintKey::Key(canonical_id, target_data.target_id());
+  db_->current_transaction()->Put(index_key, empty_buffer);
+
   metadata_->target_count++;
   UpdateMetadata(target_data);
   SaveMetadata();
@@ -129,48 +145,58 @@ void LevelDbTargetCache::RemoveTarget(const TargetData& target_data) {
   std::string key = LevelDbTargetKey::Key(target_id);
   db_->current_transaction()->Delete(key);
 
-  std::string index_key =
-      LevelDbQueryTargetKey::Key(target_data.target().CanonicalId(), target_id);
+  const std::string& canonical_id = target_data.target().CanonicalId();
+  std::string index_key = LevelDbQueryTargetKey::Key(canonical_id, target_id);
+  db_->current_transaction()->Delete(index_key);
+
+  index_key = LevelDbTargetFingerprintKey::Key(canonical_id, target_id);
   db_->current_transaction()->Delete(index_key);
 
+  target_lookup_cache_.Erase(target_data.target());
+
   metadata_->target_count--;
   SaveMetadata();
 }
 
 absl::optional<TargetData> LevelDbTargetCache::GetTarget(const Target& target) {
-  // Scan the query-target index starting with a prefix starting with the given
-  // target's canonical_id. Note that this is a scan rather than a get because
-  // canonical_ids are not required to be unique per target.
+  if (const TargetData* cached = target_lookup_cache_.Get(target)) {
+    return *cached;
+  }
+
+  // Scan the target-fingerprint index starting with a prefix starting with the
+  // fingerprint of the given target's canonical_id. Note that this is a scan
+  // rather than a get because fingerprints are not required to be unique per
+  // target.
   const std::string& canonical_id = target.CanonicalId();
   auto index_iterator = db_->current_transaction()->NewIterator();
-  std::string index_prefix = LevelDbQueryTargetKey::KeyPrefix(canonical_id);
+  std::string index_prefix =
+      LevelDbTargetFingerprintKey::KeyPrefix(canonical_id);
   index_iterator->Seek(index_prefix);
 
   // Simultaneously scan the targets table. This works because each
-  // (canonical_id, target_id) pair is unique and ordered, so when scanning a
-  // table prefixed by exactly one canonical_id, all the target_ids will be
+  // (fingerprint, target_id) pair is unique and ordered, so when scanning a
+  // table prefixed by exactly one fingerprint, all the target_ids will be
   // unique and in order.
-  std::string target_prefix = LevelDbTargetKey::KeyPrefix();
   auto target_iterator = db_->current_transaction()->NewIterator();
 
-  LevelDbQueryTargetKey row_key;
+  LevelDbTargetFingerprintKey row_key;
   for (; index_iterator->Valid(); index_iterator->Next()) {
-    // Only consider rows matching exactly the specific canonical_id of
-    // interest.
+    // Only consider rows matching exactly the fingerprint of interest. The
+    // prefix includes the whole fingerprint component, so any row with this
+    // prefix has the same fingerprint.
     if (!absl::StartsWith(index_iterator->key(), index_prefix) ||
-        !row_key.Decode(index_iterator->key()) ||
-        canonical_id != row_key.canonical_id()) {
-      // End of this canonical_id's possible targets.
+        !row_key.Decode(index_iterator->key())) {
+      // End of this fingerprint's possible targets.
       break;
     }
 
-    // Each row is a unique combination of canonical_id and target_id, so this
+    // Each row is a unique combination of fingerprint and target_id, so this
     // foreign key reference can only occur once.
     std::string target_key = LevelDbTargetKey::Key(row_key.target_id());
     target_iterator->Seek(target_key);
     if (!target_iterator->Valid() || target_iterator->key() != target_key) {
       LOG_WARN(
-          "Dangling query-target reference found: "
+          "Dangling target-fingerprint reference found: "
           "%s points to %s; seeking there found %s",
           DescribeKey(index_iterator), DescribeKey(target_key),
           DescribeKey(target_iterator));
@@ -181,6 +207,7 @@ absl::optional<TargetData> LevelDbTargetCache::GetTarget(const Target& target) {
     // actually equal to the requested target.
     TargetData target_data = DecodeTarget(target_iterator->value());
     if (target_data.target() == target) {
+      CacheTarget(target_data);
       return target_data;
     }
   }
@@ -204,7 +231,8 @@ void LevelDbTargetCache::EnumerateSequenceNumbers(
 
 size_t LevelDbTargetCache::RemoveTargets(
     ListenSequenceNumber upper_bound,
-    const std::unordered_map<model::TargetId, TargetData>& live_targets) {
+    const std::unordered_map<model::TargetId, TargetData>& live_targets,
+    absl::optional<size_t> limit) {
   std::string target_prefix = LevelDbTargetKey::KeyPrefix();
   auto it = db_->current_transaction()->NewIterator();
   it->Seek(target_prefix);
@@ -217,6 +245,10 @@ size_t LevelDbTargetCache::RemoveTargets(
   // model, we only convert it into the underlying Protobuf message.
   for (; it->Valid() && absl::StartsWith(it->key(), target_prefix);
        it->Next()) {
+    if (limit && removed_targets.size() >= *limit) {
+      break;
+    }
+
     StringReader reader{it->value()};
     auto target_proto = DecodeTargetProto(&reader);
     if (target_proto->last_listen_sequence_number <= upper_bound &&
@@ -234,6 +266,12 @@ size_t LevelDbTargetCache::RemoveTargets(
 
   // Remove the CanonicalId to TargetId mapping
   RemoveQueryTargetKeyForTargets(removed_targets);
+  RemoveTargetFingerprintKeyForTargets(removed_targets);
+
+  target_lookup_cache_.EraseIf(
+      [&](const Target&, const TargetData& target_data) {
+        return removed_targets.count(target_data.target_id()) > 0;
+      });
 
   metadata_->target_count -= removed_targets.size();
   SaveMetadata();
@@ -309,6 +347,28 @@ void LevelDbTargetCache::RemoveQueryTargetKeyForTargets(
   }
 }
 
+void LevelDbTargetCache::RemoveTargetFingerprintKeyForTargets(
+    const std::unordered_set<TargetId>& target_ids) {
+  std::string index_prefix = LevelDbTargetFingerprintKey::KeyPrefix();
+  auto index_iterator = db_->current_transaction()->NewIterator();
+  index_iterator->Seek(index_prefix);
+
+  LevelDbTargetFingerprintKey row_key;
+  for (; index_iterator->Valid(); index_iterator->Next()) {
+    if (!row_key.Decode(index_iterator->key())) {
+      break;
+    }
+
+    if (target_ids.find(row_key.target_id()) != target_ids.end()) {
+      db_->current_transaction()->Delete(index_iterator->key());
+    }
+  }
+}
+
+void LevelDbTargetCache::CacheTarget(const TargetData& target_data) {
+  target_lookup_cache_.Put(target_data.target(), target_data);
+}
+
 DocumentKeySet LevelDbTargetCache::GetMatchingKeys(TargetId target_id) {
   std::string index_prefix = LevelDbTargetDocumentKey::KeyPrefix(target_id);
   auto index_iterator = db_->current_transaction()->NewIterator();
@@ -365,6 +425,15 @@ void LevelDbTargetCache::SetLastRemoteSnapshotVersion(SnapshotVersion version) {
 
 void LevelDbTargetCache::EnumerateOrphanedDocuments(
     const OrphanedDocumentCallback& callback) {
+  EnumerateOrphanedDocumentsWhile(
+      [&](const DocumentKey& key, ListenSequenceNumber sequence_number) {
+        callback(key, sequence_number);
+        return true;
+      });
+}
+
+void LevelDbTargetCache::EnumerateOrphanedDocumentsWhile(
+    const OrphanedDocumentPredicate& callback) {
   std::string document_target_prefix = LevelDbDocumentTargetKey::KeyPrefix();
   auto it = db_->current_transaction()->NewIterator();
   it->Seek(document_target_prefix);
@@ -378,8 +447,8 @@ void LevelDbTargetCache::EnumerateOrphanedDocuments(
     if (key.IsSentinel()) {
       // if next_to_report is non-zero, report it, this is a new key so the last
       // one must be not be a member of any targets.
-      if (next_to_report != 0) {
-        callback(key_to_report, next_to_report);
+      if (next_to_report != 0 && !callback(key_to_report, next_to_report)) {
+        return;
       }
       // set next_to_report to be this sequence number. It's the next one we
       // might report, if we don't find any targets for this document.
@@ -404,6 +473,10 @@ void LevelDbTargetCache::Save(const TargetData& target_data) {
   std::string key = LevelDbTargetKey::Key(target_id);
   db_->current_transaction()->Put(key,
                                   serializer_->EncodeTargetData(target_data));
+
+  if (TargetData* cached = target_lookup_cache_.Get(target_data.target())) {
+    *cached = target_data;
+  }
 }
 
 bool LevelDbTargetCache::UpdateMetadata(const TargetData& target_data) {
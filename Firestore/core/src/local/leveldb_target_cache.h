@@ -21,10 +21,13 @@
 #include <unordered_set>
 
 #include "Firestore/Protos/nanopb/firestore/local/target.nanopb.h"
+#include "Firestore/core/src/core/target.h"
 #include "Firestore/core/src/local/target_cache.h"
+#include "Firestore/core/src/local/target_data.h"
 #include "Firestore/core/src/model/model_fwd.h"
 #include "Firestore/core/src/model/snapshot_version.h"
 #include "Firestore/core/src/nanopb/message.h"
+#include "Firestore/core/src/util/lru_cache.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
 #include "leveldb/db.h"
@@ -35,7 +38,6 @@ namespace local {
 
 class LevelDbPersistence;
 class LocalSerializer;
-class TargetData;
 
 /** Cached Queries backed by LevelDB. */
 class LevelDbTargetCache : public TargetCache {
@@ -75,9 +77,10 @@ class LevelDbTargetCache : public TargetCache {
   void EnumerateSequenceNumbers(
       const SequenceNumberCallback& callback) override;
 
-  size_t RemoveTargets(model::ListenSequenceNumber upper_bound,
-                       const std::unordered_map<model::TargetId, TargetData>&
-                           live_targets) override;
+  size_t RemoveTargets(
+      model::ListenSequenceNumber upper_bound,
+      const std::unordered_map<model::TargetId, TargetData>& live_targets,
+      absl::optional<size_t> limit) override;
 
   // Key-related methods
 
@@ -125,6 +128,13 @@ class LevelDbTargetCache : public TargetCache {
 
   void EnumerateOrphanedDocuments(const OrphanedDocumentCallback& callback);
 
+  /**
+   * Like `EnumerateOrphanedDocuments`, but stops enumerating as soon as
+   * `callback` returns false.
+   */
+  void EnumerateOrphanedDocumentsWhile(
+      const OrphanedDocumentPredicate& callback);
+
  private:
   void Save(const TargetData& target_data);
   bool UpdateMetadata(const TargetData& target_data);
@@ -144,6 +154,13 @@ class LevelDbTargetCache : public TargetCache {
   void RemoveQueryTargetKeyForTargets(
       const std::unordered_set<model::TargetId>& target_id);
 
+  /** Removes the given targets from the fingerprint to target mapping. */
+  void RemoveTargetFingerprintKeyForTargets(
+      const std::unordered_set<model::TargetId>& target_ids);
+
+  /** Adds the given target, read from LevelDB, to the lookup cache. */
+  void CacheTarget(const TargetData& target_data);
+
   // The LevelDbTargetCache is owned by LevelDbPersistence.
   LevelDbPersistence* db_;
   // Owned by LevelDbPersistence.
@@ -152,6 +169,14 @@ class LevelDbTargetCache : public TargetCache {
   /** A write-through cached copy of the metadata for the target cache. */
   nanopb::Message<firestore_client_TargetGlobal> metadata_;
 
+  /**
+   * A cache of targets previously returned by `GetTarget`, so that listening
+   * to the same target again resolves it without reading or decoding anything
+   * from LevelDB. Entries are kept up to date by `Save` and dropped when
+   * their target is removed; only the most recently used targets are kept.
+   */
+  util::LruCache<core::Target, TargetData> target_lookup_cache_;
+
   model::SnapshotVersion last_remote_snapshot_version_;
 };
 
@@ -169,8 +169,18 @@ const WriteOptions& LevelDbTransaction::DefaultWriteOptions() {
 }
 
 void LevelDbTransaction::Put(std::string key, std::string value) {
-  deletions_.erase(key);
-  mutations_[std::move(key)] = std::move(value);
+  if (deletions_.erase(key) > 0) {
+    changed_bytes_ -= key.size();
+  }
+
+  auto inserted = mutations_.emplace(std::move(key), std::string());
+  std::string& mutation = inserted.first->second;
+  if (inserted.second) {
+    changed_bytes_ += inserted.first->first.size();
+  }
+  changed_bytes_ += value.size();
+  changed_bytes_ -= mutation.size();
+  mutation = std::move(value);
   version_++;
 }
 
@@ -196,8 +206,14 @@ Status LevelDbTransaction::Get(absl::string_view key, std::string* value) {
 
 void LevelDbTransaction::Delete(absl::string_view key) {
   std::string to_delete(key);
-  deletions_.insert(to_delete);
-  mutations_.erase(to_delete);
+  auto mutation = mutations_.find(to_delete);
+  if (mutation != mutations_.end()) {
+    changed_bytes_ -= mutation->first.size() + mutation->second.size();
+    mutations_.erase(mutation);
+  }
+  if (deletions_.insert(std::move(to_delete)).second) {
+    changed_bytes_ += key.size();
+  }
   version_++;
 }
 
@@ -149,6 +149,22 @@ class LevelDbTransaction {
     return mutations_.size() + deletions_.size();
   }
 
+  /**
+   * Returns the snapshot this transaction reads from, or null if it reads the
+   * latest committed data.
+   */
+  const leveldb::Snapshot* snapshot() const {
+    return read_options_.snapshot;
+  }
+
+  /**
+   * Returns the number of bytes in the keys and values of the pending changes,
+   * which approximates the size of the batch written by `Commit`.
+   */
+  size_t changed_bytes() const {
+    return changed_bytes_;
+  }
+
   /**
    * Remove the database entry (if any) for "key".  It is not an error if "key"
    * did not exist in the database.
@@ -196,6 +212,9 @@ class LevelDbTransaction {
   leveldb::DB* db_ = nullptr;
   Mutations mutations_;
   Deletions deletions_;
+  // The running total returned by `changed_bytes`, kept up to date by `Put`
+  // and `Delete`.
+  size_t changed_bytes_ = 0;
   leveldb::ReadOptions read_options_;
   leveldb::WriteOptions write_options_;
   int32_t version_ = 0;
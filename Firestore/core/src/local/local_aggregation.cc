@@ -0,0 +1,223 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/local/local_aggregation.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/core/query.h"
+#include "Firestore/core/src/model/document.h"
+#include "Firestore/core/src/model/document_set.h"
+#include "Firestore/core/src/model/field_path.h"
+#include "Firestore/core/src/model/value_util.h"
+#include "Firestore/core/src/nanopb/message.h"
+#include "Firestore/core/src/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+namespace {
+
+using core::Query;
+using model::AggregateField;
+using model::Document;
+using model::DocumentMap;
+using model::DocumentSet;
+using model::FieldPath;
+using model::ObjectValue;
+using nanopb::Message;
+
+/** Accumulates the numeric values of one field for SUM and AVERAGE. */
+class NumericAccumulator {
+ public:
+  void Add(const google_firestore_v1_Value& value) {
+    if (model::IsInteger(value)) {
+      ++count_;
+      double_sum_ += static_cast<double>(value.integer_value);
+      if (is_integer_ && !AddWithoutOverflow(value.integer_value)) {
+        is_integer_ = false;
+      }
+    } else if (model::IsDouble(value)) {
+      ++count_;
+      double_sum_ += value.double_value;
+      is_integer_ = false;
+    }
+  }
+
+  Message<google_firestore_v1_Value> Sum() const {
+    Message<google_firestore_v1_Value> result;
+    if (is_integer_) {
+      result->which_value_type = google_firestore_v1_Value_integer_value_tag;
+      result->integer_value = integer_sum_;
+    } else {
+      result->which_value_type = google_firestore_v1_Value_double_value_tag;
+      result->double_value = double_sum_;
+    }
+    return result;
+  }
+
+  Message<google_firestore_v1_Value> Average() const {
+    Message<google_firestore_v1_Value> result;
+    if (count_ == 0) {
+      *result = model::NullValue();
+    } else {
+      result->which_value_type = google_firestore_v1_Value_double_value_tag;
+      result->double_value = double_sum_ / static_cast<double>(count_);
+    }
+    return result;
+  }
+
+ private:
+  bool AddWithoutOverflow(int64_t value) {
+    if ((value > 0 &&
+         integer_sum_ > std::numeric_limits<int64_t>::max() - value) ||
+        (value < 0 &&
+         integer_sum_ < std::numeric_limits<int64_t>::min() - value)) {
+      return false;
+    }
+    integer_sum_ += value;
+    return true;
+  }
+
+  int64_t count_ = 0;
+  int64_t integer_sum_ = 0;
+  double double_sum_ = 0;
+  bool is_integer_ = true;
+};
+
+/** Returns the documents in `documents` that are part of the query result. */
+std::vector<Document> ApplyQuery(const Query& query,
+                                 const DocumentMap& documents) {
+  std::vector<Document> result;
+  if (!query.has_limit()) {
+    // Without a limit the order doesn't matter, so there is no need to sort.
+    for (const auto& entry : documents) {
+      const Document& doc = entry.second;
+      if (doc->is_found_document() && query.Matches(doc)) {
+        result.push_back(doc);
+      }
+    }
+    return result;
+  }
+
+  DocumentSet sorted(query.Comparator());
+  for (const auto& entry : documents) {
+    const Document& doc = entry.second;
+    if (doc->is_found_document() && query.Matches(doc)) {
+      sorted = sorted.insert(doc);
+    }
+  }
+
+  size_t limit = static_cast<size_t>(query.limit());
+  size_t skip = 0;
+  if (query.has_limit_to_last() && sorted.size() > limit) {
+    skip = sorted.size() - limit;
+  }
+  for (const Document& doc : sorted) {
+    if (skip > 0) {
+      --skip;
+      continue;
+    }
+    if (result.size() == limit) break;
+    result.push_back(doc);
+  }
+  return result;
+}
+
+FieldPath AliasPath(const AggregateField& aggregate) {
+  return FieldPath::FromSegments(
+      std::vector<std::string>{aggregate.alias.StringValue()});
+}
+
+Message<google_firestore_v1_Value> CountValue(size_t count) {
+  Message<google_firestore_v1_Value> value;
+  value->which_value_type = google_firestore_v1_Value_integer_value_tag;
+  value->integer_value = static_cast<int64_t>(count);
+  return value;
+}
+
+}  // namespace
+
+bool IsCountOnly(const std::vector<AggregateField>& aggregates) {
+  for (const AggregateField& aggregate : aggregates) {
+    if (aggregate.op != AggregateField::OpKind::Count) {
+      return false;
+    }
+  }
+  return true;
+}
+
+ObjectValue ComputeCounts(const Query& query,
+                          const std::vector<AggregateField>& aggregates,
+                          size_t count) {
+  HARD_ASSERT(IsCountOnly(aggregates), "Expected only COUNT aggregations");
+  if (query.has_limit()) {
+    count = std::min(count, static_cast<size_t>(query.limit()));
+  }
+
+  ObjectValue result;
+  for (const AggregateField& aggregate : aggregates) {
+    result.Set(AliasPath(aggregate), CountValue(count));
+  }
+  return result;
+}
+
+ObjectValue ComputeAggregates(const Query& query,
+                              const std::vector<AggregateField>& aggregates,
+                              const DocumentMap& documents) {
+  std::vector<Document> results = ApplyQuery(query, documents);
+
+  ObjectValue result;
+  for (const AggregateField& aggregate : aggregates) {
+    FieldPath alias = AliasPath(aggregate);
+
+    if (aggregate.op == AggregateField::OpKind::Count) {
+      result.Set(alias, CountValue(results.size()));
+      continue;
+    }
+
+    NumericAccumulator accumulator;
+    for (const Document& doc : results) {
+      absl::optional<google_firestore_v1_Value> value =
+          doc->field(aggregate.fieldPath);
+      if (value.has_value()) {
+        accumulator.Add(*value);
+      }
+    }
+
+    switch (aggregate.op) {
+      case AggregateField::OpKind::Sum:
+        result.Set(alias, accumulator.Sum());
+        break;
+      case AggregateField::OpKind::Avg:
+        result.Set(alias, accumulator.Average());
+        break;
+      case AggregateField::OpKind::Count:
+        UNREACHABLE();
+    }
+  }
+  return result;
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
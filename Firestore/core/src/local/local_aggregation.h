@@ -0,0 +1,70 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_LOCAL_LOCAL_AGGREGATION_H_
+#define FIRESTORE_CORE_SRC_LOCAL_LOCAL_AGGREGATION_H_
+
+#include <vector>
+
+#include "Firestore/core/src/model/aggregate_field.h"
+#include "Firestore/core/src/model/model_fwd.h"
+#include "Firestore/core/src/model/object_value.h"
+
+namespace firebase {
+namespace firestore {
+
+namespace core {
+class Query;
+}  // namespace core
+
+namespace local {
+
+/**
+ * Evaluates `aggregates` over the documents in `documents` that match `query`,
+ * including the query's limit, and returns the results keyed by alias in the
+ * same shape as `Datastore::RunAggregateQuery`.
+ *
+ * The aggregations follow the backend's semantics:
+ *
+ *   - COUNT is the number of matching documents, as an integer.
+ *   - SUM ignores documents whose field is missing or not a number. It is an
+ *     integer if all summed values are integers and the sum does not overflow,
+ *     and a double otherwise. The sum of no values is the integer 0.
+ *   - AVERAGE ignores the same documents as SUM and is always a double, or null
+ *     if no document has a numeric value for the field.
+ */
+model::ObjectValue ComputeAggregates(
+    const core::Query& query,
+    const std::vector<model::AggregateField>& aggregates,
+    const model::DocumentMap& documents);
+
+/** Returns whether all of `aggregates` are COUNTs. */
+bool IsCountOnly(const std::vector<model::AggregateField>& aggregates);
+
+/**
+ * Returns the results of `aggregates`, which must all be COUNTs, when `count`
+ * documents match `query` before its limit is applied.
+ */
+model::ObjectValue ComputeCounts(
+    const core::Query& query,
+    const std::vector<model::AggregateField>& aggregates,
+    size_t count);
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_LOCAL_LOCAL_AGGREGATION_H_
@@ -17,6 +17,7 @@
 #include "Firestore/core/src/local/local_documents_view.h"
 
 #include <algorithm>
+#include <iterator>
 #include <map>
 #include <memory>
 #include <set>
@@ -114,21 +115,43 @@ model::DocumentMap LocalDocumentsView::GetDocumentsMatchingCollectionGroupQuery(
   const std::string& collection_id = *query.collection_group();
   std::vector<ResourcePath> parents =
       index_manager_->GetCollectionParents(collection_id);
-  DocumentMap results;
 
   // Perform a collection query against each parent that contains the
-  // collection_id and aggregate the results.
+  // collection_id and aggregate the results. The remote document cache may
+  // scan the collections concurrently.
+  std::vector<Query> collection_queries;
+  std::vector<OverlayByDocumentKeyMap> overlays;
+  collection_queries.reserve(parents.size());
+  overlays.reserve(parents.size());
   for (const ResourcePath& parent : parents) {
-    Query collection_query =
-        query.AsCollectionQueryAtPath(parent.Append(collection_id));
-    DocumentMap collection_results =
-        GetDocumentsMatchingCollectionQuery(collection_query, offset, context);
-    for (const auto& kv : collection_results) {
-      const DocumentKey& key = kv.first;
-      results = results.insert(key, Document(kv.second));
-    }
+    collection_queries.push_back(
+        query.AsCollectionQueryAtPath(parent.Append(collection_id)));
+    overlays.push_back(document_overlay_cache_->GetOverlays(
+        collection_queries.back().path(), offset.largest_batch_id()));
   }
-  return results;
+  std::vector<MutableDocumentMap> remote_documents =
+      remote_document_cache_->GetDocumentsMatchingQueries(
+          collection_queries, offset, context, overlays);
+
+  std::vector<std::pair<DocumentKey, Document>> results;
+  for (size_t i = 0; i < collection_queries.size(); ++i) {
+    AppendMatchingDocuments(collection_queries[i],
+                            std::move(remote_documents[i]), overlays[i],
+                            &results);
+  }
+
+  // The documents of each collection are in key order, but the documents of
+  // a collection can sort between the ones of another collection that is a
+  // prefix of its path.
+  auto by_key = [](const std::pair<DocumentKey, Document>& lhs,
+                   const std::pair<DocumentKey, Document>& rhs) {
+    return lhs.first < rhs.first;
+  };
+  if (!std::is_sorted(results.begin(), results.end(), by_key)) {
+    std::sort(results.begin(), results.end(), by_key);
+  }
+  return DocumentMap::FromSortedRange(std::make_move_iterator(results.begin()),
+                                      std::make_move_iterator(results.end()));
 }
 
 LocalWriteResult LocalDocumentsView::GetNextDocuments(
@@ -173,6 +196,18 @@ DocumentMap LocalDocumentsView::GetDocumentsMatchingCollectionQuery(
       remote_document_cache_->GetDocumentsMatchingQuery(
           query, offset, context, absl::nullopt, overlays);
 
+  std::vector<std::pair<DocumentKey, Document>> results;
+  AppendMatchingDocuments(query, std::move(remote_documents), overlays,
+                          &results);
+  return DocumentMap::FromSortedRange(std::make_move_iterator(results.begin()),
+                                      std::make_move_iterator(results.end()));
+}
+
+void LocalDocumentsView::AppendMatchingDocuments(
+    const Query& query,
+    MutableDocumentMap remote_documents,
+    const OverlayByDocumentKeyMap& overlays,
+    std::vector<std::pair<DocumentKey, Document>>* results) {
   // As documents might match the query because of their overlay we need to
   // include documents for all overlays in the initial document set.
   for (const auto& entry : overlays) {
@@ -183,7 +218,6 @@ DocumentMap LocalDocumentsView::GetDocumentsMatchingCollectionQuery(
   }
 
   // Apply the overlays and match against the query.
-  DocumentMap results;
   for (const auto& entry : remote_documents) {
     const auto& key = entry.first;
     MutableDocument doc = entry.second;
@@ -194,13 +228,11 @@ DocumentMap LocalDocumentsView::GetDocumentsMatchingCollectionQuery(
           .second.mutation()
           .ApplyToLocalView(doc, FieldMask(), Timestamp::Now());
     }
-    // Finally, insert the documents that still match the query
+    // Finally, keep the documents that still match the query
     if (query.Matches(doc)) {
-      results = results.insert(key, std::move(doc));
+      results->emplace_back(key, Document{std::move(doc)});
     }
   }
-
-  return results;
 }
 
 Document LocalDocumentsView::GetDocument(const DocumentKey& key) {
@@ -20,6 +20,7 @@
 #include <cstddef>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "Firestore/core/src/immutable/sorted_set.h"
@@ -197,6 +198,16 @@ class LocalDocumentsView {
   }
 
  private:
+  /**
+   * Applies `overlays` to the documents of a collection query and appends the
+   * documents that then match `query` to `results`, in key order.
+   */
+  static void AppendMatchingDocuments(
+      const core::Query& query,
+      model::MutableDocumentMap remote_documents,
+      const model::OverlayByDocumentKeyMap& overlays,
+      std::vector<std::pair<model::DocumentKey, model::Document>>* results);
+
   /** Returns a base document that can be used to apply `overlay`. */
   model::MutableDocument GetBaseDocument(
       const model::DocumentKey& key,
@@ -24,6 +24,7 @@
 #include "Firestore/core/src/credentials/user.h"
 #include "Firestore/core/src/local/bundle_cache.h"
 #include "Firestore/core/src/local/index_backfiller.h"
+#include "Firestore/core/src/local/local_aggregation.h"
 #include "Firestore/core/src/local/local_documents_view.h"
 #include "Firestore/core/src/local/local_view_changes.h"
 #include "Firestore/core/src/local/local_write_result.h"
@@ -192,61 +193,79 @@ DocumentMap LocalStore::HandleUserChange(const User& user) {
 
 LocalWriteResult LocalStore::WriteLocally(std::vector<Mutation>&& mutations) {
   Timestamp local_write_time = Timestamp::Now();
+  return persistence_->Run("Locally write mutations", [&] {
+    return WriteLocallyInTransaction(std::move(mutations), local_write_time);
+  });
+}
+
+std::vector<LocalWriteResult> LocalStore::WriteLocally(
+    std::vector<std::vector<Mutation>>&& batches) {
+  Timestamp local_write_time = Timestamp::Now();
+  return persistence_->Run("Locally write mutation batches", [&] {
+    std::vector<LocalWriteResult> results;
+    results.reserve(batches.size());
+    for (std::vector<Mutation>& mutations : batches) {
+      results.push_back(
+          WriteLocallyInTransaction(std::move(mutations), local_write_time));
+    }
+    return results;
+  });
+}
+
+LocalWriteResult LocalStore::WriteLocallyInTransaction(
+    std::vector<Mutation>&& mutations, const Timestamp& local_write_time) {
   DocumentKeySet keys;
   for (const Mutation& mutation : mutations) {
     keys = keys.insert(mutation.key());
   }
 
-  return persistence_->Run("Locally write mutations", [&] {
-    // Figure out which keys do not have a remote version in the cache, this is
-    // needed to create the right overlay mutation: if no remote version
-    // presents, we do not need to create overlays as patch mutations.
-    // TODO(Overlay): Is there a better way to determine this? Document version
-    // does not work because local mutations set them back to 0.
-    auto remote_docs = remote_document_cache_->GetAll(keys);
-    std::unordered_set<DocumentKey, DocumentKeyHash>
-        docs_without_remote_version;
-    for (const auto& entry : remote_docs) {
-      if (!entry.second.is_valid_document()) {
-        docs_without_remote_version.insert(entry.first);
-      }
+  // Figure out which keys do not have a remote version in the cache, this is
+  // needed to create the right overlay mutation: if no remote version
+  // presents, we do not need to create overlays as patch mutations.
+  // TODO(Overlay): Is there a better way to determine this? Document version
+  // does not work because local mutations set them back to 0.
+  auto remote_docs = remote_document_cache_->GetAll(keys);
+  std::unordered_set<DocumentKey, DocumentKeyHash> docs_without_remote_version;
+  for (const auto& entry : remote_docs) {
+    if (!entry.second.is_valid_document()) {
+      docs_without_remote_version.insert(entry.first);
     }
-    // Load and apply all existing mutations. This lets us compute the current
-    // base state for all non-idempotent transforms before applying any
-    // additional user-provided writes.
-    auto overlayed_documents =
-        local_documents_->GetOverlayedDocuments(remote_docs);
-
-    // For non-idempotent mutations (such as `FieldValue.increment()`), we
-    // record the base state in a separate patch mutation. This is later used to
-    // guarantee consistent values and prevents flicker even if the backend
-    // sends us an update that already includes our transform.
-    std::vector<Mutation> base_mutations;
-    for (const Mutation& mutation : mutations) {
-      auto it = overlayed_documents.find(mutation.key());
-      HARD_ASSERT(it != overlayed_documents.end(),
-                  "Failed to find overlayed document with mutation key: %s",
-                  it->first.ToString());
-      absl::optional<ObjectValue> base_value =
-          mutation.ExtractTransformBaseValue(it->second.document());
-      if (base_value) {
-        // NOTE: The base state should only be applied if there's some existing
-        // document to override, so use a Precondition of exists=true
-        model::FieldMask mask = base_value->ToFieldMask();
-        base_mutations.push_back(PatchMutation(mutation.key(),
-                                               std::move(*base_value), mask,
-                                               Precondition::Exists(true)));
-      }
+  }
+  // Load and apply all existing mutations. This lets us compute the current
+  // base state for all non-idempotent transforms before applying any
+  // additional user-provided writes.
+  auto overlayed_documents =
+      local_documents_->GetOverlayedDocuments(remote_docs);
+
+  // For non-idempotent mutations (such as `FieldValue.increment()`), we
+  // record the base state in a separate patch mutation. This is later used to
+  // guarantee consistent values and prevents flicker even if the backend
+  // sends us an update that already includes our transform.
+  std::vector<Mutation> base_mutations;
+  for (const Mutation& mutation : mutations) {
+    auto it = overlayed_documents.find(mutation.key());
+    HARD_ASSERT(it != overlayed_documents.end(),
+                "Failed to find overlayed document with mutation key: %s",
+                it->first.ToString());
+    absl::optional<ObjectValue> base_value =
+        mutation.ExtractTransformBaseValue(it->second.document());
+    if (base_value) {
+      // NOTE: The base state should only be applied if there's some existing
+      // document to override, so use a Precondition of exists=true
+      model::FieldMask mask = base_value->ToFieldMask();
+      base_mutations.push_back(PatchMutation(mutation.key(),
+                                             std::move(*base_value), mask,
+                                             Precondition::Exists(true)));
     }
+  }
 
-    MutationBatch batch = mutation_queue_->AddMutationBatch(
-        local_write_time, std::move(base_mutations), std::move(mutations));
-    std::unordered_map<DocumentKey, Mutation, DocumentKeyHash> overlays =
-        batch.ApplyToLocalDocumentSet(overlayed_documents);
-    document_overlay_cache_->SaveOverlays(batch.batch_id(), overlays);
-    return LocalWriteResult::FromOverlayedDocuments(
-        batch.batch_id(), std::move(overlayed_documents));
-  });
+  MutationBatch batch = mutation_queue_->AddMutationBatch(
+      local_write_time, std::move(base_mutations), std::move(mutations));
+  std::unordered_map<DocumentKey, Mutation, DocumentKeyHash> overlays =
+      batch.ApplyToLocalDocumentSet(overlayed_documents);
+  document_overlay_cache_->SaveOverlays(batch.batch_id(), overlays);
+  return LocalWriteResult::FromOverlayedDocuments(
+      batch.batch_id(), std::move(overlayed_documents));
 }
 
 DocumentMap LocalStore::AcknowledgeBatch(
@@ -302,7 +321,12 @@ DocumentMap LocalStore::RejectBatch(BatchId batch_id) {
     document_overlay_cache_->RemoveOverlaysForBatchId(batch_id);
     local_documents_->RecalculateAndSaveOverlays(to_reject.value().keys());
 
-    return local_documents_->GetDocuments(to_reject->keys());
+    DocumentMap documents = local_documents_->GetDocuments(to_reject->keys());
+    // The documents may have been indexed with the rejected mutations applied.
+    // Their remote versions did not change, so the index backfiller won't
+    // revisit them.
+    index_manager_->UpdateIndexEntries(documents);
+    return documents;
   });
 }
 
@@ -552,7 +576,8 @@ void LocalStore::ReleaseTarget(TargetId target_id) {
 }
 
 QueryResult LocalStore::ExecuteQuery(const Query& query,
-                                     bool use_previous_results) {
+                                     bool use_previous_results,
+                                     QueryPlan* plan) {
   return persistence_->Run("ExecuteQuery", [&] {
     absl::optional<TargetData> target_data = GetTargetData(query.ToTarget());
     SnapshotVersion last_limbo_free_snapshot_version;
@@ -568,11 +593,43 @@ QueryResult LocalStore::ExecuteQuery(const Query& query,
         query,
         use_previous_results ? last_limbo_free_snapshot_version
                              : SnapshotVersion::None(),
-        use_previous_results ? remote_keys : DocumentKeySet{});
+        use_previous_results ? remote_keys : DocumentKeySet{}, plan);
     return QueryResult(std::move(documents), std::move(remote_keys));
   });
 }
 
+ObjectValue LocalStore::RunAggregateQuery(
+    const Query& query, const std::vector<model::AggregateField>& aggregates) {
+  return persistence_->Run("RunAggregateQuery", [&] {
+    absl::optional<TargetData> target_data = GetTargetData(query.ToTarget());
+    SnapshotVersion last_limbo_free_snapshot_version;
+    DocumentKeySet remote_keys;
+
+    if (target_data) {
+      last_limbo_free_snapshot_version =
+          target_data->last_limbo_free_snapshot_version();
+      remote_keys = target_cache_->GetMatchingKeys(target_data->target_id());
+    }
+
+    if (IsCountOnly(aggregates)) {
+      // Counts only need the keys of the matching documents, which a field
+      // index that fully serves the query provides without reading them.
+      absl::optional<size_t> count =
+          query_engine_->CountDocumentsMatchingQueryUsingIndex(query);
+      if (count.has_value()) {
+        return ComputeCounts(query, aggregates, count.value());
+      }
+    }
+
+    // The query engine picks the cheapest way to find the candidates (which
+    // may be a field index), but every candidate is checked against the query
+    // since index entries can lag behind the cache.
+    DocumentMap documents = query_engine_->GetDocumentsMatchingQuery(
+        query, last_limbo_free_snapshot_version, remote_keys);
+    return ComputeAggregates(query, aggregates, documents);
+  });
+}
+
 DocumentKeySet LocalStore::GetRemoteDocumentKeys(TargetId target_id) {
   return persistence_->Run("RemoteDocumentKeysForTarget", [&] {
     return target_cache_->GetMatchingKeys(target_id);
@@ -585,12 +642,23 @@ LruResults LocalStore::CollectGarbage(LruGarbageCollector* garbage_collector) {
   });
 }
 
+LruResults LocalStore::CollectGarbageSlice(
+    LruGarbageCollector* garbage_collector) {
+  return persistence_->Run("Collect garbage slice", [&] {
+    return garbage_collector->CollectSlice(target_data_by_target_);
+  });
+}
+
 int LocalStore::Backfill() const {
   return persistence_->Run("Backfill Indexes", [&] {
     return index_backfiller_->WriteIndexEntries(this);
   });
 }
 
+IndexBackfillProgress LocalStore::GetIndexBackfillProgress() const {
+  return index_backfiller_->progress();
+}
+
 bool LocalStore::HasNewerBundle(const bundle::BundleMetadata& metadata) {
   return persistence_->Run("Has newer bundle", [&] {
     absl::optional<bundle::BundleMetadata> cached_metadata =
@@ -612,30 +680,49 @@ DocumentMap LocalStore::ApplyBundledDocuments(
   TargetData umbrella_target = AllocateTarget(NewUmbrellaTarget(bundle_id));
   return persistence_->Run("Apply bundle documents", [&] {
     DocumentKeySet keys;
-    DocumentUpdateMap document_updates;
-    DocumentVersionMap versions;
-
     for (const auto& kv : bundled_documents) {
-      const DocumentKey& key = kv.first;
-      const auto& doc = kv.second;
-      if (doc.is_found_document()) {
-        keys = keys.insert(key);
+      if (kv.second.is_found_document()) {
+        keys = keys.insert(kv.first);
       }
-      document_updates.emplace(key, doc);
-      versions.emplace(key, doc.version());
     }
 
     target_cache_->RemoveMatchingKeysForTarget(umbrella_target.target_id());
     target_cache_->AddMatchingKeys(keys, umbrella_target.target_id());
 
-    auto result = PopulateDocumentChanges(document_updates, versions,
-                                          SnapshotVersion::None());
-    return local_documents_->GetLocalViewOfDocuments(
-        std::move(result.changed_docs),
-        std::move(result.existence_changed_keys));
+    return WriteBundledDocuments(bundled_documents);
   });
 }
 
+DocumentMap LocalStore::ApplyBundledDocumentChunk(
+    const MutableDocumentMap& documents) {
+  return persistence_->Run("Apply bundle document chunk",
+                           [&] { return WriteBundledDocuments(documents); });
+}
+
+void LocalStore::SaveBundledDocumentKeys(const DocumentKeySet& keys,
+                                         const std::string& bundle_id) {
+  TargetData umbrella_target = AllocateTarget(NewUmbrellaTarget(bundle_id));
+  persistence_->Run("Save bundled document keys", [&] {
+    target_cache_->RemoveMatchingKeysForTarget(umbrella_target.target_id());
+    target_cache_->AddMatchingKeys(keys, umbrella_target.target_id());
+  });
+}
+
+DocumentMap LocalStore::WriteBundledDocuments(
+    const MutableDocumentMap& documents) {
+  DocumentUpdateMap document_updates;
+  DocumentVersionMap versions;
+  for (const auto& kv : documents) {
+    document_updates.emplace(kv.first, kv.second);
+    versions.emplace(kv.first, kv.second.version());
+  }
+
+  auto result = PopulateDocumentChanges(document_updates, versions,
+                                        SnapshotVersion::None());
+  return local_documents_->GetLocalViewOfDocuments(
+      std::move(result.changed_docs), std::move(result.existence_changed_keys));
+}
+
 void LocalStore::SaveNamedQuery(const bundle::NamedQuery& query,
                                 const model::DocumentKeySet& keys) {
   // Allocate a target for the named query such that it can be resumed from
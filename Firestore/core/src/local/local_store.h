@@ -22,6 +22,7 @@
 #include <unordered_map>
 #include <vector>
 
+#include "Firestore/core/include/firebase/firestore/timestamp.h"
 #include "Firestore/core/src/bundle/bundle_callback.h"
 #include "Firestore/core/src/bundle/bundle_metadata.h"
 #include "Firestore/core/src/bundle/named_query.h"
@@ -30,8 +31,10 @@
 #include "Firestore/core/src/local/overlay_migration_manager.h"
 #include "Firestore/core/src/local/reference_set.h"
 #include "Firestore/core/src/local/target_data.h"
+#include "Firestore/core/src/model/aggregate_field.h"
 #include "Firestore/core/src/model/document.h"
 #include "Firestore/core/src/model/model_fwd.h"
+#include "Firestore/core/src/model/object_value.h"
 #include "absl/types/optional.h"
 
 namespace firebase {
@@ -65,11 +68,13 @@ class LruGarbageCollector;
 class MutationQueue;
 class Persistence;
 class QueryEngine;
+class QueryPlan;
 class QueryResult;
 class RemoteDocumentCache;
 class TargetCache;
 class IndexBackfiller;
 
+struct IndexBackfillProgress;
 struct LruResults;
 
 /**
@@ -134,6 +139,17 @@ class LocalStore : public bundle::BundleCallback {
   /** Accepts locally generated Mutations and commits them to storage. */
   LocalWriteResult WriteLocally(std::vector<model::Mutation>&& mutations);
 
+  /**
+   * Accepts several batches of locally generated Mutations and commits them to
+   * storage in a single transaction. Each batch is added to the mutation queue
+   * as its own MutationBatch, so batches are still acknowledged and rejected
+   * individually.
+   *
+   * @return The result of each write, in the order of `batches`.
+   */
+  std::vector<LocalWriteResult> WriteLocally(
+      std::vector<std::vector<model::Mutation>>&& batches);
+
   /**
    * Returns the current value of a document with a given key, or an invalid
    * document if not found.
@@ -221,8 +237,21 @@ class LocalStore : public bundle::BundleCallback {
    *
    * @param use_previous_results Whether results from previous executions can be
    *     used to optimize this query execution.
+   * @param plan If not null, receives a description of how the query was
+   *     executed.
    */
-  QueryResult ExecuteQuery(const core::Query& query, bool use_previous_results);
+  QueryResult ExecuteQuery(const core::Query& query,
+                           bool use_previous_results,
+                           QueryPlan* plan = nullptr);
+
+  /**
+   * Evaluates the given aggregations over the results of `query` in the local
+   * cache, including any pending local writes. The result has the same shape
+   * as the result of an aggregation run by the backend.
+   */
+  model::ObjectValue RunAggregateQuery(
+      const core::Query& query,
+      const std::vector<model::AggregateField>& aggregates);
 
   /**
    * Notify the local store of the changed views to locally pin / unpin
@@ -250,12 +279,21 @@ class LocalStore : public bundle::BundleCallback {
 
   LruResults CollectGarbage(LruGarbageCollector* garbage_collector);
 
+  /**
+   * Runs the next slice of incremental garbage collection. See
+   * `LruGarbageCollector::CollectSlice`.
+   */
+  LruResults CollectGarbageSlice(LruGarbageCollector* garbage_collector);
+
   /**
    * Runs a single backfill operation and returns the number of documents
    * processed.
    */
   int Backfill() const;
 
+  /** Returns the progress made by the index backfiller so far. */
+  IndexBackfillProgress GetIndexBackfillProgress() const;
+
   /**
    * Returns whether the given bundle has already been loaded and its create
    * time is newer or equal to the currently loading bundle.
@@ -276,6 +314,18 @@ class LocalStore : public bundle::BundleCallback {
       const model::MutableDocumentMap& documents,
       const std::string& bundle_id) override;
 
+  /**
+   * Applies a chunk of the documents from a bundle to the "ground-state"
+   * (remote) documents, without adding them to the umbrella target of the
+   * bundle.
+   */
+  model::DocumentMap ApplyBundledDocumentChunk(
+      const model::MutableDocumentMap& documents) override;
+
+  /** Sets the document keys held by the umbrella target of a bundle. */
+  void SaveBundledDocumentKeys(const model::DocumentKeySet& keys,
+                               const std::string& bundle_id) override;
+
   /** Saves the given `NamedQuery` to local persistence. */
   void SaveNamedQuery(const bundle::NamedQuery& query,
                       const model::DocumentKeySet& keys) override;
@@ -322,6 +372,14 @@ class LocalStore : public bundle::BundleCallback {
 
   void ApplyBatchResult(const model::MutationBatchResult& batch_result);
 
+  /**
+   * Adds `mutations` to the mutation queue as a new batch. Must be called
+   * within a persistence transaction.
+   */
+  LocalWriteResult WriteLocallyInTransaction(
+      std::vector<model::Mutation>&& mutations,
+      const Timestamp& local_write_time);
+
   /**
    * Returns true if the new_target_data should be persisted during an update of
    * an active target. TargetData should always be persisted when a target is
@@ -351,6 +409,13 @@ class LocalStore : public bundle::BundleCallback {
    */
   static core::Target NewUmbrellaTarget(const std::string& bundle_id);
 
+  /**
+   * Writes the given bundled documents to the remote document cache, and
+   * returns their local views. Must be called in a transaction.
+   */
+  model::DocumentMap WriteBundledDocuments(
+      const model::MutableDocumentMap& documents);
+
   /**
    * Populates the remote document cache with documents from backend or a
    * bundle. Returns the document changes resulting from applying those
@@ -16,17 +16,18 @@
 
 #include "Firestore/core/src/local/lru_garbage_collector.h"
 
+#include <algorithm>
 #include <chrono>  // NOLINT(build/c++11)
 #include <queue>
 #include <string>
 #include <utility>
 
-#include "Firestore/core/include/firebase/firestore/timestamp.h"
 #include "Firestore/core/src/api/settings.h"
 #include "Firestore/core/src/local/target_data.h"
 #include "Firestore/core/src/model/document_key.h"
 #include "Firestore/core/src/util/log.h"
 #include "Firestore/core/src/util/statusor.h"
+#include "absl/strings/str_cat.h"
 
 namespace firebase {
 namespace firestore {
@@ -40,13 +41,7 @@ using model::TargetId;
 using util::StatusOr;
 
 using Millis = std::chrono::milliseconds;
-
-static Millis::rep MillisecondsBetween(const Timestamp& start,
-                                       const Timestamp& end) {
-  return std::chrono::duration_cast<Millis>(end.ToTimePoint() -
-                                            start.ToTimePoint())
-      .count();
-}
+using Stage = LruSliceStats::Stage;
 
 /**
  * RollingSequenceNumberBuffer tracks the nth sequence number in a series.
@@ -92,11 +87,11 @@ class RollingSequenceNumberBuffer {
 const ListenSequenceNumber kListenSequenceNumberInvalid = -1;
 
 LruParams LruParams::Default() {
-  return LruParams{100 * 1024 * 1024, 10, 1000};
+  return LruParams{100 * 1024 * 1024, 10, 1000, 1000};
 }
 
 LruParams LruParams::Disabled() {
-  return LruParams{api::Settings::CacheSizeUnlimited, 0, 0};
+  return LruParams{api::Settings::CacheSizeUnlimited, 0, 0, 0};
 }
 
 LruParams LruParams::WithCacheSize(int64_t cache_size) {
@@ -115,9 +110,79 @@ StatusOr<int64_t> LruGarbageCollector::CalculateByteSize() const {
 }
 
 LruResults LruGarbageCollector::Collect(const LiveQueryMap& live_targets) {
+  if (!ShouldCollect()) {
+    return LruResults::DidNotRun();
+  }
+
+  // A full pass collects everything an incremental one would have.
+  pass_.reset();
+  stats_.pass_in_progress = false;
+  return RunGarbageCollection(live_targets);
+}
+
+LruResults LruGarbageCollector::CollectSlice(const LiveQueryMap& live_targets) {
+  auto start = std::chrono::steady_clock::now();
+
+  if (!pass_) {
+    if (!ShouldCollect()) {
+      return LruResults::DidNotRun();
+    }
+
+    int sequence_numbers = 0;
+    ListenSequenceNumber upper_bound = PlanPass(&sequence_numbers);
+    stats_.slices.clear();
+    RecordSlice(Stage::kPlanning, 0, 0, start);
+    if (upper_bound == kListenSequenceNumberInvalid) {
+      // Nothing to collect.
+      stats_.passes_completed++;
+    } else {
+      pass_ = Pass{upper_bound, /* targets_removed= */ false};
+      stats_.pass_in_progress = true;
+    }
+    return LruResults{/* did_run= */ true, sequence_numbers, 0, 0};
+  }
+
+  // Both stages share the slice's budget. A stage that removes less than its
+  // budget has nothing left to remove.
+  size_t budget =
+      static_cast<size_t>(std::max(params_.maximum_removals_per_slice, 1));
+  Stage stage = Stage::kRemovingDocuments;
+
+  int targets_removed = 0;
+  if (!pass_->targets_removed) {
+    stage = Stage::kRemovingTargets;
+    targets_removed =
+        delegate_->RemoveTargets(pass_->upper_bound, live_targets, budget);
+    budget -= static_cast<size_t>(targets_removed);
+    pass_->targets_removed = budget > 0;
+  }
+
+  int documents_removed = 0;
+  if (budget > 0) {
+    documents_removed =
+        delegate_->RemoveOrphanedDocuments(pass_->upper_bound, budget);
+    budget -= static_cast<size_t>(documents_removed);
+    if (budget > 0) {
+      pass_.reset();
+      stats_.pass_in_progress = false;
+      stats_.passes_completed++;
+    }
+  }
+
+  RecordSlice(stage, targets_removed, documents_removed, start);
+  LOG_DEBUG(
+      "LRU Garbage Collection slice: removed %s targets and %s documents in "
+      "%sms",
+      targets_removed, documents_removed,
+      stats_.slices.back().duration.count());
+  return LruResults{/* did_run= */ true, 0, targets_removed,
+                    documents_removed};
+}
+
+bool LruGarbageCollector::ShouldCollect() {
   if (params_.min_bytes_threshold == Settings::CacheSizeUnlimited) {
     LOG_DEBUG("Garbage collection skipped; disabled");
-    return LruResults::DidNotRun();
+    return false;
   }
 
   StatusOr<int64_t> maybe_current_size = CalculateByteSize();
@@ -126,7 +191,7 @@ LruResults LruGarbageCollector::Collect(const LiveQueryMap& live_targets) {
         "Garbage collection skipped; failed to estimate the size of the "
         "cache: %s",
         maybe_current_size.status().ToString());
-    return LruResults::DidNotRun();
+    return false;
   }
 
   int64_t current_size = maybe_current_size.ValueOrDie();
@@ -135,55 +200,73 @@ LruResults LruGarbageCollector::Collect(const LiveQueryMap& live_targets) {
     LOG_DEBUG(
         "Garbage collection skipped; Cache size %s is lower than threshold %s",
         current_size, params_.min_bytes_threshold);
-    return LruResults::DidNotRun();
+    return false;
   }
 
   LOG_DEBUG("Running garbage collection on cache of size: %s", current_size);
-  return RunGarbageCollection(live_targets);
+  stats_.byte_size = current_size;
+  return true;
 }
 
 LruResults LruGarbageCollector::RunGarbageCollection(
     const LiveQueryMap& live_targets) {
-  Timestamp start = Timestamp::Now();
-
-  // Cap at the configured max
-  int sequence_numbers = QueryCountForPercentile(params_.percentile_to_collect);
-  if (sequence_numbers > params_.maximum_sequence_numbers_to_collect) {
-    sequence_numbers = params_.maximum_sequence_numbers_to_collect;
-  }
-  Timestamp counted_targets = Timestamp::Now();
+  stats_.slices.clear();
 
-  ListenSequenceNumber upper_bound =
-      SequenceNumberForQueryCount(sequence_numbers);
-  Timestamp found_upper_bound = Timestamp::Now();
+  auto start = std::chrono::steady_clock::now();
+  int sequence_numbers = 0;
+  ListenSequenceNumber upper_bound = PlanPass(&sequence_numbers);
+  RecordSlice(Stage::kPlanning, 0, 0, start);
 
+  start = std::chrono::steady_clock::now();
   int num_targets_removed = RemoveTargets(upper_bound, live_targets);
-  Timestamp removed_targets = Timestamp::Now();
+  RecordSlice(Stage::kRemovingTargets, num_targets_removed, 0, start);
 
+  start = std::chrono::steady_clock::now();
   int num_documents_removed = RemoveOrphanedDocuments(upper_bound);
-  Timestamp removed_documents = Timestamp::Now();
+  RecordSlice(Stage::kRemovingDocuments, 0, num_documents_removed, start);
 
+  stats_.passes_completed++;
+
+  const auto& slices = stats_.slices;
   std::string desc = "LRU Garbage Collection:\n";
-  absl::StrAppend(&desc, "\tCounted targets in ",
-                  MillisecondsBetween(start, counted_targets), "ms\n");
   absl::StrAppend(&desc, "\tDetermined least recently used ", sequence_numbers,
-                  " sequence numbers in ",
-                  MillisecondsBetween(counted_targets, found_upper_bound),
+                  " sequence numbers in ", slices[0].duration.count(),
                   "ms\n");
   absl::StrAppend(&desc, "\tRemoved ", num_targets_removed, " targets in ",
-                  MillisecondsBetween(found_upper_bound, removed_targets),
-                  "ms\n");
+                  slices[1].duration.count(), "ms\n");
   absl::StrAppend(&desc, "\tRemoved ", num_documents_removed, " documents in ",
-                  MillisecondsBetween(removed_targets, removed_documents),
-                  "ms\n");
+                  slices[2].duration.count(), "ms\n");
   absl::StrAppend(&desc, "Total duration: ",
-                  MillisecondsBetween(start, removed_documents), "ms");
+                  (slices[0].duration + slices[1].duration + slices[2].duration)
+                      .count(),
+                  "ms");
   LOG_DEBUG(desc.c_str());
 
   return LruResults{/* did_run= */ true, sequence_numbers, num_targets_removed,
                     num_documents_removed};
 }
 
+ListenSequenceNumber LruGarbageCollector::PlanPass(int* sequence_numbers) {
+  // Cap at the configured max
+  int count = QueryCountForPercentile(params_.percentile_to_collect);
+  if (count > params_.maximum_sequence_numbers_to_collect) {
+    count = params_.maximum_sequence_numbers_to_collect;
+  }
+  *sequence_numbers = count;
+  return SequenceNumberForQueryCount(count);
+}
+
+void LruGarbageCollector::RecordSlice(
+    Stage stage,
+    int targets_removed,
+    int documents_removed,
+    std::chrono::steady_clock::time_point start) {
+  auto duration = std::chrono::duration_cast<Millis>(
+      std::chrono::steady_clock::now() - start);
+  stats_.slices.push_back(
+      LruSliceStats{stage, targets_removed, documents_removed, duration});
+}
+
 int LruGarbageCollector::QueryCountForPercentile(int percentile) {
   size_t total_count = delegate_->GetSequenceNumberCount();
   return static_cast<int>((percentile / 100.0f) * total_count);
@@ -212,12 +295,13 @@ ListenSequenceNumber LruGarbageCollector::SequenceNumberForQueryCount(
 
 int LruGarbageCollector::RemoveTargets(ListenSequenceNumber sequence_number,
                                        const LiveQueryMap& live_queries) {
-  return delegate_->RemoveTargets(sequence_number, live_queries);
+  return delegate_->RemoveTargets(sequence_number, live_queries,
+                                  absl::nullopt);
 }
 
 int LruGarbageCollector::RemoveOrphanedDocuments(
     ListenSequenceNumber sequence_number) {
-  return delegate_->RemoveOrphanedDocuments(sequence_number);
+  return delegate_->RemoveOrphanedDocuments(sequence_number, absl::nullopt);
 }
 
 }  // namespace local
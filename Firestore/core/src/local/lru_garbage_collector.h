@@ -17,13 +17,16 @@
 #ifndef FIRESTORE_CORE_SRC_LOCAL_LRU_GARBAGE_COLLECTOR_H_
 #define FIRESTORE_CORE_SRC_LOCAL_LRU_GARBAGE_COLLECTOR_H_
 
+#include <chrono>  // NOLINT(build/c++11)
 #include <unordered_map>
+#include <vector>
 
 #include "Firestore/core/src/local/reference_delegate.h"
 #include "Firestore/core/src/local/target_cache.h"
 #include "Firestore/core/src/local/target_data.h"
 #include "Firestore/core/src/model/types.h"
 #include "Firestore/core/src/util/status_fwd.h"
+#include "absl/types/optional.h"
 
 namespace firebase {
 namespace firestore {
@@ -45,6 +48,12 @@ struct LruParams {
   int64_t min_bytes_threshold;
   int percentile_to_collect;
   int maximum_sequence_numbers_to_collect;
+
+  /**
+   * The maximum number of targets and documents that a single call to
+   * `LruGarbageCollector::CollectSlice` removes.
+   */
+  int maximum_removals_per_slice;
 };
 
 struct LruResults {
@@ -58,6 +67,38 @@ struct LruResults {
   int documents_removed;
 };
 
+/** Describes the work done by one slice of a garbage collection pass. */
+struct LruSliceStats {
+  enum class Stage {
+    /** Determined the sequence number up to which the pass collects. */
+    kPlanning,
+    /** Removed targets, and possibly some orphaned documents. */
+    kRemovingTargets,
+    /** Removed orphaned documents. */
+    kRemovingDocuments,
+  };
+
+  Stage stage;
+  int targets_removed;
+  int documents_removed;
+  std::chrono::milliseconds duration;
+};
+
+/** Describes the progress of incremental garbage collection. */
+struct LruStats {
+  /** The cache size observed when the current or last pass started. */
+  int64_t byte_size = 0;
+
+  /** The number of passes that have removed everything they planned to. */
+  int passes_completed = 0;
+
+  /** Whether a pass has been planned but not completed yet. */
+  bool pass_in_progress = false;
+
+  /** The slices run by the current pass or, if none, by the last one. */
+  std::vector<LruSliceStats> slices;
+};
+
 using LiveQueryMap = std::unordered_map<model::TargetId, TargetData>;
 
 /**
@@ -72,6 +113,11 @@ class LruDelegate : public ReferenceDelegate {
   /** Access to the underlying LRU Garbage collector instance. */
   virtual LruGarbageCollector* garbage_collector() = 0;
 
+  /**
+   * Returns the size of the cache. This is called on every collection attempt,
+   * so implementations should keep a running account rather than measure the
+   * whole cache.
+   */
   virtual util::StatusOr<int64_t> CalculateByteSize() = 0;
 
   /** Returns the number of targets and orphaned documents cached. */
@@ -92,19 +138,21 @@ class LruDelegate : public ReferenceDelegate {
 
   /**
    * Removes all unreferenced documents from the cache that have a sequence
-   * number less than or equal to the given sequence number. Returns the number
-   * of documents removed.
+   * number less than or equal to the given sequence number, up to `limit`
+   * documents if given. Returns the number of documents removed.
    */
   virtual int RemoveOrphanedDocuments(
-      model::ListenSequenceNumber sequence_number) = 0;
+      model::ListenSequenceNumber sequence_number,
+      absl::optional<size_t> limit) = 0;
 
   /**
    * Removes all targets that are not currently being listened to and have a
-   * sequence number less than or equal to the given sequence number. Returns
-   * the number of targets removed.
+   * sequence number less than or equal to the given sequence number, up to
+   * `limit` targets if given. Returns the number of targets removed.
    */
   virtual int RemoveTargets(model::ListenSequenceNumber sequence_number,
-                            const LiveQueryMap& live_queries) = 0;
+                            const LiveQueryMap& live_queries,
+                            absl::optional<size_t> limit) = 0;
 };
 
 /**
@@ -145,8 +193,35 @@ class LruGarbageCollector {
    */
   int RemoveOrphanedDocuments(model::ListenSequenceNumber sequence_number);
 
+  /**
+   * Runs a complete garbage collection pass if the cache has outgrown its
+   * threshold, abandoning any pass started by `CollectSlice`.
+   */
   local::LruResults Collect(const LiveQueryMap& live_targets);
 
+  /**
+   * Runs the next bounded slice of an incremental garbage collection pass.
+   *
+   * If no pass is in progress and the cache has outgrown its threshold, plans
+   * a new one. Otherwise, removes up to `maximum_removals_per_slice` of the
+   * targets and then documents that the current pass planned to collect.
+   * Callers are expected to keep calling this, in separate transactions, while
+   * `pass_in_progress()` returns true.
+   *
+   * The returned results describe only the work done by this slice.
+   */
+  local::LruResults CollectSlice(const LiveQueryMap& live_targets);
+
+  /** Whether a pass started by `CollectSlice` still has work to do. */
+  bool pass_in_progress() const {
+    return pass_.has_value();
+  }
+
+  /** Returns statistics about the current or last incremental pass. */
+  const LruStats& stats() const {
+    return stats_;
+  }
+
   /**
    * Visible for testing only!
    */
@@ -155,12 +230,35 @@ class LruGarbageCollector {
   }
 
  private:
+  /** The state of an incremental pass between slices. */
+  struct Pass {
+    model::ListenSequenceNumber upper_bound;
+    bool targets_removed;
+  };
+
+  /**
+   * Returns whether the cache is large enough to be collected, recording its
+   * size in `stats_`.
+   */
+  bool ShouldCollect();
+
   LruResults RunGarbageCollection(const LiveQueryMap& live_targets);
 
+  /** Determines the sequence number up to which a new pass collects. */
+  model::ListenSequenceNumber PlanPass(int* sequence_numbers);
+
+  void RecordSlice(LruSliceStats::Stage stage,
+                   int targets_removed,
+                   int documents_removed,
+                   std::chrono::steady_clock::time_point start);
+
   // Delegate owns the LruGarbageCollector; this is a back pointer.
   LruDelegate* delegate_;
 
   LruParams params_ = LruParams::Default();
+
+  absl::optional<Pass> pass_;
+  LruStats stats_;
 };
 
 }  // namespace local
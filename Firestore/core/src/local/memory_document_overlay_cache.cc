@@ -94,10 +94,9 @@ OverlayByDocumentKeyMap MemoryDocumentOverlayCache::GetOverlays(
     absl::string_view collection_group,
     int since_batch_id,
     std::size_t count) const {
-  // NOTE: This method is only used by the backfiller, which will not run for
-  // memory persistence; therefore, this method is being implemented only so
-  // that the test suite for `LevelDbDocumentOverlayCache` can be re-used by
-  // the test suite for this class.
+  // NOTE: This method is only used by the backfiller, which runs rarely and
+  // in small batches, so it scans all overlays rather than keeping them
+  // indexed by collection group.
   using OverlaysByDocumentKeyMap =
       std::unordered_map<DocumentKey, Overlay, DocumentKeyHash>;
   std::map<int, OverlaysByDocumentKeyMap> batch_id_to_overlays;
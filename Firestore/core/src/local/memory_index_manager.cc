@@ -17,21 +17,103 @@
 #include "Firestore/core/src/local/memory_index_manager.h"
 
 #include <algorithm>
+#include <memory>
 #include <set>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "Firestore/core/src/core/target.h"
+#include "Firestore/core/src/index/index_entry.h"
+#include "Firestore/core/src/local/index_manager_util.h"
+#include "Firestore/core/src/local/memory_persistence.h"
+#include "Firestore/core/src/model/database_id.h"
+#include "Firestore/core/src/model/document.h"
+#include "Firestore/core/src/model/document_set.h"
 #include "Firestore/core/src/model/field_index.h"
 #include "Firestore/core/src/model/model_fwd.h"
 #include "Firestore/core/src/model/resource_path.h"
+#include "Firestore/core/src/model/target_index_matcher.h"
 #include "Firestore/core/src/util/hard_assert.h"
+#include "Firestore/core/src/util/log.h"
+#include "Firestore/core/src/util/ordered_code.h"
+#include "absl/memory/memory.h"
 
 namespace firebase {
 namespace firestore {
 namespace local {
 
+using core::Target;
+using index::IndexEntry;
+using model::Document;
+using model::DocumentKey;
+using model::DocumentKeyHash;
+using model::DocumentMap;
+using model::FieldIndex;
+using model::IndexOffset;
+using model::IndexState;
 using model::ResourcePath;
+using model::TargetIndexMatcher;
+using util::OrderedCode;
+
+namespace {
+
+/** The number of targets whose index match counts are kept. */
+const size_t kMaxIndexMatchCounts = 100;
+
+/**
+ * The database used to encode document keys. References are indexed without
+ * their database name, so it doesn't affect the order of the entries.
+ */
+const model::DatabaseId& KeyEncodingDatabaseId() {
+  static const auto* database_id = new model::DatabaseId("index");
+  return *database_id;
+}
+
+/**
+ * Returns the start of the keys of all entries with the given values. Entry
+ * keys append the ordered document key to it, which is unique per document.
+ */
+std::string EncodeEntryKeyPrefix(const std::string& array_value,
+                                 const std::string& directional_value) {
+  std::string result;
+  OrderedCode::WriteString(&result, array_value);
+  OrderedCode::WriteString(&result, directional_value);
+  return result;
+}
+
+/** Iterates over the entries between `lower` and `upper`, inclusive. */
+class MemoryIndexCursor : public IndexCursor {
+ public:
+  MemoryIndexCursor(const std::map<std::string, DocumentKey>& documents,
+                    const std::string& lower,
+                    std::string upper)
+      : iter_(documents.lower_bound(lower)),
+        end_(documents.end()),
+        upper_(std::move(upper)) {
+  }
+
+  bool Valid() const override {
+    return iter_ != end_ && iter_->first <= upper_;
+  }
+
+  const DocumentKey& key() const override {
+    HARD_ASSERT(Valid(), "key() called on an invalid cursor");
+    return iter_->second;
+  }
+
+  void Next() override {
+    ++iter_;
+  }
+
+ private:
+  std::map<std::string, DocumentKey>::const_iterator iter_;
+  std::map<std::string, DocumentKey>::const_iterator end_;
+  std::string upper_;
+};
+
+}  // namespace
 
 bool MemoryCollectionParentIndex::Add(const ResourcePath& collection_path) {
   HARD_ASSERT(collection_path.size() % 2 == 1, "Expected a collection path.");
@@ -55,75 +137,338 @@ std::vector<ResourcePath> MemoryCollectionParentIndex::GetEntries(
   return result;
 }
 
+MemoryIndexManager::MemoryIndexManager(MemoryPersistence* persistence)
+    : persistence_(persistence), index_match_counts_(kMaxIndexMatchCounts) {
+}
+
+void MemoryIndexManager::Start() {
+  // Index configurations are read from MemoryPersistence as needed, so there
+  // is nothing to load.
+}
+
 void MemoryIndexManager::AddToCollectionParentIndex(
     const ResourcePath& collection_path) {
-  collection_parents_index_.Add(collection_path);
+  persistence_->collection_parents_.Add(collection_path);
 }
 
 std::vector<ResourcePath> MemoryIndexManager::GetCollectionParents(
     const std::string& collection_id) {
-  return collection_parents_index_.GetEntries(collection_id);
+  return persistence_->collection_parents_.GetEntries(collection_id);
 }
 
-// Below methods are only stubs because field indices are not supported with
-// memory persistence.
-
-void MemoryIndexManager::Start() {
+void MemoryIndexManager::AddFieldIndex(const FieldIndex& index) {
+  auto& field_indexes = persistence_->field_indexes_;
+  int32_t next_index_id =
+      field_indexes.empty() ? 0 : field_indexes.rbegin()->first + 1;
+  field_indexes.emplace(
+      next_index_id, FieldIndex(next_index_id, index.collection_group(),
+                                index.segments(), FieldIndex::InitialState()));
+  index_states_[next_index_id] = index.index_state();
+  index_match_counts_.Clear();
 }
 
-void MemoryIndexManager::AddFieldIndex(const model::FieldIndex& index) {
-  (void)index;
+void MemoryIndexManager::DeleteFieldIndex(const FieldIndex& index) {
+  persistence_->field_indexes_.erase(index.index_id());
+
+  // Delete states and entries from all users for this index id.
+  for (const auto& entry : persistence_->index_managers_) {
+    entry.second->DeleteIndexData(index.index_id());
+  }
 }
 
-void MemoryIndexManager::DeleteFieldIndex(const model::FieldIndex& index) {
-  (void)index;
+void MemoryIndexManager::DeleteIndexData(int32_t index_id) {
+  index_states_.erase(index_id);
+  index_entries_.erase(index_id);
+  index_match_counts_.Clear();
 }
 
-std::vector<model::FieldIndex> MemoryIndexManager::GetFieldIndexes(
+std::vector<FieldIndex> MemoryIndexManager::GetFieldIndexes(
     const std::string& collection_group) const {
-  (void)collection_group;
-  return {};
+  std::vector<FieldIndex> result;
+  for (const auto& entry : persistence_->field_indexes_) {
+    if (entry.second.collection_group() == collection_group) {
+      result.push_back(WithUserState(entry.second));
+    }
+  }
+  return result;
+}
+
+std::vector<FieldIndex> MemoryIndexManager::GetFieldIndexes() const {
+  std::vector<FieldIndex> result;
+  for (const auto& entry : persistence_->field_indexes_) {
+    result.push_back(WithUserState(entry.second));
+  }
+  return result;
+}
+
+FieldIndex MemoryIndexManager::WithUserState(const FieldIndex& index) const {
+  auto state = index_states_.find(index.index_id());
+  if (state == index_states_.end()) {
+    return index;
+  }
+  return FieldIndex(index.index_id(), index.collection_group(),
+                    index.segments(), state->second);
 }
 
-std::vector<model::FieldIndex> MemoryIndexManager::GetFieldIndexes() const {
-  return {};
+absl::optional<FieldIndex> MemoryIndexManager::GetFieldIndex(
+    const Target& target) const {
+  std::string collection_group = target.collection_group() != nullptr
+                                     ? (*target.collection_group())
+                                     : target.path().last_segment();
+  return SelectFieldIndex(target, GetFieldIndexes(collection_group));
 }
 
 void MemoryIndexManager::DeleteAllFieldIndexes() {
+  persistence_->DeleteAllFieldIndexes();
+}
+
+void MemoryIndexManager::CreateTargetIndexes(const Target& target) {
+  for (const auto& sub_target : GetSubTargets(target)) {
+    IndexManager::IndexType type = GetIndexType(sub_target);
+    if (type == IndexManager::IndexType::NONE ||
+        type == IndexManager::IndexType::PARTIAL) {
+      TargetIndexMatcher target_index_matcher(sub_target);
+      auto const field_index = target_index_matcher.BuildTargetIndex();
+      if (field_index.has_value()) {
+        AddFieldIndex(field_index.value());
+      }
+    }
+  }
+}
+
+IndexOffset MemoryIndexManager::GetMinOffset(const Target& target) {
+  std::vector<FieldIndex> indexes;
+  for (const auto& sub_target : GetSubTargets(target)) {
+    auto index_opt = GetFieldIndex(sub_target);
+    if (index_opt.has_value()) {
+      indexes.push_back(index_opt.value());
+    }
+  }
+  return GetLeastRecentOffset(indexes);
+}
+
+IndexOffset MemoryIndexManager::GetMinOffset(
+    const std::string& collection_group) const {
+  return GetLeastRecentOffset(GetFieldIndexes(collection_group));
 }
 
-void MemoryIndexManager::CreateTargetIndexes(const core::Target&) {
+IndexManager::IndexType MemoryIndexManager::GetIndexType(
+    const Target& target) {
+  IndexManager::IndexType result = IndexManager::IndexType::FULL;
+  for (const Target& sub_target : GetSubTargets(target)) {
+    absl::optional<FieldIndex> index = GetFieldIndex(sub_target);
+    if (!index) {
+      return IndexManager::IndexType::NONE;
+    }
+
+    if (index.value().segments().size() < sub_target.GetSegmentCount()) {
+      result = IndexManager::IndexType::PARTIAL;
+    }
+  }
+  return result;
 }
 
-model::IndexOffset MemoryIndexManager::GetMinOffset(const core::Target&) {
-  return model::IndexOffset::None();
+absl::optional<std::vector<DocumentKey>>
+MemoryIndexManager::GetDocumentsMatchingTarget(const Target& target) {
+  auto index_ranges = GetIndexRanges(target);
+  if (!index_ranges.has_value()) {
+    return absl::nullopt;
+  }
+
+  std::vector<DocumentKey> result;
+  std::unordered_set<DocumentKey, DocumentKeyHash> existing_keys;
+  for (const auto& range : index_ranges.value()) {
+    auto entries = index_entries_.find(range.index_id);
+    if (entries == index_entries_.end()) {
+      continue;
+    }
+
+    const auto& documents = entries->second.documents;
+    int32_t count = 0;
+    for (auto it = documents.lower_bound(range.lower);
+         it != documents.end() && count < target.limit() &&
+         it->first <= range.upper;
+         ++it) {
+      ++count;
+      if (existing_keys.insert(it->second).second) {
+        result.push_back(it->second);
+      }
+    }
+  }
+
+  if (!target.HasLimit()) {
+    index_match_counts_.Put(target, result.size());
+  }
+  return result;
 }
 
-model::IndexOffset MemoryIndexManager::GetMinOffset(const std::string&) const {
-  return model::IndexOffset::None();
+absl::optional<std::vector<std::unique_ptr<IndexCursor>>>
+MemoryIndexManager::ScanDocumentsMatchingTarget(const Target& target) {
+  for (const auto& sub_target : GetSubTargets(target)) {
+    auto index_opt = GetFieldIndex(sub_target);
+    if (!index_opt.has_value() ||
+        index_opt.value().segments().size() < sub_target.GetSegmentCount() ||
+        !IsScannedInTargetOrder(index_opt.value(), sub_target)) {
+      return absl::nullopt;
+    }
+  }
+
+  auto index_ranges = GetIndexRanges(target);
+  if (!index_ranges.has_value()) {
+    return absl::nullopt;
+  }
+
+  std::vector<std::unique_ptr<IndexCursor>> cursors;
+  for (auto& range : index_ranges.value()) {
+    // Scanning an index without entries reads from an empty map.
+    const auto& documents = index_entries_[range.index_id].documents;
+    cursors.push_back(absl::make_unique<MemoryIndexCursor>(
+        documents, range.lower, std::move(range.upper)));
+  }
+  return cursors;
 }
 
-IndexManager::IndexType MemoryIndexManager::GetIndexType(const core::Target&) {
-  return IndexManager::IndexType::NONE;
+absl::optional<std::vector<MemoryIndexManager::IndexRange>>
+MemoryIndexManager::GetIndexRanges(const Target& target) {
+  std::vector<std::pair<Target, FieldIndex>> indexes;
+  for (const auto& sub_target : GetSubTargets(target)) {
+    auto index_opt = GetFieldIndex(sub_target);
+    if (!index_opt.has_value()) {
+      return absl::nullopt;
+    }
+    indexes.emplace_back(sub_target, index_opt.value());
+  }
+
+  std::vector<IndexRange> result;
+  for (const auto& entry : indexes) {
+    const Target& sub_target = entry.first;
+    const FieldIndex& index = entry.second;
+
+    LOG_DEBUG("Using index %s to execute target %s", index.collection_group(),
+              sub_target.CanonicalId());
+
+    for (const auto& range : GetIndexEntryRanges(sub_target, index)) {
+      result.push_back(IndexRange{
+          index.index_id(),
+          EncodeEntryKeyPrefix(range.lower.array_value(),
+                               range.lower.directional_value()),
+          EncodeEntryKeyPrefix(range.upper.array_value(),
+                               range.upper.directional_value())});
+    }
+  }
+  return result;
 }
 
-absl::optional<std::vector<model::DocumentKey>>
-MemoryIndexManager::GetDocumentsMatchingTarget(const core::Target&) {
-  // Field indices are not supported with memory persistence.
-  return absl::nullopt;
+absl::optional<size_t> MemoryIndexManager::GetIndexMatchCount(
+    const Target& target) const {
+  const size_t* count = index_match_counts_.Get(target);
+  if (!count) {
+    return absl::nullopt;
+  }
+  return *count;
 }
 
 absl::optional<std::string> MemoryIndexManager::GetNextCollectionGroupToUpdate()
     const {
-  return absl::nullopt;
+  // Picks the collection group whose index was updated least recently, like
+  // the update queue of LevelDbIndexManager.
+  absl::optional<FieldIndex> next;
+  for (const auto& index : GetFieldIndexes()) {
+    if (!next.has_value() ||
+        std::make_pair(index.index_state().sequence_number(),
+                       index.collection_group()) <
+            std::make_pair(next->index_state().sequence_number(),
+                           next->collection_group())) {
+      next = index;
+    }
+  }
+
+  if (!next.has_value()) {
+    return absl::nullopt;
+  }
+  return next->collection_group();
+}
+
+void MemoryIndexManager::UpdateCollectionGroup(
+    const std::string& collection_group, IndexOffset offset) {
+  model::ListenSequenceNumber max_sequence_number = 0;
+  for (const auto& index : GetFieldIndexes()) {
+    max_sequence_number =
+        std::max(max_sequence_number, index.index_state().sequence_number());
+  }
+
+  for (const auto& index : GetFieldIndexes(collection_group)) {
+    index_states_[index.index_id()] =
+        IndexState{max_sequence_number + 1, offset};
+  }
+}
+
+void MemoryIndexManager::UpdateIndexEntries(const DocumentMap& documents) {
+  for (const auto& kv : documents) {
+    const auto group = kv.first.GetCollectionGroup();
+    HARD_ASSERT(group.has_value(),
+                "Document key is expected to have a collection group");
+
+    for (const auto& index : GetFieldIndexes(group.value())) {
+      IndexEntries& entries = index_entries_[index.index_id()];
+      std::set<std::string> new_keys = ComputeEntryKeys(kv.second, index);
+
+      auto existing = entries.entry_keys.find(kv.first);
+      if (existing == entries.entry_keys.end()) {
+        if (new_keys.empty()) {
+          continue;
+        }
+        existing = entries.entry_keys.emplace(kv.first, std::set<std::string>())
+                       .first;
+      }
+
+      std::set<std::string>& existing_keys = existing->second;
+      if (existing_keys == new_keys) {
+        continue;
+      }
+      for (const auto& key : existing_keys) {
+        if (new_keys.find(key) == new_keys.end()) {
+          entries.documents.erase(key);
+        }
+      }
+      for (const auto& key : new_keys) {
+        entries.documents.emplace(key, kv.first);
+      }
+
+      if (new_keys.empty()) {
+        entries.entry_keys.erase(existing);
+      } else {
+        existing_keys = std::move(new_keys);
+      }
+    }
+  }
 }
 
-void MemoryIndexManager::UpdateCollectionGroup(const std::string&,
-                                               model::IndexOffset) {
-  // Field indices are not supported with memory persistence.
+std::set<std::string> MemoryIndexManager::ComputeEntryKeys(
+    const Document& document, const FieldIndex& index) const {
+  std::set<std::string> result;
+  std::set<IndexEntry> entries = ComputeIndexEntries(document, index);
+  if (entries.empty()) {
+    return result;
+  }
+
+  std::string directional_key =
+      EncodeDirectionalKey(KeyEncodingDatabaseId(), index, document->key());
+  for (const auto& entry : entries) {
+    std::string key = EncodeEntryKeyPrefix(entry.array_value(),
+                                           entry.directional_value());
+    OrderedCode::WriteString(&key, directional_key);
+    result.insert(std::move(key));
+  }
+  return result;
 }
 
-void MemoryIndexManager::UpdateIndexEntries(const model::DocumentMap&) {
+std::vector<Target> MemoryIndexManager::GetSubTargets(const Target& target) {
+  auto it = target_to_dnf_subtargets_.find(target);
+  if (it != target_to_dnf_subtargets_.end()) {
+    return it->second;
+  }
+  return target_to_dnf_subtargets_[target] = GetDnfSubTargets(target);
 }
 
 }  // namespace local
@@ -17,17 +17,24 @@
 #ifndef FIRESTORE_CORE_SRC_LOCAL_MEMORY_INDEX_MANAGER_H_
 #define FIRESTORE_CORE_SRC_LOCAL_MEMORY_INDEX_MANAGER_H_
 
+#include <map>
 #include <set>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "Firestore/core/src/core/target.h"
 #include "Firestore/core/src/local/index_manager.h"
+#include "Firestore/core/src/model/document_key.h"
+#include "Firestore/core/src/model/field_index.h"
+#include "Firestore/core/src/util/lru_cache.h"
 
 namespace firebase {
 namespace firestore {
 namespace local {
 
+class MemoryPersistence;
+
 /**
  * Internal implementation of the collection-parent index. Also used for
  * in-memory caching by LevelDbIndexManager and initial index population during
@@ -45,10 +52,18 @@ class MemoryCollectionParentIndex {
   std::unordered_map<std::string, std::set<model::ResourcePath>> index_;
 };
 
-/** An in-memory implementation of IndexManager. */
+/**
+ * An in-memory implementation of IndexManager.
+ *
+ * Like their LevelDB counterparts, index configurations and the collection
+ * parent index are shared by all users (and owned by MemoryPersistence), while
+ * each user's manager owns its index states and entries. Entries are kept
+ * sorted by an ordered-code key of their array value, directional value and
+ * document key, so targets are served by the same range scans as with LevelDB.
+ */
 class MemoryIndexManager : public IndexManager {
  public:
-  MemoryIndexManager() = default;
+  explicit MemoryIndexManager(MemoryPersistence* persistence);
 
   void Start() override;
 
@@ -69,25 +84,103 @@ class MemoryIndexManager : public IndexManager {
 
   void DeleteAllFieldIndexes() override;
 
-  void CreateTargetIndexes(const core::Target&) override;
+  void CreateTargetIndexes(const core::Target& target) override;
 
-  model::IndexOffset GetMinOffset(const core::Target&) override;
+  model::IndexOffset GetMinOffset(const core::Target& target) override;
 
-  model::IndexOffset GetMinOffset(const std::string&) const override;
+  model::IndexOffset GetMinOffset(
+      const std::string& collection_group) const override;
 
-  IndexType GetIndexType(const core::Target&) override;
+  IndexType GetIndexType(const core::Target& target) override;
 
   absl::optional<std::vector<model::DocumentKey>> GetDocumentsMatchingTarget(
-      const core::Target&) override;
+      const core::Target& target) override;
+
+  absl::optional<std::vector<std::unique_ptr<IndexCursor>>>
+  ScanDocumentsMatchingTarget(const core::Target& target) override;
+
+  absl::optional<size_t> GetIndexMatchCount(
+      const core::Target& target) const override;
 
   absl::optional<std::string> GetNextCollectionGroupToUpdate() const override;
 
-  void UpdateCollectionGroup(const std::string&, model::IndexOffset) override;
+  void UpdateCollectionGroup(const std::string& collection_group,
+                             model::IndexOffset offset) override;
+
+  void UpdateIndexEntries(const model::DocumentMap& documents) override;
 
-  void UpdateIndexEntries(const model::DocumentMap&) override;
+  /**
+   * Drops the state and entries this user has for the index `index_id`. Called
+   * for every user when the index is deleted.
+   */
+  void DeleteIndexData(int32_t index_id);
 
  private:
-  MemoryCollectionParentIndex collection_parents_index_;
+  /** The entries of a single field index. */
+  struct IndexEntries {
+    /** The document of each entry, keyed and sorted by the entry's key. */
+    std::map<std::string, model::DocumentKey> documents;
+
+    /** The keys of each document's entries. */
+    std::unordered_map<model::DocumentKey,
+                       std::set<std::string>,
+                       model::DocumentKeyHash>
+        entry_keys;
+  };
+
+  /** The entries to scan for a target: `lower <= key <= upper`. */
+  struct IndexRange {
+    int32_t index_id;
+    std::string lower;
+    std::string upper;
+  };
+
+  std::vector<core::Target> GetSubTargets(const core::Target& target);
+
+  /**
+   * Returns the index ranges that have to be scanned to serve `target`, in
+   * the order of its sub-targets, or `nullopt` if some sub-target has no
+   * index.
+   */
+  absl::optional<std::vector<IndexRange>> GetIndexRanges(
+      const core::Target& target);
+
+  /**
+   * Returns an index that can be used to serve the provided target. Returns
+   * `nullopt` if no index is configured.
+   */
+  absl::optional<model::FieldIndex> GetFieldIndex(
+      const core::Target& target) const;
+
+  /** Combines the configuration of an index with this user's state. */
+  model::FieldIndex WithUserState(const model::FieldIndex& index) const;
+
+  /** Returns the keys of the entries of `index` for `document`. */
+  std::set<std::string> ComputeEntryKeys(const model::Document& document,
+                                         const model::FieldIndex& index) const;
+
+  // The MemoryIndexManager is owned by MemoryPersistence.
+  MemoryPersistence* persistence_;
+
+  /**
+   * Maps from a target to its equivalent list of sub-targets. Each sub-target
+   * contains only one term from the target's disjunctive normal form (DNF).
+   */
+  std::unordered_map<core::Target, std::vector<core::Target>>
+      target_to_dnf_subtargets_;
+
+  /**
+   * The number of documents each unlimited target matched the last time it was
+   * served from an index, for the most recently used targets. Cleared whenever
+   * the index configuration changes.
+   */
+  mutable util::LruCache<core::Target, size_t> index_match_counts_;
+
+  /** This user's state of each index, keyed by index id. */
+  std::unordered_map<int32_t, model::IndexState> index_states_;
+
+  /** This user's entries of each index, keyed by index id. */
+  std::unordered_map<int32_t, IndexEntries> index_entries_;
 };
 
 }  // namespace local
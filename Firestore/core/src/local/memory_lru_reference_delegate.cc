@@ -45,6 +45,8 @@ MemoryLruReferenceDelegate::MemoryLruReferenceDelegate(
     : persistence_(persistence),
       sizer_(std::move(sizer)),
       gc_(this, lru_params) {
+  persistence_->remote_document_cache()->SetSizer(sizer_.get());
+
   // Theoretically this is always 0, since this is all in-memory...
   ListenSequenceNumber highest_sequence_number =
       persistence_->target_cache()->highest_listen_sequence_number();
@@ -115,16 +117,17 @@ size_t MemoryLruReferenceDelegate::GetSequenceNumberCount() {
 
 int MemoryLruReferenceDelegate::RemoveTargets(
     model::ListenSequenceNumber sequence_number,
-    const LiveQueryMap& live_queries) {
+    const LiveQueryMap& live_queries,
+    absl::optional<size_t> limit) {
   return static_cast<int>(persistence_->target_cache()->RemoveTargets(
-      sequence_number, live_queries));
+      sequence_number, live_queries, limit));
 }
 
 int MemoryLruReferenceDelegate::RemoveOrphanedDocuments(
-    model::ListenSequenceNumber upper_bound) {
+    model::ListenSequenceNumber upper_bound, absl::optional<size_t> limit) {
   std::vector<DocumentKey> removed =
       persistence_->remote_document_cache()->RemoveOrphanedDocuments(
-          this, upper_bound);
+          this, upper_bound, limit);
   for (const auto& key : removed) {
     sequence_numbers_.erase(key);
   }
@@ -175,13 +178,12 @@ bool MemoryLruReferenceDelegate::IsPinnedAtSequenceNumber(
 }
 
 StatusOr<int64_t> MemoryLruReferenceDelegate::CalculateByteSize() {
-  // Note that this method is only used for testing because this delegate is
-  // only used for testing. The algorithm here (loop through everything,
-  // serialize it and count bytes) is inefficient and inexact, but won't run in
-  // production.
+  // Documents make up the bulk of the cache, so the remote document cache
+  // keeps a running total of their sizes. Targets and mutations are still
+  // serialized and counted each time, which is inexact but cheap enough.
   int64_t count = 0;
   count += persistence_->target_cache()->CalculateByteSize(*sizer_);
-  count += persistence_->remote_document_cache()->CalculateByteSize(*sizer_);
+  count += persistence_->remote_document_cache()->byte_size();
   const auto& queues = persistence_->mutation_queues();
   for (const auto& entry : queues) {
     count += entry.second->CalculateByteSize(*sizer_);
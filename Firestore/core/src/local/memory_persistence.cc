@@ -130,9 +130,17 @@ MemoryRemoteDocumentCache* MemoryPersistence::remote_document_cache() {
   return &remote_document_cache_;
 }
 
-MemoryIndexManager* MemoryPersistence::GetIndexManager(
-    const credentials::User&) {
-  return &index_manager_;
+MemoryIndexManager* MemoryPersistence::GetIndexManager(const User& user) {
+  auto iter = index_managers_.find(user);
+  if (iter == index_managers_.end()) {
+    auto index_manager = absl::make_unique<MemoryIndexManager>(this);
+    MemoryIndexManager* result = index_manager.get();
+
+    index_managers_.emplace(user, std::move(index_manager));
+    return result;
+  } else {
+    return iter->second.get();
+  }
 }
 
 ReferenceDelegate* MemoryPersistence::reference_delegate() {
@@ -143,6 +151,12 @@ void MemoryPersistence::ReleaseOtherUserSpecificComponents(const std::string&) {
 }
 
 void MemoryPersistence::DeleteAllFieldIndexes() {
+  for (const auto& index : field_indexes_) {
+    for (const auto& entry : index_managers_) {
+      entry.second->DeleteIndexData(index.first);
+    }
+  }
+  field_indexes_.clear();
 }
 
 void MemoryPersistence::RunInternal(absl::string_view label,
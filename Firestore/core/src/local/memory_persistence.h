@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_LOCAL_MEMORY_PERSISTENCE_H_
 #define FIRESTORE_CORE_SRC_LOCAL_MEMORY_PERSISTENCE_H_
 
+#include <map>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -62,6 +63,11 @@ class MemoryPersistence : public Persistence {
                          std::unique_ptr<MemoryMutationQueue>,
                          firebase::firestore::credentials::HashUser>;
 
+  using IndexManagers =
+      std::unordered_map<credentials::User,
+                         std::unique_ptr<MemoryIndexManager>,
+                         firebase::firestore::credentials::HashUser>;
+
   using DocumentOverlayCaches =
       std::unordered_map<credentials::User,
                          std::unique_ptr<MemoryDocumentOverlayCache>,
@@ -112,6 +118,8 @@ class MemoryPersistence : public Persistence {
                    std::function<void()> block) override;
 
  private:
+  friend class MemoryIndexManager;
+
   MemoryPersistence();
 
   void set_reference_delegate(std::unique_ptr<ReferenceDelegate> delegate);
@@ -137,7 +145,16 @@ class MemoryPersistence : public Persistence {
    */
   MemoryRemoteDocumentCache remote_document_cache_;
 
-  MemoryIndexManager index_manager_;
+  /**
+   * The field indexes configured for all users, keyed by index id. Their
+   * states are kept per user by `index_managers_`.
+   */
+  std::map<int32_t, model::FieldIndex> field_indexes_;
+
+  /** The collection-parent index, which is shared by all users. */
+  MemoryCollectionParentIndex collection_parents_;
+
+  IndexManagers index_managers_;
 
   MemoryBundleCache bundle_cache_;
 
@@ -16,6 +16,11 @@
 
 #include "Firestore/core/src/local/memory_remote_document_cache.h"
 
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <vector>
+
 #include "Firestore/core/src/core/query.h"
 #include "Firestore/core/src/local/memory_lru_reference_delegate.h"
 #include "Firestore/core/src/local/memory_persistence.h"
@@ -45,15 +50,29 @@ MemoryRemoteDocumentCache::MemoryRemoteDocumentCache(
 
 void MemoryRemoteDocumentCache::Add(const MutableDocument& document,
                                     const model::SnapshotVersion& read_time) {
+  const auto& existing = docs_.get(document.key());
+  if (existing) {
+    UpdateByteSize(*existing, -1);
+    UpdateReadTimeIndex(*existing, -1);
+  }
+
   // Note: We create an explicit copy to prevent further modifications.
-  docs_ =
-      docs_.insert(document.key(), document.Clone().WithReadTime(read_time));
+  MutableDocument copy = document.Clone();
+  copy.WithReadTime(read_time);
+  UpdateByteSize(copy, 1);
+  UpdateReadTimeIndex(copy, 1);
+  docs_ = docs_.insert(document.key(), std::move(copy));
 
   NOT_NULL(index_manager_);
   index_manager_->AddToCollectionParentIndex(document.key().path().PopLast());
 }
 
 void MemoryRemoteDocumentCache::Remove(const DocumentKey& key) {
+  const auto& existing = docs_.get(key);
+  if (existing) {
+    UpdateByteSize(*existing, -1);
+    UpdateReadTimeIndex(*existing, -1);
+  }
   docs_ = docs_.erase(key);
 }
 
@@ -66,23 +85,79 @@ MutableDocument MemoryRemoteDocumentCache::Get(const DocumentKey& key) const {
 
 MutableDocumentMap MemoryRemoteDocumentCache::GetAll(
     const DocumentKeySet& keys) const {
-  MutableDocumentMap results;
+  MutableDocumentMap::Builder results;
+  results.reserve(keys.size());
   for (const DocumentKey& key : keys) {
     // Make sure each key has a corresponding entry, which is nullopt in case
     // the document is not found.
     // TODO(http://b/32275378): Don't conflate missing / deleted.
-    results = results.insert(key, Get(key));
+    results.insert(key, Get(key));
   }
-  return results;
+  return results.Build();
+}
+
+DocumentKeySet MemoryRemoteDocumentCache::GetFoundDocumentKeys(
+    const DocumentKeySet& keys) const {
+  DocumentKeySet result;
+  for (const DocumentKey& key : keys) {
+    auto found = docs_.find(key);
+    if (found != docs_.end() && found->second.is_found_document()) {
+      result = result.insert(key);
+    }
+  }
+  return result;
 }
 
-// This method should only be called from the IndexBackfiller if LevelDB is
-// enabled.
-MutableDocumentMap MemoryRemoteDocumentCache::GetAll(const std::string&,
-                                                     const model::IndexOffset&,
-                                                     size_t) const {
-  util::ThrowInvalidArgument(
-      "getAll(String, IndexOffset, int) is not supported.");
+MutableDocumentMap MemoryRemoteDocumentCache::GetAll(
+    const std::string& collection_group,
+    const model::IndexOffset& offset,
+    size_t limit) const {
+  HARD_ASSERT(limit > 0u, "Limit should be at least 1");
+
+  // Every collection contributes at most `limit` documents, of which the ones
+  // with the lowest read times across the collection group are kept.
+  std::vector<std::pair<SnapshotVersion, DocumentKey>> candidates;
+  for (const auto& parent :
+       index_manager_->GetCollectionParents(collection_group)) {
+    auto collection = documents_by_read_time_.find(
+        parent.Append(collection_group).CanonicalString());
+    if (collection == documents_by_read_time_.end()) {
+      continue;
+    }
+
+    const auto& documents = collection->second;
+    size_t found = 0;
+    for (auto it = documents.upper_bound(
+             {offset.read_time(), offset.document_key()});
+         it != documents.end() && found < limit; ++it) {
+      if (docs_.get(it->second)->is_found_document()) {
+        candidates.push_back(*it);
+        ++found;
+      }
+    }
+  }
+
+  if (candidates.size() > limit) {
+    std::nth_element(candidates.begin(), candidates.begin() + limit,
+                     candidates.end());
+    candidates.resize(limit);
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [](const std::pair<SnapshotVersion, DocumentKey>& lhs,
+               const std::pair<SnapshotVersion, DocumentKey>& rhs) {
+              return lhs.second < rhs.second;
+            });
+
+  std::vector<std::pair<DocumentKey, MutableDocument>> result;
+  result.reserve(candidates.size());
+  for (const auto& candidate : candidates) {
+    // Note: We create an explicit copy to prevent modifications on the backing
+    // data.
+    result.emplace_back(candidate.second, docs_.get(candidate.second)->Clone());
+  }
+  return MutableDocumentMap::FromSortedRange(
+      std::make_move_iterator(result.begin()),
+      std::make_move_iterator(result.end()));
 }
 
 MutableDocumentMap MemoryRemoteDocumentCache::GetDocumentsMatchingQuery(
@@ -136,29 +211,83 @@ MutableDocumentMap MemoryRemoteDocumentCache::GetDocumentsMatchingQuery(
   return results;
 }
 
+std::vector<MutableDocumentMap>
+MemoryRemoteDocumentCache::GetDocumentsMatchingQueries(
+    const std::vector<Query>& queries,
+    const model::IndexOffset& offset,
+    absl::optional<QueryContext>& context,
+    const std::vector<model::OverlayByDocumentKeyMap>& mutated_docs) const {
+  HARD_ASSERT(queries.size() == mutated_docs.size(),
+              "Expected mutated documents for each query");
+  std::vector<MutableDocumentMap> results;
+  results.reserve(queries.size());
+  for (size_t i = 0; i < queries.size(); ++i) {
+    results.push_back(GetDocumentsMatchingQuery(
+        queries[i], offset, context, absl::nullopt, mutated_docs[i]));
+  }
+  return results;
+}
+
 std::vector<DocumentKey> MemoryRemoteDocumentCache::RemoveOrphanedDocuments(
     MemoryLruReferenceDelegate* reference_delegate,
-    ListenSequenceNumber upper_bound) {
+    ListenSequenceNumber upper_bound,
+    absl::optional<size_t> limit) {
   std::vector<DocumentKey> removed;
   auto updated_docs = docs_;
   for (const auto& kv : docs_) {
+    if (limit && removed.size() >= *limit) {
+      break;
+    }
+
     const DocumentKey& key = kv.first;
     if (!reference_delegate->IsPinnedAtSequenceNumber(upper_bound, key)) {
       updated_docs = updated_docs.erase(key);
       removed.push_back(key);
+      UpdateByteSize(kv.second, -1);
+      UpdateReadTimeIndex(kv.second, -1);
     }
   }
   docs_ = updated_docs;
   return removed;
 }
 
-int64_t MemoryRemoteDocumentCache::CalculateByteSize(const Sizer& sizer) {
-  int64_t count = 0;
+void MemoryRemoteDocumentCache::SetSizer(const Sizer* sizer) {
+  sizer_ = NOT_NULL(sizer);
+  byte_size_ = 0;
   for (const auto& kv : docs_) {
-    const MutableDocument& document = kv.second;
-    count += sizer.CalculateByteSize(document);
+    UpdateByteSize(kv.second, 1);
+  }
+}
+
+void MemoryRemoteDocumentCache::UpdateByteSize(const MutableDocument& document,
+                                               int sign) {
+  if (sizer_) {
+    int64_t size = sizer_->CalculateByteSize(document);
+    byte_size_ += sign < 0 ? -size : size;
+  }
+}
+
+absl::optional<size_t> MemoryRemoteDocumentCache::GetCollectionSize(
+    const model::ResourcePath& collection_path) const {
+  auto it = documents_by_read_time_.find(collection_path.CanonicalString());
+  if (it == documents_by_read_time_.end()) {
+    return absl::nullopt;
+  }
+  return it->second.size();
+}
+
+void MemoryRemoteDocumentCache::UpdateReadTimeIndex(
+    const MutableDocument& document, int sign) {
+  std::string collection = document.key().path().PopLast().CanonicalString();
+  ReadTimeIndex& documents = documents_by_read_time_[collection];
+  if (sign < 0) {
+    documents.erase({document.read_time(), document.key()});
+    if (documents.empty()) {
+      documents_by_read_time_.erase(collection);
+    }
+  } else {
+    documents.insert({document.read_time(), document.key()});
   }
-  return count;
 }
 
 void MemoryRemoteDocumentCache::SetIndexManager(IndexManager* manager) {
@@ -17,7 +17,9 @@
 #ifndef FIRESTORE_CORE_SRC_LOCAL_MEMORY_REMOTE_DOCUMENT_CACHE_H_
 #define FIRESTORE_CORE_SRC_LOCAL_MEMORY_REMOTE_DOCUMENT_CACHE_H_
 
+#include <set>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -50,6 +52,8 @@ class MemoryRemoteDocumentCache : public RemoteDocumentCache {
   model::MutableDocument Get(const model::DocumentKey& key) const override;
   model::MutableDocumentMap GetAll(
       const model::DocumentKeySet& keys) const override;
+  model::DocumentKeySet GetFoundDocumentKeys(
+      const model::DocumentKeySet& keys) const override;
   model::MutableDocumentMap GetAll(const std::string&,
                                    const model::IndexOffset&,
                                    size_t) const override;
@@ -64,19 +68,65 @@ class MemoryRemoteDocumentCache : public RemoteDocumentCache {
       absl::optional<QueryContext>&,
       absl::optional<size_t> limit = absl::nullopt,
       const model::OverlayByDocumentKeyMap& mutated_docs = {}) const override;
+  std::vector<model::MutableDocumentMap> GetDocumentsMatchingQueries(
+      const std::vector<core::Query>& queries,
+      const model::IndexOffset& offset,
+      absl::optional<QueryContext>& context,
+      const std::vector<model::OverlayByDocumentKeyMap>& mutated_docs)
+      const override;
+
+  absl::optional<size_t> GetCollectionSize(
+      const model::ResourcePath& collection_path) const override;
 
   void SetIndexManager(IndexManager* manager) override;
 
   std::vector<model::DocumentKey> RemoveOrphanedDocuments(
       MemoryLruReferenceDelegate* reference_delegate,
-      model::ListenSequenceNumber upper_bound);
+      model::ListenSequenceNumber upper_bound,
+      absl::optional<size_t> limit);
 
-  int64_t CalculateByteSize(const Sizer& sizer);
+  /**
+   * Starts keeping a running total of the sizes of the cached documents, as
+   * measured by `sizer`. The sizer is owned by the caller.
+   */
+  void SetSizer(const Sizer* sizer);
+
+  /**
+   * Returns the total size of the cached documents. Only tracked after a sizer
+   * has been set.
+   */
+  int64_t byte_size() const {
+    return byte_size_;
+  }
 
  private:
+  /** The keys of a collection's documents, ordered by their read time. */
+  using ReadTimeIndex =
+      std::set<std::pair<model::SnapshotVersion, model::DocumentKey>>;
+
+  /**
+   * Adds `document` to `documents_by_read_time_`, or removes it from there if
+   * `sign < 0`.
+   */
+  void UpdateReadTimeIndex(const model::MutableDocument& document, int sign);
+
+  /** Adjusts `byte_size_` by the size of `document`, negated if `sign < 0`. */
+  void UpdateByteSize(const model::MutableDocument& document, int sign);
+
   /** Underlying cache of documents and their read times. */
   immutable::SortedMap<model::DocumentKey, model::MutableDocument> docs_;
 
+  /**
+   * The documents in `docs_` per canonical collection path, ordered by read
+   * time. Serves the index backfiller and collection sizes.
+   */
+  std::unordered_map<std::string, ReadTimeIndex> documents_by_read_time_;
+
+  const Sizer* sizer_ = nullptr;
+
+  /** The total size of `docs_`, as measured by `sizer_`. */
+  int64_t byte_size_ = 0;
+
   // This instance is owned by MemoryPersistence; avoid a retain cycle.
   MemoryPersistence* persistence_;
   // This instance is also owned by MemoryPersistence.
@@ -77,9 +77,14 @@ void MemoryTargetCache::EnumerateSequenceNumbers(
 
 size_t MemoryTargetCache::RemoveTargets(
     model::ListenSequenceNumber upper_bound,
-    const std::unordered_map<TargetId, TargetData>& live_targets) {
+    const std::unordered_map<TargetId, TargetData>& live_targets,
+    absl::optional<size_t> limit) {
   std::vector<const Target*> to_remove;
   for (const auto& kv : targets_) {
+    if (limit && to_remove.size() >= *limit) {
+      break;
+    }
+
     const Target& target = kv.first;
     const TargetData& target_data = kv.second;
 
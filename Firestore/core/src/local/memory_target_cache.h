@@ -52,9 +52,10 @@ class MemoryTargetCache : public TargetCache {
   void EnumerateSequenceNumbers(
       const SequenceNumberCallback& callback) override;
 
-  size_t RemoveTargets(model::ListenSequenceNumber upper_bound,
-                       const std::unordered_map<model::TargetId, TargetData>&
-                           live_targets) override;
+  size_t RemoveTargets(
+      model::ListenSequenceNumber upper_bound,
+      const std::unordered_map<model::TargetId, TargetData>& live_targets,
+      absl::optional<size_t> limit) override;
 
   // Key-related methods
   void AddMatchingKeys(const model::DocumentKeySet& keys,
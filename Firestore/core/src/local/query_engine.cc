@@ -16,17 +16,30 @@
 
 #include "Firestore/core/src/local/query_engine.h"
 
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <set>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/core/query.h"
 #include "Firestore/core/src/core/target.h"
+#include "Firestore/core/src/local/document_overlay_cache.h"
+#include "Firestore/core/src/local/index_manager.h"
 #include "Firestore/core/src/local/local_documents_view.h"
 #include "Firestore/core/src/local/query_context.h"
+#include "Firestore/core/src/local/remote_document_cache.h"
 #include "Firestore/core/src/model/document.h"
 #include "Firestore/core/src/model/document_set.h"
 #include "Firestore/core/src/model/mutable_document.h"
+#include "Firestore/core/src/model/overlay.h"
 #include "Firestore/core/src/model/snapshot_version.h"
+#include "Firestore/core/src/util/comparison.h"
+#include "Firestore/core/src/util/hard_assert.h"
 #include "Firestore/core/src/util/log.h"
+#include "absl/memory/memory.h"
 
 namespace firebase {
 namespace firestore {
@@ -36,59 +49,199 @@ namespace {
 
 static const int kDefaultIndexAutoCreationMinCollectionSize = 100;
 
-/**
- * This cost represents the evaluation result of (([index, docKey] + [docKey,
- * docContent]) per document in the result set) / ([docKey, docContent] per
- * documents in full collection scan) coming from experiment
- * https://github.com/firebase/firebase-ios-sdk/pull/11716.
- */
-
-static const double KDefaultRelativeIndexReadCostPerDocument = 3.4;
 }  // namespace
 
 using core::LimitType;
 using core::Query;
 using model::Document;
+using model::DocumentKey;
 using model::DocumentKeySet;
 using model::DocumentMap;
 using model::DocumentSet;
 using model::MutableDocument;
 using model::SnapshotVersion;
 
+QueryEngine::QueryEngine()
+    : index_auto_creation_min_collection_size_(
+          kDefaultIndexAutoCreationMinCollectionSize),
+      planner_(absl::make_unique<QueryPlanner>()) {
+}
+
+// Out of line because of the unique_ptr to QueryPlanner.
+QueryEngine::~QueryEngine() = default;
+
 void QueryEngine::Initialize(LocalDocumentsView* local_documents) {
   local_documents_view_ = local_documents;
   index_manager_ = local_documents->index_manager();
   index_auto_creation_min_collection_size_ =
       kDefaultIndexAutoCreationMinCollectionSize;
-  relative_index_read_cost_per_document_ =
-      KDefaultRelativeIndexReadCostPerDocument;
 }
 
 const DocumentMap QueryEngine::GetDocumentsMatchingQuery(
     const Query& query,
     const SnapshotVersion& last_limbo_free_snapshot_version,
-    const DocumentKeySet& remote_keys) const {
+    const DocumentKeySet& remote_keys,
+    QueryPlan* plan) const {
   HARD_ASSERT(local_documents_view_ && index_manager_,
               "Initialize() not called");
 
-  const absl::optional<DocumentMap> index_result =
-      PerformQueryUsingIndex(query);
-  if (index_result.has_value()) {
-    return index_result.value();
+  QueryPlan query_plan =
+      PlanQuery(query, last_limbo_free_snapshot_version, remote_keys);
+  LOG_DEBUG("Planned query %s: %s", query.ToString(), query_plan.ToString());
+
+  // Strategies that turn out to be unusable (e.g. a limit query whose
+  // previous results need a refill) still count towards the work done.
+  size_t documents_read = 0;
+  for (const QueryPlanCandidate& candidate : query_plan.candidates()) {
+    absl::optional<DocumentMap> result;
+    switch (candidate.strategy) {
+      case QueryPlanStrategy::kIndex:
+        result = PerformQueryUsingIndex(query, &documents_read);
+        break;
+      case QueryPlanStrategy::kRemoteKeys:
+        result = PerformQueryUsingRemoteKeys(query, remote_keys,
+                                             last_limbo_free_snapshot_version,
+                                             &documents_read);
+        break;
+      case QueryPlanStrategy::kFullCollectionScan: {
+        absl::optional<QueryContext> context = QueryContext();
+        result = ExecuteFullCollectionScan(query, context);
+        documents_read += context.value().GetDocumentReadCount();
+        if (index_auto_creation_enabled_) {
+          CreateCacheIndexes(query, context.value(), result.value().size());
+        }
+        break;
+      }
+    }
+
+    if (result.has_value()) {
+      query_plan.RecordExecution(candidate.strategy, documents_read,
+                                 result.value().size());
+      if (plan) {
+        *plan = std::move(query_plan);
+      }
+      return std::move(result).value();
+    }
   }
 
-  const absl::optional<DocumentMap> key_result = PerformQueryUsingRemoteKeys(
-      query, remote_keys, last_limbo_free_snapshot_version);
-  if (key_result.has_value()) {
-    return key_result.value();
+  HARD_FAIL("The query plan for %s did not contain a full collection scan",
+            query.ToString());
+}
+
+absl::optional<size_t> QueryEngine::CountDocumentsMatchingQueryUsingIndex(
+    const Query& query) const {
+  HARD_ASSERT(local_documents_view_ && index_manager_,
+              "Initialize() not called");
+
+  if (query.MatchesAllDocuments()) {
+    return absl::nullopt;
   }
 
-  absl::optional<QueryContext> context = QueryContext();
-  auto full_scan_result = ExecuteFullCollectionScan(query, context);
-  if (index_auto_creation_enabled_) {
-    CreateCacheIndexes(query, context.value(), full_scan_result.size());
+  const Query unlimited = query.WithLimitToFirst(core::Target::kNoLimit);
+  const core::Target& target = unlimited.ToTarget();
+  if (index_manager_->GetIndexType(target) != IndexManager::IndexType::FULL) {
+    return absl::nullopt;
+  }
+
+  LOG_DEBUG("Counting documents from index entries for query: %s",
+            query.ToString());
+
+  auto keys = index_manager_->GetDocumentsMatchingTarget(target);
+  HARD_ASSERT(keys.has_value(), "Full index for target is missing: %s",
+              target.ToString());
+  model::IndexOffset offset = index_manager_->GetMinOffset(target);
+
+  // Field indexes span collection groups, so a collection query has to skip
+  // the entries of same-named collections elsewhere.
+  DocumentKeySet indexed;
+  for (const DocumentKey& key : keys.value()) {
+    if (query.IsCollectionGroupQuery() ||
+        key.path().PopLast() == query.path()) {
+      indexed = indexed.insert(key);
+    }
+  }
+
+  // Index entries are not deleted when a document is removed from the cache
+  // (e.g. by garbage collection) or deleted remotely, so check which keys
+  // still have found documents.
+  RemoteDocumentCache* remote_documents =
+      local_documents_view_->remote_document_cache();
+  indexed = remote_documents->GetFoundDocumentKeys(indexed);
+
+  // The entries of documents that changed after the index offset may be
+  // stale. Whether these documents match is decided below, like for the ones
+  // that have not been indexed yet.
+  const std::string& collection_group =
+      query.collection_group() ? *query.collection_group()
+                               : query.path().last_segment();
+  for (const auto& entry : remote_documents->GetAll(
+           collection_group, offset, std::numeric_limits<size_t>::max())) {
+    indexed = indexed.erase(entry.first);
+  }
+
+  // Documents with overlays were indexed with the local view at the time, and
+  // have to be read to see if they still match.
+  std::set<DocumentKey> mutated_keys(indexed.begin(), indexed.end());
+  model::OverlayByDocumentKeyMap overlays;
+  local_documents_view_->document_overlay_cache()->GetOverlays(overlays,
+                                                               mutated_keys);
+  DocumentKeySet mutated;
+  for (const auto& entry : overlays) {
+    indexed = indexed.erase(entry.first);
+    mutated = mutated.insert(entry.first);
   }
-  return full_scan_result;
+
+  DocumentKeySet matched;
+  auto add_matches = [&](const DocumentMap& documents) {
+    for (const auto& entry : documents) {
+      const Document& document = entry.second;
+      if (document->is_found_document() && query.Matches(document)) {
+        matched = matched.insert(entry.first);
+      }
+    }
+  };
+  add_matches(local_documents_view_->GetDocuments(mutated));
+  add_matches(local_documents_view_->GetDocumentsMatchingQuery(unlimited,
+                                                               offset));
+
+  // `matched` only contains documents whose keys were removed from `indexed`.
+  return indexed.size() + matched.size();
+}
+
+QueryPlan QueryEngine::PlanQuery(
+    const Query& query,
+    const SnapshotVersion& last_limbo_free_snapshot_version,
+    const DocumentKeySet& remote_keys) const {
+  QueryPlanInputs inputs;
+
+  if (!query.MatchesAllDocuments()) {
+    const core::Target& target = query.ToTarget();
+    inputs.index_type = index_manager_->GetIndexType(target);
+    if (inputs.index_type != IndexManager::IndexType::NONE) {
+      // Match counts are recorded for the unlimited target, which also has the
+      // order of a limit-to-first query.
+      const Query unlimited = query.WithLimitToFirst(core::Target::kNoLimit);
+      inputs.index_match_count =
+          index_manager_->GetIndexMatchCount(unlimited.ToTarget());
+    }
+  }
+
+  // Queries that have never seen a snapshot without limbo free documents
+  // cannot re-use their previous results.
+  inputs.remote_keys_available =
+      last_limbo_free_snapshot_version != SnapshotVersion::None();
+  inputs.remote_key_count = remote_keys.size();
+
+  // Statistics are kept per collection, so collection group queries (which
+  // span many collections) always use the fixed strategy order.
+  if (query.IsCollectionGroupQuery() || query.IsDocumentQuery()) {
+    return planner_->Plan(query, inputs);
+  }
+  inputs.collection_size =
+      local_documents_view_->remote_document_cache()->GetCollectionSize(
+          query.path());
+
+  return planner_->Plan(query, inputs);
 }
 
 void QueryEngine::CreateCacheIndexes(const core::Query& query,
@@ -110,7 +263,7 @@ void QueryEngine::CreateCacheIndexes(const core::Query& query,
       query.ToString(), context.GetDocumentReadCount(), result_size);
 
   if (context.GetDocumentReadCount() >
-      relative_index_read_cost_per_document_ * result_size) {
+      planner_->relative_index_read_cost_per_document() * result_size) {
     index_manager_->CreateTargetIndexes(query.ToTarget());
     LOG_DEBUG(
         "The SDK decides to create cache indexes for query: %s, as using cache "
@@ -123,8 +276,13 @@ void QueryEngine::SetIndexAutoCreationEnabled(bool is_enabled) {
   index_auto_creation_enabled_ = is_enabled;
 }
 
+void QueryEngine::SetQueryPlanner(std::unique_ptr<QueryPlanner> planner) {
+  HARD_ASSERT(planner != nullptr, "QueryPlanner must not be null");
+  planner_ = std::move(planner);
+}
+
 absl::optional<DocumentMap> QueryEngine::PerformQueryUsingIndex(
-    const Query& query) const {
+    const Query& query, size_t* documents_read) const {
   if (query.MatchesAllDocuments()) {
     // Don't use indexes for queries that can be executed by scanning the
     // collection.
@@ -150,7 +308,19 @@ absl::optional<DocumentMap> QueryEngine::PerformQueryUsingIndex(
     // in such cases.
     const Query query_with_limit =
         query.WithLimitToFirst(core::Target::kNoLimit);
-    return PerformQueryUsingIndex(query_with_limit);
+    return PerformQueryUsingIndex(query_with_limit, documents_read);
+  }
+
+  if (query.has_limit()) {
+    // When the index orders the documents like the query's target does, there
+    // is no need to read many more of them than the limit.
+    auto result = PerformQueryUsingIndexInOrder(query, documents_read);
+    if (result.has_value()) {
+      return result;
+    }
+    // Otherwise the limit can't be applied while scanning the index.
+    return PerformQueryUsingIndex(
+        query.WithLimitToFirst(core::Target::kNoLimit), documents_read);
   }
 
   auto keys = index_manager_->GetDocumentsMatchingTarget(target);
@@ -158,13 +328,16 @@ absl::optional<DocumentMap> QueryEngine::PerformQueryUsingIndex(
       keys.has_value(),
       "index manager must return results for partial and full indexes.");
 
-  DocumentKeySet remote_keys;
-  for (auto key : keys.value()) {
-    remote_keys = remote_keys.insert(key);
+  DocumentKeySet::Builder builder;
+  builder.reserve(keys.value().size());
+  for (auto& key : keys.value()) {
+    builder.insert(std::move(key));
   }
+  DocumentKeySet remote_keys = builder.Build();
 
   DocumentMap indexedDocuments =
       local_documents_view_->GetDocuments(remote_keys);
+  *documents_read += remote_keys.size();
   model::IndexOffset offset = index_manager_->GetMinOffset(target);
 
   DocumentSet previous_results = ApplyQuery(query, indexedDocuments);
@@ -175,18 +348,108 @@ absl::optional<DocumentMap> QueryEngine::PerformQueryUsingIndex(
     // can then apply the limit once all local edits are incorporated.
     const Query query_with_limit =
         query.WithLimitToFirst(core::Target::kNoLimit);
-    return PerformQueryUsingIndex(query_with_limit);
+    return PerformQueryUsingIndex(query_with_limit, documents_read);
   }
 
   // Retrieve all results for documents that were updated since the last
   // remote snapshot that did not contain any Limbo documents.
-  return AppendRemainingResults(previous_results, query, offset);
+  return AppendRemainingResults(previous_results, query, offset,
+                                documents_read);
+}
+
+absl::optional<DocumentMap> QueryEngine::PerformQueryUsingIndexInOrder(
+    const Query& query, size_t* documents_read) const {
+  const core::Target& target = query.ToTarget();
+  auto cursors = index_manager_->ScanDocumentsMatchingTarget(target);
+  if (!cursors.has_value()) {
+    return absl::nullopt;
+  }
+
+  LOG_DEBUG("Reading index in order to execute limit query: %s",
+            query.ToString());
+
+  model::IndexOffset offset = index_manager_->GetMinOffset(target);
+  DocumentMap results;
+  DocumentKeySet visited;
+
+  // Returns the next document from `cursor` that matches the query and whose
+  // index entries are up to date, so that it sorts where the cursor found it.
+  auto next_in_order = [&](IndexCursor* cursor) -> absl::optional<Document> {
+    for (; cursor->Valid(); cursor->Next()) {
+      const DocumentKey& key = cursor->key();
+      if (visited.contains(key)) {
+        continue;
+      }
+      visited = visited.insert(key);
+
+      Document document = local_documents_view_->GetDocument(key);
+      ++*documents_read;
+      if (!document->is_found_document() || !query.Matches(document)) {
+        continue;
+      }
+
+      if (document->has_pending_writes() ||
+          document->version() > offset.read_time()) {
+        // The document changed after it was indexed, so it may sort
+        // elsewhere now. Include it, but don't let it count towards the limit:
+        // the caller sorts all results once the remaining ones are appended.
+        results = results.insert(key, document);
+        continue;
+      }
+
+      cursor->Next();
+      return document;
+    }
+    return absl::nullopt;
+  };
+
+  // Merge the cursors, keeping the next document of each in a heap ordered
+  // like the target. The target of a `limitToLast` query orders documents in
+  // reverse, so that its limit applies to the first ones.
+  model::DocumentComparator comparator = query.Comparator();
+  util::ComparisonResult later = query.has_limit_to_last()
+                                     ? util::ComparisonResult::Ascending
+                                     : util::ComparisonResult::Descending;
+  using Head = std::pair<Document, IndexCursor*>;
+  auto after = [&](const Head& lhs, const Head& rhs) {
+    return comparator.Compare(lhs.first, rhs.first) == later;
+  };
+  std::vector<Head> heap;
+  for (const auto& cursor : cursors.value()) {
+    absl::optional<Document> document = next_in_order(cursor.get());
+    if (document) {
+      heap.emplace_back(std::move(*document), cursor.get());
+    }
+  }
+  std::make_heap(heap.begin(), heap.end(), after);
+
+  int32_t in_order = 0;
+  while (in_order < query.limit() && !heap.empty()) {
+    std::pop_heap(heap.begin(), heap.end(), after);
+    Head head = std::move(heap.back());
+    heap.pop_back();
+
+    results = results.insert(head.first->key(), head.first);
+    ++in_order;
+
+    absl::optional<Document> document = next_in_order(head.second);
+    if (document) {
+      heap.emplace_back(std::move(*document), head.second);
+      std::push_heap(heap.begin(), heap.end(), after);
+    }
+  }
+
+  // Retrieve all results for documents that were updated since the index
+  // offset.
+  return AppendRemainingResults(ApplyQuery(query, results), query, offset,
+                                documents_read);
 }
 
 absl::optional<DocumentMap> QueryEngine::PerformQueryUsingRemoteKeys(
     const Query& query,
     const DocumentKeySet& remote_keys,
-    const SnapshotVersion& last_limbo_free_snapshot_version) const {
+    const SnapshotVersion& last_limbo_free_snapshot_version,
+    size_t* documents_read) const {
   // Queries that match all documents don't benefit from using key-based
   // lookups. It is more efficient to scan all documents in a collection, rather
   // than to perform individual lookups.
@@ -201,6 +464,7 @@ absl::optional<DocumentMap> QueryEngine::PerformQueryUsingRemoteKeys(
   }
 
   DocumentMap documents = local_documents_view_->GetDocuments(remote_keys);
+  *documents_read += remote_keys.size();
   DocumentSet previous_results = ApplyQuery(query, documents);
 
   if ((query.has_limit_to_first() || query.has_limit_to_last()) &&
@@ -216,7 +480,8 @@ absl::optional<DocumentMap> QueryEngine::PerformQueryUsingRemoteKeys(
   // remote snapshot that did not contain any Limbo documents.
   return AppendRemainingResults(
       previous_results, query,
-      model::IndexOffset::CreateSuccessor(last_limbo_free_snapshot_version));
+      model::IndexOffset::CreateSuccessor(last_limbo_free_snapshot_version),
+      documents_read);
 }
 
 DocumentSet QueryEngine::ApplyQuery(const Query& query,
@@ -283,10 +548,12 @@ const DocumentMap QueryEngine::ExecuteFullCollectionScan(
 const DocumentMap QueryEngine::AppendRemainingResults(
     const DocumentSet& indexed_results,
     const Query& query,
-    const model::IndexOffset& offset) const {
+    const model::IndexOffset& offset,
+    size_t* documents_read) const {
   // Retrieve all results for documents that were updated since the offset.
   DocumentMap remaining_results =
       local_documents_view_->GetDocumentsMatchingQuery(query, offset);
+  *documents_read += remaining_results.size();
 
   // We merge `previous_results` into `update_results`, since `update_results`
   // is already a DocumentMap. If a document is contained in both lists, then
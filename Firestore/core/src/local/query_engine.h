@@ -17,6 +17,9 @@
 #ifndef FIRESTORE_CORE_SRC_LOCAL_QUERY_ENGINE_H_
 #define FIRESTORE_CORE_SRC_LOCAL_QUERY_ENGINE_H_
 
+#include <memory>
+
+#include "Firestore/core/src/local/query_planner.h"
 #include "Firestore/core/src/model/model_fwd.h"
 
 namespace firebase {
@@ -61,10 +64,17 @@ class QueryContext;
  * specific optimization is not guaranteed to produce the same results as full
  * collection scans. So in these cases, query processing falls back to full
  * scans.
+ *
+ * When the IndexManager and the RemoteDocumentCache have statistics for the
+ * queried collection, a QueryPlanner estimates the cost of each of these modes
+ * and the cheapest one is attempted first. Without statistics the modes are
+ * attempted in the order described above.
  */
 class QueryEngine {
  public:
-  virtual ~QueryEngine() = default;
+  QueryEngine();
+
+  virtual ~QueryEngine();
 
   /**
    * Sets the document view and index manager to query against.
@@ -74,23 +84,61 @@ class QueryEngine {
    */
   virtual void Initialize(LocalDocumentsView* local_documents);
 
+  /**
+   * Returns the documents matching `query`.
+   *
+   * @param plan If not null, receives a description of the strategies that
+   *     were considered, the one that was executed and the work it did.
+   */
   const model::DocumentMap GetDocumentsMatchingQuery(
       const core::Query& query,
       const model::SnapshotVersion& last_limbo_free_snapshot_version,
-      const model::DocumentKeySet& remote_keys) const;
+      const model::DocumentKeySet& remote_keys,
+      QueryPlan* plan = nullptr) const;
+
+  /**
+   * Returns the number of documents matching `query`, ignoring its limit,
+   * counted from the entries of field indexes that fully serve it. Returns
+   * nullopt if there are no such indexes.
+   *
+   * Only documents that have local mutations or that changed after they were
+   * indexed are read; all others are counted from their index entries alone.
+   */
+  absl::optional<size_t> CountDocumentsMatchingQueryUsingIndex(
+      const core::Query& query) const;
 
   void SetIndexAutoCreationEnabled(bool is_enabled);
 
+  /** Replaces the cost model used to order the execution strategies. */
+  void SetQueryPlanner(std::unique_ptr<QueryPlanner> planner);
+
  private:
   friend class IndexManagerTest;
   friend class LocalStoreTestBase;
 
+  /**
+   * Gathers the statistics for `query` and asks the planner for the order in
+   * which the execution strategies should be attempted.
+   */
+  QueryPlan PlanQuery(
+      const core::Query& query,
+      const model::SnapshotVersion& last_limbo_free_snapshot_version,
+      const model::DocumentKeySet& remote_keys) const;
+
   /**
    * Performs an indexed query that evaluates the query based on a collection's
    * persisted index values. Returns nullopt if an index is not available.
    */
   absl::optional<model::DocumentMap> PerformQueryUsingIndex(
-      const core::Query& query) const;
+      const core::Query& query, size_t* documents_read) const;
+
+  /**
+   * Performs a limit query served by a full index by reading the ranges it
+   * scans in index order, merging them, until the limit is reached. Returns
+   * nullopt if an index is not available.
+   */
+  absl::optional<model::DocumentMap> PerformQueryUsingIndexInOrder(
+      const core::Query& query, size_t* documents_read) const;
 
   /**
    * Performs a query based on the target's persisted query mapping. Returns
@@ -99,7 +147,8 @@ class QueryEngine {
   absl::optional<model::DocumentMap> PerformQueryUsingRemoteKeys(
       const core::Query& query,
       const model::DocumentKeySet& remote_keys,
-      const model::SnapshotVersion& last_limbo_free_snapshot_version) const;
+      const model::SnapshotVersion& last_limbo_free_snapshot_version,
+      size_t* documents_read) const;
 
   /** Applies the query filter and sorting to the provided documents. */
   model::DocumentSet ApplyQuery(const core::Query& query,
@@ -133,7 +182,8 @@ class QueryEngine {
   const model::DocumentMap AppendRemainingResults(
       const model::DocumentSet& indexedResults,
       const core::Query& query,
-      const model::IndexOffset& offset) const;
+      const model::IndexOffset& offset,
+      size_t* documents_read) const;
 
   void CreateCacheIndexes(const core::Query& query,
                           const QueryContext& context,
@@ -149,7 +199,7 @@ class QueryEngine {
    * larger than this. */
   size_t index_auto_creation_min_collection_size_;
 
-  double relative_index_read_cost_per_document_;
+  std::unique_ptr<QueryPlanner> planner_;
 
   // For testing
   void SetIndexAutoCreationMinCollectionSize(size_t new_min) {
@@ -158,7 +208,7 @@ class QueryEngine {
 
   // For testing
   void SetRelativeIndexReadCostPerDocument(double new_cost) {
-    relative_index_read_cost_per_document_ = new_cost;
+    planner_->set_relative_index_read_cost_per_document(new_cost);
   }
 };
 
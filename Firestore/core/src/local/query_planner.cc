@@ -0,0 +1,209 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/local/query_planner.h"
+
+#include <algorithm>
+
+#include "Firestore/core/src/core/filter.h"
+#include "Firestore/core/src/core/query.h"
+#include "Firestore/core/src/util/hard_assert.h"
+#include "absl/strings/str_cat.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+namespace {
+
+/**
+ * Below this many cached documents the planner keeps the fixed strategy order
+ * (index, remote keys, full collection scan). Matches the threshold used for
+ * automatic index creation.
+ */
+const size_t kDefaultMinCollectionSize = 100;
+
+/**
+ * The cost of reading one document through an index, relative to reading one
+ * document during a full collection scan. See
+ * https://github.com/firebase/firebase-ios-sdk/pull/11716.
+ */
+const double kDefaultRelativeIndexReadCostPerDocument = 3.4;
+
+/**
+ * The cost of reading one document by key, relative to reading one document
+ * during a full collection scan. A key lookup is a random seek like an index
+ * lookup, but it skips reading the index entry.
+ */
+const double kRelativeKeyLookupCostPerDocument = 2.0;
+
+/**
+ * The fraction of a collection assumed to match an equality-style filter
+ * (`==`, `in`, `array-contains`, ...) when no better statistics are known.
+ */
+const double kEqualityFilterSelectivity = 0.1;
+
+/**
+ * The fraction of a collection assumed to match an inequality or composite
+ * filter when no better statistics are known.
+ */
+const double kRangeFilterSelectivity = 0.5;
+
+std::string FormatEstimate(const absl::optional<double>& value) {
+  return value.has_value() ? absl::StrCat(value.value()) : "unknown";
+}
+
+}  // namespace
+
+std::string ToString(QueryPlanStrategy strategy) {
+  switch (strategy) {
+    case QueryPlanStrategy::kIndex:
+      return "INDEX";
+    case QueryPlanStrategy::kRemoteKeys:
+      return "REMOTE_KEYS";
+    case QueryPlanStrategy::kFullCollectionScan:
+      return "FULL_COLLECTION_SCAN";
+  }
+  UNREACHABLE();
+}
+
+std::string QueryPlan::ToString() const {
+  std::string result =
+      absl::StrCat("QueryPlan(cost_based=", cost_based_ ? "true" : "false",
+                   ")\n");
+  int rank = 0;
+  for (const QueryPlanCandidate& candidate : candidates_) {
+    absl::StrAppend(&result, "  ", ++rank, ". ",
+                    local::ToString(candidate.strategy),
+                    " estimated_documents_read=",
+                    FormatEstimate(candidate.estimated_documents_read),
+                    " estimated_cost=",
+                    FormatEstimate(candidate.estimated_cost), "\n");
+  }
+  absl::StrAppend(&result,
+                  "  executed: ", local::ToString(executed_strategy_),
+                  " documents_read=", documents_read_,
+                  " result_count=", result_count_);
+  return result;
+}
+
+QueryPlanner::QueryPlanner()
+    : min_collection_size_(kDefaultMinCollectionSize),
+      relative_index_read_cost_per_document_(
+          kDefaultRelativeIndexReadCostPerDocument) {
+}
+
+QueryPlan QueryPlanner::Plan(const core::Query& query,
+                             const QueryPlanInputs& inputs) const {
+  std::vector<QueryPlanCandidate> candidates;
+
+  // Queries that match all documents don't benefit from indexes or key-based
+  // lookups. It is more efficient to scan all documents in a collection.
+  if (!query.MatchesAllDocuments()) {
+    if (inputs.index_type != IndexManager::IndexType::NONE) {
+      candidates.push_back(EstimateIndexCost(query, inputs));
+    }
+    if (inputs.remote_keys_available) {
+      candidates.push_back(EstimateRemoteKeysCost(query, inputs));
+    }
+  }
+  candidates.push_back(EstimateFullCollectionScanCost(query, inputs));
+
+  bool cost_based =
+      inputs.collection_size.has_value() &&
+      inputs.collection_size.value() >= min_collection_size_ &&
+      std::all_of(candidates.begin(), candidates.end(),
+                  [](const QueryPlanCandidate& candidate) {
+                    return candidate.estimated_cost.has_value();
+                  });
+
+  if (cost_based) {
+    // A stable sort keeps the fixed order for strategies with equal costs.
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](const QueryPlanCandidate& lhs,
+                        const QueryPlanCandidate& rhs) {
+                       return lhs.estimated_cost.value() <
+                              rhs.estimated_cost.value();
+                     });
+  }
+
+  return QueryPlan(std::move(candidates), cost_based);
+}
+
+QueryPlanCandidate QueryPlanner::EstimateIndexCost(
+    const core::Query& query, const QueryPlanInputs& inputs) const {
+  QueryPlanCandidate candidate;
+  candidate.strategy = QueryPlanStrategy::kIndex;
+
+  absl::optional<double> matches;
+  if (inputs.index_match_count.has_value()) {
+    matches = static_cast<double>(inputs.index_match_count.value());
+  } else if (inputs.collection_size.has_value()) {
+    double selectivity = 1.0;
+    if (inputs.index_type == IndexManager::IndexType::FULL) {
+      for (const core::Filter& filter : query.filters()) {
+        selectivity *= filter.IsAFieldFilter() && !filter.IsInequality()
+                           ? kEqualityFilterSelectivity
+                           : kRangeFilterSelectivity;
+      }
+    } else {
+      // A partial index doesn't cover every filter, so it returns a superset
+      // of the results that has to be filtered in memory.
+      selectivity = kRangeFilterSelectivity;
+    }
+    matches = std::max(
+        1.0, static_cast<double>(inputs.collection_size.value()) * selectivity);
+  }
+
+  if (matches.has_value() && query.has_limit() &&
+      inputs.index_type == IndexManager::IndexType::FULL) {
+    // Full indexes stop reading after `limit` entries.
+    matches = std::min(matches.value(), static_cast<double>(query.limit()));
+  }
+
+  candidate.estimated_documents_read = matches;
+  if (matches.has_value()) {
+    candidate.estimated_cost =
+        matches.value() * relative_index_read_cost_per_document_;
+  }
+  return candidate;
+}
+
+QueryPlanCandidate QueryPlanner::EstimateRemoteKeysCost(
+    const core::Query&, const QueryPlanInputs& inputs) const {
+  QueryPlanCandidate candidate;
+  candidate.strategy = QueryPlanStrategy::kRemoteKeys;
+  double documents = static_cast<double>(inputs.remote_key_count);
+  candidate.estimated_documents_read = documents;
+  candidate.estimated_cost = documents * kRelativeKeyLookupCostPerDocument;
+  return candidate;
+}
+
+QueryPlanCandidate QueryPlanner::EstimateFullCollectionScanCost(
+    const core::Query&, const QueryPlanInputs& inputs) const {
+  QueryPlanCandidate candidate;
+  candidate.strategy = QueryPlanStrategy::kFullCollectionScan;
+  if (inputs.collection_size.has_value()) {
+    double documents = static_cast<double>(inputs.collection_size.value());
+    candidate.estimated_documents_read = documents;
+    candidate.estimated_cost = documents;
+  }
+  return candidate;
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,212 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_LOCAL_QUERY_PLANNER_H_
+#define FIRESTORE_CORE_SRC_LOCAL_QUERY_PLANNER_H_
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/local/index_manager.h"
+#include "absl/types/optional.h"
+
+namespace firebase {
+namespace firestore {
+
+namespace core {
+class Query;
+}  // namespace core
+
+namespace local {
+
+/** The ways in which the QueryEngine can execute a query. */
+enum class QueryPlanStrategy {
+  /** Look up matching keys in a field index, then read those documents. */
+  kIndex,
+  /** Re-use the keys that matched the target at its last limbo-free sync. */
+  kRemoteKeys,
+  /** Read and filter every document in the collection. */
+  kFullCollectionScan,
+};
+
+std::string ToString(QueryPlanStrategy strategy);
+
+/** A single execution strategy considered by the planner. */
+struct QueryPlanCandidate {
+  QueryPlanStrategy strategy = QueryPlanStrategy::kFullCollectionScan;
+
+  /**
+   * The estimated number of documents this strategy has to read, or `nullopt`
+   * if no statistics were available to estimate it.
+   */
+  absl::optional<double> estimated_documents_read;
+
+  /**
+   * The estimated cost of the strategy, expressed in units of "documents read
+   * by a full collection scan", or `nullopt` if it could not be estimated.
+   */
+  absl::optional<double> estimated_cost;
+};
+
+/**
+ * The statistics the planner uses to cost a query. All of these are gathered
+ * by the QueryEngine from the IndexManager and the RemoteDocumentCache.
+ */
+struct QueryPlanInputs {
+  /** The type of index that can serve the query's target. */
+  IndexManager::IndexType index_type = IndexManager::IndexType::NONE;
+
+  /**
+   * The number of index entries that matched the target the last time it was
+   * served from an index, if known.
+   */
+  absl::optional<size_t> index_match_count;
+
+  /**
+   * Whether the target's previous result (its remote keys) can be re-used,
+   * i.e. the target has been limbo-free at least once.
+   */
+  bool remote_keys_available = false;
+
+  /** The number of keys that matched the target at its last sync. */
+  size_t remote_key_count = 0;
+
+  /** The number of documents cached in the query's collection, if known. */
+  absl::optional<size_t> collection_size;
+};
+
+/**
+ * An EXPLAIN-style description of a query execution: the strategies that were
+ * considered (ordered by preference), the one that produced the result and the
+ * work that was actually done.
+ */
+class QueryPlan {
+ public:
+  QueryPlan() = default;
+
+  QueryPlan(std::vector<QueryPlanCandidate> candidates, bool cost_based)
+      : candidates_(std::move(candidates)), cost_based_(cost_based) {
+  }
+
+  /** The candidate strategies, in the order in which they are attempted. */
+  const std::vector<QueryPlanCandidate>& candidates() const {
+    return candidates_;
+  }
+
+  /**
+   * Whether the candidates were ordered by estimated cost. If statistics are
+   * missing (or the collection is too small to matter), the planner falls
+   * back to the fixed order index, remote keys, full collection scan.
+   */
+  bool cost_based() const {
+    return cost_based_;
+  }
+
+  /** The strategy that produced the result. */
+  QueryPlanStrategy executed_strategy() const {
+    return executed_strategy_;
+  }
+
+  /** The number of documents read to compute the result. */
+  size_t documents_read() const {
+    return documents_read_;
+  }
+
+  /** The number of documents in the result. */
+  size_t result_count() const {
+    return result_count_;
+  }
+
+  void RecordExecution(QueryPlanStrategy strategy,
+                       size_t documents_read,
+                       size_t result_count) {
+    executed_strategy_ = strategy;
+    documents_read_ = documents_read;
+    result_count_ = result_count;
+  }
+
+  /** Returns a multi-line, human readable description of this plan. */
+  std::string ToString() const;
+
+ private:
+  std::vector<QueryPlanCandidate> candidates_;
+  bool cost_based_ = false;
+
+  QueryPlanStrategy executed_strategy_ = QueryPlanStrategy::kFullCollectionScan;
+  size_t documents_read_ = 0;
+  size_t result_count_ = 0;
+};
+
+/**
+ * Estimates the cost of every strategy the QueryEngine can use to execute a
+ * query and orders them cheapest first.
+ *
+ * The cost functions are virtual so that alternative cost models can be
+ * plugged into the QueryEngine (see `QueryEngine::SetQueryPlanner`).
+ */
+class QueryPlanner {
+ public:
+  QueryPlanner();
+
+  virtual ~QueryPlanner() = default;
+
+  /**
+   * Returns the candidate strategies for `query`. A full collection scan is
+   * always the last resort, so it is always part of the returned plan.
+   */
+  QueryPlan Plan(const core::Query& query, const QueryPlanInputs& inputs) const;
+
+  /**
+   * Collections with fewer cached documents than this are executed in the
+   * fixed strategy order, since no plan is meaningfully more expensive there.
+   */
+  void set_min_collection_size(size_t size) {
+    min_collection_size_ = size;
+  }
+
+  void set_relative_index_read_cost_per_document(double cost) {
+    relative_index_read_cost_per_document_ = cost;
+  }
+
+  double relative_index_read_cost_per_document() const {
+    return relative_index_read_cost_per_document_;
+  }
+
+ protected:
+  /** Estimates the cost of serving `query` from a field index. */
+  virtual QueryPlanCandidate EstimateIndexCost(
+      const core::Query& query, const QueryPlanInputs& inputs) const;
+
+  /** Estimates the cost of re-using the target's previous remote keys. */
+  virtual QueryPlanCandidate EstimateRemoteKeysCost(
+      const core::Query& query, const QueryPlanInputs& inputs) const;
+
+  /** Estimates the cost of scanning the whole collection. */
+  virtual QueryPlanCandidate EstimateFullCollectionScanCost(
+      const core::Query& query, const QueryPlanInputs& inputs) const;
+
+ private:
+  size_t min_collection_size_;
+  double relative_index_read_cost_per_document_;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_LOCAL_QUERY_PLANNER_H_
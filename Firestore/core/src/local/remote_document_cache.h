@@ -18,6 +18,7 @@
 #define FIRESTORE_CORE_SRC_LOCAL_REMOTE_DOCUMENT_CACHE_H_
 
 #include <string>
+#include <vector>
 
 #include "Firestore/core/src/model/document_key.h"
 #include "Firestore/core/src/model/model_fwd.h"
@@ -81,6 +82,14 @@ class RemoteDocumentCache {
   virtual model::MutableDocumentMap GetAll(
       const model::DocumentKeySet& keys) const = 0;
 
+  /**
+   * Returns the keys in `keys` whose cache entry is a found Document, leaving
+   * out keys that are not cached or cached as a DeletedDocument or
+   * UnknownDocument. Unlike `GetAll`, this does not decode the documents.
+   */
+  virtual model::DocumentKeySet GetFoundDocumentKeys(
+      const model::DocumentKeySet& keys) const = 0;
+
   /**
    * Looks up the next "limit" number of documents for a collection group based
    * on the provided offset. The ordering is based on the document's read time
@@ -144,6 +153,36 @@ class RemoteDocumentCache {
       absl::optional<size_t> limit = absl::nullopt,
       const model::OverlayByDocumentKeyMap& mutated_docs = {}) const = 0;
 
+  /**
+   * Executes several queries against the cached Document entries, like
+   * `GetDocumentsMatchingQuery` without a limit. Implementations may execute
+   * the queries concurrently.
+   *
+   * @param queries The queries to match documents against.
+   * @param offset The read time and document key to start scanning at
+   * (exclusive).
+   * @param context A optional tracker to keep a record of important details
+   * during database local query execution.
+   * @param mutated_docs The documents with local mutations for each query, in
+   * the same order as `queries`.
+   * @return The sets of matching documents, in the same order as `queries`.
+   */
+  virtual std::vector<model::MutableDocumentMap> GetDocumentsMatchingQueries(
+      const std::vector<core::Query>& queries,
+      const model::IndexOffset& offset,
+      absl::optional<QueryContext>& context,
+      const std::vector<model::OverlayByDocumentKeyMap>& mutated_docs)
+      const = 0;
+
+  /**
+   * Returns the number of documents cached in the given collection (excluding
+   * subcollections), or `nullopt` if the cache does not have statistics for
+   * it. The count is an estimate used for query planning and is not
+   * guaranteed to be exact.
+   */
+  virtual absl::optional<size_t> GetCollectionSize(
+      const model::ResourcePath& collection_path) const = 0;
+
   /**
    * Sets the index manager used by remote document cache.
    *
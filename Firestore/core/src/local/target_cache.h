@@ -22,6 +22,7 @@
 
 #include "Firestore/core/src/model/model_fwd.h"
 #include "Firestore/core/src/model/types.h"
+#include "absl/types/optional.h"
 
 namespace firebase {
 namespace firestore {
@@ -37,6 +38,9 @@ class TargetData;
 using OrphanedDocumentCallback =
     std::function<void(const model::DocumentKey&, model::ListenSequenceNumber)>;
 
+using OrphanedDocumentPredicate =
+    std::function<bool(const model::DocumentKey&, model::ListenSequenceNumber)>;
+
 using SequenceNumberCallback = std::function<void(model::ListenSequenceNumber)>;
 
 /**
@@ -100,11 +104,13 @@ class TargetCache {
    * @param upper_bound The upper bound for last target's sequence number
    *     (inclusive).
    * @param live_targets Targets to ignore.
+   * @param limit The maximum number of targets to remove, if any.
    * @return The number of targets removed.
    */
   virtual size_t RemoveTargets(
       model::ListenSequenceNumber upper_bound,
-      const std::unordered_map<model::TargetId, TargetData>& live_targets) = 0;
+      const std::unordered_map<model::TargetId, TargetData>& live_targets,
+      absl::optional<size_t> limit = absl::nullopt) = 0;
 
   // Key-related methods
   virtual void AddMatchingKeys(const model::DocumentKeySet& keys,
@@ -26,7 +26,6 @@
 #include "Firestore/core/src/nanopb/fields_array.h"
 #include "Firestore/core/src/nanopb/message.h"
 #include "Firestore/core/src/nanopb/nanopb_util.h"
-#include "Firestore/core/src/util/hashing.h"
 
 #include "absl/strings/str_format.h"
 #include "absl/types/span.h"
@@ -199,8 +198,38 @@ ObjectValue::ObjectValue(Message<google_firestore_v1_Value> value)
   SortFields(*value_);
 }
 
+ObjectValue::ObjectValue(ObjectValue&& other) noexcept
+    : value_(std::move(other.value_)),
+      fingerprint_(other.fingerprint_.load(std::memory_order_relaxed)) {
+}
+
+ObjectValue& ObjectValue::operator=(ObjectValue&& other) noexcept {
+  value_ = std::move(other.value_);
+  fingerprint_.store(other.fingerprint_.load(std::memory_order_relaxed),
+                     std::memory_order_relaxed);
+  return *this;
+}
+
 ObjectValue::ObjectValue(const ObjectValue& other)
-    : value_(DeepClone(*other.value_)) {
+    : value_(other.value_.arena()
+                 ? Message<google_firestore_v1_Value>(*other.value_,
+                                                      other.value_.arena())
+                 : DeepClone(*other.value_)),
+      fingerprint_(other.fingerprint_.load(std::memory_order_relaxed)) {
+}
+
+ObjectValue ObjectValue::CloneToArena(
+    std::shared_ptr<nanopb::Arena> arena) const {
+  ObjectValue result{DeepClone(*value_, std::move(arena))};
+  result.fingerprint_.store(fingerprint_.load(std::memory_order_relaxed),
+                            std::memory_order_relaxed);
+  return result;
+}
+
+void ObjectValue::EnsureHeapAllocated() {
+  if (value_.arena()) {
+    value_ = DeepClone(*value_);
+  }
 }
 
 ObjectValue ObjectValue::FromMapValue(
@@ -321,6 +350,9 @@ void ObjectValue::Set(const FieldPath& path,
                       Message<google_firestore_v1_Value> value) {
   HARD_ASSERT(!path.empty(), "Cannot set field for empty path on ObjectValue");
 
+  EnsureHeapAllocated();
+  ResetFingerprint();
+
   google_firestore_v1_MapValue* parent_map = ParentMap(path.PopLast());
 
   std::map<std::string, Message<google_firestore_v1_Value>> upserts;
@@ -330,6 +362,9 @@ void ObjectValue::Set(const FieldPath& path,
 }
 
 void ObjectValue::SetAll(TransformMap data) {
+  EnsureHeapAllocated();
+  ResetFingerprint();
+
   FieldPath parent;
 
   std::map<std::string, Message<google_firestore_v1_Value>> upserts;
@@ -363,6 +398,9 @@ void ObjectValue::SetAll(TransformMap data) {
 void ObjectValue::Delete(const FieldPath& path) {
   HARD_ASSERT(!path.empty(), "Cannot delete field with empty path");
 
+  EnsureHeapAllocated();
+  ResetFingerprint();
+
   google_firestore_v1_Value* nested_value = value_.get();
   for (const std::string& segment : path.PopLast()) {
     auto* entry = FindEntry(*nested_value, segment);
@@ -383,7 +421,34 @@ std::string ObjectValue::ToString() const {
 }
 
 size_t ObjectValue::Hash() const {
-  return util::Hash(CanonicalId(*value_));
+  return static_cast<size_t>(Fingerprint());
+}
+
+uint64_t ObjectValue::Fingerprint() const {
+  uint64_t fingerprint = fingerprint_.load(std::memory_order_relaxed);
+  if (fingerprint == kNoFingerprint) {
+    // Concurrent callers may both compute the fingerprint, but they store the
+    // same result.
+    fingerprint = model::Fingerprint(*value_);
+    if (fingerprint == kNoFingerprint) {
+      fingerprint = 1;
+    }
+    fingerprint_.store(fingerprint, std::memory_order_relaxed);
+  }
+  return fingerprint;
+}
+
+bool operator==(const ObjectValue& lhs, const ObjectValue& rhs) {
+  const google_firestore_v1_MapValue& left = lhs.value_->map_value;
+  const google_firestore_v1_MapValue& right = rhs.value_->map_value;
+  // Copies of an arena-backed value share their fields.
+  if (left.fields == right.fields && left.fields_count == right.fields_count) {
+    return true;
+  }
+  if (lhs.Fingerprint() != rhs.Fingerprint()) {
+    return false;
+  }
+  return *lhs.value_ == *rhs.value_;
 }
 
 google_firestore_v1_MapValue* ObjectValue::ParentMap(const FieldPath& path) {
@@ -17,7 +17,10 @@
 #ifndef FIRESTORE_CORE_SRC_MODEL_OBJECT_VALUE_H_
 #define FIRESTORE_CORE_SRC_MODEL_OBJECT_VALUE_H_
 
+#include <atomic>
+#include <cstdint>
 #include <map>
+#include <memory>
 #include <ostream>
 #include <set>
 #include <string>
@@ -28,6 +31,7 @@
 #include "Firestore/core/src/model/field_path.h"
 #include "Firestore/core/src/model/model_fwd.h"
 #include "Firestore/core/src/model/value_util.h"
+#include "Firestore/core/src/nanopb/arena.h"
 #include "Firestore/core/src/nanopb/message.h"
 #include "Firestore/core/src/util/hard_assert.h"
 
@@ -47,8 +51,8 @@ class ObjectValue {
   /** Creates a new ObjectValue */
   explicit ObjectValue(nanopb::Message<google_firestore_v1_Value> value);
 
-  ObjectValue(ObjectValue&& other) noexcept = default;
-  ObjectValue& operator=(ObjectValue&& other) noexcept = default;
+  ObjectValue(ObjectValue&& other) noexcept;
+  ObjectValue& operator=(ObjectValue&& other) noexcept;
   ObjectValue(const ObjectValue& other);
 
   ObjectValue& operator=(const ObjectValue&) = delete;
@@ -83,6 +87,18 @@ class ObjectValue {
       pb_size_t count,
       const absl::flat_hash_map<std::string, std::string>& aliasMap);
 
+  /**
+   * Returns a copy of this ObjectValue whose contents are stored in `arena`.
+   * Copies of the returned value share the arena instead of deep-cloning the
+   * proto, and the first mutation of a copy moves it back onto the heap.
+   */
+  ObjectValue CloneToArena(std::shared_ptr<nanopb::Arena> arena) const;
+
+  /** Whether the contents of this ObjectValue are stored in an arena. */
+  bool is_arena_backed() const {
+    return value_.arena() != nullptr;
+  }
+
   /** Recursively extracts the FieldPaths that are set in this ObjectValue. */
   FieldMask ToFieldMask() const;
 
@@ -138,6 +154,13 @@ class ObjectValue {
 
   size_t Hash() const;
 
+  /**
+   * Returns a hash of the contents of this ObjectValue, which is computed on
+   * first use and cached until the value is modified. Equal ObjectValues have
+   * the same fingerprint. See `model::Fingerprint`.
+   */
+  uint64_t Fingerprint() const;
+
   friend bool operator==(const ObjectValue& lhs, const ObjectValue& rhs);
   friend std::ostream& operator<<(std::ostream& out,
                                   const ObjectValue& object_value);
@@ -152,12 +175,26 @@ class ObjectValue {
    */
   google_firestore_v1_MapValue* ParentMap(const FieldPath& path);
 
+  /**
+   * Replaces an arena-backed value with a heap-allocated copy, since arena
+   * memory is shared between copies and must not be modified.
+   */
+  void EnsureHeapAllocated();
+
+  /** Drops the cached fingerprint; must be called whenever `value_` changes. */
+  void ResetFingerprint() {
+    fingerprint_.store(kNoFingerprint, std::memory_order_relaxed);
+  }
+
+  /** The value of `fingerprint_` until the fingerprint has been computed. */
+  static constexpr uint64_t kNoFingerprint = 0;
+
   nanopb::Message<google_firestore_v1_Value> value_;
-};
 
-inline bool operator==(const ObjectValue& lhs, const ObjectValue& rhs) {
-  return *lhs.value_ == *rhs.value_;
-}
+  // Atomic since documents may be compared concurrently, e.g. when the views
+  // of a remote event are updated in parallel.
+  mutable std::atomic<uint64_t> fingerprint_{kNoFingerprint};
+};
 
 inline bool operator!=(const ObjectValue& lhs, const ObjectValue& rhs) {
   return !(lhs == rhs);
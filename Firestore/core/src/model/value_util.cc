@@ -18,6 +18,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <limits>
 #include <memory>
 #include <type_traits>
@@ -30,6 +31,7 @@
 #include "Firestore/core/src/nanopb/nanopb_util.h"
 #include "Firestore/core/src/util/comparison.h"
 #include "Firestore/core/src/util/hard_assert.h"
+#include "absl/base/casts.h"
 #include "absl/strings/escaping.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
@@ -235,31 +237,49 @@ ComparisonResult CompareArrays(const google_firestore_v1_Value& left,
                        right.array_value.values_count);
 }
 
-ComparisonResult CompareMaps(const google_firestore_v1_MapValue& left,
-                             const google_firestore_v1_MapValue& right) {
-  // Sort the given MapValues
-  auto left_map = DeepClone(left);
-  auto right_map = DeepClone(right);
-  SortFields(*left_map);
-  SortFields(*right_map);
+bool HasSortedFields(const google_firestore_v1_MapValue& value) {
+  for (pb_size_t i = 1; i < value.fields_count; ++i) {
+    if (nanopb::MakeStringView(value.fields[i].key) <
+        nanopb::MakeStringView(value.fields[i - 1].key)) {
+      return false;
+    }
+  }
+  return true;
+}
 
-  for (pb_size_t i = 0;
-       i < left_map->fields_count && i < right_map->fields_count; ++i) {
+ComparisonResult CompareSortedMaps(const google_firestore_v1_MapValue& left,
+                                   const google_firestore_v1_MapValue& right) {
+  for (pb_size_t i = 0; i < left.fields_count && i < right.fields_count; ++i) {
     const ComparisonResult key_cmp =
-        util::Compare(nanopb::MakeStringView(left_map->fields[i].key),
-                      nanopb::MakeStringView(right_map->fields[i].key));
+        util::Compare(nanopb::MakeStringView(left.fields[i].key),
+                      nanopb::MakeStringView(right.fields[i].key));
     if (key_cmp != ComparisonResult::Same) {
       return key_cmp;
     }
 
     const ComparisonResult value_cmp =
-        Compare(left_map->fields[i].value, right_map->fields[i].value);
+        Compare(left.fields[i].value, right.fields[i].value);
     if (value_cmp != ComparisonResult::Same) {
       return value_cmp;
     }
   }
 
-  return util::Compare(left_map->fields_count, right_map->fields_count);
+  return util::Compare(left.fields_count, right.fields_count);
+}
+
+ComparisonResult CompareMaps(const google_firestore_v1_MapValue& left,
+                             const google_firestore_v1_MapValue& right) {
+  // Maps that are part of an ObjectValue are already sorted, so only sort
+  // copies of the given MapValues if needed.
+  if (HasSortedFields(left) && HasSortedFields(right)) {
+    return CompareSortedMaps(left, right);
+  }
+
+  auto left_map = DeepClone(left);
+  auto right_map = DeepClone(right);
+  SortFields(*left_map);
+  SortFields(*right_map);
+  return CompareSortedMaps(*left_map, *right_map);
 }
 
 ComparisonResult CompareVectors(const google_firestore_v1_Value& left,
@@ -491,6 +511,142 @@ bool Equals(const google_firestore_v1_ArrayValue& lhs,
   return ArrayEquals(lhs, rhs);
 }
 
+namespace {
+
+uint64_t MixFingerprint(uint64_t state, uint64_t value) {
+  // The finalizer of SplitMix64, which spreads every input bit over the
+  // whole result.
+  uint64_t result = (state ^ value) + 0x9e3779b97f4a7c15ULL;
+  result = (result ^ (result >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  result = (result ^ (result >> 27)) * 0x94d049bb133111ebULL;
+  return result ^ (result >> 31);
+}
+
+uint64_t FingerprintBytes(absl::string_view bytes) {
+  // FNV-1a
+  uint64_t result = 0xcbf29ce484222325ULL;
+  for (char c : bytes) {
+    result = (result ^ static_cast<uint8_t>(c)) * 0x100000001b3ULL;
+  }
+  return MixFingerprint(result, bytes.size());
+}
+
+uint64_t FingerprintDouble(double value) {
+  // `Compare` considers all NaNs the same, and -0.0 the same as 0.0.
+  if (std::isnan(value)) {
+    return 0x7ff8000000000000ULL;
+  }
+  return absl::bit_cast<uint64_t>(value == 0.0 ? 0.0 : value);
+}
+
+uint64_t FingerprintNumber(const google_firestore_v1_Value& value) {
+  // Integers and doubles with the same numeric value compare as the same, so
+  // integral doubles are fingerprinted as integers.
+  if (value.which_value_type == google_firestore_v1_Value_integer_value_tag) {
+    return static_cast<uint64_t>(value.integer_value);
+  }
+
+  double double_value = value.double_value;
+  constexpr double kMinInt64 =
+      static_cast<double>(std::numeric_limits<int64_t>::min());
+  if (double_value >= kMinInt64 && double_value < -kMinInt64 &&
+      std::trunc(double_value) == double_value) {
+    return static_cast<uint64_t>(static_cast<int64_t>(double_value));
+  }
+  return FingerprintDouble(double_value);
+}
+
+uint64_t FingerprintTimestamp(const google_protobuf_Timestamp& timestamp) {
+  return MixFingerprint(static_cast<uint64_t>(timestamp.seconds),
+                        static_cast<uint64_t>(timestamp.nanos));
+}
+
+uint64_t FingerprintReference(const google_firestore_v1_Value& value) {
+  // `Compare` ignores empty path segments.
+  uint64_t result = 0;
+  for (absl::string_view segment :
+       absl::StrSplit(nanopb::MakeStringView(value.reference_value), '/',
+                      absl::SkipEmpty())) {
+    result = MixFingerprint(result, FingerprintBytes(segment));
+  }
+  return result;
+}
+
+uint64_t FingerprintMap(const google_firestore_v1_MapValue& value) {
+  // Fields are combined independently of their order, since maps with the
+  // same fields in a different order are equal.
+  uint64_t result = value.fields_count;
+  for (pb_size_t i = 0; i < value.fields_count; ++i) {
+    const google_firestore_v1_MapValue_FieldsEntry& entry = value.fields[i];
+    uint64_t key = FingerprintBytes(nanopb::MakeStringView(entry.key));
+    result += MixFingerprint(key, Fingerprint(entry.value));
+  }
+  return result;
+}
+
+}  // namespace
+
+uint64_t Fingerprint(const google_firestore_v1_Value& value) {
+  TypeOrder type_order = GetTypeOrder(value);
+  uint64_t result = 0;
+  switch (type_order) {
+    case TypeOrder::kNull:
+    case TypeOrder::kMaxValue:
+      break;
+
+    case TypeOrder::kBoolean:
+      result = value.boolean_value ? 1 : 0;
+      break;
+
+    case TypeOrder::kNumber:
+      result = FingerprintNumber(value);
+      break;
+
+    case TypeOrder::kTimestamp:
+      result = FingerprintTimestamp(value.timestamp_value);
+      break;
+
+    case TypeOrder::kServerTimestamp:
+      result = FingerprintTimestamp(GetLocalWriteTime(value));
+      break;
+
+    case TypeOrder::kString:
+      result = FingerprintBytes(nanopb::MakeStringView(value.string_value));
+      break;
+
+    case TypeOrder::kBlob:
+      result = FingerprintBytes(nanopb::MakeStringView(value.bytes_value));
+      break;
+
+    case TypeOrder::kReference:
+      result = FingerprintReference(value);
+      break;
+
+    case TypeOrder::kGeoPoint:
+      result =
+          MixFingerprint(FingerprintDouble(value.geo_point_value.latitude),
+                         FingerprintDouble(value.geo_point_value.longitude));
+      break;
+
+    case TypeOrder::kArray:
+      result = value.array_value.values_count;
+      for (pb_size_t i = 0; i < value.array_value.values_count; ++i) {
+        result =
+            MixFingerprint(result, Fingerprint(value.array_value.values[i]));
+      }
+      break;
+
+    case TypeOrder::kVector:
+    case TypeOrder::kMap:
+      result = FingerprintMap(value.map_value);
+      break;
+
+    default:
+      HARD_FAIL("Invalid type value: %s", type_order);
+  }
+  return MixFingerprint(static_cast<uint64_t>(type_order), result);
+}
+
 std::string CanonifyTimestamp(const google_firestore_v1_Value& value) {
   return absl::StrFormat("time(%d,%d)", value.timestamp_value.seconds,
                          value.timestamp_value.nanos);
@@ -1002,6 +1158,113 @@ Message<google_firestore_v1_MapValue> DeepClone(
   return target;
 }
 
+namespace {
+
+/** Returns the number of arena bytes needed to copy the contents of `value`. */
+size_t ArenaSize(const google_firestore_v1_Value& value) {
+  switch (value.which_value_type) {
+    case google_firestore_v1_Value_string_value_tag:
+      return value.string_value ? nanopb::Arena::BytesArrayAllocationSize(
+                                      value.string_value->size)
+                                : 0;
+
+    case google_firestore_v1_Value_reference_value_tag:
+      return value.reference_value ? nanopb::Arena::BytesArrayAllocationSize(
+                                         value.reference_value->size)
+                                   : 0;
+
+    case google_firestore_v1_Value_bytes_value_tag:
+      return value.bytes_value ? nanopb::Arena::BytesArrayAllocationSize(
+                                     value.bytes_value->size)
+                               : 0;
+
+    case google_firestore_v1_Value_array_value_tag: {
+      const google_firestore_v1_ArrayValue& array = value.array_value;
+      size_t size = nanopb::Arena::AllocationSize(
+          sizeof(google_firestore_v1_Value) * array.values_count);
+      for (pb_size_t i = 0; i < array.values_count; ++i) {
+        size += ArenaSize(array.values[i]);
+      }
+      return size;
+    }
+
+    case google_firestore_v1_Value_map_value_tag: {
+      const google_firestore_v1_MapValue& map = value.map_value;
+      size_t size = nanopb::Arena::AllocationSize(
+          sizeof(google_firestore_v1_MapValue_FieldsEntry) * map.fields_count);
+      for (pb_size_t i = 0; i < map.fields_count; ++i) {
+        const pb_bytes_array_t* key = map.fields[i].key;
+        size += key ? nanopb::Arena::BytesArrayAllocationSize(key->size) : 0;
+        size += ArenaSize(map.fields[i].value);
+      }
+      return size;
+    }
+
+    default:
+      return 0;
+  }
+}
+
+pb_bytes_array_t* ArenaCopy(const pb_bytes_array_t* source,
+                            nanopb::Arena* arena) {
+  return source ? arena->MakeBytesArray(source->bytes, source->size) : nullptr;
+}
+
+/** Copies the contents of `source` into `target` using `arena` memory. */
+void ArenaCopy(const google_firestore_v1_Value& source,
+               google_firestore_v1_Value* target,
+               nanopb::Arena* arena) {
+  *target = source;
+  switch (source.which_value_type) {
+    case google_firestore_v1_Value_string_value_tag:
+      target->string_value = ArenaCopy(source.string_value, arena);
+      break;
+
+    case google_firestore_v1_Value_reference_value_tag:
+      target->reference_value = ArenaCopy(source.reference_value, arena);
+      break;
+
+    case google_firestore_v1_Value_bytes_value_tag:
+      target->bytes_value = ArenaCopy(source.bytes_value, arena);
+      break;
+
+    case google_firestore_v1_Value_array_value_tag: {
+      const google_firestore_v1_ArrayValue& array = source.array_value;
+      target->array_value.values =
+          arena->MakeArray<google_firestore_v1_Value>(array.values_count);
+      for (pb_size_t i = 0; i < array.values_count; ++i) {
+        ArenaCopy(array.values[i], &target->array_value.values[i], arena);
+      }
+      break;
+    }
+
+    case google_firestore_v1_Value_map_value_tag: {
+      const google_firestore_v1_MapValue& map = source.map_value;
+      target->map_value.fields =
+          arena->MakeArray<google_firestore_v1_MapValue_FieldsEntry>(
+              map.fields_count);
+      for (pb_size_t i = 0; i < map.fields_count; ++i) {
+        target->map_value.fields[i].key = ArenaCopy(map.fields[i].key, arena);
+        ArenaCopy(map.fields[i].value, &target->map_value.fields[i].value,
+                  arena);
+      }
+      break;
+    }
+  }
+}
+
+}  // namespace
+
+Message<google_firestore_v1_Value> DeepClone(
+    const google_firestore_v1_Value& source,
+    std::shared_ptr<nanopb::Arena> arena) {
+  // Reserving the exact size up front places the whole copy in one block.
+  arena->Reserve(ArenaSize(source));
+  google_firestore_v1_Value target;
+  ArenaCopy(source, &target, arena.get());
+  return Message<google_firestore_v1_Value>{target, std::move(arena)};
+}
+
 }  // namespace model
 }  // namespace firestore
 }  // namespace firebase
@@ -17,11 +17,14 @@
 #ifndef FIRESTORE_CORE_SRC_MODEL_VALUE_UTIL_H_
 #define FIRESTORE_CORE_SRC_MODEL_VALUE_UTIL_H_
 
+#include <cstdint>
+#include <memory>
 #include <ostream>
 #include <string>
 #include <vector>
 
 #include "Firestore/Protos/nanopb/google/firestore/v1/document.nanopb.h"
+#include "Firestore/core/src/nanopb/arena.h"
 #include "Firestore/core/src/nanopb/message.h"
 #include "Firestore/core/src/nanopb/nanopb_util.h"
 #include "absl/types/optional.h"
@@ -103,6 +106,15 @@ bool Equals(const google_firestore_v1_Value& left,
 bool Equals(const google_firestore_v1_ArrayValue& left,
             const google_firestore_v1_ArrayValue& right);
 
+/**
+ * Returns a 64-bit hash of the structure and contents of `value`.
+ *
+ * Values that `Compare` considers the same have the same fingerprint, so
+ * different fingerprints prove that two values differ. The converse doesn't
+ * hold: equal fingerprints are only a strong hint that two values are equal.
+ */
+uint64_t Fingerprint(const google_firestore_v1_Value& value);
+
 /**
  * Generates the canonical ID for the provided field value (as used in Target
  * serialization).
@@ -236,6 +248,14 @@ nanopb::Message<google_firestore_v1_Value> RefValue(
 nanopb::Message<google_firestore_v1_Value> DeepClone(
     const google_firestore_v1_Value& source);
 
+/**
+ * Creates a copy of the contents of the Value proto whose dynamically-allocated
+ * memory lives in `arena`. The copy must not be modified; see nanopb::Arena.
+ */
+nanopb::Message<google_firestore_v1_Value> DeepClone(
+    const google_firestore_v1_Value& source,
+    std::shared_ptr<nanopb::Arena> arena);
+
 /** Creates a copy of the contents of the ArrayValue proto. */
 nanopb::Message<google_firestore_v1_ArrayValue> DeepClone(
     const google_firestore_v1_ArrayValue& source);
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/nanopb/arena.h"
+
+#include <algorithm>
+
+#include "Firestore/core/src/nanopb/nanopb_util.h"
+
+namespace firebase {
+namespace firestore {
+namespace nanopb {
+
+namespace {
+
+// `new char[]` returns memory aligned for any fundamental type, which blocks
+// then preserve by rounding every allocation up to this alignment.
+constexpr size_t kAlignment = alignof(std::max_align_t);
+
+}  // namespace
+
+constexpr size_t Arena::kDefaultBlockSize;
+
+Arena::Arena(size_t block_size) : block_size_(block_size) {
+}
+
+size_t Arena::AllocationSize(size_t size) {
+  return (size + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+size_t Arena::BytesArrayAllocationSize(size_t size) {
+  // One extra byte for the null terminator, just like `MakeBytesArray`.
+  return size == 0 ? 0 : AllocationSize(PB_BYTES_ARRAY_T_ALLOCSIZE(size + 1));
+}
+
+void* Arena::Allocate(size_t size) {
+  size = AllocationSize(size);
+  if (static_cast<size_t>(end_ - next_) < size) {
+    AddBlock(size);
+  }
+  void* result = next_;
+  next_ += size;
+  return result;
+}
+
+pb_bytes_array_t* Arena::MakeBytesArray(const void* data, size_t size) {
+  if (size == 0) return nullptr;
+
+  pb_size_t pb_size = CheckedSize(size);
+  auto result = static_cast<pb_bytes_array_t*>(
+      Allocate(PB_BYTES_ARRAY_T_ALLOCSIZE(pb_size + 1)));
+  result->size = pb_size;
+  std::memcpy(result->bytes, data, pb_size);
+  result->bytes[pb_size] = '\0';
+  return result;
+}
+
+void Arena::Reserve(size_t size) {
+  if (static_cast<size_t>(end_ - next_) < size) {
+    AddBlock(size);
+  }
+}
+
+void Arena::AddBlock(size_t min_size) {
+  // The unused tail of the current block is abandoned; it is at most as large
+  // as the allocation that didn't fit into it.
+  size_t size = std::max(min_size, block_size_);
+  blocks_.emplace_back(new char[size]);
+  capacity_ += size;
+  next_ = blocks_.back().get();
+  end_ = next_ + size;
+}
+
+}  // namespace nanopb
+}  // namespace firestore
+}  // namespace firebase
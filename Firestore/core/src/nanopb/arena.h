@@ -0,0 +1,116 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_NANOPB_ARENA_H_
+#define FIRESTORE_CORE_SRC_NANOPB_ARENA_H_
+
+#include <pb.h>
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace firebase {
+namespace firestore {
+namespace nanopb {
+
+/**
+ * A bump allocator for the dynamically-allocated parts of Nanopb protos.
+ *
+ * Allocations are carved out of a few large blocks and are never freed
+ * individually: all memory is released at once when the `Arena` is destroyed.
+ * Building a proto tree in an `Arena` therefore costs a handful of `malloc`s
+ * instead of one per string, array and map entry, and destroying it is O(1) in
+ * the size of the tree.
+ *
+ * Protos whose memory lives in an `Arena` must be treated as immutable: Nanopb
+ * and the helpers in nanopb_util.h use `free` and `realloc`, which must never
+ * see memory that was allocated by an `Arena`. `Message` supports this by
+ * keeping a reference to the `Arena` instead of calling `pb_release`.
+ *
+ * This class is not thread-safe.
+ */
+class Arena {
+ public:
+  /** The default size of the blocks that allocations are carved out of. */
+  static constexpr size_t kDefaultBlockSize = 4096;
+
+  explicit Arena(size_t block_size = kDefaultBlockSize);
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  /**
+   * Allocates `size` bytes, suitably aligned for any Nanopb type. The memory
+   * is not initialized.
+   */
+  void* Allocate(size_t size);
+
+  /** Allocates a zero-initialized array of `count` values of type `T`. */
+  template <typename T>
+  T* MakeArray(pb_size_t count) {
+    if (count == 0) return nullptr;
+    size_t size = sizeof(T) * count;
+    void* result = Allocate(size);
+    std::memset(result, 0, size);
+    return static_cast<T*>(result);
+  }
+
+  /**
+   * Creates a null-terminated copy of the given bytes, like
+   * `nanopb::MakeBytesArray`. Returns null if `size` is zero.
+   */
+  pb_bytes_array_t* MakeBytesArray(const void* data, size_t size);
+
+  /**
+   * Makes sure that the next allocations, totaling at most `size` bytes
+   * (including any padding, see `AllocationSize`), are served from a single
+   * block.
+   */
+  void Reserve(size_t size);
+
+  /** The number of bytes reserved by `Allocate` and `MakeBytesArray`. */
+  static size_t AllocationSize(size_t size);
+
+  /** The number of bytes used by `MakeBytesArray` for `size` bytes. */
+  static size_t BytesArrayAllocationSize(size_t size);
+
+  /** Returns the total number of bytes in all blocks owned by the arena. */
+  size_t capacity() const {
+    return capacity_;
+  }
+
+  /** Returns the number of blocks owned by the arena. */
+  size_t block_count() const {
+    return blocks_.size();
+  }
+
+ private:
+  void AddBlock(size_t min_size);
+
+  size_t block_size_ = 0;
+  size_t capacity_ = 0;
+  char* next_ = nullptr;
+  char* end_ = nullptr;
+  std::vector<std::unique_ptr<char[]>> blocks_;
+};
+
+}  // namespace nanopb
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_NANOPB_ARENA_H_
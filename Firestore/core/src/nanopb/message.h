@@ -21,10 +21,12 @@
 #include <string>
 #include <utility>
 
+#include "Firestore/core/src/nanopb/arena.h"
 #include "Firestore/core/src/nanopb/byte_string.h"
 #include "Firestore/core/src/nanopb/fields_array.h"
 #include "Firestore/core/src/nanopb/reader.h"
 #include "Firestore/core/src/nanopb/writer.h"
+#include "Firestore/core/src/util/hard_assert.h"
 #include "grpcpp/support/byte_buffer.h"
 
 namespace firebase {
@@ -72,6 +74,16 @@ class Message {
   explicit Message(const T& proto) : owns_proto_(true), proto_(proto) {
   }
 
+  /**
+   * Creates a `Message` object that wraps `proto`, whose dynamically-allocated
+   * memory is owned by `arena` rather than by the proto itself. The `Message`
+   * keeps the arena alive and never calls `pb_release` on the proto, so the
+   * proto must not be modified in ways that free or reallocate its memory.
+   */
+  Message(const T& proto, std::shared_ptr<Arena> arena)
+      : owns_proto_(true), proto_(proto), arena_(std::move(arena)) {
+  }
+
   /**
    * Attempts to parse a Nanopb message from the given `reader`. If the reader
    * contains ill-formed bytes, returns a default-constructed `Message`; check
@@ -94,7 +106,9 @@ class Message {
    * results in undefined behavior.
    */
   Message(Message&& other) noexcept
-      : owns_proto_{other.owns_proto_}, proto_{other.proto_} {
+      : owns_proto_{other.owns_proto_},
+        proto_{other.proto_},
+        arena_{std::move(other.arena_)} {
     other.owns_proto_ = false;
   }
 
@@ -103,12 +117,19 @@ class Message {
 
     owns_proto_ = other.owns_proto_;
     proto_ = other.proto_;
+    arena_ = std::move(other.arena_);
     other.owns_proto_ = false;
 
     return *this;
   }
 
+  /**
+   * Gives up ownership of the proto and returns a pointer to it. The caller
+   * becomes responsible for freeing it, so this may not be called on an
+   * arena-backed `Message`.
+   */
   T* release() {
+    HARD_ASSERT(!arena_, "Cannot release an arena-backed Message");
     auto result = get();
     owns_proto_ = false;
     return result;
@@ -181,18 +202,28 @@ class Message {
     return owns_proto_;
   }
 
+  /**
+   * Returns the arena that owns the proto's dynamically-allocated memory, or
+   * null if the proto owns its memory itself.
+   */
+  const std::shared_ptr<Arena>& arena() const {
+    return arena_;
+  }
+
  private:
   // Important: this function does *not* modify `owns_proto_`.
   void Free() {
-    if (owns_proto_) {
+    if (owns_proto_ && !arena_) {
       FreeNanopbMessage(fields(), &proto_);
     }
+    arena_.reset();
   }
 
   bool owns_proto_ = true;
   // The Nanopb-proto is value-initialized (zeroed out) to make sure that any
   // member variables that aren't written to are in a valid state.
   T proto_{};
+  std::shared_ptr<Arena> arena_;
 };
 
 template <typename T>
@@ -16,11 +16,15 @@
 
 #include "Firestore/core/src/remote/grpc_nanopb.h"
 
+#include <pb_encode.h>
+
+#include <algorithm>
+#include <cstring>
 #include <vector>
 
 #include "Firestore/core/include/firebase/firestore/firestore_errors.h"
-#include "Firestore/core/src/nanopb/writer.h"
 #include "Firestore/core/src/remote/grpc_util.h"
+#include "Firestore/core/src/util/hard_assert.h"
 #include "Firestore/core/src/util/status.h"
 #include "grpcpp/support/status.h"
 
@@ -28,13 +32,10 @@ namespace firebase {
 namespace firestore {
 namespace remote {
 
-using nanopb::ByteString;
-using nanopb::ByteStringWriter;
 using util::Status;
 
 ByteBufferReader::ByteBufferReader(const grpc::ByteBuffer& buffer) {
-  std::vector<grpc::Slice> slices;
-  grpc::Status status = buffer.Dump(&slices);
+  grpc::Status status = buffer.Dump(&slices_);
   // Conversion may fail if compression is used and gRPC tries to decompress an
   // ill-formed buffer.
   if (!status.ok()) {
@@ -45,14 +46,49 @@ ByteBufferReader::ByteBufferReader(const grpc::ByteBuffer& buffer) {
     return;
   }
 
-  ByteStringWriter writer;
-  writer.Reserve(buffer.Length());
-  for (const auto& slice : slices) {
-    writer.Append(slice.begin(), slice.size());
+  if (slices_.size() == 1) {
+    // Nanopb reads contiguous buffers faster than callback streams.
+    stream_ = pb_istream_from_buffer(slices_[0].begin(), slices_[0].size());
+    return;
   }
 
-  bytes_ = writer.Release();
-  stream_ = pb_istream_from_buffer(bytes_.data(), bytes_.size());
+  size_t size = 0;
+  for (const grpc::Slice& slice : slices_) {
+    size += slice.size();
+  }
+  stream_.callback = ReadFromSlices;
+  stream_.state = this;
+  stream_.bytes_left = size;
+}
+
+bool ByteBufferReader::ReadFromSlices(pb_istream_t* stream,
+                                      pb_byte_t* buf,
+                                      size_t count) {
+  auto reader = static_cast<ByteBufferReader*>(stream->state);
+  std::vector<grpc::Slice>& slices = reader->slices_;
+
+  while (count > 0) {
+    if (reader->slice_index_ == slices.size()) {
+      return false;
+    }
+
+    const grpc::Slice& slice = slices[reader->slice_index_];
+    size_t available = slice.size() - reader->slice_offset_;
+    size_t length = std::min(available, count);
+    // Nanopb passes a null buffer to skip bytes.
+    if (buf) {
+      std::memcpy(buf, slice.begin() + reader->slice_offset_, length);
+      buf += length;
+    }
+    count -= length;
+
+    reader->slice_offset_ += length;
+    if (reader->slice_offset_ == slice.size()) {
+      ++reader->slice_index_;
+      reader->slice_offset_ = 0;
+    }
+  }
+  return true;
 }
 
 void ByteBufferReader::Read(const pb_field_t* fields, void* dest_struct) {
@@ -63,22 +99,20 @@ void ByteBufferReader::Read(const pb_field_t* fields, void* dest_struct) {
   }
 }
 
-namespace {
-
-bool AppendToGrpcBuffer(pb_ostream_t* stream,
-                        const pb_byte_t* buf,
-                        size_t count) {
-  auto buffer = static_cast<std::vector<grpc::Slice>*>(stream->state);
-  buffer->emplace_back(buf, count);
-  return true;
-}
-
-}  // namespace
+void ByteBufferWriter::Write(const pb_field_t* fields,
+                             const void* src_struct) {
+  size_t size = 0;
+  if (!pb_get_encoded_size(&size, fields, src_struct)) {
+    HARD_FAIL("Failed to compute the encoded size of a proto");
+  }
 
-ByteBufferWriter::ByteBufferWriter() {
-  stream_.callback = AppendToGrpcBuffer;
-  stream_.state = &buffer_;
-  stream_.max_size = SIZE_MAX;
+  buffer_.emplace_back(size);
+  // The slice was just allocated, so nothing else refers to its memory yet.
+  auto bytes = const_cast<pb_byte_t*>(buffer_.back().begin());
+  pb_ostream_t stream = pb_ostream_from_buffer(bytes, size);
+  if (!pb_encode(&stream, fields, src_struct)) {
+    HARD_FAIL(PB_GET_ERROR(&stream));
+  }
 }
 
 grpc::ByteBuffer ByteBufferWriter::Release() {
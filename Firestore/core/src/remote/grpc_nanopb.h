@@ -25,7 +25,6 @@
 #include "Firestore/core/src/nanopb/byte_string.h"
 #include "Firestore/core/src/nanopb/message.h"
 #include "Firestore/core/src/nanopb/reader.h"
-#include "Firestore/core/src/nanopb/writer.h"
 #include "grpcpp/support/byte_buffer.h"
 
 namespace firebase {
@@ -36,23 +35,45 @@ namespace remote {
 class ByteBufferReader : public nanopb::Reader {
  public:
   /**
-   * Copies the given `buffer` and associates the resulting stream with this
-   * `ByteBufferReader`.
+   * Associates the slices of the given `buffer` with this `ByteBufferReader`.
+   * The slices are reference-counted, so the bytes are decoded directly from
+   * the memory gRPC received them into, without copying the buffer.
    */
-  // TODO(varconst): avoid copying the buffer.
   explicit ByteBufferReader(const grpc::ByteBuffer& buffer);
 
+  // The stream refers back to this reader.
+  ByteBufferReader(const ByteBufferReader&) = delete;
+  ByteBufferReader& operator=(const ByteBufferReader&) = delete;
+
   void Read(const pb_field_t* fields, void* dest_struct) override;
 
  private:
-  nanopb::ByteString bytes_;
+  /** The `pb_istream_t` callback that reads from a chain of slices. */
+  static bool ReadFromSlices(pb_istream_t* stream,
+                             pb_byte_t* buf,
+                             size_t count);
+
+  std::vector<grpc::Slice> slices_;
+  size_t slice_index_ = 0;
+  size_t slice_offset_ = 0;
   pb_istream_t stream_{};
 };
 
-/** A `Writer` that writes into a `grpc::ByteBuffer`. */
-class ByteBufferWriter : public nanopb::Writer {
+/**
+ * Writes protos into a `grpc::ByteBuffer`.
+ *
+ * Unlike `nanopb::Writer`s, which encode into a single stream, this encodes
+ * each proto into a slice of its own, so it does not derive from
+ * `nanopb::Writer`.
+ */
+class ByteBufferWriter {
  public:
-  ByteBufferWriter();
+  /**
+   * Encodes the given proto into a single slice. The encoded size is computed
+   * up front, so that the slice is allocated once and filled in place. All
+   * errors are considered fatal.
+   */
+  void Write(const pb_field_t* fields, const void* src_struct);
 
   grpc::ByteBuffer Release();
 
@@ -16,6 +16,7 @@
 
 #include "Firestore/core/src/remote/remote_store.h"
 
+#include <iterator>
 #include <string>
 #include <utility>
 
@@ -43,6 +44,7 @@ using model::AggregateField;
 using model::BatchId;
 using model::DocumentKeySet;
 using model::kBatchIdUnknown;
+using model::Mutation;
 using model::MutationBatch;
 using model::MutationBatchResult;
 using model::MutationResult;
@@ -59,6 +61,12 @@ using util::Status;
  */
 constexpr int kMaxPendingWrites = 10;
 
+/**
+ * The maximum number of mutations to send in a single coalesced write request.
+ * A single batch with more mutations is still sent in a request of its own.
+ */
+constexpr size_t kMaxMutationsPerWriteRequest = 500;
+
 RemoteStore::RemoteStore(
     LocalStore* local_store,
     std::shared_ptr<Datastore> datastore,
@@ -134,6 +142,8 @@ void RemoteStore::DisableNetworkInternal() {
               write_pipeline_.size());
     write_pipeline_.clear();
   }
+  write_batches_sent_ = 0;
+  write_request_batch_counts_.clear();
 
   CleanUpWatchStreamState();
 }
@@ -409,6 +419,8 @@ void RemoteStore::FillWritePipeline() {
     last_batch_id_retrieved = batch->batch_id();
   }
 
+  SendPendingWrites();
+
   if (ShouldStartWriteStream()) {
     StartWriteStream();
   }
@@ -424,11 +436,51 @@ void RemoteStore::AddToWritePipeline(const MutationBatch& batch) {
 
   write_pipeline_.push_back(batch);
 
-  if (write_stream_->IsOpen() && write_stream_->handshake_complete()) {
-    write_stream_->WriteMutations(batch.mutations());
+  // Coalesced writes are sent once `FillWritePipeline` is done adding batches.
+  if (!write_coalescing_enabled_) {
+    SendPendingWrites();
+  }
+}
+
+void RemoteStore::SendPendingWrites() {
+  if (!write_stream_->IsOpen() || !write_stream_->handshake_complete()) {
+    return;
+  }
+
+  while (write_batches_sent_ < write_pipeline_.size()) {
+    const MutationBatch& first = write_pipeline_[write_batches_sent_];
+    size_t batch_count = 1;
+    if (!CanCoalesceWrite(first, 0)) {
+      write_stream_->WriteMutations(first.mutations());
+    } else {
+      std::vector<Mutation> mutations = first.mutations();
+      while (write_batches_sent_ + batch_count < write_pipeline_.size()) {
+        const MutationBatch& next =
+            write_pipeline_[write_batches_sent_ + batch_count];
+        if (!CanCoalesceWrite(next, mutations.size())) {
+          break;
+        }
+
+        mutations.insert(mutations.end(), next.mutations().begin(),
+                         next.mutations().end());
+        ++batch_count;
+      }
+      write_stream_->WriteMutations(mutations);
+    }
+
+    write_request_batch_counts_.push_back(batch_count);
+    write_batches_sent_ += batch_count;
   }
 }
 
+bool RemoteStore::CanCoalesceWrite(const MutationBatch& batch,
+                                   size_t request_size) const {
+  return write_coalescing_enabled_ &&
+         batch.batch_id() > uncoalesced_through_batch_id_ &&
+         request_size + batch.mutations().size() <=
+             kMaxMutationsPerWriteRequest;
+}
+
 bool RemoteStore::ShouldStartWriteStream() const {
   return CanUseNetwork() && !write_stream_->IsStarted() &&
          !write_pipeline_.empty();
@@ -448,26 +500,63 @@ void RemoteStore::OnWriteStreamHandshakeComplete() {
   // Record the stream token.
   local_store_->SetLastStreamToken(write_stream_->last_stream_token());
 
-  // Send the write pipeline now that the stream is established.
-  for (const MutationBatch& write : write_pipeline_) {
-    write_stream_->WriteMutations(write.mutations());
-  }
+  // Send the write pipeline now that the stream is established. Requests sent
+  // on a previous stream that weren't acknowledged are sent again.
+  write_batches_sent_ = 0;
+  write_request_batch_counts_.clear();
+  SendPendingWrites();
 }
 
 void RemoteStore::OnWriteStreamMutationResult(
     SnapshotVersion commit_version,
     std::vector<MutationResult> mutation_results) {
   // This is a response to a write containing mutations and should be correlated
-  // to the first write in our write pipeline.
-  HARD_ASSERT(!write_pipeline_.empty(), "Got result for empty write pipeline");
-
-  MutationBatch batch = write_pipeline_.front();
-  write_pipeline_.erase(write_pipeline_.begin());
-
-  MutationBatchResult batch_result(std::move(batch), commit_version,
-                                   std::move(mutation_results),
-                                   write_stream_->last_stream_token());
-  sync_engine_->HandleSuccessfulWrite(std::move(batch_result));
+  // to the first request sent, i.e. to the first write(s) in our write
+  // pipeline.
+  HARD_ASSERT(!write_request_batch_counts_.empty() && !write_pipeline_.empty(),
+              "Got result for empty write pipeline");
+
+  size_t batch_count = write_request_batch_counts_.front();
+  write_request_batch_counts_.pop_front();
+  HARD_ASSERT(batch_count <= write_pipeline_.size(),
+              "Got result for %s batches, but only %s are pending",
+              batch_count, write_pipeline_.size());
+
+  std::vector<MutationBatch> batches(write_pipeline_.begin(),
+                                     write_pipeline_.begin() + batch_count);
+  write_pipeline_.erase(write_pipeline_.begin(),
+                        write_pipeline_.begin() + batch_count);
+  write_batches_sent_ -= batch_count;
+
+  if (batch_count == 1) {
+    MutationBatchResult batch_result(std::move(batches.front()), commit_version,
+                                     std::move(mutation_results),
+                                     write_stream_->last_stream_token());
+    sync_engine_->HandleSuccessfulWrite(std::move(batch_result));
+  } else {
+    // The results of a coalesced request are in the order of its mutations, so
+    // each batch gets the next `mutations().size()` results.
+    size_t expected_results = 0;
+    for (const MutationBatch& batch : batches) {
+      expected_results += batch.mutations().size();
+    }
+    HARD_ASSERT(mutation_results.size() == expected_results,
+                "Expected %s results for a coalesced write, got %s",
+                expected_results, mutation_results.size());
+
+    auto next_result = mutation_results.begin();
+    for (MutationBatch& batch : batches) {
+      auto end = next_result + batch.mutations().size();
+      std::vector<MutationResult> batch_results(
+          std::make_move_iterator(next_result), std::make_move_iterator(end));
+      next_result = end;
+
+      MutationBatchResult batch_result(std::move(batch), commit_version,
+                                       std::move(batch_results),
+                                       write_stream_->last_stream_token());
+      sync_engine_->HandleSuccessfulWrite(std::move(batch_result));
+    }
+  }
 
   // It's possible that with the completion of this mutation another slot has
   // freed up.
@@ -535,6 +624,19 @@ void RemoteStore::HandleWriteError(const Status& status) {
     return;
   }
 
+  size_t batch_count = write_request_batch_counts_.empty()
+                           ? 1
+                           : write_request_batch_counts_.front();
+  if (batch_count > 1) {
+    // Any of the coalesced batches may have caused the error. Resend them one
+    // by one once the stream restarts so that only the offending batch is
+    // rejected.
+    uncoalesced_through_batch_id_ =
+        write_pipeline_[batch_count - 1].batch_id();
+    write_stream_->InhibitBackoff();
+    return;
+  }
+
   // If this was a permanent error, the request itself was the problem so it's
   // not going to succeed if we resend it.
   MutationBatch batch = write_pipeline_.front();
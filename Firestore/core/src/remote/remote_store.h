@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_REMOTE_REMOTE_STORE_H_
 #define FIRESTORE_CORE_SRC_REMOTE_REMOTE_STORE_H_
 
+#include <deque>
 #include <memory>
 #include <unordered_map>
 #include <vector>
@@ -188,6 +189,16 @@ class RemoteStore : public TargetMetadataProvider,
    */
   void AddToWritePipeline(const model::MutationBatch& batch);
 
+  /**
+   * Enables or disables write coalescing. While enabled, consecutive batches in
+   * the write pipeline are sent to the backend as a single write request. The
+   * backend's result for the request is split up again so that each batch is
+   * still acknowledged (or rejected) on its own.
+   */
+  void set_write_coalescing_enabled(bool enabled) {
+    write_coalescing_enabled_ = enabled;
+  }
+
   /** Returns a new transaction backed by this remote store. */
   // TODO(c++14): return a plain value when it becomes possible to move
   // `Transaction` into lambdas.
@@ -238,6 +249,19 @@ class RemoteStore : public TargetMetadataProvider,
    */
   bool CanAddToWritePipeline() const;
 
+  /**
+   * Sends the batches in the write pipeline that haven't been sent yet, if the
+   * write stream is ready to accept mutations.
+   */
+  void SendPendingWrites();
+
+  /**
+   * Returns true if `batch` can be added to a write request that already
+   * contains `request_size` mutations.
+   */
+  bool CanCoalesceWrite(const model::MutationBatch& batch,
+                        size_t request_size) const;
+
   void StartWriteStream();
 
   /**
@@ -313,6 +337,29 @@ class RemoteStore : public TargetMetadataProvider,
    * the `write_pipeline_` as we receive responses.
    */
   std::vector<model::MutationBatch> write_pipeline_;
+
+  /**
+   * The number of batches at the front of `write_pipeline_` that have been
+   * sent on the current write stream.
+   */
+  size_t write_batches_sent_ = 0;
+
+  /**
+   * The number of batches contained in each write request that was sent on the
+   * current write stream and is awaiting a response, in the order in which the
+   * requests were sent. Without write coalescing, every request contains
+   * exactly one batch.
+   */
+  std::deque<size_t> write_request_batch_counts_;
+
+  bool write_coalescing_enabled_ = false;
+
+  /**
+   * If a coalesced write request is rejected, there is no way to tell which of
+   * its batches caused the rejection. Batches up to and including this ID are
+   * then resent one per request, so that only the offending batch is rejected.
+   */
+  model::BatchId uncoalesced_through_batch_id_ = model::kBatchIdUnknown;
 };
 
 }  // namespace remote
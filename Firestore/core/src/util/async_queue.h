@@ -73,7 +73,13 @@ enum class TimerId {
   /**
    * A timer used to periodically attempt Index Backfill
    */
-  IndexBackfillDelay
+  IndexBackfillDelay,
+
+  /**
+   * A timer used to flush user writes that were buffered to be coalesced into
+   * a single local commit.
+   */
+  WriteCoalescingDelay
 };
 
 // A serial queue that executes given operations asynchronously, one at a time.
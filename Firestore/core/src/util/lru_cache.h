@@ -0,0 +1,131 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_UTIL_LRU_CACHE_H_
+#define FIRESTORE_CORE_SRC_UTIL_LRU_CACHE_H_
+
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+#include "Firestore/core/src/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+/**
+ * A map that holds at most `capacity` entries, and evicts the least recently
+ * used entry to make room for a new one.
+ *
+ * Entries are kept in a list ordered by recency, and a hash map from keys to
+ * list positions gives constant-time lookups. Both looking up and storing an
+ * entry mark it as the most recently used.
+ *
+ * The remaining variadic template arguments are passed as the template
+ * arguments to `unordered_map` after the key and value types, allowing custom
+ * hashing and comparison functions to be specified.
+ */
+template <typename K, typename V, typename... UnorderedMapArgs>
+class LruCache {
+ public:
+  explicit LruCache(size_t capacity) : capacity_(capacity) {
+    HARD_ASSERT(capacity > 0, "LruCache capacity must be positive");
+  }
+
+  /**
+   * Returns the value stored for `key` and marks it as the most recently used,
+   * or returns `nullptr` if there is none. The pointer is valid until the
+   * entry is evicted or erased.
+   */
+  V* Get(const K& key) {
+    auto found = positions_.find(key);
+    if (found == positions_.end()) {
+      return nullptr;
+    }
+    entries_.splice(entries_.begin(), entries_, found->second);
+    return &found->second->second;
+  }
+
+  /**
+   * Stores `value` for `key`, replacing any value stored before, and marks it
+   * as the most recently used. Evicts the least recently used entry if the
+   * cache was full.
+   */
+  void Put(const K& key, V value) {
+    V* existing = Get(key);
+    if (existing) {
+      *existing = std::move(value);
+      return;
+    }
+
+    if (entries_.size() >= capacity_) {
+      positions_.erase(entries_.back().first);
+      entries_.pop_back();
+    }
+    entries_.emplace_front(key, std::move(value));
+    positions_.emplace(key, entries_.begin());
+  }
+
+  /** Removes the entry for `key`, if any. */
+  void Erase(const K& key) {
+    auto found = positions_.find(key);
+    if (found == positions_.end()) {
+      return;
+    }
+    entries_.erase(found->second);
+    positions_.erase(found);
+  }
+
+  /** Removes every entry for which `predicate(key, value)` returns true. */
+  template <typename Predicate>
+  void EraseIf(const Predicate& predicate) {
+    for (auto it = entries_.begin(); it != entries_.end();) {
+      if (predicate(it->first, it->second)) {
+        positions_.erase(it->first);
+        it = entries_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  void Clear() {
+    entries_.clear();
+    positions_.clear();
+  }
+
+  size_t size() const {
+    return entries_.size();
+  }
+
+ private:
+  using Entry = std::pair<K, V>;
+
+  size_t capacity_ = 0;
+
+  // The entries, from the most to the least recently used.
+  std::list<Entry> entries_;
+  using Position = typename std::list<Entry>::iterator;
+  std::unordered_map<K, Position, UnorderedMapArgs...> positions_;
+};
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_UTIL_LRU_CACHE_H_
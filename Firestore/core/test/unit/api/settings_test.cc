@@ -149,6 +149,24 @@ TEST(Settings, EqualityAndHash) {
     EXPECT_NE(settings1, settings2);
     EXPECT_NE(settings1.Hash(), settings2.Hash());
   }
+  {
+    Settings settings1;
+    settings1.set_write_coalescing_window_ms(10);
+
+    Settings settings2;
+    settings2.set_write_coalescing_window_ms(10);
+
+    EXPECT_EQ(settings1, settings2);
+    EXPECT_EQ(settings1.Hash(), settings2.Hash());
+
+    Settings copy(settings1);
+    EXPECT_EQ(copy.write_coalescing_window_ms(), 10);
+
+    settings2.set_write_coalescing_window_ms(20);
+
+    EXPECT_NE(settings1, settings2);
+    EXPECT_NE(settings1.Hash(), settings2.Hash());
+  }
   {
     Settings settings1;
     settings1.set_host("host");
@@ -184,6 +202,35 @@ TEST(Settings, EqualityAndHash) {
     EXPECT_NE(settings1, settings2);
     EXPECT_NE(settings1.Hash(), settings2.Hash());
   }
+  {
+    PersistentCacheSettings cache_settings =
+        PersistentCacheSettings{}
+            .WithBlockCacheSizeBytes(32 * 1024 * 1024)
+            .WithBloomFilterBitsPerKey(10)
+            .WithWriteBufferSizeBytes(8 * 1024 * 1024)
+            .WithCompressionEnabled(false);
+
+    Settings settings1;
+    settings1.set_local_cache_settings(cache_settings);
+
+    Settings settings2;
+    settings2.set_local_cache_settings(cache_settings);
+
+    EXPECT_EQ(settings1, settings2);
+    EXPECT_EQ(settings1.Hash(), settings2.Hash());
+
+    settings2.set_local_cache_settings(
+        cache_settings.WithBloomFilterBitsPerKey(0));
+
+    EXPECT_NE(settings1, settings2);
+    EXPECT_NE(settings1.Hash(), settings2.Hash());
+
+    settings2.set_local_cache_settings(
+        cache_settings.WithCompressionEnabled(true));
+
+    EXPECT_NE(settings1, settings2);
+    EXPECT_NE(settings1.Hash(), settings2.Hash());
+  }
 }
 
 }  // namespace
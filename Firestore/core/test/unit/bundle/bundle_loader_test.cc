@@ -63,6 +63,22 @@ class BundleLoaderTest : public ::testing::Test {
       return DocumentMap{};
     }
 
+    model::DocumentMap ApplyBundledDocumentChunk(
+        const model::MutableDocumentMap& documents) override {
+      DocumentKeySet chunk;
+      for (const auto& entry : documents) {
+        chunk = chunk.insert(entry.first);
+      }
+      parent_.last_chunks_.push_back(chunk);
+      return DocumentMap{};
+    }
+
+    void SaveBundledDocumentKeys(const model::DocumentKeySet& keys,
+                                 const std::string& bundle_id) override {
+      (void)bundle_id;
+      parent_.last_documents_ = keys;
+    }
+
     void SaveNamedQuery(const NamedQuery& query,
                         const model::DocumentKeySet& keys) override {
       parent_.last_queries_.insert({query.query_name(), keys});
@@ -102,6 +118,7 @@ class BundleLoaderTest : public ::testing::Test {
  protected:
   std::unique_ptr<BundleCallback> callback_ = nullptr;
   DocumentKeySet last_documents_;
+  std::vector<DocumentKeySet> last_chunks_;
   std::unordered_map<std::string, DocumentKeySet> last_queries_;
   std::unordered_map<std::string, BundleMetadata> last_bundles_;
   model::SnapshotVersion create_time_ =
@@ -250,6 +267,97 @@ TEST_F(BundleLoaderTest, VerifiesDocumentCount) {
   EXPECT_NOT_OK(loader.ApplyChanges());
 }
 
+TEST_F(BundleLoaderTest, AppliesDocumentsInChunks) {
+  BundleLoader loader(callback_.get(), CreateMetadata(3),
+                      /*chunk_byte_size=*/4);
+
+  EXPECT_OK(loader.AddElement(
+      absl::make_unique<BundledDocumentMetadata>(
+          testutil::Key("coll/doc1"), create_time_,
+          /*exists=*/true, std::vector<std::string>{"query-1"}),
+      /*byte_size=*/1));
+  // The chunk is big enough, but still misses the document of its metadata.
+  EXPECT_OK(loader.AddElement(
+      absl::make_unique<NamedQuery>(
+          "query-1",
+          BundledQuery(testutil::Query("foo").ToTarget(), LimitType::First),
+          create_time_),
+      /*byte_size=*/3));
+  EXPECT_TRUE(last_chunks_.empty());
+
+  BundleLoader::AddElementResult result = loader.AddElement(
+      absl::make_unique<BundleDocument>(testutil::Doc("coll/doc1", 1)),
+      /*byte_size=*/1);
+  EXPECT_OK(result);
+  AssertProgress(result.ValueOrDie(), /*documents_loaded=*/1,
+                 /*total_documents=*/3, /*bytes_loaded*/ 5, /*total_bytes*/ 10,
+                 LoadBundleTaskState::kInProgress);
+  ASSERT_EQ(last_chunks_.size(), 1u);
+  EXPECT_EQ(last_chunks_[0], DocumentKeySet{testutil::Key("coll/doc1")});
+
+  // Progress is still reported for documents that do not complete a chunk.
+  result = loader.AddElement(absl::make_unique<BundledDocumentMetadata>(
+                                 testutil::Key("coll/doc2"), create_time_,
+                                 /*exists=*/false, std::vector<std::string>{}),
+                             /*byte_size=*/1);
+  EXPECT_OK(result);
+  AssertProgress(result.ValueOrDie(), /*documents_loaded=*/2,
+                 /*total_documents=*/3, /*bytes_loaded*/ 6, /*total_bytes*/ 10,
+                 LoadBundleTaskState::kInProgress);
+  EXPECT_EQ(last_chunks_.size(), 1u);
+
+  EXPECT_OK(loader.AddElement(
+      absl::make_unique<BundledDocumentMetadata>(
+          testutil::Key("coll/doc3"), create_time_,
+          /*exists=*/true, std::vector<std::string>{"query-1"}),
+      /*byte_size=*/1));
+  EXPECT_OK(loader.AddElement(
+      absl::make_unique<BundleDocument>(testutil::Doc("coll/doc3", 1)),
+      /*byte_size=*/1));
+  EXPECT_EQ(last_chunks_.size(), 1u);
+
+  // Nothing but the documents is saved before the bundle is complete.
+  EXPECT_TRUE(last_documents_.empty());
+  EXPECT_TRUE(last_queries_.empty());
+  EXPECT_TRUE(last_bundles_.empty());
+
+  EXPECT_OK(loader.ApplyChanges());
+
+  ASSERT_EQ(last_chunks_.size(), 2u);
+  EXPECT_EQ(last_chunks_[1], (DocumentKeySet{testutil::Key("coll/doc2"),
+                                             testutil::Key("coll/doc3")}));
+  // Only found documents are kept from being garbage collected.
+  EXPECT_EQ(last_documents_, (DocumentKeySet{testutil::Key("coll/doc1"),
+                                             testutil::Key("coll/doc3")}));
+  EXPECT_EQ(last_queries_["query-1"], last_documents_);
+  EXPECT_EQ(last_bundles_["bundle-1"], CreateMetadata(3));
+}
+
+TEST_F(BundleLoaderTest, VerifiesDocumentCountWhenLoadingInChunks) {
+  BundleLoader loader(callback_.get(), CreateMetadata(2),
+                      /*chunk_byte_size=*/1);
+
+  EXPECT_OK(loader.AddElement(
+      absl::make_unique<BundledDocumentMetadata>(
+          testutil::Key("coll/doc1"), create_time_,
+          /*exists=*/true, std::vector<std::string>{"query-1"}),
+      /*byte_size=*/1));
+  EXPECT_OK(loader.AddElement(
+      absl::make_unique<BundleDocument>(testutil::Doc("coll/doc1", 1)),
+      /*byte_size=*/10));
+  EXPECT_EQ(last_chunks_.size(), 1u);
+  // BundleMetadata says there are 2 documents, but only 1 is found.
+  EXPECT_NOT_OK(loader.ApplyChanges());
+  EXPECT_TRUE(last_documents_.empty());
+
+  // The applied chunk stays, and is kept from being garbage collected, but
+  // the bundle is not recorded as loaded.
+  loader.SaveAppliedDocumentKeys();
+  EXPECT_EQ(last_documents_, DocumentKeySet{testutil::Key("coll/doc1")});
+  EXPECT_TRUE(last_queries_.empty());
+  EXPECT_TRUE(last_bundles_.empty());
+}
+
 }  //  namespace
 }  //  namespace bundle
 }  //  namespace firestore
@@ -0,0 +1,178 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/bundle/binary_bundle_converter.h"
+#include "Firestore/core/src/bundle/binary_bundle_serializer.h"
+#include "Firestore/core/src/bundle/bundle_document_decoder.h"
+#include "Firestore/core/src/bundle/bundle_reader.h"
+#include "Firestore/core/src/bundle/bundle_serializer.h"
+#include "Firestore/core/src/model/database_id.h"
+#include "Firestore/core/src/remote/serializer.h"
+#include "Firestore/core/src/util/byte_stream_cpp.h"
+#include "Firestore/core/src/util/hard_assert.h"
+#include "Firestore/core/src/util/json_reader.h"
+#include "Firestore/third_party/nlohmann_json/json.hpp"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace bundle {
+namespace {
+
+using model::DatabaseId;
+using nlohmann::json;
+using util::ByteStreamCpp;
+using util::JsonReader;
+
+remote::Serializer RpcSerializer() {
+  return remote::Serializer(DatabaseId("p", "default"));
+}
+
+/** Returns a document element of about 1 KB, with values of most types. */
+std::string DocumentElement(int i) {
+  return absl::StrCat(
+      R"({"document":{"name":"projects/p/databases/default/documents/coll/)",
+      "doc", i, R"(","createTime":{"seconds":"1","nanos":2},)",
+      R"("updateTime":{"seconds":"1","nanos":2},"fields":{)",
+      R"("text":{"stringValue":")", std::string(400, 'a' + i % 26), R"("},)",
+      R"("count":{"integerValue":")", i, R"("},)",
+      R"("score":{"doubleValue":)", i * 0.5, "},",
+      R"("tags":{"arrayValue":{"values":[)",
+      R"({"stringValue":"red"},{"stringValue":"green"},)",
+      R"({"stringValue":"blue"},{"integerValue":"7"}]}},)",
+      R"("nested":{"mapValue":{"fields":{)",
+      R"("at":{"timestampValue":"2024-01-01T00:00:00.123456Z"},)",
+      R"("flag":{"booleanValue":true},"none":{"nullValue":null},)",
+      R"("where":{"geoPointValue":{"latitude":1.5,"longitude":-2.5}},)",
+      R"("ref":{"referenceValue":)",
+      R"("projects/p/databases/default/documents/coll/other"}}}}}}})");
+}
+
+/** Returns the document elements of a bundle of about `megabytes` MB. */
+std::vector<std::string> DocumentElements(int64_t megabytes) {
+  std::vector<std::string> result;
+  size_t size = 0;
+  for (int i = 0; size < static_cast<size_t>(megabytes) << 20; ++i) {
+    result.push_back(DocumentElement(i));
+    size += result.back().size();
+  }
+  return result;
+}
+
+/** Returns a length-prefixed bundle holding `elements`. */
+std::string Bundle(const std::vector<std::string>& elements) {
+  std::string metadata = absl::StrCat(
+      R"({"metadata":{"id":"bundle","createTime":{"seconds":1,"nanos":0},)",
+      R"("version":1,"totalDocuments":)", elements.size(), "}}");
+  std::string result = absl::StrCat(metadata.size(), metadata);
+  for (const std::string& element : elements) {
+    absl::StrAppend(&result, element.size(), element);
+  }
+  return result;
+}
+
+std::unique_ptr<ByteStreamCpp> ToByteStream(const std::string& bundle) {
+  return absl::make_unique<ByteStreamCpp>(
+      absl::make_unique<std::stringstream>(bundle));
+}
+
+void ReadAll(const std::string& bundle) {
+  BundleReader reader(BundleSerializer(RpcSerializer()), ToByteStream(bundle));
+  while (reader.GetNextElement()) {
+  }
+  HARD_ASSERT(reader.reader_status().ok());
+}
+
+void BM_ReadBundle(benchmark::State& state) {
+  std::string bundle = Bundle(DocumentElements(state.range(0)));
+  for (auto _ : state) {
+    ReadAll(bundle);
+  }
+  state.SetBytesProcessed(state.iterations() * bundle.size());
+}
+BENCHMARK(BM_ReadBundle)->Arg(100)->Unit(benchmark::kMillisecond);
+
+/**
+ * Reads the same bundle as `BM_ReadBundle`, converted to the binary format.
+ * The bytes processed are the ones of the JSON bundle, so that throughputs can
+ * be compared.
+ */
+void BM_ReadBinaryBundle(benchmark::State& state) {
+  std::string bundle = Bundle(DocumentElements(state.range(0)));
+  BundleReader json_reader(BundleSerializer(RpcSerializer()),
+                           ToByteStream(bundle));
+  BinaryBundleSerializer serializer(RpcSerializer());
+  std::string binary_bundle =
+      ConvertToBinaryBundle(json_reader, serializer).ValueOrDie();
+  for (auto _ : state) {
+    ReadAll(binary_bundle);
+  }
+  state.SetBytesProcessed(state.iterations() * bundle.size());
+  state.counters["binary_size_ratio"] =
+      static_cast<double>(binary_bundle.size()) / bundle.size();
+}
+BENCHMARK(BM_ReadBinaryBundle)->Arg(100)->Unit(benchmark::kMillisecond);
+
+/** Decodes document elements straight from their JSON text. */
+void BM_DecodeDocumentsFromText(benchmark::State& state) {
+  std::vector<std::string> elements = DocumentElements(state.range(0));
+  BundleDocumentDecoder decoder(RpcSerializer());
+  size_t size = 0;
+  for (auto _ : state) {
+    size = 0;
+    JsonReader reader;
+    for (const std::string& element : elements) {
+      benchmark::DoNotOptimize(decoder.DecodeElement(reader, element));
+      size += element.size();
+    }
+    HARD_ASSERT(reader.ok());
+  }
+  state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_DecodeDocumentsFromText)->Arg(100)->Unit(benchmark::kMillisecond);
+
+/** Decodes document elements from a parsed `nlohmann::json` DOM. */
+void BM_DecodeDocumentsFromDom(benchmark::State& state) {
+  std::vector<std::string> elements = DocumentElements(state.range(0));
+  BundleSerializer serializer(RpcSerializer());
+  size_t size = 0;
+  for (auto _ : state) {
+    size = 0;
+    JsonReader reader;
+    for (const std::string& element : elements) {
+      json parsed = json::parse(element, /*callback=*/nullptr,
+                                /*allow_exceptions=*/false);
+      benchmark::DoNotOptimize(
+          serializer.DecodeDocument(reader, parsed.at("document")));
+      size += element.size();
+    }
+    HARD_ASSERT(reader.ok());
+  }
+  state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_DecodeDocumentsFromDom)->Arg(100)->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace bundle
+}  // namespace firestore
+}  // namespace firebase
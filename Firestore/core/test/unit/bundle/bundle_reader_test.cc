@@ -25,6 +25,8 @@
 #include "Firestore/Protos/cpp/firestore/bundle.pb.h"
 #include "Firestore/Protos/cpp/firestore/local/maybe_document.pb.h"
 #include "Firestore/Protos/cpp/google/firestore/v1/document.pb.h"
+#include "Firestore/core/src/bundle/binary_bundle_converter.h"
+#include "Firestore/core/src/bundle/binary_bundle_serializer.h"
 #include "Firestore/core/src/bundle/named_query.h"
 #include "Firestore/core/src/core/field_filter.h"
 #include "Firestore/core/src/local/local_serializer.h"
@@ -83,6 +85,7 @@ class BundleReaderTest : public ::testing::Test {
     *element.mutable_named_query() = data;
     MessageToJsonString(element, &json);
     elements_.push_back(json);
+    binary_elements_.push_back(element.SerializeAsString());
     return json;
   }
 
@@ -92,6 +95,7 @@ class BundleReaderTest : public ::testing::Test {
     *element.mutable_document_metadata() = data;
     MessageToJsonString(element, &json);
     elements_.push_back(json);
+    binary_elements_.push_back(element.SerializeAsString());
     return json;
   }
 
@@ -101,6 +105,7 @@ class BundleReaderTest : public ::testing::Test {
     *element.mutable_document() = data;
     MessageToJsonString(element, &json);
     elements_.push_back(json);
+    binary_elements_.push_back(element.SerializeAsString());
     return json;
   }
 
@@ -132,6 +137,42 @@ class BundleReaderTest : public ::testing::Test {
     return std::to_string(metadata_str.size()) + metadata_str + bundle;
   }
 
+  static std::string Varint(uint64_t value) {
+    std::string result;
+    while (value >= 0x80) {
+      result.push_back(static_cast<char>((value & 0x7f) | 0x80));
+      value >>= 7;
+    }
+    result.push_back(static_cast<char>(value));
+    return result;
+  }
+
+  /** Builds a bundle of the added elements in the binary format. */
+  std::string BuildBinaryBundle(const std::string& bundle_id,
+                                model::SnapshotVersion create_time,
+                                int32_t documents) {
+    std::string bundle;
+    for (const auto& element : binary_elements_) {
+      bundle.append(Varint(element.size()));
+      bundle.append(element);
+    }
+
+    ProtoBundleElement element;
+    ProtoBundleMetadata* metadata = element.mutable_metadata();
+    metadata->set_id(bundle_id);
+    metadata->set_version(1);
+    metadata->set_total_documents(documents);
+    metadata->mutable_create_time()->set_nanos(
+        create_time.timestamp().nanoseconds());
+    metadata->mutable_create_time()->set_seconds(
+        create_time.timestamp().seconds());
+    metadata->set_total_bytes(bundle.size());
+    std::string metadata_str = element.SerializeAsString();
+
+    return std::string(kBinaryBundleHeader, kBinaryBundleHeaderSize) +
+           Varint(metadata_str.size()) + metadata_str + bundle;
+  }
+
   std::unique_ptr<util::ByteStream> ToByteStream(const std::string& bundle) {
     auto bundle_istream = absl::make_unique<std::stringstream>(bundle);
     return absl::make_unique<ByteStreamCpp>(
@@ -328,6 +369,7 @@ class BundleReaderTest : public ::testing::Test {
   remote::Serializer remote_serializer;
   local::LocalSerializer local_serializer;
   bundle::BundleSerializer bundle_serializer;
+  bundle::BinaryBundleSerializer binary_serializer{remote_serializer};
 
  protected:
   MessageDifferencer msg_diff_;
@@ -335,6 +377,7 @@ class BundleReaderTest : public ::testing::Test {
 
  private:
   std::vector<std::string> elements_;
+  std::vector<std::string> binary_elements_;
 };
 
 TEST_F(BundleReaderTest, ReadsEmptyBundle) {
@@ -578,6 +621,120 @@ TEST_F(BundleReaderTest, FailsWhenBundleIsSomehowCorrupted) {
   }
 }
 
+TEST_F(BundleReaderTest, ReadsBinaryBundle) {
+  AddDocumentMetadata(DocumentMetadata1());
+  AddDocument(Document1());
+  AddNamedQuery(LimitQuery());
+  AddNamedQuery(LimitToLastQuery());
+  AddDocumentMetadata(DeletedDocumentMetadata());
+  AddDocumentMetadata(DocumentMetadata2());
+  AddDocument(LargeDocument2());
+
+  const auto& bundle =
+      BuildBinaryBundle("bundle-1", testutil::Version(6000004000), 3);
+  BundleReader reader(bundle_serializer, ToByteStream(bundle));
+
+  std::vector<std::unique_ptr<BundleElement>> elements =
+      VerifyFullBundleParsed(reader, "bundle-1", testutil::Version(6000004000));
+
+  ASSERT_EQ(elements.size(), 7);
+  VerifyDocumentMetadataEquals(
+      *static_cast<BundledDocumentMetadata*>(elements[0].get()),
+      DocumentMetadata1());
+  VerifyDocumentEncodesToOriginal(
+      *static_cast<BundleDocument*>(elements[1].get()), Document1());
+  VerifyNamedQueryEncodesToOriginal(
+      *static_cast<NamedQuery*>(elements[2].get()), LimitQuery());
+  VerifyNamedQueryEncodesToOriginal(
+      *static_cast<NamedQuery*>(elements[3].get()), LimitToLastQuery());
+  VerifyDocumentMetadataEquals(
+      *static_cast<BundledDocumentMetadata*>(elements[4].get()),
+      DeletedDocumentMetadata());
+  VerifyDocumentMetadataEquals(
+      *static_cast<BundledDocumentMetadata*>(elements[5].get()),
+      DocumentMetadata2());
+  VerifyDocumentEncodesToOriginal(
+      *static_cast<BundleDocument*>(elements[6].get()), LargeDocument2());
+}
+
+TEST_F(BundleReaderTest, ReadsEmptyBinaryBundle) {
+  const auto& bundle =
+      BuildBinaryBundle("bundle-1", testutil::Version(6000004000), 0);
+  BundleReader reader(bundle_serializer, ToByteStream(bundle));
+
+  std::vector<std::unique_ptr<BundleElement>> elements =
+      VerifyFullBundleParsed(reader, "bundle-1", testutil::Version(6000004000));
+  EXPECT_EQ(elements.size(), 0);
+}
+
+TEST_F(BundleReaderTest, ConvertsJsonBundleToBinary) {
+  AddNamedQuery(LimitQuery());
+  AddDocumentMetadata(DocumentMetadata1());
+  AddDocument(Document1());
+  AddDocumentMetadata(DeletedDocumentMetadata());
+
+  const auto& bundle =
+      BuildBundle("bundle-1", testutil::Version(6000004000), 2);
+  BundleReader json_reader(bundle_serializer, ToByteStream(bundle));
+  auto converted = ConvertToBinaryBundle(json_reader, binary_serializer);
+  ASSERT_OK(converted.status());
+
+  BundleReader reader(bundle_serializer,
+                      ToByteStream(converted.ValueOrDie()));
+  std::vector<std::unique_ptr<BundleElement>> elements =
+      VerifyFullBundleParsed(reader, "bundle-1", testutil::Version(6000004000));
+
+  ASSERT_EQ(elements.size(), 4);
+  VerifyNamedQueryEncodesToOriginal(
+      *static_cast<NamedQuery*>(elements[0].get()), LimitQuery());
+  VerifyDocumentMetadataEquals(
+      *static_cast<BundledDocumentMetadata*>(elements[1].get()),
+      DocumentMetadata1());
+  VerifyDocumentEncodesToOriginal(
+      *static_cast<BundleDocument*>(elements[2].get()), Document1());
+  VerifyDocumentMetadataEquals(
+      *static_cast<BundledDocumentMetadata*>(elements[3].get()),
+      DeletedDocumentMetadata());
+}
+
+TEST_F(BundleReaderTest, ConvertingFailsWithInvalidBundle) {
+  const auto& bundle =
+      BuildBundle("bundle-1", testutil::Version(6000004000), 0);
+  BundleReader reader(bundle_serializer, ToByteStream(bundle + "foo"));
+
+  EXPECT_NOT_OK(ConvertToBinaryBundle(reader, binary_serializer).status());
+}
+
+TEST_F(BundleReaderTest, FailsWithBadBinaryHeader) {
+  std::string bundle =
+      BuildBinaryBundle("bundle-1", testutil::Version(6000004000), 0);
+  bundle[kBinaryBundleHeaderSize - 1] = '0';
+  BundleReader reader(bundle_serializer, ToByteStream(bundle));
+
+  EXPECT_EQ(reader.GetBundleMetadata(), BundleMetadata());
+  EXPECT_EQ(reader.GetNextElement(), nullptr);
+  EXPECT_NOT_OK(reader.reader_status());
+}
+
+TEST_F(BundleReaderTest, FailsWhenBinaryBundleIsTruncated) {
+  AddDocumentMetadata(DocumentMetadata1());
+  AddDocument(Document1());
+
+  const auto& bundle =
+      BuildBinaryBundle("bundle-1", testutil::Version(6000004000), 1);
+
+  for (size_t size = 1; size < bundle.size(); ++size) {
+    BundleReader reader(bundle_serializer,
+                        ToByteStream(bundle.substr(0, size)));
+    while (reader.GetNextElement() != nullptr) {
+    }
+    // A bundle can be cut between two elements, but then fewer bytes than
+    // the metadata promises are read.
+    EXPECT_TRUE(!reader.reader_status().ok() ||
+                reader.bytes_read() < reader.GetBundleMetadata().total_bytes());
+  }
+}
+
 }  //  namespace
 }  //  namespace bundle
 }  //  namespace firestore
@@ -16,6 +16,7 @@
 
 #include "Firestore/core/src/bundle/bundle_serializer.h"
 
+#include "Firestore/core/src/bundle/bundle_document_decoder.h"
 #include "Firestore/Protos/cpp/firestore/bundle.pb.h"
 #include "Firestore/Protos/cpp/firestore/local/maybe_document.pb.h"
 #include "Firestore/Protos/cpp/google/firestore/v1/document.pb.h"
@@ -65,6 +66,7 @@ using testutil::Filter;
 using testutil::Map;
 using testutil::OrderBy;
 using testutil::Value;
+using testutil::WrapObject;
 using util::JsonReader;
 
 json Parse(const std::string& s) {
@@ -81,13 +83,15 @@ class BundleSerializerTest : public ::testing::Test {
   BundleSerializerTest()
       : remote_serializer(DatabaseId("p", "default")),
         local_serializer(remote_serializer),
-        bundle_serializer(remote_serializer) {
+        bundle_serializer(remote_serializer),
+        document_decoder(remote_serializer) {
     msg_diff_.ReportDifferencesToString(&message_differences);
   }
 
   remote::Serializer remote_serializer;
   local::LocalSerializer local_serializer;
   bundle::BundleSerializer bundle_serializer;
+  bundle::BundleDocumentDecoder document_decoder;
 
   static std::string FullPath(const std::string& path) {
     return "projects/p/databases/default/documents/" + path;
@@ -146,6 +150,13 @@ class BundleSerializerTest : public ::testing::Test {
     BundleDocument actual =
         bundle_serializer.DecodeDocument(reader, Parse(json_string));
     EXPECT_OK(reader.status());
+
+    // Decoding straight from the JSON text yields the same document.
+    JsonReader streaming_reader;
+    BundleDocument streamed =
+        document_decoder.DecodeDocument(streaming_reader, json_string);
+    EXPECT_OK(streaming_reader.status());
+    EXPECT_EQ(streamed.document(), actual.document());
     return actual;
   }
 
@@ -154,6 +165,10 @@ class BundleSerializerTest : public ::testing::Test {
     BundleDocument actual =
         bundle_serializer.DecodeDocument(reader, Parse(json_string));
     EXPECT_NOT_OK(reader.status());
+
+    JsonReader streaming_reader;
+    document_decoder.DecodeDocument(streaming_reader, json_string);
+    EXPECT_NOT_OK(streaming_reader.status());
   }
 
   // 1. Take a `Query` object, put it in a `NamedQuery` and encode it to byte
@@ -563,6 +578,34 @@ TEST_F(BundleSerializerTest, DecodesInvalidTimestampValueFails) {
   VerifyJsonStringDecodeFails(json_copy);
 }
 
+TEST_F(BundleSerializerTest, DecodesOutOfRangeNumericTimestampFails) {
+  google::protobuf::Timestamp t1;
+  t1.set_seconds(0);
+  t1.set_nanos(0);
+  ProtoValue value;
+  *value.mutable_timestamp_value() = t1;
+  ProtoDocument document = TestDocument(value);
+
+  std::string json_string;
+  MessageToJsonString(document, &json_string);
+
+  auto json_copy = ReplacedCopy(json_string, "\"1970-01-01T00:00:00Z\"",
+                                R"({"seconds": 0, "nanos": 1000000000})");
+  VerifyJsonStringDecodeFails(json_copy);
+
+  // Nanos that don't fit in 32 bits, and seconds that don't fit in 64 bits,
+  // fail instead of wrapping around to a valid timestamp.
+  for (const char* timestamp :
+       {R"({"seconds": 0, "nanos": 4294967296})",
+        R"({"seconds": 18446744073709551615, "nanos": 0})"}) {
+    json_copy =
+        ReplacedCopy(json_string, "\"1970-01-01T00:00:00Z\"", timestamp);
+    JsonReader reader;
+    document_decoder.DecodeDocument(reader, json_copy);
+    EXPECT_NOT_OK(reader.status()) << timestamp;
+  }
+}
+
 TEST_F(BundleSerializerTest, DecodesGeoPointValues) {
   google::type::LatLng g1;
   g1.set_latitude(1.23);
@@ -674,6 +717,91 @@ TEST_F(BundleSerializerTest, DecodesNestedObjectValues) {
   VerifyFieldValueRoundtrip(value);
 }
 
+// MARK: Tests for decoding documents straight from JSON text
+
+TEST_F(BundleSerializerTest, DecodesDocumentElements) {
+  ProtoValue value;
+  value.set_string_value("foo");
+  std::string json_string;
+  MessageToJsonString(TestDocument(value), &json_string);
+
+  JsonReader reader;
+  absl::optional<BundleDocument> actual = document_decoder.DecodeElement(
+      reader, R"({"document":)" + json_string + "}");
+  EXPECT_OK(reader.status());
+  ASSERT_TRUE(actual.has_value());
+  EXPECT_EQ(actual->document(),
+            bundle_serializer.DecodeDocument(reader, Parse(json_string))
+                .document());
+}
+
+TEST_F(BundleSerializerTest, LeavesOtherElementsToBundleSerializer) {
+  std::string json_string;
+  MessageToJsonString(TestBundleMetadata(), &json_string);
+
+  JsonReader reader;
+  EXPECT_FALSE(document_decoder
+                   .DecodeElement(reader, R"({"metadata":)" + json_string + "}")
+                   .has_value());
+  EXPECT_FALSE(document_decoder.DecodeElement(reader, "{}").has_value());
+  EXPECT_OK(reader.status());
+}
+
+TEST_F(BundleSerializerTest, DecodesDuplicateAndUnsortedFieldsLikeDom) {
+  VerifyJsonStringDecodes(R"({
+    "name": ")" + FullPath("bundle/test_doc") +
+                          R"(",
+    "updateTime": {"seconds": "1", "nanos": 2},
+    "ignored": [{"stringValue": "x"}],
+    "fields": {
+      "b": {"integerValue": "1"},
+      "a": {"mapValue": {"fields": {"z": {"nullValue": null},
+                                    "y": {"arrayValue": {}}}}},
+      "b": {"stringValue": "last"}
+    }
+  })");
+}
+
+TEST_F(BundleSerializerTest, DecodesDocumentsWithoutFields) {
+  BundleDocument actual = VerifyJsonStringDecodes(
+      R"({"name": ")" + FullPath("bundle/test_doc") +
+      R"(", "updateTime": "1970-01-01T00:00:01Z"})");
+  EXPECT_EQ(actual.document().data(), model::ObjectValue{});
+}
+
+TEST_F(BundleSerializerTest, DecodeTruncatedDocumentFails) {
+  ProtoValue value;
+  value.set_string_value("foo");
+  std::string json_string;
+  MessageToJsonString(TestDocument(value), &json_string);
+
+  for (size_t size : {size_t{0}, json_string.size() / 2,
+                      json_string.size() - 1}) {
+    JsonReader reader;
+    document_decoder.DecodeDocument(reader, json_string.substr(0, size));
+    EXPECT_NOT_OK(reader.status());
+  }
+}
+
+TEST_F(BundleSerializerTest, DecodesValuesWithSeveralTypesLikeDom) {
+  std::string json_string = R"({"name": ")" + FullPath("bundle/test_doc") +
+                            R"(", "updateTime": "1970-01-01T00:00:01Z",
+      "fields": {
+        "a": {"stringValue": "a", "integerValue": "1"},
+        "b": {"mapValue": {"fields": {"c": {"nullValue": null}}},
+              "nullValue": null}
+      }})";
+  BundleDocument actual = VerifyJsonStringDecodes(json_string);
+  EXPECT_EQ(actual.document().data(), WrapObject("a", 1, "b", nullptr));
+
+  // Elements holding such documents are left to `BundleSerializer`.
+  JsonReader reader;
+  EXPECT_FALSE(document_decoder
+                   .DecodeElement(reader, R"({"document":)" + json_string + "}")
+                   .has_value());
+  EXPECT_OK(reader.status());
+}
+
 // MARK: Tests for Query decoding
 
 TEST_F(BundleSerializerTest, DecodesCollectionQuery) {
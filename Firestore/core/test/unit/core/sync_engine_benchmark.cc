@@ -0,0 +1,258 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/core/database_info.h"
+#include "Firestore/core/src/core/sync_engine.h"
+#include "Firestore/core/src/core/sync_engine_callback.h"
+#include "Firestore/core/src/core/view_snapshot.h"
+#include "Firestore/core/src/credentials/empty_credentials_provider.h"
+#include "Firestore/core/src/credentials/user.h"
+#include "Firestore/core/src/local/local_store.h"
+#include "Firestore/core/src/local/memory_persistence.h"
+#include "Firestore/core/src/local/query_engine.h"
+#include "Firestore/core/src/model/database_id.h"
+#include "Firestore/core/src/remote/connectivity_monitor.h"
+#include "Firestore/core/src/remote/datastore.h"
+#include "Firestore/core/src/remote/firebase_metadata_provider.h"
+#include "Firestore/core/src/remote/firebase_metadata_provider_noop.h"
+#include "Firestore/core/src/remote/remote_event.h"
+#include "Firestore/core/src/remote/remote_store.h"
+#include "Firestore/core/src/remote/watch_change.h"
+#include "Firestore/core/src/util/async_queue.h"
+#include "Firestore/core/test/unit/remote/create_noop_connectivity_monitor.h"
+#include "Firestore/core/test/unit/remote/fake_target_metadata_provider.h"
+#include "Firestore/core/test/unit/testutil/async_testing.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "absl/memory/memory.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+namespace {
+
+using credentials::EmptyAppCheckCredentialsProvider;
+using credentials::EmptyAuthCredentialsProvider;
+using credentials::User;
+using local::LocalStore;
+using local::MemoryPersistence;
+using local::QueryEngine;
+using model::DatabaseId;
+using model::OnlineState;
+using model::TargetId;
+using remote::ConnectivityMonitor;
+using remote::Datastore;
+using remote::DocumentWatchChange;
+using remote::FakeTargetMetadataProvider;
+using remote::FirebaseMetadataProvider;
+using remote::RemoteEvent;
+using remote::RemoteStore;
+using remote::WatchChangeAggregator;
+using testutil::Doc;
+using testutil::Filter;
+using testutil::Map;
+using testutil::Version;
+using util::AsyncQueue;
+using util::Status;
+
+class NoOpSyncEngineCallback : public SyncEngineCallback {
+ public:
+  void HandleOnlineStateChange(OnlineState) override {
+  }
+  void OnViewSnapshots(std::vector<ViewSnapshot>&& snapshots) override {
+    benchmark::DoNotOptimize(snapshots);
+  }
+  void OnError(const Query&, const Status&) override {
+  }
+};
+
+/**
+ * A SyncEngine backed by in-memory persistence and a RemoteStore that never
+ * connects to the backend. Listeners only listen locally; remote events are
+ * applied directly.
+ */
+class SyncEngineHarness {
+ public:
+  SyncEngineHarness()
+      : worker_queue_(testutil::AsyncQueueForTesting()),
+        persistence_(MemoryPersistence::WithEagerGarbageCollector()),
+        local_store_(
+            persistence_.get(), &query_engine_, User::Unauthenticated()),
+        connectivity_monitor_(remote::CreateNoOpConnectivityMonitor()),
+        firebase_metadata_provider_(
+            remote::CreateFirebaseMetadataProviderNoOp()) {
+    worker_queue_->EnqueueBlocking([&] {
+      local_store_.Start();
+
+      auto datastore = std::make_shared<Datastore>(
+          DatabaseInfo{DatabaseId{"p", "d"}, "", "localhost", false},
+          worker_queue_, std::make_shared<EmptyAuthCredentialsProvider>(),
+          std::make_shared<EmptyAppCheckCredentialsProvider>(),
+          connectivity_monitor_.get(), firebase_metadata_provider_.get());
+      remote_store_ = absl::make_unique<RemoteStore>(
+          &local_store_, std::move(datastore), worker_queue_,
+          connectivity_monitor_.get(), [](OnlineState) {});
+      sync_engine_ = absl::make_unique<SyncEngine>(
+          &local_store_, remote_store_.get(), User::Unauthenticated(),
+          /* max_concurrent_limbo_resolutions= */ 100);
+      sync_engine_->SetCallback(&callback_);
+      remote_store_->set_sync_engine(sync_engine_.get());
+    });
+  }
+
+  ~SyncEngineHarness() {
+    worker_queue_->EnqueueBlocking([&] {
+      sync_engine_.reset();
+      remote_store_->Shutdown();
+      remote_store_.reset();
+    });
+  }
+
+  SyncEngine* sync_engine() {
+    return sync_engine_.get();
+  }
+
+  /**
+   * Adds `count` listeners on distinct queries, spread evenly over
+   * `collections` collections.
+   */
+  void Listen(int count, int collections = 1) {
+    target_ids_.resize(collections);
+    worker_queue_->EnqueueBlocking([&] {
+      for (int i = 0; i < count; ++i) {
+        int collection = i % collections;
+        Query query = testutil::Query(CollectionPath(collection))
+                          .AddingFilter(Filter("rank", ">=", -i));
+        target_ids_[collection].push_back(
+            sync_engine_->Listen(query, /* should_listen_to_remote= */ false));
+      }
+    });
+  }
+
+  /**
+   * Applies a remote event that changes `count` documents in the collection
+   * `collection`, for all of the targets listening to it.
+   */
+  void ApplyRemoteEvent(int count, int collection = 0) {
+    ++version_;
+    const std::string path = CollectionPath(collection);
+    const std::vector<TargetId>& target_ids = target_ids_[collection];
+    auto metadata_provider =
+        FakeTargetMetadataProvider::CreateEmptyResultProvider(
+            model::ResourcePath{path}, target_ids);
+    WatchChangeAggregator aggregator{&metadata_provider};
+    for (int i = 0; i < count; ++i) {
+      model::MutableDocument doc =
+          Doc(path + "/doc" + std::to_string(i), version_,
+              Map("rank", i, "v", version_));
+      aggregator.HandleDocumentChange(
+          DocumentWatchChange{target_ids, {}, doc.key(), doc});
+    }
+    RemoteEvent event = aggregator.CreateRemoteEvent(Version(version_));
+
+    worker_queue_->EnqueueBlocking(
+        [&] { sync_engine_->ApplyRemoteEvent(event); });
+  }
+
+ private:
+  static std::string CollectionPath(int collection) {
+    return "coll" + std::to_string(collection);
+  }
+
+  std::shared_ptr<AsyncQueue> worker_queue_;
+  std::unique_ptr<MemoryPersistence> persistence_;
+  QueryEngine query_engine_;
+  LocalStore local_store_;
+  std::unique_ptr<ConnectivityMonitor> connectivity_monitor_;
+  std::unique_ptr<FirebaseMetadataProvider> firebase_metadata_provider_;
+  std::unique_ptr<RemoteStore> remote_store_;
+  std::unique_ptr<SyncEngine> sync_engine_;
+  NoOpSyncEngineCallback callback_;
+
+  // The targets listening to each collection.
+  std::vector<std::vector<TargetId>> target_ids_;
+  int64_t version_ = 0;
+};
+
+/**
+ * Measures how long it takes to raise the snapshots for a remote event that
+ * changes `range(1)` documents seen by `range(0)` listeners.
+ */
+void BM_ApplyRemoteEvent(benchmark::State& state, bool parallel) {
+  SyncEngineHarness harness;
+  harness.sync_engine()->SetMinViewsForParallelComputation(
+      parallel ? 1 : std::numeric_limits<size_t>::max());
+  harness.Listen(static_cast<int>(state.range(0)));
+
+  int changed_documents = static_cast<int>(state.range(1));
+  for (auto _ : state) {
+    harness.ApplyRemoteEvent(changed_documents);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0) *
+                          state.range(1));
+}
+
+void ListenerAndDocumentCounts(benchmark::internal::Benchmark* benchmark) {
+  for (int listeners : {1, 16, 64, 256}) {
+    for (int documents : {10, 100, 1000}) {
+      benchmark->Args({listeners, documents});
+    }
+  }
+}
+
+BENCHMARK_CAPTURE(BM_ApplyRemoteEvent, serial, false)
+    ->Apply(ListenerAndDocumentCounts)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_ApplyRemoteEvent, parallel, true)
+    ->Apply(ListenerAndDocumentCounts)
+    ->Unit(benchmark::kMillisecond);
+
+/**
+ * Measures how long it takes to raise the snapshots for a remote event that
+ * changes `range(1)` documents in one of 100 collections, while `range(0)`
+ * listeners are spread over all of them. Only the listeners of the changed
+ * collection should contribute to the cost.
+ */
+void BM_ApplyRemoteEventToOneCollection(benchmark::State& state) {
+  const int collections = 100;
+  SyncEngineHarness harness;
+  harness.Listen(static_cast<int>(state.range(0)), collections);
+
+  int changed_documents = static_cast<int>(state.range(1));
+  int collection = 0;
+  for (auto _ : state) {
+    harness.ApplyRemoteEvent(changed_documents, collection);
+    collection = (collection + 1) % collections;
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+
+BENCHMARK(BM_ApplyRemoteEventToOneCollection)
+    ->Args({100, 10})
+    ->Args({100, 100})
+    ->Args({1000, 10})
+    ->Args({1000, 100})
+    ->Unit(benchmark::kMicrosecond);
+
+}  // namespace
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
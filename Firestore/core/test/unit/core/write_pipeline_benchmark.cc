@@ -0,0 +1,206 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/core/database_info.h"
+#include "Firestore/core/src/core/sync_engine.h"
+#include "Firestore/core/src/core/sync_engine_callback.h"
+#include "Firestore/core/src/core/view_snapshot.h"
+#include "Firestore/core/src/credentials/empty_credentials_provider.h"
+#include "Firestore/core/src/credentials/user.h"
+#include "Firestore/core/src/local/leveldb_persistence.h"
+#include "Firestore/core/src/local/local_store.h"
+#include "Firestore/core/src/local/query_engine.h"
+#include "Firestore/core/src/model/database_id.h"
+#include "Firestore/core/src/model/set_mutation.h"
+#include "Firestore/core/src/remote/connectivity_monitor.h"
+#include "Firestore/core/src/remote/firebase_metadata_provider.h"
+#include "Firestore/core/src/remote/firebase_metadata_provider_noop.h"
+#include "Firestore/core/src/remote/remote_store.h"
+#include "Firestore/core/src/util/async_queue.h"
+#include "Firestore/core/test/unit/local/persistence_testing.h"
+#include "Firestore/core/test/unit/remote/create_noop_connectivity_monitor.h"
+#include "Firestore/core/test/unit/remote/fake_write_stream.h"
+#include "Firestore/core/test/unit/testutil/async_testing.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "absl/memory/memory.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+namespace {
+
+using credentials::EmptyAppCheckCredentialsProvider;
+using credentials::EmptyAuthCredentialsProvider;
+using credentials::User;
+using local::LevelDbPersistence;
+using local::LocalStore;
+using local::QueryEngine;
+using model::DatabaseId;
+using model::Mutation;
+using model::OnlineState;
+using remote::ConnectivityMonitor;
+using remote::FakeWriteStream;
+using remote::FakeWriteStreamDatastore;
+using remote::FirebaseMetadataProvider;
+using remote::RemoteStore;
+using testutil::Map;
+using testutil::Version;
+using util::AsyncQueue;
+using util::Status;
+using util::StatusCallback;
+
+class NoOpSyncEngineCallback : public SyncEngineCallback {
+ public:
+  void HandleOnlineStateChange(OnlineState) override {
+  }
+  void OnViewSnapshots(std::vector<ViewSnapshot>&&) override {
+  }
+  void OnError(const Query&, const Status&) override {
+  }
+};
+
+/**
+ * A SyncEngine backed by LevelDB persistence whose RemoteStore sends writes to
+ * a local fake write stream, which acknowledges them on demand.
+ */
+class WritePipelineHarness {
+ public:
+  explicit WritePipelineHarness(bool coalesce)
+      : coalesce_(coalesce),
+        worker_queue_(testutil::AsyncQueueForTesting()),
+        persistence_(local::LevelDbPersistenceForTesting()),
+        local_store_(
+            persistence_.get(), &query_engine_, User::Unauthenticated()),
+        connectivity_monitor_(remote::CreateNoOpConnectivityMonitor()),
+        firebase_metadata_provider_(
+            remote::CreateFirebaseMetadataProviderNoOp()) {
+    worker_queue_->EnqueueBlocking([&] {
+      local_store_.Start();
+
+      datastore_ = std::make_shared<FakeWriteStreamDatastore>(
+          DatabaseInfo{DatabaseId{"p", "d"}, "", "localhost", false},
+          worker_queue_, std::make_shared<EmptyAuthCredentialsProvider>(),
+          std::make_shared<EmptyAppCheckCredentialsProvider>(),
+          connectivity_monitor_.get(), firebase_metadata_provider_.get());
+      remote_store_ = absl::make_unique<RemoteStore>(
+          &local_store_, datastore_, worker_queue_,
+          connectivity_monitor_.get(), [](OnlineState) {});
+      remote_store_->set_write_coalescing_enabled(coalesce_);
+      sync_engine_ = absl::make_unique<SyncEngine>(
+          &local_store_, remote_store_.get(), User::Unauthenticated(),
+          /* max_concurrent_limbo_resolutions= */ 100);
+      sync_engine_->SetCallback(&callback_);
+      remote_store_->set_sync_engine(sync_engine_.get());
+      remote_store_->Start();
+    });
+  }
+
+  ~WritePipelineHarness() {
+    worker_queue_->EnqueueBlocking([&] {
+      sync_engine_.reset();
+      remote_store_->Shutdown();
+      remote_store_.reset();
+    });
+  }
+
+  /**
+   * Writes `count` single-document batches and lets the fake backend
+   * acknowledge every request the RemoteStore sends until all of them have
+   * been acknowledged.
+   */
+  void WriteAndAcknowledge(int count) {
+    worker_queue_->EnqueueBlocking([&] {
+      std::vector<std::vector<Mutation>> batches;
+      std::vector<StatusCallback> callbacks;
+      for (int i = 0; i < count; ++i) {
+        batches.push_back({testutil::SetMutation(
+            "coll/doc" + std::to_string(i), Map("v", version_))});
+        callbacks.push_back([](Status) {});
+      }
+
+      if (coalesce_) {
+        sync_engine_->WriteMutations(std::move(batches), std::move(callbacks));
+      } else {
+        for (size_t i = 0; i < batches.size(); ++i) {
+          sync_engine_->WriteMutations(std::move(batches[i]),
+                                       std::move(callbacks[i]));
+        }
+      }
+
+      FakeWriteStream& stream = *datastore_->write_stream();
+      while (stream.pending_requests() > 0) {
+        stream.AckNextRequest(Version(++version_));
+      }
+    });
+  }
+
+  size_t requests_sent() {
+    return datastore_->write_stream()->requests().size();
+  }
+
+ private:
+  bool coalesce_ = false;
+  std::shared_ptr<AsyncQueue> worker_queue_;
+  std::unique_ptr<LevelDbPersistence> persistence_;
+  QueryEngine query_engine_;
+  LocalStore local_store_;
+  std::unique_ptr<ConnectivityMonitor> connectivity_monitor_;
+  std::unique_ptr<FirebaseMetadataProvider> firebase_metadata_provider_;
+  std::shared_ptr<FakeWriteStreamDatastore> datastore_;
+  std::unique_ptr<RemoteStore> remote_store_;
+  std::unique_ptr<SyncEngine> sync_engine_;
+  NoOpSyncEngineCallback callback_;
+
+  int64_t version_ = 0;
+};
+
+/**
+ * Measures how long it takes to commit `range(0)` small write batches locally,
+ * send them to the backend and process their acknowledgements, with and
+ * without write coalescing.
+ */
+void BM_WriteAndAcknowledge(benchmark::State& state, bool coalesce) {
+  WritePipelineHarness harness(coalesce);
+  int batches = static_cast<int>(state.range(0));
+  for (auto _ : state) {
+    harness.WriteAndAcknowledge(batches);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.counters["requests_per_iteration"] =
+      static_cast<double>(harness.requests_sent()) /
+      static_cast<double>(state.iterations());
+}
+
+BENCHMARK_CAPTURE(BM_WriteAndAcknowledge, individual, false)
+    ->Arg(1)
+    ->Arg(10)
+    ->Arg(100)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_WriteAndAcknowledge, coalesced, true)
+    ->Arg(1)
+    ->Arg(10)
+    ->Arg(100)
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
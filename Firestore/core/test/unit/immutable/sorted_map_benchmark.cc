@@ -0,0 +1,112 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/immutable/sorted_map.h"
+#include "Firestore/core/src/immutable/sorted_set.h"
+#include "Firestore/core/src/util/secure_random.h"
+#include "benchmark/benchmark.h"
+
+using firebase::firestore::immutable::SortedMap;
+using firebase::firestore::immutable::SortedSet;
+using firebase::firestore::util::SecureRandom;
+
+using IntMap = SortedMap<int, int>;
+using IntSet = SortedSet<int>;
+
+static std::vector<int> Keys(int64_t size, bool shuffled) {
+  std::vector<int> keys(static_cast<size_t>(size));
+  for (size_t i = 0; i < keys.size(); ++i) {
+    keys[i] = static_cast<int>(i);
+  }
+  if (shuffled) {
+    SecureRandom rng;
+    std::shuffle(keys.begin(), keys.end(), rng);
+  }
+  return keys;
+}
+
+static void BM_InsertOneAtATime(benchmark::State& state, bool shuffled) {
+  std::vector<int> keys = Keys(state.range(0), shuffled);
+  for (auto _ : state) {
+    IntMap map;
+    for (int key : keys) {
+      map = map.insert(key, key);
+    }
+    benchmark::DoNotOptimize(map);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_Builder(benchmark::State& state, bool shuffled) {
+  std::vector<int> keys = Keys(state.range(0), shuffled);
+  for (auto _ : state) {
+    IntMap::Builder builder;
+    builder.reserve(keys.size());
+    for (int key : keys) {
+      builder.insert(key, key);
+    }
+    IntMap map = builder.Build();
+    benchmark::DoNotOptimize(map);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_FromSortedRange(benchmark::State& state) {
+  std::vector<std::pair<int, int>> entries;
+  for (int key : Keys(state.range(0), /* shuffled= */ false)) {
+    entries.emplace_back(key, key);
+  }
+  for (auto _ : state) {
+    IntMap map = IntMap::FromSortedRange(entries.begin(), entries.end());
+    benchmark::DoNotOptimize(map);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_UnionWith(benchmark::State& state) {
+  IntSet::Builder evens;
+  IntSet::Builder odds;
+  for (int key : Keys(state.range(0), /* shuffled= */ false)) {
+    (key % 2 == 0 ? evens : odds).insert(key);
+  }
+  IntSet lhs = evens.Build();
+  IntSet rhs = odds.Build();
+
+  for (auto _ : state) {
+    IntSet set = lhs.union_with(rhs);
+    benchmark::DoNotOptimize(set);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_CAPTURE(BM_InsertOneAtATime, Sorted, false)
+    ->RangeMultiplier(10)
+    ->Range(10000, 1000000);
+BENCHMARK_CAPTURE(BM_InsertOneAtATime, Shuffled, true)
+    ->RangeMultiplier(10)
+    ->Range(10000, 1000000);
+BENCHMARK_CAPTURE(BM_Builder, Sorted, false)
+    ->RangeMultiplier(10)
+    ->Range(10000, 1000000);
+BENCHMARK_CAPTURE(BM_Builder, Shuffled, true)
+    ->RangeMultiplier(10)
+    ->Range(10000, 1000000);
+BENCHMARK(BM_FromSortedRange)->RangeMultiplier(10)->Range(10000, 1000000);
+BENCHMARK(BM_UnionWith)->RangeMultiplier(10)->Range(10000, 1000000);
@@ -122,6 +122,21 @@ TYPED_TEST(SortedMapTest, Increasing) {
   ASSERT_EQ(Pairs(empty), Collect(map));
 }
 
+TYPED_TEST(SortedMapTest, FromSortedRange) {
+  std::vector<int> values = Sequence(this->large_number());
+  std::vector<std::pair<int, int>> entries = Pairs(values);
+  TypeParam map = TypeParam::FromSortedRange(entries.begin(), entries.end());
+  ASSERT_EQ(this->large_size(), map.size());
+  ASSERT_SEQ_EQ(entries, map);
+
+  for (int i : Shuffled(values)) {
+    ASSERT_TRUE(Found(map, i, i));
+    map = map.erase(i);
+    ASSERT_TRUE(NotFound(map, i));
+  }
+  ASSERT_TRUE(map.empty());
+}
+
 TYPED_TEST(SortedMapTest, Overwrite) {
   TypeParam map = TypeParam().insert(10, 10).insert(10, 8);
 
@@ -471,6 +486,60 @@ TYPED_TEST(SortedMapTest, KeysIn) {
   ASSERT_SEQ_EQ(Seq(8, 14), map.keys_in(7, 13));   // in between to in between
 }
 
+TEST(SortedMapBuilderTest, BuildsEmptyMap) {
+  SortedMap<int, int>::Builder builder;
+  SortedMap<int, int> map = builder.Build();
+  EXPECT_TRUE(map.empty());
+}
+
+TEST(SortedMapBuilderTest, SortsEntries) {
+  for (int n : {5, 100, 1000}) {
+    std::vector<int> values = Sequence(n);
+
+    SortedMap<int, int>::Builder builder;
+    for (int i : Shuffled(values)) {
+      builder.insert(i, i);
+    }
+    SortedMap<int, int> map = builder.Build();
+
+    ASSERT_EQ(static_cast<SizeType>(n), map.size());
+    ASSERT_SEQ_EQ(Pairs(values), map);
+    ASSERT_EQ(0u, builder.size());
+  }
+}
+
+TEST(SortedMapBuilderTest, LastValueWins) {
+  SortedMap<int, int>::Builder builder;
+  for (int i : Sequence(100)) {
+    builder.insert(i % 10, i);
+  }
+  SortedMap<int, int> map = builder.Build();
+
+  ASSERT_EQ(10u, map.size());
+  for (int i : Sequence(10)) {
+    ASSERT_TRUE(Found(map, i, 90 + i));
+  }
+}
+
+TEST(SortedMapBuilderTest, AddsToExistingMap) {
+  auto base = ToMap<SortedMap<int, int>>(Sequence(0, 100, 2));
+
+  SortedMap<int, int>::Builder builder{base};
+  for (int i : Shuffled(Sequence(50, 150))) {
+    builder.insert(i, -i);
+  }
+  SortedMap<int, int> map = builder.Build();
+
+  ASSERT_EQ(125u, map.size());
+  for (int i : Sequence(0, 50, 2)) {
+    ASSERT_TRUE(Found(map, i, i));
+  }
+  for (int i : Sequence(50, 150)) {
+    ASSERT_TRUE(Found(map, i, -i));
+  }
+  ASSERT_EQ(50u, base.size());
+}
+
 }  // namespace immutable
 }  // namespace firestore
 }  // namespace firebase
@@ -154,6 +154,39 @@ TEST(SortedSetTest, ValuesIn) {
   ASSERT_SEQ_EQ(Seq(8, 14), set.values_in(7, 13));   // in between to in between
 }
 
+TEST(SortedSetTest, FromSortedRange) {
+  std::vector<int> values = Sequence(kLargeNumber);
+  auto set = SortedSet<int>::FromSortedRange(values.begin(), values.end());
+  ASSERT_EQ(static_cast<SizeType>(kLargeNumber), set.size());
+  ASSERT_SEQ_EQ(values, set);
+}
+
+TEST(SortedSetTest, Builder) {
+  std::vector<int> values = Sequence(kLargeNumber);
+
+  SortedSet<int>::Builder builder;
+  for (int i : Shuffled(values)) {
+    builder.insert(i);
+    builder.insert(i);
+  }
+  SortedSet<int> set = builder.Build();
+  ASSERT_SEQ_EQ(values, set);
+}
+
+TEST(SortedSetTest, UnionWith) {
+  SortedSet<int> evens = ToSet(Sequence(0, 200, 2));
+  SortedSet<int> odds = ToSet(Sequence(1, 200, 2));
+  SortedSet<int> few = ToSet(Sequence(1, 7, 2));
+
+  ASSERT_SEQ_EQ(Sequence(200), evens.union_with(odds));
+  ASSERT_SEQ_EQ(Sequence(200), odds.union_with(evens));
+
+  std::vector<int> expected = Sequence(0, 200, 2);
+  expected.insert(expected.end(), {1, 3, 5});
+  ASSERT_SEQ_EQ(Sorted(expected), evens.union_with(few));
+  ASSERT_SEQ_EQ(Sorted(expected), few.union_with(evens));
+}
+
 TEST(SortedSetTest, HashesStdHashable) {
   SortedSet<int> set;
 
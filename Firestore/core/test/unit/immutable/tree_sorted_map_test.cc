@@ -230,6 +230,59 @@ TEST(TreeSortedMap, InitializerIsSorted) {
   EXPECT_TRUE(std::is_sorted(map.begin(), map.end()));
 }
 
+// Returns the black height of the given subtree, or -1 if it violates the
+// invariants of a left-leaning red-black tree.
+int BlackHeight(const IntMap::node_type& node) {
+  if (node.empty()) {
+    return 0;
+  }
+  if (node.right().red()) {
+    return -1;
+  }
+  if (node.red() && node.left().red()) {
+    return -1;
+  }
+  if (node.size() != node.left().size() + 1 + node.right().size()) {
+    return -1;
+  }
+
+  int left = BlackHeight(node.left());
+  int right = BlackHeight(node.right());
+  if (left < 0 || left != right) {
+    return -1;
+  }
+  return left + (node.red() ? 0 : 1);
+}
+
+TEST(TreeSortedMap, FromSortedRangeIsBalanced) {
+  for (int n = 0; n < 300; ++n) {
+    std::vector<IntMap::value_type> entries = Pairs(Sequence(n));
+    IntMap map = IntMap::FromSortedRange(entries.begin(), entries.end(), {});
+
+    ASSERT_EQ(static_cast<size_t>(n), map.size());
+    ASSERT_FALSE(map.root().red());
+    ASSERT_GE(BlackHeight(map.root()), 0) << "for size " << n;
+    ASSERT_TRUE(std::equal(map.begin(), map.end(), entries.begin()));
+  }
+}
+
+TEST(TreeSortedMap, FromSortedRangeSupportsInsertAndErase) {
+  std::vector<IntMap::value_type> entries = Pairs(Sequence(0, 200, 2));
+  IntMap map = IntMap::FromSortedRange(entries.begin(), entries.end(), {});
+
+  for (int i : Shuffled(Sequence(1, 200, 2))) {
+    map = map.insert(i, i);
+    ASSERT_GE(BlackHeight(map.root()), 0);
+  }
+  ASSERT_EQ(200u, map.size());
+
+  for (int i : Shuffled(Sequence(200))) {
+    map = map.erase(i);
+    ASSERT_GE(BlackHeight(map.root()), 0);
+  }
+  ASSERT_TRUE(map.empty());
+}
+
 }  // namespace impl
 }  // namespace immutable
 }  // namespace firestore
@@ -0,0 +1,133 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <limits>
+#include <memory>
+#include <string>
+
+#include "Firestore/core/src/core/query.h"
+#include "Firestore/core/src/credentials/user.h"
+#include "Firestore/core/src/local/leveldb_persistence.h"
+#include "Firestore/core/src/local/leveldb_remote_document_cache.h"
+#include "Firestore/core/src/local/local_documents_view.h"
+#include "Firestore/core/src/model/document.h"
+#include "Firestore/core/src/util/hard_assert.h"
+#include "Firestore/core/test/unit/local/persistence_testing.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+using credentials::User;
+using model::DocumentMap;
+using model::IndexOffset;
+using testutil::CollectionGroupQuery;
+using testutil::Doc;
+using testutil::Filter;
+using testutil::Map;
+
+/** The number of parents of the collection group. */
+const int kParentCount = 10000;
+
+/** The number of documents in each collection of the collection group. */
+const int kDocumentsPerCollection = 5;
+
+/** A LevelDB-backed cache holding a collection group with many parents. */
+class PopulatedCache {
+ public:
+  PopulatedCache() : persistence_(LevelDbPersistenceForTesting()) {
+    User user = User::Unauthenticated();
+    IndexManager* index_manager = persistence_->GetIndexManager(user);
+    persistence_->remote_document_cache()->SetIndexManager(index_manager);
+    documents_view_ = absl::make_unique<LocalDocumentsView>(
+        persistence_->remote_document_cache(),
+        persistence_->GetMutationQueue(user, index_manager),
+        persistence_->GetDocumentOverlayCache(user), index_manager);
+
+    for (int i = 0; i < kParentCount; i += 1000) {
+      persistence_->Run("Populate", [&] {
+        for (int parent = i; parent < i + 1000; ++parent) {
+          for (int j = 0; j < kDocumentsPerCollection; ++j) {
+            auto doc = Doc(absl::StrCat("parents/p", parent, "/group/d", j), 1,
+                           Map("i", j, "payload", std::string(200, 'a' + j)));
+            persistence_->remote_document_cache()->Add(doc, doc.version());
+          }
+        }
+      });
+    }
+  }
+
+  ~PopulatedCache() {
+    persistence_->Shutdown();
+  }
+
+  LevelDbPersistence* persistence() {
+    return persistence_.get();
+  }
+
+  LocalDocumentsView* documents_view() {
+    return documents_view_.get();
+  }
+
+ private:
+  std::unique_ptr<LevelDbPersistence> persistence_;
+  std::unique_ptr<LocalDocumentsView> documents_view_;
+};
+
+PopulatedCache* Cache() {
+  static PopulatedCache* cache = new PopulatedCache();
+  return cache;
+}
+
+/**
+ * Runs a collection group query over all parents. The argument is the number
+ * of collections from which they are read concurrently, where 0 means never.
+ */
+void BM_CollectionGroupQuery(benchmark::State& state) {
+  PopulatedCache* cache = Cache();
+  size_t min_collections = state.range(0) == 0
+                               ? std::numeric_limits<size_t>::max()
+                               : static_cast<size_t>(state.range(0));
+  cache->persistence()
+      ->remote_document_cache()
+      ->set_min_collections_for_concurrent_scan(min_collections);
+
+  core::Query query =
+      CollectionGroupQuery("group").AddingFilter(Filter("i", ">=", 2));
+  cache->persistence()->Run("BM_CollectionGroupQuery", [&] {
+    for (auto _ : state) {
+      DocumentMap results = cache->documents_view()->GetDocumentsMatchingQuery(
+          query, IndexOffset::None());
+      HARD_ASSERT(results.size() == static_cast<size_t>(kParentCount) * 3);
+    }
+  });
+  state.SetItemsProcessed(state.iterations() * kParentCount *
+                          kDocumentsPerCollection);
+}
+BENCHMARK(BM_CollectionGroupQuery)
+    ->Arg(0)
+    ->Arg(16)
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -176,6 +176,11 @@ model::MutableDocumentMap WrappedRemoteDocumentCache::GetAll(
   return result;
 }
 
+model::DocumentKeySet WrappedRemoteDocumentCache::GetFoundDocumentKeys(
+    const model::DocumentKeySet& keys) const {
+  return subject_->GetFoundDocumentKeys(keys);
+}
+
 model::MutableDocumentMap WrappedRemoteDocumentCache::GetAll(
     const std::string& collection_group,
     const model::IndexOffset& offset,
@@ -206,6 +211,20 @@ model::MutableDocumentMap WrappedRemoteDocumentCache::GetDocumentsMatchingQuery(
   return result;
 }
 
+std::vector<model::MutableDocumentMap>
+WrappedRemoteDocumentCache::GetDocumentsMatchingQueries(
+    const std::vector<core::Query>& queries,
+    const model::IndexOffset& offset,
+    absl::optional<QueryContext>& context,
+    const std::vector<model::OverlayByDocumentKeyMap>& mutated_docs) const {
+  auto results = subject_->GetDocumentsMatchingQueries(queries, offset,
+                                                       context, mutated_docs);
+  for (const auto& result : results) {
+    query_engine_->documents_read_by_query_ += result.size();
+  }
+  return results;
+}
+
 // MARK: - WrappedDocumentOverlayCache
 
 absl::optional<model::Overlay> WrappedDocumentOverlayCache::GetOverlay(
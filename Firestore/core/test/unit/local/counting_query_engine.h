@@ -192,6 +192,9 @@ class WrappedRemoteDocumentCache : public RemoteDocumentCache {
   model::MutableDocumentMap GetAll(
       const model::DocumentKeySet& keys) const override;
 
+  model::DocumentKeySet GetFoundDocumentKeys(
+      const model::DocumentKeySet& keys) const override;
+
   model::MutableDocumentMap GetAll(const std::string& collection_group,
                                    const model::IndexOffset& offset,
                                    size_t limit) const override;
@@ -209,6 +212,18 @@ class WrappedRemoteDocumentCache : public RemoteDocumentCache {
       absl::optional<size_t> limit,
       const model::OverlayByDocumentKeyMap& mutated_docs) const override;
 
+  std::vector<model::MutableDocumentMap> GetDocumentsMatchingQueries(
+      const std::vector<core::Query>& queries,
+      const model::IndexOffset& offset,
+      absl::optional<QueryContext>& context,
+      const std::vector<model::OverlayByDocumentKeyMap>& mutated_docs)
+      const override;
+
+  absl::optional<size_t> GetCollectionSize(
+      const model::ResourcePath& collection_path) const override {
+    return subject_->GetCollectionSize(collection_path);
+  }
+
   void SetIndexManager(IndexManager* manager) override {
     index_manager_ = NOT_NULL(manager);
   }
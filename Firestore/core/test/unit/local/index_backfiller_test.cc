@@ -112,6 +112,17 @@ class IndexBackfillerTest : public ::testing::Test {
     index_backfiller_->SetMaxDocumentsToProcess(new_max);
   }
 
+  void SetBatchSize(size_t batch_size) const {
+    index_backfiller_->progress_.batch_size = batch_size;
+  }
+
+  void AddDocs(const std::string& collection_group, int count) const {
+    for (int i = 0; i < count; ++i) {
+      AddDoc(collection_group + "/doc" + std::to_string(i), Version(10), "foo",
+             i);
+    }
+  }
+
   void VerifyQueryResults(
       const core::Query& query,
       const std::unordered_set<std::string>& expected_keys) const {
@@ -554,6 +565,72 @@ TEST_F(IndexBackfillerTest, ReindexesDocumentsWhenNewIndexIsAdded) {
   VerifyQueryResults(query_b, {"coll/doc2"});
 }
 
+TEST_F(IndexBackfillerTest, ReportsProgress) {
+  AddFieldIndex("coll1", "foo");
+  AddFieldIndex("coll2", "foo");
+  AddDocs("coll1", 2);
+  AddDocs("coll2", 3);
+
+  EXPECT_FALSE(local_store_.GetIndexBackfillProgress().caught_up);
+
+  local_store_.Backfill();
+  IndexBackfillProgress progress = local_store_.GetIndexBackfillProgress();
+  EXPECT_EQ(5u, progress.documents_processed_in_last_run);
+  EXPECT_EQ(5u, progress.total_documents_processed);
+  EXPECT_EQ(2u, progress.collection_groups_processed_in_last_run);
+  EXPECT_TRUE(progress.caught_up);
+
+  AddDoc("coll1/docX", Version(20), "foo", 1);
+  local_store_.Backfill();
+  progress = local_store_.GetIndexBackfillProgress();
+  EXPECT_EQ(1u, progress.documents_processed_in_last_run);
+  EXPECT_EQ(6u, progress.total_documents_processed);
+  EXPECT_TRUE(progress.caught_up);
+}
+
+TEST_F(IndexBackfillerTest, IsNotCaughtUpWhenCapIsReached) {
+  SetMaxDocumentsToProcess(2);
+  AddFieldIndex("coll1", "foo");
+  AddDocs("coll1", 3);
+
+  local_store_.Backfill();
+  EXPECT_FALSE(local_store_.GetIndexBackfillProgress().caught_up);
+
+  local_store_.Backfill();
+  EXPECT_TRUE(local_store_.GetIndexBackfillProgress().caught_up);
+  VerifyQueryResults("coll1", {"coll1/doc0", "coll1/doc1", "coll1/doc2"});
+}
+
+TEST_F(IndexBackfillerTest, ProcessesSeveralBatchesWithinTimeBudget) {
+  index_backfiller_->SetTimeBudget(std::chrono::seconds(60));
+  SetBatchSize(5);
+  AddFieldIndex("coll1", "foo");
+  AddFieldIndex("coll2", "foo");
+  AddDocs("coll1", 12);
+  AddDocs("coll2", 7);
+
+  int documents_processed = local_store_.Backfill();
+  ASSERT_EQ(19, documents_processed);
+  EXPECT_TRUE(local_store_.GetIndexBackfillProgress().caught_up);
+  EXPECT_GT(local_store_.GetIndexBackfillProgress().documents_per_millisecond,
+            0);
+}
+
+TEST_F(IndexBackfillerTest, ClampsBatchSizeWhenTimeBudgetIsExhausted) {
+  index_backfiller_->SetTimeBudget(std::chrono::milliseconds(0));
+  SetBatchSize(5);
+  AddFieldIndex("coll1", "foo");
+  AddDocs("coll1", 12);
+
+  int documents_processed = local_store_.Backfill();
+  ASSERT_EQ(5, documents_processed);
+  EXPECT_FALSE(local_store_.GetIndexBackfillProgress().caught_up);
+
+  // A zero time budget leaves room for no documents, so the next batch is
+  // clamped to the minimum batch size.
+  EXPECT_EQ(local_store_.GetIndexBackfillProgress().batch_size, 10u);
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -1578,7 +1578,7 @@ TEST_F(LevelDbIndexManagerTest, IndexTypeForOrQueries) {
                       .AddingFilter(OrFilters(
                           {Filter("a", "==", 1), Filter("b", "==", 1)}))
                       .WithLimitToFirst(2);
-    ValidateIndexType(query9, IndexManager::IndexType::PARTIAL);
+    ValidateIndexType(query9, IndexManager::IndexType::FULL);
 
     // OR query with explicit orderBy with limit which has all sub-target
     // indexes.
@@ -1587,7 +1587,7 @@ TEST_F(LevelDbIndexManagerTest, IndexTypeForOrQueries) {
                            {Filter("a", "==", 1), Filter("b", "==", 1)}))
                        .AddingOrderBy(OrderBy("a"))
                        .WithLimitToFirst(2);
-    ValidateIndexType(query10, IndexManager::IndexType::PARTIAL);
+    ValidateIndexType(query10, IndexManager::IndexType::FULL);
 
     // OR query with implicit orderBy with limit which has all sub-target
     // indexes.
@@ -1595,7 +1595,7 @@ TEST_F(LevelDbIndexManagerTest, IndexTypeForOrQueries) {
                        .AddingFilter(OrFilters(
                            {Filter("a", ">", 1), Filter("b", "==", 1)}))
                        .WithLimitToLast(2);
-    ValidateIndexType(query11, IndexManager::IndexType::PARTIAL);
+    ValidateIndexType(query11, IndexManager::IndexType::FULL);
   });
 }
 
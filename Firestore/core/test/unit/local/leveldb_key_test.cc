@@ -72,6 +72,15 @@ std::string RemoteDocumentReadTimeKey(absl::string_view collection_path,
       document_id);
 }
 
+std::string RemoteDocumentCollectionGroupReadTimeKey(
+    absl::string_view collection_group,
+    int64_t version,
+    absl::string_view document_key) {
+  return LevelDbRemoteDocumentCollectionGroupReadTimeKey::Key(
+      collection_group, testutil::Version(version),
+      testutil::Key(document_key));
+}
+
 }  // namespace
 
 /**
@@ -226,6 +235,64 @@ TEST(LevelDbDocumentMutationKeyTest, Description) {
       "[document_mutation: user_id=user1 path=foo/bar batch_id=42]", key);
 }
 
+TEST(LevelDbDocumentMutationCollectionIndexKeyTest, EncodeDecodeCycle) {
+  LevelDbDocumentMutationCollectionIndexKey key;
+  std::string user("foo");
+
+  std::vector<DocumentKey> document_keys{testutil::Key("a/b"),
+                                         testutil::Key("a/b/c/d")};
+
+  std::vector<BatchId> batch_ids{0, 1, 100, INT_MAX - 1, INT_MAX};
+
+  for (BatchId batch_id : batch_ids) {
+    for (auto&& document_key : document_keys) {
+      auto encoded = LevelDbDocumentMutationCollectionIndexKey::Key(
+          user, document_key, batch_id);
+
+      bool ok = key.Decode(encoded);
+      ASSERT_TRUE(ok);
+      ASSERT_EQ(user, key.user_id());
+      ASSERT_EQ(document_key.path().PopLast(), key.collection());
+      ASSERT_EQ(batch_id, key.batch_id());
+      ASSERT_EQ(document_key.path().last_segment(), key.document_id());
+    }
+  }
+}
+
+TEST(LevelDbDocumentMutationCollectionIndexKeyTest, Ordering) {
+  auto key = [](absl::string_view path, BatchId batch_id) {
+    return LevelDbDocumentMutationCollectionIndexKey::Key(
+        "1", testutil::Key(path), batch_id);
+  };
+
+  // Within a collection, rows are ordered by batch_id before document_id.
+  ASSERT_LT(key("foo/bar", 0), key("foo/bar", 1));
+  ASSERT_LT(key("foo/baz", 0), key("foo/bar", 1));
+  ASSERT_LT(key("foo/bar", 1), key("foo/baz", 1));
+
+  // All rows of a collection sort before those of its subcollections.
+  ASSERT_LT(key("foo/bar", 100), key("foo/bar/sub/doc", 0));
+  ASSERT_LT(key("foo/bar", 100), key("foo/baz/sub/doc", 0));
+
+  // A subcollection's rows are still covered by the collection prefix.
+  ASSERT_TRUE(absl::StartsWith(
+      key("foo/bar/sub/doc", 0),
+      LevelDbDocumentMutationCollectionIndexKey::KeyPrefix(
+          "1", testutil::Resource("foo"))));
+}
+
+TEST(LevelDbDocumentMutationCollectionIndexKeyTest, Description) {
+  AssertExpectedKeyDescription(
+      "[document_mutation_collection_index: user_id=user1 incomplete key]",
+      LevelDbDocumentMutationCollectionIndexKey::KeyPrefix("user1"));
+
+  AssertExpectedKeyDescription(
+      "[document_mutation_collection_index: user_id=user1 path=foo "
+      "batch_id=42 document_id=bar]",
+      LevelDbDocumentMutationCollectionIndexKey::Key(
+          "user1", testutil::Key("foo/bar"), 42));
+}
+
 TEST(LevelDbTargetGlobalKeyTest, EncodeDecodeCycle) {
   LevelDbTargetGlobalKey key;
 
@@ -271,6 +338,39 @@ TEST(LevelDbQueryKeyTest, Description) {
                                LevelDbQueryTargetKey::Key("foo", 42));
 }
 
+TEST(LevelDbTargetFingerprintKeyTest, FingerprintIsStable) {
+  // Fingerprints are persisted, so they must never change.
+  ASSERT_EQ(0xcbf29ce484222325ULL,
+            LevelDbTargetFingerprintKey::Fingerprint(""));
+  ASSERT_EQ(0xdcb27518fed9d577ULL,
+            LevelDbTargetFingerprintKey::Fingerprint("foo"));
+}
+
+TEST(LevelDbTargetFingerprintKeyTest, EncodeDecodeCycle) {
+  LevelDbTargetFingerprintKey key;
+  std::string canonical_id("foo");
+  TargetId target_id = 42;
+
+  auto encoded = LevelDbTargetFingerprintKey::Key(canonical_id, target_id);
+  bool ok = key.Decode(encoded);
+  ASSERT_TRUE(ok);
+  ASSERT_EQ(LevelDbTargetFingerprintKey::Fingerprint(canonical_id),
+            key.fingerprint());
+  ASSERT_EQ(target_id, key.target_id());
+
+  ASSERT_TRUE(absl::StartsWith(
+      encoded, LevelDbTargetFingerprintKey::KeyPrefix(canonical_id)));
+  ASSERT_FALSE(absl::StartsWith(
+      encoded, LevelDbTargetFingerprintKey::KeyPrefix("bar")));
+}
+
+TEST(LevelDbTargetFingerprintKeyTest, Description) {
+  AssertExpectedKeyDescription(
+      "[target_fingerprint: target_fingerprint=dcb27518fed9d577 "
+      "target_id=42]",
+      LevelDbTargetFingerprintKey::Key("foo", 42));
+}
+
 TEST(TargetDocumentKeyTest, EncodeDecodeCycle) {
   LevelDbTargetDocumentKey key;
 
@@ -427,6 +527,64 @@ TEST(RemoteDocumentReadTimeKeyTest, Description) {
       RemoteDocumentReadTimeKey("coll", 1000001, "doc"));
 }
 
+TEST(RemoteDocumentCollectionGroupReadTimeKeyTest, Ordering) {
+  // Different collection groups:
+  ASSERT_LT(RemoteDocumentCollectionGroupReadTimeKey("bar", 2, "a/1/bar/doc"),
+            RemoteDocumentCollectionGroupReadTimeKey("baz", 1, "a/1/baz/doc"));
+
+  // Different read times, regardless of the collection:
+  ASSERT_LT(RemoteDocumentCollectionGroupReadTimeKey("foo", 1, "b/1/foo/doc"),
+            RemoteDocumentCollectionGroupReadTimeKey("foo", 2, "a/1/foo/doc"));
+  ASSERT_LT(
+      RemoteDocumentCollectionGroupReadTimeKey("foo", 1000000, "foo/doc"),
+      RemoteDocumentCollectionGroupReadTimeKey("foo", 1000001, "foo/doc"));
+
+  // Different document keys:
+  ASSERT_LT(RemoteDocumentCollectionGroupReadTimeKey("foo", 1, "a/1/foo/doc"),
+            RemoteDocumentCollectionGroupReadTimeKey("foo", 1, "b/1/foo/doc"));
+  ASSERT_LT(RemoteDocumentCollectionGroupReadTimeKey("foo", 1, "foo/a"),
+            RemoteDocumentCollectionGroupReadTimeKey("foo", 1, "foo/b"));
+
+  // Prefixes:
+  ASSERT_TRUE(absl::StartsWith(
+      RemoteDocumentCollectionGroupReadTimeKey("foo", 1, "foo/a"),
+      LevelDbRemoteDocumentCollectionGroupReadTimeKey::KeyPrefix(
+          "foo", testutil::Version(1))));
+  ASSERT_FALSE(absl::StartsWith(
+      RemoteDocumentCollectionGroupReadTimeKey("foo", 1, "foo/a"),
+      LevelDbRemoteDocumentCollectionGroupReadTimeKey::KeyPrefix(
+          "foo", testutil::Version(2))));
+}
+
+TEST(RemoteDocumentCollectionGroupReadTimeKeyTest, EncodeDecodeCycle) {
+  LevelDbRemoteDocumentCollectionGroupReadTimeKey key;
+
+  std::vector<std::string> document_keys{"foo/docA", "bar/doc/foo/docB",
+                                         "a/b/c/d/foo/docC"};
+  std::vector<int64_t> versions{1, 1000000, 1000001};
+
+  for (const auto& document_key : document_keys) {
+    for (auto version : versions) {
+      auto encoded = RemoteDocumentCollectionGroupReadTimeKey("foo", version,
+                                                              document_key);
+      bool ok = key.Decode(encoded);
+      ASSERT_TRUE(ok);
+      ASSERT_EQ("foo", key.collection_group());
+      ASSERT_EQ(testutil::Version(version), key.read_time());
+      ASSERT_EQ(testutil::Key(document_key), key.document_key());
+    }
+  }
+}
+
+TEST(RemoteDocumentCollectionGroupReadTimeKeyTest, Description) {
+  AssertExpectedKeyDescription(
+      "[remote_document_collection_group_read_time: collection_group=coll "
+      "snapshot_version=Timestamp(seconds=1, nanoseconds=1000) "
+      "path=parent/1/coll/doc]",
+      RemoteDocumentCollectionGroupReadTimeKey("coll", 1000001,
+                                               "parent/1/coll/doc"));
+}
+
 TEST(BundleKeyTest, Prefixing) {
   auto table_key = LevelDbBundleKey::KeyPrefix();
 
@@ -17,6 +17,8 @@
 #include "Firestore/core/src/core/filter.h"
 #include "Firestore/core/src/core/query.h"
 #include "Firestore/core/src/local/leveldb_persistence.h"
+#include "Firestore/core/src/model/aggregate_alias.h"
+#include "Firestore/core/src/model/aggregate_field.h"
 #include "Firestore/core/src/model/delete_mutation.h"
 #include "Firestore/core/src/model/field_index.h"
 #include "Firestore/core/src/model/set_mutation.h"
@@ -31,6 +33,8 @@ namespace firestore {
 namespace local {
 namespace {
 
+using model::AggregateAlias;
+using model::AggregateField;
 using model::DocumentKey;
 using model::FieldIndex;
 using model::IndexState;
@@ -50,6 +54,7 @@ using testutil::OrFilters;
 using testutil::OverlayTypeMap;
 using testutil::SetMutation;
 using testutil::UpdateRemoteEvent;
+using testutil::Value;
 using testutil::Vector;
 using testutil::Version;
 
@@ -79,6 +84,14 @@ auto convertToSet = [](std::vector<FieldIndex>&& vec) {
   return result;
 };
 
+/** Returns a single COUNT aggregation. */
+std::vector<AggregateField> CountAggregate() {
+  std::vector<AggregateField> aggregates;
+  aggregates.emplace_back(AggregateField::OpKind::Count,
+                          AggregateAlias("count"));
+  return aggregates;
+}
+
 }  // namespace
 
 INSTANTIATE_TEST_SUITE_P(LevelDbLocalStoreTest,
@@ -93,6 +106,17 @@ class LevelDbLocalStoreTest : public LocalStoreTestBase {
             LevelDbPersistence::kMaxOperationPerTransaction) {
   }
 
+  /**
+   * Configures an index on the "matches" field of "coll" and returns a query
+   * that can be served from it.
+   */
+  core::Query ConfigureMatchesIndex() {
+    ConfigureFieldIndexes(
+        {MakeFieldIndex("coll", 0, FieldIndex::InitialState(), "matches",
+                        model::Segment::Kind::kAscending)});
+    return testutil::Query("coll").AddingFilter(Filter("matches", "==", true));
+  }
+
   const size_t max_operation_per_transaction_;
 };
 
@@ -253,7 +277,7 @@ TEST_F(LevelDbLocalStoreTest, UsesPartiallyIndexedOverlaysWhenAvailable) {
   FSTAssertQueryReturned("coll/a", "coll/b");
 }
 
-TEST_F(LevelDbLocalStoreTest, DoesNotUseLimitWhenIndexIsOutdated) {
+TEST_F(LevelDbLocalStoreTest, UsesLimitWhenIndexIsOutdated) {
   FieldIndex index = MakeFieldIndex("coll", 0, FieldIndex::InitialState(),
                                     "count", model::Segment::Kind::kAscending);
   ConfigureFieldIndexes({index});
@@ -273,10 +297,11 @@ TEST_F(LevelDbLocalStoreTest, DoesNotUseLimitWhenIndexIsOutdated) {
 
   ExecuteQuery(query);
 
-  // The query engine first reads the documents by key and then re-runs the
-  // query without limit.
-  FSTAssertRemoteDocumentsRead(/* byKey= */ 5, /* byCollection= */ 0);
-  FSTAssertOverlaysRead(/* byKey= */ 5, /* byCollection= */ 1);
+  // The query engine reads the index in order until it has found two matching
+  // documents, skipping the deleted one. Its overlay is a delete, so its
+  // remote document is not read.
+  FSTAssertRemoteDocumentsRead(/* byKey= */ 2, /* byCollection= */ 0);
+  FSTAssertOverlaysRead(/* byKey= */ 3, /* byCollection= */ 1);
   FSTAssertOverlayTypes(
       OverlayTypeMap({{Key("coll/b"), model::Mutation::Type::Delete}}));
 
@@ -801,6 +826,98 @@ TEST_F(LevelDbLocalStoreTest,
   FSTAssertQueryReturned("coll/a", "coll/e");
 }
 
+TEST_F(LevelDbLocalStoreTest, CountsDocumentsFromIndexEntries) {
+  core::Query query = ConfigureMatchesIndex();
+  int target_id = AllocateQuery(query);
+
+  ApplyRemoteEvent(AddedRemoteEvent({Doc("coll/a", 10, Map("matches", true)),
+                                     Doc("coll/b", 10, Map("matches", true)),
+                                     Doc("coll/c", 10, Map("matches", false))},
+                                    {target_id}));
+  BackfillIndexes();
+
+  ResetPersistenceStats();
+  model::ObjectValue result =
+      local_store_.RunAggregateQuery(query, CountAggregate());
+  EXPECT_EQ(*result.Get("count"), *Value(2));
+  FSTAssertRemoteDocumentsRead(/* byKey= */ 0, /* byCollection= */ 0);
+
+  model::ObjectValue limited = local_store_.RunAggregateQuery(
+      query.WithLimitToFirst(1), CountAggregate());
+  EXPECT_EQ(*limited.Get("count"), *Value(1));
+}
+
+TEST_F(LevelDbLocalStoreTest, DoesNotCountRemotelyDeletedDocuments) {
+  core::Query query = ConfigureMatchesIndex();
+  int target_id = AllocateQuery(query);
+
+  ApplyRemoteEvent(AddedRemoteEvent({Doc("coll/a", 10, Map("matches", true)),
+                                     Doc("coll/b", 10, Map("matches", true))},
+                                    {target_id}));
+  BackfillIndexes();
+
+  // The index entry of the deleted document stays until the next backfill.
+  ApplyRemoteEvent(
+      UpdateRemoteEvent(DeletedDoc("coll/b", 11), {}, {target_id}));
+
+  model::ObjectValue result =
+      local_store_.RunAggregateQuery(query, CountAggregate());
+  EXPECT_EQ(*result.Get("count"), *Value(1));
+}
+
+TEST_F(LevelDbLocalStoreTest, DoesNotCountDocumentsOfSameNamedSubcollections) {
+  core::Query query = ConfigureMatchesIndex();
+  int target_id = AllocateQuery(query);
+  int subcollection_target_id = AllocateQuery(testutil::Query("a/b/coll"));
+
+  ApplyRemoteEvent(AddedRemoteEvent({Doc("coll/a", 10, Map("matches", true))},
+                                    {target_id}));
+  ApplyRemoteEvent(
+      AddedRemoteEvent({Doc("a/b/coll/c", 10, Map("matches", true))},
+                       {subcollection_target_id}));
+  BackfillIndexes();
+
+  model::ObjectValue result =
+      local_store_.RunAggregateQuery(query, CountAggregate());
+  EXPECT_EQ(*result.Get("count"), *Value(1));
+}
+
+TEST_F(LevelDbLocalStoreTest, CountsMutatedDocumentsFromTheirLocalView) {
+  core::Query query = ConfigureMatchesIndex();
+  int target_id = AllocateQuery(query);
+
+  ApplyRemoteEvent(AddedRemoteEvent({Doc("coll/a", 10, Map("matches", true)),
+                                     Doc("coll/b", 10, Map("matches", true))},
+                                    {target_id}));
+  BackfillIndexes();
+
+  WriteMutation(SetMutation("coll/b", Map("matches", false)));
+  WriteMutation(SetMutation("coll/c", Map("matches", true)));
+
+  model::ObjectValue result =
+      local_store_.RunAggregateQuery(query, CountAggregate());
+  EXPECT_EQ(*result.Get("count"), *Value(2));
+}
+
+TEST_F(LevelDbLocalStoreTest, DoesNotCountIndexEntriesOfRejectedMutations) {
+  core::Query query = ConfigureMatchesIndex();
+  int target_id = AllocateQuery(query);
+
+  ApplyRemoteEvent(AddedRemoteEvent({Doc("coll/a", 10, Map("matches", true)),
+                                     Doc("coll/b", 10, Map("matches", false))},
+                                    {target_id}));
+  WriteMutation(SetMutation("coll/b", Map("matches", true)));
+  BackfillIndexes();
+
+  model::ObjectValue result =
+      local_store_.RunAggregateQuery(query, CountAggregate());
+  EXPECT_EQ(*result.Get("count"), *Value(2));
+
+  RejectMutation();
+  result = local_store_.RunAggregateQuery(query, CountAggregate());
+  EXPECT_EQ(*result.Get("count"), *Value(1));
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
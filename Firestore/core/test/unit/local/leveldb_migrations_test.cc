@@ -467,6 +467,54 @@ TEST_F(LevelDbMigrationsTest, CreateCollectionParentsIndex) {
   }
 }
 
+TEST_F(LevelDbMigrationsTest, CreatesDocumentMutationCollectionIndex) {
+  std::string empty_buffer;
+  LevelDbMigrations::RunMigrations(db_.get(), 8, *serializer_);
+  {
+    LevelDbTransaction transaction(db_.get(), "Write Mutations");
+    // As above, only the DbDocumentMutation index entries matter.
+    transaction.Put(
+        LevelDbDocumentMutationKey::Key("foo", testutil::Key("coll/a"), 1),
+        empty_buffer);
+    transaction.Put(LevelDbDocumentMutationKey::Key(
+                        "foo", testutil::Key("coll/a/sub/b"), 2),
+                    empty_buffer);
+    transaction.Put(
+        LevelDbDocumentMutationKey::Key("bar", testutil::Key("coll/c"), 3),
+        empty_buffer);
+
+    // A stale row left behind by a downgraded client.
+    transaction.Put(LevelDbDocumentMutationCollectionIndexKey::Key(
+                        "foo", testutil::Key("coll/stale"), 4),
+                    empty_buffer);
+    transaction.Commit();
+  }
+
+  LevelDbMigrations::RunMigrations(db_.get(), 9, *serializer_);
+  {
+    LevelDbTransaction transaction(db_.get(), "Verify");
+
+    std::vector<std::string> actual_keys;
+    std::string index_prefix =
+        LevelDbDocumentMutationCollectionIndexKey::KeyPrefix();
+    auto it = transaction.NewIterator();
+    for (it->Seek(index_prefix);
+         it->Valid() && absl::StartsWith(it->key(), index_prefix); it->Next()) {
+      actual_keys.push_back(it->key());
+    }
+
+    std::vector<std::string> expected_keys{
+        LevelDbDocumentMutationCollectionIndexKey::Key(
+            "bar", testutil::Key("coll/c"), 3),
+        LevelDbDocumentMutationCollectionIndexKey::Key(
+            "foo", testutil::Key("coll/a"), 1),
+        LevelDbDocumentMutationCollectionIndexKey::Key(
+            "foo", testutil::Key("coll/a/sub/b"), 2),
+    };
+    ASSERT_EQ(actual_keys, expected_keys);
+  }
+}
+
 TEST_F(LevelDbMigrationsTest, RewritesCanonicalIds) {
   LevelDbMigrations::RunMigrations(db_.get(), 6, *serializer_);
   auto query = Query("collection").AddingFilter(Filter("foo", "==", "bar"));
@@ -513,6 +561,93 @@ TEST_F(LevelDbMigrationsTest, RewritesCanonicalIds) {
   }
 }
 
+TEST_F(LevelDbMigrationsTest, CreatesTargetFingerprintIndex) {
+  LevelDbMigrations::RunMigrations(db_.get(), 9, *serializer_);
+  auto query = Query("collection").AddingFilter(Filter("foo", "==", "bar"));
+  TargetData target_data(query.ToTarget(),
+                         /* target_id= */ 2,
+                         /* sequence_number= */ 1, QueryPurpose::Listen);
+  auto stale_key = LevelDbTargetFingerprintKey::Key("removed", 3);
+
+  {
+    LevelDbTransaction transaction(db_.get(), "Write target");
+    transaction.Put(LevelDbTargetKey::Key(2),
+                    serializer_->EncodeTargetData(target_data));
+
+    // A stale row left behind by a downgraded client.
+    std::string empty_buffer;
+    transaction.Put(stale_key, empty_buffer);
+    transaction.Commit();
+  }
+
+  LevelDbMigrations::RunMigrations(db_.get(), 10, *serializer_);
+  {
+    LevelDbTransaction transaction(db_.get(), "Verify");
+
+    std::vector<std::string> actual_keys;
+    std::string index_prefix = LevelDbTargetFingerprintKey::KeyPrefix();
+    auto it = transaction.NewIterator();
+    for (it->Seek(index_prefix);
+         it->Valid() && absl::StartsWith(it->key(), index_prefix); it->Next()) {
+      actual_keys.push_back(it->key());
+    }
+
+    std::vector<std::string> expected_keys{LevelDbTargetFingerprintKey::Key(
+        target_data.target().CanonicalId(), target_data.target_id())};
+    ASSERT_EQ(actual_keys, expected_keys);
+  }
+}
+
+TEST_F(LevelDbMigrationsTest, CreatesCollectionGroupReadTimeIndex) {
+  std::string empty_buffer;
+  LevelDbMigrations::RunMigrations(db_.get(), 10, *serializer_);
+  {
+    LevelDbTransaction transaction(db_.get(), "Write read time index");
+    // Only the read time index entries matter.
+    transaction.Put(LevelDbRemoteDocumentReadTimeKey::Key(
+                        testutil::Resource("coll"), testutil::Version(2), "a"),
+                    empty_buffer);
+    transaction.Put(
+        LevelDbRemoteDocumentReadTimeKey::Key(
+            testutil::Resource("parent/p/coll"), testutil::Version(1), "b"),
+        empty_buffer);
+    transaction.Put(
+        LevelDbRemoteDocumentReadTimeKey::Key(
+            testutil::Resource("parent/p/other"), testutil::Version(3), "c"),
+        empty_buffer);
+
+    // A stale row left behind by a downgraded client.
+    transaction.Put(LevelDbRemoteDocumentCollectionGroupReadTimeKey::Key(
+                        "coll", testutil::Version(4), Key("coll/stale")),
+                    empty_buffer);
+    transaction.Commit();
+  }
+
+  LevelDbMigrations::RunMigrations(db_.get(), 11, *serializer_);
+  {
+    LevelDbTransaction transaction(db_.get(), "Verify");
+
+    std::vector<std::string> actual_keys;
+    std::string index_prefix =
+        LevelDbRemoteDocumentCollectionGroupReadTimeKey::KeyPrefix();
+    auto it = transaction.NewIterator();
+    for (it->Seek(index_prefix);
+         it->Valid() && absl::StartsWith(it->key(), index_prefix); it->Next()) {
+      actual_keys.push_back(it->key());
+    }
+
+    std::vector<std::string> expected_keys{
+        LevelDbRemoteDocumentCollectionGroupReadTimeKey::Key(
+            "coll", testutil::Version(1), Key("parent/p/coll/b")),
+        LevelDbRemoteDocumentCollectionGroupReadTimeKey::Key(
+            "coll", testutil::Version(2), Key("coll/a")),
+        LevelDbRemoteDocumentCollectionGroupReadTimeKey::Key(
+            "other", testutil::Version(3), Key("parent/p/other/c")),
+    };
+    ASSERT_EQ(actual_keys, expected_keys);
+  }
+}
+
 TEST_F(LevelDbMigrationsTest, CanDowngrade) {
   // First, run all of the migrations
   LevelDbMigrations::RunMigrations(db_.get(), *serializer_);
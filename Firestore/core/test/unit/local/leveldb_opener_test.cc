@@ -17,6 +17,8 @@
 #include "Firestore/core/src/local/leveldb_opener.h"
 
 #include "Firestore/core/src/core/database_info.h"
+#include "Firestore/core/src/credentials/user.h"
+#include "Firestore/core/src/local/leveldb_options.h"
 #include "Firestore/core/src/local/leveldb_persistence.h"
 #include "Firestore/core/src/local/local_serializer.h"
 #include "Firestore/core/src/model/database_id.h"
@@ -214,6 +216,46 @@ TEST(LevelDbOpenerTest, WorksWithoutLegacyData) {
   ASSERT_THAT(other_fs.IsDirectory(data_dir), IsOk());
 }
 
+TEST(LevelDbOpenerTest, AppliesStorageOptions) {
+  TestTempDir root_dir;
+  OtherFilesystem other_fs(root_dir.path());
+  DatabaseInfo db_info = FakeDatabaseInfo();
+  model::MutableDocument doc =
+      testutil::Doc("coll/a", 1, testutil::Map("a", 1));
+
+  LevelDbOptions options = LevelDbOptions::Tuned();
+  options.block_cache_size_bytes = 1024 * 1024;
+  options.bloom_filter_bits_per_key = 16;
+  options.write_buffer_size_bytes = 64 * 1024;
+  options.compression_enabled = false;
+  {
+    LevelDbOpener opener(db_info, &other_fs);
+    auto created = opener.Create(LruParams::Disabled(), options);
+    ASSERT_OK(created.status());
+    auto persistence = std::move(created).ValueOrDie();
+    IndexManager* index_manager =
+        persistence->GetIndexManager(credentials::User::Unauthenticated());
+    persistence->remote_document_cache()->SetIndexManager(index_manager);
+    persistence->Run("Add", [&] {
+      persistence->remote_document_cache()->Add(doc, doc.version());
+    });
+    persistence->Shutdown();
+  }
+
+  {
+    // Tables written with one set of options stay readable with another.
+    LevelDbOpener opener(db_info, &other_fs);
+    auto created =
+        opener.Create(LruParams::Disabled(), LevelDbOptions::Default());
+    ASSERT_OK(created.status());
+    auto persistence = std::move(created).ValueOrDie();
+    persistence->Run("Get", [&] {
+      EXPECT_EQ(persistence->remote_document_cache()->Get(doc.key()), doc);
+    });
+    persistence->Shutdown();
+  }
+}
+
 class MockFilesystem : public Filesystem {
  public:
   MOCK_METHOD1(AppDataDir, StatusOr<Path>(absl::string_view));
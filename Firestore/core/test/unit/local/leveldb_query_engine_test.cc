@@ -14,11 +14,13 @@
  * limitations under the License.
  */
 
+#include <string>
 #include <vector>
 
 #include "Firestore/core/src/core/query.h"
 #include "Firestore/core/src/local/leveldb_persistence.h"
 #include "Firestore/core/src/local/query_engine.h"
+#include "Firestore/core/src/local/query_planner.h"
 #include "Firestore/core/src/model/document_set.h"
 #include "Firestore/core/src/model/field_index.h"
 #include "Firestore/core/src/model/mutable_document.h"
@@ -34,6 +36,7 @@ namespace firestore {
 namespace local {
 namespace {
 
+using model::DocumentKeySet;
 using model::DocumentSet;
 using model::SnapshotVersion;
 using testutil::AndFilters;
@@ -638,6 +641,134 @@ TEST_F(LevelDbQueryEngineTest, OrderByEquality) {
   });
 }
 
+TEST_F(LevelDbQueryEngineTest, ReadsIndexInOrderForLimitQueries) {
+  persistence_->Run("ReadsIndexInOrderForLimitQueries", [&] {
+    mutation_queue_->Start();
+    index_manager_->Start();
+
+    std::vector<model::MutableDocument> docs;
+    for (int i = 0; i < 20; ++i) {
+      docs.push_back(
+          Doc("coll/" + std::string(1, static_cast<char>('a' + i)), 1,
+              Map("a", 19 - i)));
+    }
+    AddDocuments(docs);
+
+    index_manager_->AddFieldIndex(
+        MakeFieldIndex("coll", "a", model::Segment::kAscending));
+    index_manager_->UpdateIndexEntries(DocumentMap(docs));
+    index_manager_->UpdateCollectionGroup(
+        "coll", model::IndexOffset::FromDocument(docs.back()));
+
+    core::Query query =
+        Query("coll").AddingOrderBy(OrderBy("a")).WithLimitToFirst(3);
+    QueryPlan plan;
+    model::DocumentMap result;
+    ExpectOptimizedCollectionScan([&] {
+      result = query_engine_.GetDocumentsMatchingQuery(
+          query, SnapshotVersion::None(), DocumentKeySet(), &plan);
+      return DocumentSet(query.Comparator());
+    });
+    EXPECT_EQ(result.size(), 3u);
+    for (int i = 17; i < 20; ++i) {
+      EXPECT_TRUE(result.contains(docs[i].key()));
+    }
+    // Reading stops one document after the limit is reached.
+    EXPECT_EQ(plan.documents_read(), 4u);
+  });
+}
+
+TEST_F(LevelDbQueryEngineTest, ReadsIndexInOrderForLimitToLastQueries) {
+  persistence_->Run("ReadsIndexInOrderForLimitToLastQueries", [&] {
+    mutation_queue_->Start();
+    index_manager_->Start();
+
+    auto doc1 = Doc("coll/1", 1, Map("a", 4));
+    auto doc2 = Doc("coll/2", 1, Map("a", 3));
+    auto doc3 = Doc("coll/3", 1, Map("a", 2));
+    auto doc4 = Doc("coll/4", 1, Map("a", 1));
+    AddDocuments({doc1, doc2, doc3, doc4});
+
+    index_manager_->AddFieldIndex(
+        MakeFieldIndex("coll", "a", model::Segment::kDescending));
+    index_manager_->UpdateIndexEntries(DocumentMap({doc1, doc2, doc3, doc4}));
+    index_manager_->UpdateCollectionGroup(
+        "coll", model::IndexOffset::FromDocument(doc4));
+
+    core::Query query =
+        Query("coll").AddingOrderBy(OrderBy("a")).WithLimitToLast(2);
+    DocumentSet docs = ExpectOptimizedCollectionScan(
+        [&] { return RunQuery(query, SnapshotVersion::None()); });
+    EXPECT_EQ(docs, DocSet(query.Comparator(), {doc2, doc1}));
+  });
+}
+
+TEST_F(LevelDbQueryEngineTest, MergesIndexScansForOrLimitQueries) {
+  persistence_->Run("MergesIndexScansForOrLimitQueries", [&] {
+    mutation_queue_->Start();
+    index_manager_->Start();
+
+    auto doc1 = Doc("coll/1", 1, Map("a", 1, "b", 0));
+    auto doc2 = Doc("coll/2", 1, Map("a", 2, "b", 1));
+    auto doc3 = Doc("coll/3", 1, Map("a", 1, "b", 1));
+    auto doc4 = Doc("coll/4", 1, Map("a", 1, "b", 3));
+    auto doc5 = Doc("coll/5", 1, Map("a", 3, "b", 3));
+    AddDocuments({doc1, doc2, doc3, doc4, doc5});
+
+    index_manager_->AddFieldIndex(
+        MakeFieldIndex("coll", "a", model::Segment::kAscending));
+    index_manager_->AddFieldIndex(
+        MakeFieldIndex("coll", "b", model::Segment::kAscending));
+    index_manager_->UpdateIndexEntries(
+        DocumentMap({doc1, doc2, doc3, doc4, doc5}));
+    index_manager_->UpdateCollectionGroup(
+        "coll", model::IndexOffset::FromDocument(doc5));
+
+    // Both sub-targets produce doc3, which must only be counted once.
+    core::Query query = Query("coll")
+                            .AddingFilter(OrFilters(
+                                {Filter("a", "==", 1), Filter("b", "==", 1)}))
+                            .WithLimitToFirst(3);
+    DocumentSet docs = ExpectOptimizedCollectionScan(
+        [&] { return RunQuery(query, SnapshotVersion::None()); });
+    EXPECT_EQ(docs, DocSet(query.Comparator(), {doc1, doc2, doc3}));
+  });
+}
+
+TEST_F(LevelDbQueryEngineTest, ReadsIndexInOrderWithPendingWrites) {
+  persistence_->Run("ReadsIndexInOrderWithPendingWrites", [&] {
+    mutation_queue_->Start();
+    index_manager_->Start();
+
+    auto doc1 = Doc("coll/1", 1, Map("a", 1));
+    auto doc2 = Doc("coll/2", 1, Map("a", 2));
+    auto doc3 = Doc("coll/3", 1, Map("a", 3));
+    auto doc4 = Doc("coll/4", 1, Map("a", 4));
+    AddDocuments({doc1, doc2, doc3, doc4});
+
+    index_manager_->AddFieldIndex(
+        MakeFieldIndex("coll", "a", model::Segment::kAscending));
+    index_manager_->UpdateIndexEntries(DocumentMap({doc1, doc2, doc3, doc4}));
+    index_manager_->UpdateCollectionGroup(
+        "coll", model::IndexOffset::FromDocument(doc4));
+
+    // Move the last indexed document to the front, and one of the first ones
+    // out of the result.
+    AddMutation(PatchMutation("coll/4", Map("a", 0)));
+    AddMutation(PatchMutation("coll/1", Map("a", 5)));
+
+    core::Query query =
+        Query("coll").AddingOrderBy(OrderBy("a")).WithLimitToFirst(2);
+    DocumentSet docs = ExpectOptimizedCollectionScan(
+        [&] { return RunQuery(query, SnapshotVersion::None()); });
+    std::vector<model::DocumentKey> keys;
+    for (const auto& doc : docs) {
+      keys.push_back(doc->key());
+    }
+    EXPECT_EQ(keys, (std::vector<model::DocumentKey>{doc4.key(), doc2.key()}));
+  });
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
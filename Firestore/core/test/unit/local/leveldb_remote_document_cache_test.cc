@@ -14,16 +14,25 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <initializer_list>
 #include <memory>
 #include <string>
+#include <vector>
 
+#include "Firestore/core/src/credentials/user.h"
 #include "Firestore/core/src/local/leveldb_persistence.h"
+#include "Firestore/core/src/local/leveldb_remote_document_cache.h"
+#include "Firestore/core/src/local/query_context.h"
 #include "Firestore/core/src/local/remote_document_cache.h"
+#include "Firestore/core/src/model/document_key_set.h"
+#include "Firestore/core/src/model/mutable_document.h"
 #include "Firestore/core/src/util/ordered_code.h"
 #include "Firestore/core/test/unit/local/persistence_testing.h"
 #include "Firestore/core/test/unit/local/remote_document_cache_test.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 #include "leveldb/db.h"
 
 namespace firebase {
@@ -32,6 +41,17 @@ namespace local {
 namespace {
 
 using leveldb::WriteOptions;
+using model::DocumentKeySet;
+using model::MutableDocument;
+using model::MutableDocumentMap;
+using testutil::Doc;
+using testutil::Field;
+using testutil::Filter;
+using testutil::Key;
+using testutil::Map;
+using testutil::Query;
+using testutil::Value;
+using testutil::Version;
 using util::OrderedCode;
 
 // A dummy document value, useful for testing code that's known to examine only
@@ -78,12 +98,260 @@ std::unique_ptr<Persistence> PersistenceFactory() {
   return persistence;
 }
 
+/** Returns the documents of `map`, in key order. */
+std::vector<MutableDocument> Docs(const MutableDocumentMap& map) {
+  std::vector<MutableDocument> result;
+  for (const auto& entry : map) {
+    result.push_back(entry.second);
+  }
+  return result;
+}
+
 }  // namespace
 
 INSTANTIATE_TEST_SUITE_P(LevelDbRemoteDocumentCacheTest,
                          RemoteDocumentCacheTest,
                          testing::Values(PersistenceFactory));
 
+class LevelDbRemoteDocumentCacheTest : public testing::Test {
+ protected:
+  LevelDbRemoteDocumentCacheTest()
+      : persistence_(LevelDbPersistenceForTesting()),
+        cache_(persistence_->remote_document_cache()) {
+    cache_->SetIndexManager(
+        persistence_->GetIndexManager(credentials::User::Unauthenticated()));
+  }
+
+  /**
+   * Adds `docs_per_collection` documents to each of `collections` collections
+   * of the collection group "group", in reverse key order of their read time.
+   */
+  void AddCollectionGroup(int collections, int docs_per_collection) {
+    for (int i = 0; i < collections; ++i) {
+      for (int j = 0; j < docs_per_collection; ++j) {
+        cache_->Add(Doc(absl::StrCat("parent/", 100 + i, "/group/", 100 + j),
+                        1, Map("even", j % 2 == 0)),
+                    Version(1000 - j));
+      }
+    }
+  }
+
+  /** Returns the collection queries of the collection group "group". */
+  std::vector<core::Query> CollectionQueries(int collections) {
+    std::vector<core::Query> queries;
+    for (int i = 0; i < collections; ++i) {
+      queries.push_back(Query(absl::StrCat("parent/", 100 + i, "/group"))
+                            .AddingFilter(Filter("even", "==", true)));
+    }
+    return queries;
+  }
+
+  std::unique_ptr<LevelDbPersistence> persistence_;
+  LevelDbRemoteDocumentCache* cache_ = nullptr;
+};
+
+TEST_F(LevelDbRemoteDocumentCacheTest, GetAllDecodesInBatches) {
+  persistence_->Run("GetAllDecodesInBatches", [&] {
+    cache_->set_decode_batch_size(3);
+
+    DocumentKeySet keys;
+    for (int i = 0; i < 20; ++i) {
+      std::string path = absl::StrCat("coll/", 100 + i);
+      keys = keys.insert(Key(path));
+      // Leave every fifth document out of the cache.
+      if (i % 5 != 0) {
+        cache_->Add(Doc(path, 1, Map("i", i)), Version(1));
+      }
+    }
+
+    MutableDocumentMap results = cache_->GetAll(keys);
+    ASSERT_EQ(results.size(), 20u);
+
+    int i = 0;
+    for (const auto& entry : results) {
+      EXPECT_EQ(entry.first, Key(absl::StrCat("coll/", 100 + i)));
+      EXPECT_EQ(entry.second.is_found_document(), i % 5 != 0);
+      ++i;
+    }
+  });
+}
+
+TEST_F(LevelDbRemoteDocumentCacheTest, QueryDecodesInBatches) {
+  persistence_->Run("QueryDecodesInBatches", [&] {
+    cache_->set_decode_batch_size(4);
+
+    for (int i = 0; i < 25; ++i) {
+      cache_->Add(Doc(absl::StrCat("coll/", 100 + i), 1,
+                      Map("matches", i % 2 == 0)),
+                  Version(1));
+    }
+
+    core::Query query =
+        Query("coll").AddingFilter(Filter("matches", "==", true));
+    MutableDocumentMap results =
+        cache_->GetDocumentsMatchingQuery(query, model::IndexOffset::None());
+    ASSERT_EQ(results.size(), 13u);
+
+    int i = 0;
+    for (const auto& entry : results) {
+      EXPECT_EQ(entry.first, Key(absl::StrCat("coll/", 100 + i)));
+      EXPECT_EQ(entry.second.read_time(), Version(1));
+      i += 2;
+    }
+  });
+}
+
+TEST_F(LevelDbRemoteDocumentCacheTest, DecodesIntoArenas) {
+  persistence_->Run("DecodesIntoArenas", [&] {
+    cache_->set_decode_batch_size(2);
+    cache_->set_arena_allocation(true);
+
+    DocumentKeySet keys;
+    for (int i = 0; i < 5; ++i) {
+      std::string path = absl::StrCat("coll/", 100 + i);
+      keys = keys.insert(Key(path));
+      cache_->Add(Doc(path, 1, Map("i", i, "s", "string")), Version(1));
+    }
+
+    MutableDocumentMap results = cache_->GetAll(keys);
+    ASSERT_EQ(results.size(), 5u);
+
+    int i = 0;
+    for (const auto& entry : results) {
+      const model::ObjectValue& data = entry.second.data();
+      EXPECT_TRUE(data.is_arena_backed());
+      EXPECT_EQ(*data.Get(Field("i")), *Value(i));
+      EXPECT_EQ(*data.Get(Field("s")), *Value("string"));
+      ++i;
+    }
+  });
+}
+
+TEST_F(LevelDbRemoteDocumentCacheTest, ScansCollectionsConcurrently) {
+  persistence_->Run("Setup", [&] { AddCollectionGroup(20, 10); });
+
+  persistence_->Run("ScansCollectionsConcurrently", [&] {
+    std::vector<core::Query> queries = CollectionQueries(20);
+    std::vector<model::OverlayByDocumentKeyMap> overlays(queries.size());
+
+    cache_->set_min_collections_for_concurrent_scan(1000);
+    absl::optional<QueryContext> serial_context = QueryContext();
+    std::vector<MutableDocumentMap> serial =
+        cache_->GetDocumentsMatchingQueries(queries, model::IndexOffset::None(),
+                                            serial_context, overlays);
+
+    cache_->set_min_collections_for_concurrent_scan(2);
+    absl::optional<QueryContext> concurrent_context = QueryContext();
+    std::vector<MutableDocumentMap> concurrent =
+        cache_->GetDocumentsMatchingQueries(queries, model::IndexOffset::None(),
+                                            concurrent_context, overlays);
+
+    ASSERT_EQ(concurrent.size(), 20u);
+    for (size_t i = 0; i < concurrent.size(); ++i) {
+      EXPECT_EQ(concurrent[i].size(), 5u);
+      EXPECT_EQ(Docs(concurrent[i]), Docs(serial[i]));
+    }
+    EXPECT_EQ(concurrent_context->GetDocumentReadCount(), 200u);
+    EXPECT_EQ(serial_context->GetDocumentReadCount(), 200u);
+  });
+}
+
+TEST_F(LevelDbRemoteDocumentCacheTest, ScansSeriallyAfterWrites) {
+  persistence_->Run("ScansSeriallyAfterWrites", [&] {
+    cache_->set_min_collections_for_concurrent_scan(2);
+    // Snapshots would not see these uncommitted documents.
+    AddCollectionGroup(4, 2);
+
+    std::vector<core::Query> queries = CollectionQueries(4);
+    std::vector<model::OverlayByDocumentKeyMap> overlays(queries.size());
+    absl::optional<QueryContext> context;
+    std::vector<MutableDocumentMap> results =
+        cache_->GetDocumentsMatchingQueries(queries, model::IndexOffset::None(),
+                                            context, overlays);
+
+    ASSERT_EQ(results.size(), 4u);
+    for (const MutableDocumentMap& result : results) {
+      EXPECT_EQ(result.size(), 1u);
+    }
+  });
+}
+
+TEST_F(LevelDbRemoteDocumentCacheTest, ScansOnlyQueriedCollections) {
+  persistence_->Run("ScansOnlyQueriedCollections", [&] {
+    AddCollectionGroup(5, 4);
+
+    // Every other collection of the group.
+    std::vector<core::Query> queries = CollectionQueries(5);
+    queries.erase(queries.begin() + 3);
+    queries.erase(queries.begin() + 1);
+    std::vector<model::OverlayByDocumentKeyMap> overlays(queries.size());
+    absl::optional<QueryContext> context = QueryContext();
+    std::vector<MutableDocumentMap> results =
+        cache_->GetDocumentsMatchingQueries(queries, model::IndexOffset::None(),
+                                            context, overlays);
+
+    ASSERT_EQ(results.size(), 3u);
+    for (size_t i = 0; i < results.size(); ++i) {
+      ASSERT_EQ(results[i].size(), 2u);
+      for (const auto& entry : results[i]) {
+        EXPECT_EQ(entry.first.path().PopLast(), queries[i].path());
+      }
+    }
+    EXPECT_EQ(context->GetDocumentReadCount(), 12u);
+  });
+}
+
+TEST_F(LevelDbRemoteDocumentCacheTest, CollectionGroupScanStartsAfterOffset) {
+  persistence_->Run("CollectionGroupScanStartsAfterOffset", [&] {
+    AddCollectionGroup(3, 4);
+
+    // The documents with ID 102 share read time 998, so the scan continues
+    // with the ones after the offset key before moving on to read time 999.
+    model::IndexOffset offset(Version(998), Key("parent/101/group/102"), -1);
+    MutableDocumentMap results = cache_->GetAll("group", offset, 3);
+
+    std::vector<model::DocumentKey> keys;
+    for (const auto& entry : results) {
+      keys.push_back(entry.first);
+    }
+    EXPECT_EQ(keys, (std::vector<model::DocumentKey>{
+                        Key("parent/100/group/101"),
+                        Key("parent/101/group/101"),
+                        Key("parent/102/group/102"),
+                    }));
+  });
+}
+
+TEST_F(LevelDbRemoteDocumentCacheTest, DropsCollectionSizeAfterManyWrites) {
+  persistence_->Run("DropsCollectionSizeAfterManyWrites", [&] {
+    AddCollectionGroup(1, 8);
+    model::ResourcePath path = Query("parent/100/group").path();
+    EXPECT_EQ(cache_->GetCollectionSize(path), absl::nullopt);
+
+    cache_->GetDocumentsMatchingQuery(Query("parent/100/group"),
+                                      model::IndexOffset::None());
+    EXPECT_EQ(cache_->GetCollectionSize(path), 8u);
+
+    // Updates of existing documents leave the size unchanged.
+    for (int i = 0; i < 8; ++i) {
+      cache_->Add(Doc("parent/100/group/100", 2, Map()), Version(2));
+    }
+    cache_->Remove(Key("parent/100/group/missing"));
+    EXPECT_EQ(cache_->GetCollectionSize(path), 8u);
+
+    // A quarter of the collection may change before the size is dropped.
+    cache_->Remove(Key("parent/100/group/100"));
+    cache_->Remove(Key("parent/100/group/101"));
+    EXPECT_EQ(cache_->GetCollectionSize(path), 8u);
+    cache_->Add(Doc("parent/100/group/108", 1, Map()), Version(1));
+    EXPECT_EQ(cache_->GetCollectionSize(path), absl::nullopt);
+
+    cache_->GetDocumentsMatchingQuery(Query("parent/100/group"),
+                                      model::IndexOffset::None());
+    EXPECT_TRUE(cache_->GetCollectionSize(path).has_value());
+  });
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -0,0 +1,163 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/local/leveldb_snapshot_reader.h"
+
+#include <future>  // NOLINT(build/c++11)
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/credentials/user.h"
+#include "Firestore/core/src/local/leveldb_persistence.h"
+#include "Firestore/core/src/model/document.h"
+#include "Firestore/core/src/model/mutable_document.h"
+#include "Firestore/core/src/model/mutation.h"
+#include "Firestore/core/src/model/patch_mutation.h"
+#include "Firestore/core/src/model/set_mutation.h"
+#include "Firestore/core/test/unit/local/persistence_testing.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+using credentials::User;
+using model::Document;
+using model::DocumentMap;
+using model::MutableDocument;
+using model::MutationByDocumentKeyMap;
+using testutil::Doc;
+using testutil::Key;
+using testutil::Map;
+
+class LevelDbSnapshotReaderTest : public testing::Test {
+ public:
+  LevelDbSnapshotReaderTest()
+      : persistence_(LevelDbPersistenceForTesting()),
+        reader_(persistence_->CreateSnapshotReader(User::Unauthenticated())) {
+    persistence_->remote_document_cache()->SetIndexManager(
+        persistence_->GetIndexManager(User::Unauthenticated()));
+  }
+
+  ~LevelDbSnapshotReaderTest() override {
+    reader_.reset();
+    persistence_->Shutdown();
+  }
+
+ protected:
+  void AddDocument(const MutableDocument& doc) {
+    persistence_->Run("AddDocument", [&] {
+      persistence_->remote_document_cache()->Add(doc, doc.version());
+    });
+  }
+
+  void AddOverlay(const model::Mutation& mutation) {
+    persistence_->Run("AddOverlay", [&] {
+      MutationByDocumentKeyMap overlays;
+      overlays.insert({mutation.key(), mutation});
+      persistence_->GetDocumentOverlayCache(User::Unauthenticated())
+          ->SaveOverlays(/* largest_batch_id= */ 1, overlays);
+    });
+  }
+
+  std::unique_ptr<LevelDbPersistence> persistence_;
+  std::unique_ptr<LevelDbSnapshotReader> reader_;
+};
+
+TEST_F(LevelDbSnapshotReaderTest, ReadsDocuments) {
+  MutableDocument doc = Doc("coll/a", 1, Map("a", 1));
+  AddDocument(doc);
+
+  Document result = reader_->ReadDocument(doc.key());
+  EXPECT_EQ(result.get(), doc);
+
+  EXPECT_FALSE(reader_->ReadDocument(Key("coll/b"))->is_valid_document());
+}
+
+TEST_F(LevelDbSnapshotReaderTest, AppliesOverlays) {
+  AddDocument(Doc("coll/a", 1, Map("a", 1)));
+  AddOverlay(testutil::PatchMutation("coll/a", Map("b", 2)));
+
+  Document result = reader_->ReadDocument(Key("coll/a"));
+  EXPECT_EQ(result->data(), testutil::WrapObject(Map("a", 1, "b", 2)));
+  EXPECT_TRUE(result->has_local_mutations());
+}
+
+TEST_F(LevelDbSnapshotReaderTest, ExecutesCollectionQueries) {
+  AddDocument(Doc("coll/a", 1, Map("matches", true)));
+  AddDocument(Doc("coll/b", 1, Map("matches", false)));
+  AddDocument(Doc("other/c", 1, Map("matches", true)));
+  AddOverlay(testutil::SetMutation("coll/d", Map("matches", true)));
+
+  DocumentMap result = reader_->ExecuteQuery(
+      testutil::Query("coll").AddingFilter(
+          testutil::Filter("matches", "==", true)));
+  EXPECT_EQ(result.size(), 2u);
+  EXPECT_NE(result.find(Key("coll/a")), result.end());
+  EXPECT_NE(result.find(Key("coll/d")), result.end());
+}
+
+TEST_F(LevelDbSnapshotReaderTest, ExecutesCollectionGroupQueries) {
+  AddDocument(Doc("a/1/coll/x", 1, Map()));
+  AddDocument(Doc("b/2/coll/y", 1, Map()));
+  AddDocument(Doc("b/2/other/z", 1, Map()));
+
+  DocumentMap result =
+      reader_->ExecuteQuery(testutil::CollectionGroupQuery("coll"));
+  EXPECT_EQ(result.size(), 2u);
+}
+
+TEST_F(LevelDbSnapshotReaderTest, DoesNotObserveUncommittedTransactions) {
+  MutableDocument doc = Doc("coll/a", 1, Map("a", 1));
+
+  persistence_->Run("AddDocument", [&] {
+    persistence_->remote_document_cache()->Add(doc, doc.version());
+
+    // Read on another thread while the worker's transaction is in progress.
+    auto read = std::async(std::launch::async,
+                           [&] { return reader_->ReadDocument(doc.key()); });
+    EXPECT_FALSE(read.get()->is_valid_document());
+
+    // The transaction itself still sees its own write.
+    EXPECT_EQ(persistence_->remote_document_cache()->Get(doc.key()), doc);
+  });
+
+  EXPECT_EQ(reader_->ReadDocument(doc.key()).get(), doc);
+}
+
+TEST_F(LevelDbSnapshotReaderTest, ReadsConcurrently) {
+  for (int i = 0; i < 20; ++i) {
+    AddDocument(Doc("coll/doc" + std::to_string(i), 1, Map("i", i)));
+  }
+
+  std::vector<std::future<DocumentMap>> reads;
+  for (int i = 0; i < 8; ++i) {
+    reads.push_back(std::async(std::launch::async, [&] {
+      return reader_->ExecuteQuery(testutil::Query("coll"));
+    }));
+  }
+  for (auto& read : reads) {
+    EXPECT_EQ(read.get().size(), 20u);
+  }
+}
+
+}  // namespace
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,211 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+
+#include "Firestore/core/src/credentials/user.h"
+#include "Firestore/core/src/local/leveldb_options.h"
+#include "Firestore/core/src/local/leveldb_persistence.h"
+#include "Firestore/core/src/local/lru_garbage_collector.h"
+#include "Firestore/core/src/local/remote_document_cache.h"
+#include "Firestore/core/src/model/mutable_document.h"
+#include "Firestore/core/src/util/hard_assert.h"
+#include "Firestore/core/test/unit/local/persistence_testing.h"
+#include "Firestore/core/test/unit/testutil/filesystem_testing.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "absl/memory/memory.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+using model::DocumentKey;
+using model::MutableDocument;
+using testutil::Doc;
+using testutil::Map;
+using testutil::TestTempDir;
+
+/** The approximate size of the populated cache. */
+const int64_t kCacheSizeBytes = 1024 * 1024 * 1024;
+
+/** The size of the payload of each cached document. */
+const int kDocumentSizeBytes = 4 * 1024;
+
+const int kDocumentCount = kCacheSizeBytes / kDocumentSizeBytes;
+
+/** The number of documents added per transaction while populating. */
+const int kDocumentsPerTransaction = 1000;
+
+enum class Config {
+  kDefault,
+  kTuned,
+  kTunedNoCompression,
+  kTunedLargeBlockCache,
+};
+
+LevelDbOptions OptionsFor(Config config) {
+  switch (config) {
+    case Config::kDefault:
+      return LevelDbOptions::Default();
+    case Config::kTuned:
+      return LevelDbOptions::Tuned();
+    case Config::kTunedNoCompression: {
+      LevelDbOptions options = LevelDbOptions::Tuned();
+      options.compression_enabled = false;
+      return options;
+    }
+    case Config::kTunedLargeBlockCache: {
+      LevelDbOptions options = LevelDbOptions::Tuned();
+      options.block_cache_size_bytes = 64 * 1024 * 1024;
+      return options;
+    }
+  }
+  UNREACHABLE();
+}
+
+DocumentKey PresentKey(int i) {
+  return testutil::Key("coll/doc" + std::to_string(i));
+}
+
+/** Keys that sort between the present ones, so every table may contain them. */
+DocumentKey MissingKey(int i) {
+  return testutil::Key("coll/doc" + std::to_string(i) + "-missing");
+}
+
+/**
+ * A LevelDB-backed cache of about `kCacheSizeBytes`, opened with the options
+ * of one configuration.
+ */
+class PopulatedCache {
+ public:
+  explicit PopulatedCache(Config config) {
+    auto created =
+        LevelDbPersistence::Create(dir_.path(), MakeLocalSerializer(),
+                                   LruParams::Disabled(), OptionsFor(config));
+    HARD_ASSERT(created.ok(), "Failed to open LevelDB: %s",
+                created.status().ToString());
+    persistence_ = std::move(created).ValueOrDie();
+    persistence_->remote_document_cache()->SetIndexManager(
+        persistence_->GetIndexManager(credentials::User::Unauthenticated()));
+
+    // Fill the payload with pseudo-random text so that compression has
+    // realistic (rather than perfect) results.
+    std::mt19937 generator(0);
+    std::uniform_int_distribution<int> letters('a', 'z');
+    std::string payload;
+    for (int i = 0; i < kDocumentSizeBytes; ++i) {
+      payload.push_back(static_cast<char>(letters(generator)));
+    }
+
+    for (int start = 0; start < kDocumentCount;
+         start += kDocumentsPerTransaction) {
+      persistence_->Run("Populate", [&] {
+        for (int i = start;
+             i < start + kDocumentsPerTransaction && i < kDocumentCount; ++i) {
+          MutableDocument doc = Doc("coll/doc" + std::to_string(i), 1,
+                                    Map("i", i, "payload", payload));
+          persistence_->remote_document_cache()->Add(doc, doc.version());
+        }
+      });
+    }
+  }
+
+  ~PopulatedCache() {
+    persistence_->Shutdown();
+  }
+
+  LevelDbPersistence* persistence() {
+    return persistence_.get();
+  }
+
+ private:
+  TestTempDir dir_;
+  std::unique_ptr<LevelDbPersistence> persistence_;
+};
+
+/** Populates each configuration's cache once per process. */
+PopulatedCache* CacheFor(Config config) {
+  static std::map<Config, std::unique_ptr<PopulatedCache>> caches;
+  auto& cache = caches[config];
+  if (!cache) {
+    cache = absl::make_unique<PopulatedCache>(config);
+  }
+  return cache.get();
+}
+
+/** Measures point lookups of random documents that are in the cache. */
+void BM_GetPresentDocument(benchmark::State& state, Config config) {
+  LevelDbPersistence* persistence = CacheFor(config)->persistence();
+  std::mt19937 generator(1);
+  std::uniform_int_distribution<int> indexes(0, kDocumentCount - 1);
+
+  RemoteDocumentCache* cache = persistence->remote_document_cache();
+
+  persistence->Run("BM_GetPresentDocument", [&] {
+    for (auto _ : state) {
+      MutableDocument doc = cache->Get(PresentKey(indexes(generator)));
+      benchmark::DoNotOptimize(doc);
+    }
+  });
+  state.SetItemsProcessed(state.iterations());
+}
+
+/** Measures point lookups of random documents that are not in the cache. */
+void BM_GetMissingDocument(benchmark::State& state, Config config) {
+  LevelDbPersistence* persistence = CacheFor(config)->persistence();
+  std::mt19937 generator(2);
+  std::uniform_int_distribution<int> indexes(0, kDocumentCount - 1);
+
+  RemoteDocumentCache* cache = persistence->remote_document_cache();
+
+  persistence->Run("BM_GetMissingDocument", [&] {
+    for (auto _ : state) {
+      MutableDocument doc = cache->Get(MissingKey(indexes(generator)));
+      benchmark::DoNotOptimize(doc);
+    }
+  });
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_CAPTURE(BM_GetPresentDocument, default, Config::kDefault);
+BENCHMARK_CAPTURE(BM_GetPresentDocument, tuned, Config::kTuned);
+BENCHMARK_CAPTURE(BM_GetPresentDocument,
+                  tuned_no_compression,
+                  Config::kTunedNoCompression);
+BENCHMARK_CAPTURE(BM_GetPresentDocument,
+                  tuned_large_block_cache,
+                  Config::kTunedLargeBlockCache);
+
+BENCHMARK_CAPTURE(BM_GetMissingDocument, default, Config::kDefault);
+BENCHMARK_CAPTURE(BM_GetMissingDocument, tuned, Config::kTuned);
+BENCHMARK_CAPTURE(BM_GetMissingDocument,
+                  tuned_no_compression,
+                  Config::kTunedNoCompression);
+BENCHMARK_CAPTURE(BM_GetMissingDocument,
+                  tuned_large_block_cache,
+                  Config::kTunedLargeBlockCache);
+
+}  // namespace
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -151,6 +151,43 @@ TEST_F(LevelDbTargetCacheTest, SurvivesMissingTargetData) {
   });
 }
 
+TEST_F(LevelDbTargetCacheTest, GetTargetSeesUpdatesToPreviouslyReadTargets) {
+  persistence_->Run("test_get_target_sees_updates", [&]() {
+    TargetData target_data1 = MakeTargetData(query_rooms_, 1, 10, 1);
+    cache_->AddTarget(target_data1);
+    ASSERT_EQ(cache_->GetTarget(query_rooms_.ToTarget()), target_data1);
+
+    TargetData target_data2 = MakeTargetData(query_rooms_, 1, 11, 2);
+    cache_->UpdateTarget(target_data2);
+    ASSERT_EQ(cache_->GetTarget(query_rooms_.ToTarget()), target_data2);
+
+    cache_->RemoveTargets(target_data2.sequence_number(), {});
+    ASSERT_EQ(cache_->GetTarget(query_rooms_.ToTarget()), absl::nullopt);
+  });
+}
+
+TEST_F(LevelDbTargetCacheTest, GetTargetFindsTargetsAcrossRestarts) {
+  persistence_->Shutdown();
+  persistence_.reset();
+
+  Path dir = LevelDbDir();
+  Query query = testutil::Query("some/path");
+  TargetData target_data(query.ToTarget(), 5, 1234, QueryPurpose::Listen);
+
+  auto db1 = LevelDbPersistenceForTesting(dir);
+  db1->Run("add target data",
+           [&] { db1->target_cache()->AddTarget(target_data); });
+  db1->Shutdown();
+  db1.reset();
+
+  auto db2 = LevelDbPersistenceForTesting(dir);
+  db2->Run("get target data", [&] {
+    ASSERT_EQ(db2->target_cache()->GetTarget(query.ToTarget()), target_data);
+  });
+  db2->Shutdown();
+  db2.reset();
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -290,6 +290,29 @@ TEST_F(LevelDbTransactionTest, DeletingAheadOfAnIterator) {
   ASSERT_FALSE(it->Valid());
 }
 
+TEST_F(LevelDbTransactionTest, ChangedBytesTracksPendingChanges) {
+  LevelDbTransaction transaction(db_.get(), "ChangedBytesTracksPendingChanges");
+  ASSERT_EQ(0u, transaction.changed_bytes());
+
+  transaction.Put("key1", "value");
+  ASSERT_EQ(9u, transaction.changed_bytes());
+
+  // Overwriting a pending mutation replaces its value.
+  transaction.Put("key1", "v");
+  ASSERT_EQ(5u, transaction.changed_bytes());
+
+  // Deleting a pending mutation replaces it with a deletion of its key.
+  transaction.Delete("key1");
+  ASSERT_EQ(4u, transaction.changed_bytes());
+
+  transaction.Delete("key1");
+  ASSERT_EQ(4u, transaction.changed_bytes());
+
+  transaction.Put("key1", "value");
+  transaction.Put("key2", "");
+  ASSERT_EQ(13u, transaction.changed_bytes());
+}
+
 TEST_F(LevelDbTransactionTest, ToString) {
   std::string key = LevelDbMutationKey::Key("user1", 42);
   Message<firestore_client_WriteBatch> message;
@@ -0,0 +1,143 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/local/local_aggregation.h"
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "Firestore/core/src/core/query.h"
+#include "Firestore/core/src/model/aggregate_alias.h"
+#include "Firestore/core/src/model/document.h"
+#include "Firestore/core/src/model/mutable_document.h"
+#include "Firestore/core/src/model/value_util.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+namespace {
+
+using model::AggregateAlias;
+using model::AggregateField;
+using model::DocumentMap;
+using model::MutableDocument;
+using model::ObjectValue;
+using testutil::Doc;
+using testutil::Field;
+using testutil::Filter;
+using testutil::Map;
+using testutil::OrderBy;
+using testutil::Value;
+
+DocumentMap Docs(const std::vector<MutableDocument>& docs) {
+  DocumentMap result;
+  for (const MutableDocument& doc : docs) {
+    result = result.insert(doc.key(), doc);
+  }
+  return result;
+}
+
+std::vector<AggregateField> CountSumAverage(const char* field) {
+  std::vector<AggregateField> aggregates;
+  aggregates.emplace_back(AggregateField::OpKind::Count,
+                          AggregateAlias("count"));
+  aggregates.emplace_back(AggregateField::OpKind::Sum, AggregateAlias("sum"),
+                          Field(field));
+  aggregates.emplace_back(AggregateField::OpKind::Avg, AggregateAlias("avg"),
+                          Field(field));
+  return aggregates;
+}
+
+}  // namespace
+
+TEST(LocalAggregationTest, AggregatesMatchingDocuments) {
+  DocumentMap docs = Docs({Doc("coll/a", 1, Map("n", 1, "match", true)),
+                           Doc("coll/b", 1, Map("n", 2, "match", true)),
+                           Doc("coll/c", 1, Map("n", 100, "match", false)),
+                           Doc("other/d", 1, Map("n", 100, "match", true))});
+  core::Query query =
+      testutil::Query("coll").AddingFilter(Filter("match", "==", true));
+
+  ObjectValue result = ComputeAggregates(query, CountSumAverage("n"), docs);
+  EXPECT_EQ(*result.Get("count"), *Value(2));
+  EXPECT_EQ(*result.Get("sum"), *Value(3));
+  EXPECT_EQ(*result.Get("avg"), *Value(1.5));
+}
+
+TEST(LocalAggregationTest, IgnoresNonNumericValues) {
+  DocumentMap docs = Docs({Doc("coll/a", 1, Map("n", 1)),
+                           Doc("coll/b", 1, Map("n", "two")),
+                           Doc("coll/c", 1, Map("m", 3))});
+
+  ObjectValue result =
+      ComputeAggregates(testutil::Query("coll"), CountSumAverage("n"), docs);
+  EXPECT_EQ(*result.Get("count"), *Value(3));
+  EXPECT_EQ(*result.Get("sum"), *Value(1));
+  EXPECT_EQ(*result.Get("avg"), *Value(1.0));
+}
+
+TEST(LocalAggregationTest, EmptyResult) {
+  ObjectValue result = ComputeAggregates(testutil::Query("coll"),
+                                         CountSumAverage("n"), DocumentMap{});
+  EXPECT_EQ(*result.Get("count"), *Value(0));
+  EXPECT_EQ(*result.Get("sum"), *Value(0));
+  EXPECT_TRUE(model::IsNullValue(*result.Get("avg")));
+}
+
+TEST(LocalAggregationTest, SumOfDoublesIsDouble) {
+  DocumentMap docs =
+      Docs({Doc("coll/a", 1, Map("n", 1)), Doc("coll/b", 1, Map("n", 0.5))});
+
+  ObjectValue result =
+      ComputeAggregates(testutil::Query("coll"), CountSumAverage("n"), docs);
+  EXPECT_EQ(*result.Get("sum"), *Value(1.5));
+  EXPECT_EQ(*result.Get("avg"), *Value(0.75));
+}
+
+TEST(LocalAggregationTest, IntegerOverflowProducesDouble) {
+  int64_t max = std::numeric_limits<int64_t>::max();
+  DocumentMap docs =
+      Docs({Doc("coll/a", 1, Map("n", max)), Doc("coll/b", 1, Map("n", 1))});
+
+  ObjectValue result =
+      ComputeAggregates(testutil::Query("coll"), CountSumAverage("n"), docs);
+  EXPECT_TRUE(model::IsDouble(result.Get("sum")));
+}
+
+TEST(LocalAggregationTest, AppliesLimits) {
+  DocumentMap docs = Docs({Doc("coll/a", 1, Map("n", 1)),
+                           Doc("coll/b", 1, Map("n", 2)),
+                           Doc("coll/c", 1, Map("n", 3))});
+  core::Query query = testutil::Query("coll").AddingOrderBy(OrderBy("n"));
+
+  ObjectValue first = ComputeAggregates(query.WithLimitToFirst(2),
+                                        CountSumAverage("n"), docs);
+  EXPECT_EQ(*first.Get("count"), *Value(2));
+  EXPECT_EQ(*first.Get("sum"), *Value(3));
+
+  ObjectValue last = ComputeAggregates(query.WithLimitToLast(2),
+                                       CountSumAverage("n"), docs);
+  EXPECT_EQ(*last.Get("count"), *Value(2));
+  EXPECT_EQ(*last.Get("sum"), *Value(5));
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
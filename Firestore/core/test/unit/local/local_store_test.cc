@@ -338,6 +338,27 @@ TEST_P(LocalStoreTest, HandlesSetMutation) {
   }
 }
 
+TEST_P(LocalStoreTest, WritesSeveralBatchesInOneTransaction) {
+  std::vector<std::vector<Mutation>> batches;
+  batches.push_back({testutil::SetMutation("foo/bar", Map("foo", "bar"))});
+  batches.push_back({testutil::PatchMutation("foo/bar", Map("baz", 1))});
+  std::vector<LocalWriteResult> results =
+      local_store_.WriteLocally(std::move(batches));
+
+  // Each batch is added to the queue on its own, and later batches are applied
+  // on top of the earlier ones.
+  ASSERT_EQ(results.size(), 2u);
+  EXPECT_LT(results[0].batch_id(), results[1].batch_id());
+  EXPECT_EQ(local_store_.GetHighestUnacknowledgedBatchId(),
+            results[1].batch_id());
+
+  last_changes_ = results[1].changes();
+  FSTAssertChanged(
+      Doc("foo/bar", 0, Map("foo", "bar", "baz", 1)).SetHasLocalMutations());
+  FSTAssertContains(
+      Doc("foo/bar", 0, Map("foo", "bar", "baz", 1)).SetHasLocalMutations());
+}
+
 TEST_P(LocalStoreTest, HandlesSetMutationThenDocument) {
   WriteMutation(testutil::SetMutation("foo/bar", Map("foo", "bar")));
   FSTAssertChanged(Doc("foo/bar", 0, Map("foo", "bar")).SetHasLocalMutations());
@@ -924,6 +945,29 @@ TEST_P(LocalStoreTest, CanExecuteMixedCollectionQueries) {
           Document{Doc("foo/bonk", 0, Map("a", "b")).SetHasLocalMutations()}));
 }
 
+TEST_P(LocalStoreTest, RunsAggregateQueriesAgainstCache) {
+  core::Query query = Query("foo");
+  AllocateQuery(query);
+  FSTAssertTargetID(2);
+
+  ApplyRemoteEvent(UpdateRemoteEvent(Doc("foo/bar", 10, Map("n", 1)), {2}, {}));
+  ApplyRemoteEvent(UpdateRemoteEvent(Doc("foo/baz", 20, Map("n", 2)), {2}, {}));
+  WriteMutation(testutil::SetMutation("foo/bonk", Map("n", 6)));
+
+  std::vector<model::AggregateField> aggregates;
+  aggregates.emplace_back(model::AggregateField::OpKind::Count,
+                          model::AggregateAlias("count"));
+  aggregates.emplace_back(model::AggregateField::OpKind::Sum,
+                          model::AggregateAlias("sum"), testutil::Field("n"));
+  aggregates.emplace_back(model::AggregateField::OpKind::Avg,
+                          model::AggregateAlias("avg"), testutil::Field("n"));
+
+  model::ObjectValue result = local_store_.RunAggregateQuery(query, aggregates);
+  EXPECT_EQ(*result.Get("count"), *Value(3));
+  EXPECT_EQ(*result.Get("sum"), *Value(9));
+  EXPECT_EQ(*result.Get("avg"), *Value(3.0));
+}
+
 TEST_P(LocalStoreTest, ReadsAllDocumentsForInitialCollectionQueries) {
   core::Query query = Query("foo");
   local_store_.AllocateTarget(query.ToTarget());
@@ -1398,6 +1442,22 @@ TEST_P(LocalStoreTest, HandlesSavingBundledDocuments) {
   FSTAssertQueryDocumentMapping(2, expected_keys);
 }
 
+TEST_P(LocalStoreTest, HandlesSavingBundledDocumentsInChunks) {
+  last_changes_ = local_store_.ApplyBundledDocumentChunk(
+      DocVectorToMap({Doc("foo/bar", 1, Map("sum", 1337))}));
+  FSTAssertChanged(Doc("foo/bar", 1, Map("sum", 1337)));
+
+  last_changes_ = local_store_.ApplyBundledDocumentChunk(
+      DocVectorToMap({DeletedDoc("foo/bar1", 1)}));
+  FSTAssertChanged(DeletedDoc("foo/bar1", 1));
+  FSTAssertContains(Doc("foo/bar", 1, Map("sum", 1337)));
+  FSTAssertContains(DeletedDoc("foo/bar1", 1));
+
+  local_store_.SaveBundledDocumentKeys(DocumentKeySet{Key("foo/bar")}, "");
+  DocumentKeySet expected_keys({Key("foo/bar")});
+  FSTAssertQueryDocumentMapping(2, expected_keys);
+}
+
 TEST_P(LocalStoreTest, HandlesSavingBundledDocumentsWithNewerExistingVersion) {
   core::Query query = Query("foo");
   AllocateQuery(query);
@@ -766,6 +766,106 @@ TEST_P(LruGarbageCollectorTest, GCRan) {
   ASSERT_EQ(100, results.documents_removed);
 }
 
+TEST_P(LruGarbageCollectorTest, GCRecordsStats) {
+  LruParams params = LruParams::Default();
+  params.min_bytes_threshold = 100;
+  NewTestResources(params);
+
+  for (int i = 0; i < 10; i++) {
+    persistence_->Run("Add a target and a document", [&] {
+      TargetData target_data = AddNextQueryInTransaction();
+      MutableDocument doc = CacheADocumentInTransaction();
+      AddDocument(doc.key(), target_data.target_id());
+    });
+  }
+
+  persistence_->Run("GC", [&] { return gc_->Collect({}); });
+
+  const LruStats& stats = gc_->stats();
+  ASSERT_EQ(1, stats.passes_completed);
+  ASSERT_FALSE(stats.pass_in_progress);
+  ASSERT_GE(stats.byte_size, params.min_bytes_threshold);
+  ASSERT_EQ(3u, stats.slices.size());
+  ASSERT_EQ(LruSliceStats::Stage::kPlanning, stats.slices[0].stage);
+  ASSERT_EQ(LruSliceStats::Stage::kRemovingTargets, stats.slices[1].stage);
+  ASSERT_EQ(1, stats.slices[1].targets_removed);
+  ASSERT_EQ(LruSliceStats::Stage::kRemovingDocuments, stats.slices[2].stage);
+  ASSERT_EQ(1, stats.slices[2].documents_removed);
+}
+
+TEST_P(LruGarbageCollectorTest, CollectSliceDisabled) {
+  NewTestResources(LruParams::Disabled());
+
+  persistence_->Run("fill cache", [&] {
+    for (int i = 0; i < 50; i++) {
+      MutableDocument doc = CacheADocumentInTransaction();
+      MarkDocumentEligibleForGcInTransaction(doc.key());
+    }
+  });
+
+  LruResults results =
+      persistence_->Run("GC", [&] { return gc_->CollectSlice({}); });
+  ASSERT_FALSE(results.did_run);
+  ASSERT_FALSE(gc_->pass_in_progress());
+}
+
+TEST_P(LruGarbageCollectorTest, GCRunsInSlices) {
+  LruParams params = LruParams::Default();
+  params.min_bytes_threshold = 100;
+  params.maximum_removals_per_slice = 25;
+  NewTestResources(params);
+
+  // Add 100 targets and 10 documents to each.
+  for (int i = 0; i < 100; i++) {
+    persistence_->Run("Add a target and some documents", [&] {
+      TargetData target_data = AddNextQueryInTransaction();
+      for (int j = 0; j < 10; j++) {
+        MutableDocument doc = CacheADocumentInTransaction();
+        AddDocument(doc.key(), target_data.target_id());
+      }
+    });
+  }
+
+  // The first slice only plans the pass.
+  LruResults planned =
+      persistence_->Run("GC", [&] { return gc_->CollectSlice({}); });
+  ASSERT_TRUE(planned.did_run);
+  ASSERT_EQ(10, planned.sequence_numbers_collected);
+  ASSERT_EQ(0, planned.targets_removed);
+  ASSERT_EQ(0, planned.documents_removed);
+  ASSERT_TRUE(gc_->pass_in_progress());
+
+  // Each following slice, run in its own transaction, removes at most 25
+  // targets and documents until the pass has collected the same 10 targets
+  // and 100 documents as a full pass would.
+  int targets_removed = 0;
+  int documents_removed = 0;
+  int slices = 0;
+  while (gc_->pass_in_progress()) {
+    LruResults results =
+        persistence_->Run("GC", [&] { return gc_->CollectSlice({}); });
+    ASSERT_TRUE(results.did_run);
+    ASSERT_LE(results.targets_removed + results.documents_removed, 25);
+    targets_removed += results.targets_removed;
+    documents_removed += results.documents_removed;
+    ASSERT_LT(++slices, 10) << "Garbage collection did not make progress";
+  }
+  ASSERT_EQ(10, targets_removed);
+  ASSERT_EQ(100, documents_removed);
+  ASSERT_GE(slices, 5);
+
+  const LruStats& stats = gc_->stats();
+  ASSERT_EQ(1, stats.passes_completed);
+  ASSERT_EQ(static_cast<size_t>(slices + 1), stats.slices.size());
+  ASSERT_EQ(LruSliceStats::Stage::kPlanning, stats.slices.front().stage);
+  ASSERT_EQ(LruSliceStats::Stage::kRemovingDocuments,
+            stats.slices.back().stage);
+
+  // With the pass complete, the next slice plans a new one.
+  persistence_->Run("GC", [&] { return gc_->CollectSlice({}); });
+  ASSERT_TRUE(gc_->pass_in_progress());
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -16,10 +16,20 @@
 
 #include "Firestore/core/test/unit/local/index_manager_test.h"
 
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/core/query.h"
+#include "Firestore/core/src/credentials/user.h"
 #include "Firestore/core/src/local/memory_index_manager.h"
 #include "Firestore/core/src/local/memory_persistence.h"
 #include "Firestore/core/src/local/reference_delegate.h"
+#include "Firestore/core/src/model/document_set.h"
+#include "Firestore/core/src/model/field_index.h"
 #include "Firestore/core/test/unit/local/persistence_testing.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
 #include "absl/memory/memory.h"
 #include "gtest/gtest.h"
 
@@ -29,6 +39,22 @@ namespace local {
 
 namespace {
 
+using credentials::User;
+using model::DocumentKey;
+using model::FieldIndex;
+using model::IndexOffset;
+using model::Segment;
+using testutil::Array;
+using testutil::DeletedDoc;
+using testutil::Doc;
+using testutil::Filter;
+using testutil::Key;
+using testutil::MakeFieldIndex;
+using testutil::Map;
+using testutil::OrderBy;
+using testutil::OrFilters;
+using testutil::Query;
+
 std::unique_ptr<Persistence> PersistenceFactory() {
   return MemoryPersistenceWithEagerGcForTesting();
 }
@@ -39,6 +65,210 @@ INSTANTIATE_TEST_SUITE_P(MemoryIndexManagerTest,
                          IndexManagerTest,
                          ::testing::Values(PersistenceFactory));
 
+class MemoryIndexManagerTest : public ::testing::Test {
+ public:
+  MemoryIndexManagerTest() : persistence_{PersistenceFactory()} {
+    index_manager_ = persistence_->GetIndexManager(User::Unauthenticated());
+    index_manager_->Start();
+  }
+
+  void AddDocs(IndexManager* index_manager,
+               const std::vector<model::MutableDocument>& docs) const {
+    model::DocumentMap map;
+    for (const auto& doc : docs) {
+      map = map.insert(doc.key(), doc);
+    }
+    index_manager->UpdateIndexEntries(std::move(map));
+  }
+
+  void AddDoc(const std::string& key,
+              nanopb::Message<google_firestore_v1_Value> data) const {
+    AddDocs(index_manager_, {Doc(key, 1, std::move(data))});
+  }
+
+  void VerifyResults(IndexManager* index_manager,
+                     const core::Query& query,
+                     const std::vector<std::string>& documents) const {
+    absl::optional<std::vector<DocumentKey>> results =
+        index_manager->GetDocumentsMatchingTarget(query.ToTarget());
+    ASSERT_TRUE(results.has_value()) << "Target cannot be served from index.";
+    std::vector<DocumentKey> expected;
+    for (const auto& key : documents) {
+      expected.push_back(Key(key));
+    }
+    EXPECT_EQ(expected, results.value())
+        << "Query returned unexpected documents.";
+  }
+
+  void VerifyResults(const core::Query& query,
+                     const std::vector<std::string>& documents) const {
+    VerifyResults(index_manager_, query, documents);
+  }
+
+  std::unique_ptr<Persistence> persistence_;
+  IndexManager* index_manager_;
+};
+
+TEST_F(MemoryIndexManagerTest, ServesFiltersFromIndex) {
+  index_manager_->AddFieldIndex(
+      MakeFieldIndex("coll", "count", Segment::kAscending));
+  AddDoc("coll/val1", Map("count", 1));
+  AddDoc("coll/val2", Map("count", 2));
+  AddDoc("coll/val3", Map("count", 3));
+  AddDoc("coll/val4", Map("other", 4));
+
+  VerifyResults(Query("coll").AddingFilter(Filter("count", "==", 2)),
+                {"coll/val2"});
+  VerifyResults(Query("coll").AddingFilter(Filter("count", ">", 1)),
+                {"coll/val2", "coll/val3"});
+  VerifyResults(Query("coll").AddingFilter(Filter("count", "in", Array(1, 3))),
+                {"coll/val1", "coll/val3"});
+  VerifyResults(
+      Query("coll").AddingFilter(Filter("count", "not-in", Array(1, 2))),
+      {"coll/val3"});
+  VerifyResults(
+      Query("coll").AddingOrderBy(OrderBy("count")).WithLimitToFirst(2),
+      {"coll/val1", "coll/val2"});
+}
+
+TEST_F(MemoryIndexManagerTest, OrdersEntriesByValueAndKey) {
+  index_manager_->AddFieldIndex(
+      MakeFieldIndex("coll", "count", Segment::kAscending));
+  index_manager_->AddFieldIndex(
+      MakeFieldIndex("coll", "count", Segment::kDescending));
+  AddDoc("coll/val1", Map("count", 1));
+  AddDoc("coll/val2", Map("count", 1));
+  AddDoc("coll/val3", Map("count", 3));
+
+  VerifyResults(Query("coll").AddingOrderBy(OrderBy("count")),
+                {"coll/val1", "coll/val2", "coll/val3"});
+  VerifyResults(Query("coll").AddingOrderBy(OrderBy("count", "desc")),
+                {"coll/val3", "coll/val2", "coll/val1"});
+}
+
+TEST_F(MemoryIndexManagerTest, ServesArrayContainsFromIndex) {
+  index_manager_->AddFieldIndex(
+      MakeFieldIndex("coll", "values", Segment::kContains));
+  AddDoc("coll/arr1", Map("values", Array(1, 2, 3)));
+  AddDoc("coll/arr2", Map("values", Array(3, 4)));
+  AddDoc("coll/arr3", Map("values", 3));
+
+  VerifyResults(
+      Query("coll").AddingFilter(Filter("values", "array-contains", 3)),
+      {"coll/arr1", "coll/arr2"});
+  VerifyResults(Query("coll").AddingFilter(
+                    Filter("values", "array-contains-any", Array(1, 4))),
+                {"coll/arr1", "coll/arr2"});
+}
+
+TEST_F(MemoryIndexManagerTest, UpdatesEntriesWhenDocumentsChange) {
+  index_manager_->AddFieldIndex(
+      MakeFieldIndex("coll", "value", Segment::kAscending));
+  auto query = Query("coll").AddingOrderBy(OrderBy("value"));
+
+  AddDoc("coll/doc1", Map("value", 1));
+  AddDoc("coll/doc2", Map("value", 2));
+  VerifyResults(query, {"coll/doc1", "coll/doc2"});
+
+  AddDoc("coll/doc1", Map("value", 3));
+  VerifyResults(query, {"coll/doc2", "coll/doc1"});
+
+  AddDocs(index_manager_,
+          {Doc("coll/doc1", 2, Map()), DeletedDoc("coll/doc2")});
+  VerifyResults(query, {});
+}
+
+TEST_F(MemoryIndexManagerTest, ScansIndexInTargetOrder) {
+  index_manager_->AddFieldIndex(
+      MakeFieldIndex("coll", "a", Segment::kAscending));
+  index_manager_->AddFieldIndex(
+      MakeFieldIndex("coll", "b", Segment::kAscending));
+  AddDoc("coll/doc1", Map("a", 3, "b", 0));
+  AddDoc("coll/doc2", Map("a", 1, "b", 1));
+  AddDoc("coll/doc3", Map("a", 2, "b", 0));
+
+  auto query = Query("coll").AddingFilter(Filter("a", ">", 1));
+  auto cursors = index_manager_->ScanDocumentsMatchingTarget(query.ToTarget());
+  ASSERT_TRUE(cursors.has_value());
+  ASSERT_EQ(cursors->size(), 1u);
+
+  std::vector<DocumentKey> keys;
+  for (auto& cursor = cursors->front(); cursor->Valid(); cursor->Next()) {
+    keys.push_back(cursor->key());
+  }
+  EXPECT_EQ(keys,
+            std::vector<DocumentKey>({Key("coll/doc3"), Key("coll/doc1")}));
+
+  auto or_query = Query("coll").AddingFilter(
+      OrFilters({Filter("a", "==", 1), Filter("b", "==", 0)}));
+  cursors = index_manager_->ScanDocumentsMatchingTarget(or_query.ToTarget());
+  ASSERT_TRUE(cursors.has_value());
+  EXPECT_EQ(cursors->size(), 2u);
+}
+
+TEST_F(MemoryIndexManagerTest, CreatesTargetIndexes) {
+  auto query = Query("coll").AddingFilter(Filter("a", "==", 1));
+  EXPECT_EQ(index_manager_->GetIndexType(query.ToTarget()),
+            IndexManager::IndexType::NONE);
+
+  index_manager_->CreateTargetIndexes(query.ToTarget());
+  EXPECT_EQ(index_manager_->GetIndexType(query.ToTarget()),
+            IndexManager::IndexType::FULL);
+  EXPECT_EQ(index_manager_->GetFieldIndexes("coll").size(), 1u);
+}
+
+TEST_F(MemoryIndexManagerTest, TracksIndexStatesPerUser) {
+  index_manager_->AddFieldIndex(MakeFieldIndex("coll1"));
+  index_manager_->AddFieldIndex(MakeFieldIndex("coll2"));
+  EXPECT_EQ(index_manager_->GetNextCollectionGroupToUpdate(), "coll1");
+
+  IndexOffset offset{testutil::Version(20), Key("coll1/doc"), 42};
+  index_manager_->UpdateCollectionGroup("coll1", offset);
+  EXPECT_EQ(index_manager_->GetNextCollectionGroupToUpdate(), "coll2");
+  EXPECT_EQ(index_manager_->GetMinOffset("coll1"), offset);
+
+  // Another user sees the same indexes, but not the state of the first one.
+  IndexManager* other = persistence_->GetIndexManager(User("other"));
+  other->Start();
+  std::vector<FieldIndex> indexes = other->GetFieldIndexes("coll1");
+  ASSERT_EQ(indexes.size(), 1u);
+  EXPECT_EQ(indexes[0].index_state(), FieldIndex::InitialState());
+  EXPECT_EQ(other->GetNextCollectionGroupToUpdate(), "coll1");
+}
+
+TEST_F(MemoryIndexManagerTest, KeepsIndexEntriesPerUser) {
+  index_manager_->AddFieldIndex(
+      MakeFieldIndex("coll", "value", Segment::kAscending));
+  AddDoc("coll/doc1", Map("value", 1));
+
+  IndexManager* other = persistence_->GetIndexManager(User("other"));
+  other->Start();
+  AddDocs(other, {Doc("coll/doc2", 1, Map("value", 2))});
+
+  auto query = Query("coll").AddingOrderBy(OrderBy("value"));
+  VerifyResults(index_manager_, query, {"coll/doc1"});
+  VerifyResults(other, query, {"coll/doc2"});
+}
+
+TEST_F(MemoryIndexManagerTest, DeletingIndexRemovesEntriesOfAllUsers) {
+  index_manager_->AddFieldIndex(
+      MakeFieldIndex("coll", "value", Segment::kAscending));
+  AddDoc("coll/doc1", Map("value", 1));
+
+  IndexManager* other = persistence_->GetIndexManager(User("other"));
+  other->Start();
+  AddDocs(other, {Doc("coll/doc2", 1, Map("value", 2))});
+
+  index_manager_->DeleteFieldIndex(index_manager_->GetFieldIndexes("coll")[0]);
+  EXPECT_TRUE(other->GetFieldIndexes("coll").empty());
+
+  // A new index may reuse the id of the deleted one, but none of its entries.
+  other->AddFieldIndex(MakeFieldIndex("coll", "value", Segment::kAscending));
+  auto query = Query("coll").AddingOrderBy(OrderBy("value"));
+  VerifyResults(index_manager_, query, {});
+  VerifyResults(other, query, {});
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -346,6 +346,36 @@ TEST_P(MutationQueueTest, AllMutationBatchesAffectingQuery) {
   });
 }
 
+TEST_P(MutationQueueTest, AllMutationBatchesAffectingQueryWithMultipleWrites) {
+  persistence_->Run("AllMutationBatchesAffectingQueryWithMultipleWrites", [&] {
+    MutationBatch batch1 = mutation_queue_->AddMutationBatch(
+        Timestamp::Now(), {},
+        {testutil::SetMutation("foo/bar", Map("a", 1)),
+         testutil::SetMutation("foo/baz", Map("a", 1))});
+    MutationBatch batch2 = mutation_queue_->AddMutationBatch(
+        Timestamp::Now(), {},
+        {testutil::SetMutation("foo/bar/suffix/key", Map("a", 1))});
+    MutationBatch batch3 = mutation_queue_->AddMutationBatch(
+        Timestamp::Now(), {},
+        {testutil::SetMutation("foo/baz", Map("b", 1)),
+         testutil::SetMutation("foo/bar/suffix/key", Map("b", 1))});
+
+    std::vector<MutationBatch> expected = {batch1, batch3};
+    EXPECT_EQ(mutation_queue_->AllMutationBatchesAffectingQuery(Query("foo")),
+              expected);
+
+    mutation_queue_->RemoveMutationBatch(batch1);
+    expected = {batch3};
+    EXPECT_EQ(mutation_queue_->AllMutationBatchesAffectingQuery(Query("foo")),
+              expected);
+
+    expected = {batch2, batch3};
+    EXPECT_EQ(mutation_queue_->AllMutationBatchesAffectingQuery(
+                  Query("foo/bar/suffix")),
+              expected);
+  });
+}
+
 TEST_P(MutationQueueTest, RemoveMutationBatches) {
   persistence_->Run("RemoveMutationBatches", [&] {
     std::vector<MutationBatch> batches = CreateBatches(10);
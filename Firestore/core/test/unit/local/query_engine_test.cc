@@ -20,6 +20,8 @@
 
 #include <functional>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "Firestore/core/src/core/field_filter.h"
 #include "Firestore/core/src/core/view.h"
@@ -27,6 +29,7 @@
 #include "Firestore/core/src/local/memory_index_manager.h"
 #include "Firestore/core/src/local/memory_persistence.h"
 #include "Firestore/core/src/local/persistence.h"
+#include "Firestore/core/src/local/query_planner.h"
 #include "Firestore/core/src/local/remote_document_cache.h"
 #include "Firestore/core/src/local/target_cache.h"
 #include "Firestore/core/src/model/delete_mutation.h"
@@ -977,6 +980,91 @@ TEST_P(QueryEngineTest, InAndNotInFiltersWithObjectValues) {
   });
 }
 
+TEST_P(QueryEngineTest, ExplainsFullCollectionScan) {
+  persistence_->Run("ExplainsFullCollectionScan", [&] {
+    mutation_queue_->Start();
+    index_manager_->Start();
+
+    core::Query query =
+        Query("coll").AddingFilter(Filter("matches", "==", true));
+    AddDocuments(
+        {kMatchingDocA, Doc("coll/c", 1, Map("matches", false, "order", 3))});
+
+    QueryPlan plan;
+    ExpectFullCollectionScan<DocumentMap>([&] {
+      return query_engine_.GetDocumentsMatchingQuery(
+          query, kMissingLastLimboFreeSnapshot, DocumentKeySet(), &plan);
+    });
+
+    EXPECT_FALSE(plan.cost_based());
+    ASSERT_EQ(plan.candidates().size(), 1u);
+    EXPECT_EQ(plan.executed_strategy(), QueryPlanStrategy::kFullCollectionScan);
+    EXPECT_EQ(plan.result_count(), 1u);
+  });
+}
+
+TEST_P(QueryEngineTest, ExplainsRemoteKeyLookup) {
+  persistence_->Run("ExplainsRemoteKeyLookup", [&] {
+    mutation_queue_->Start();
+    index_manager_->Start();
+
+    core::Query query =
+        Query("coll").AddingFilter(Filter("matches", "==", true));
+    AddDocuments({kMatchingDocA, kMatchingDocB});
+    PersistQueryMapping({kMatchingDocA.key(), kMatchingDocB.key()});
+
+    QueryPlan plan;
+    ExpectOptimizedCollectionScan([&] {
+      DocumentKeySet remote_keys =
+          target_cache_->GetMatchingKeys(kTestTargetId);
+      query_engine_.GetDocumentsMatchingQuery(query, kLastLimboFreeSnapshot,
+                                              remote_keys, &plan);
+      return DocumentSet(query.Comparator());
+    });
+
+    EXPECT_EQ(plan.candidates().front().strategy,
+              QueryPlanStrategy::kRemoteKeys);
+    EXPECT_EQ(plan.executed_strategy(), QueryPlanStrategy::kRemoteKeys);
+    EXPECT_EQ(plan.result_count(), 2u);
+    EXPECT_GE(plan.documents_read(), 2u);
+  });
+}
+
+TEST_P(QueryEngineTest, PlannerPrefersCollectionScanOverLargeTargetMapping) {
+  persistence_->Run("PlannerPrefersCollectionScanOverLargeTargetMapping", [&] {
+    mutation_queue_->Start();
+    index_manager_->Start();
+
+    core::Query query =
+        Query("coll").AddingFilter(Filter("matches", "==", true));
+
+    std::vector<MutableDocument> docs;
+    std::vector<DocumentKey> keys;
+    for (int i = 0; i < 200; ++i) {
+      docs.push_back(Doc("coll/" + std::to_string(i), 1,
+                         Map("matches", true, "order", i)));
+      keys.push_back(docs.back().key());
+    }
+    AddDocuments(docs);
+
+    // An initial scan provides the collection statistics to the planner.
+    ExpectFullCollectionScan<DocumentSet>(
+        [&] { return RunQuery(query, kMissingLastLimboFreeSnapshot); });
+
+    PersistQueryMapping(keys);
+
+    QueryPlan plan;
+    DocumentKeySet remote_keys = target_cache_->GetMatchingKeys(kTestTargetId);
+    DocumentMap result = query_engine_.GetDocumentsMatchingQuery(
+        query, kLastLimboFreeSnapshot, remote_keys, &plan);
+
+    EXPECT_TRUE(plan.cost_based());
+    EXPECT_EQ(plan.executed_strategy(), QueryPlanStrategy::kFullCollectionScan);
+    EXPECT_EQ(plan.result_count(), 200u);
+    EXPECT_EQ(result.size(), 200u);
+  });
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -0,0 +1,183 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/local/query_planner.h"
+
+#include <vector>
+
+#include "Firestore/core/src/core/query.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+namespace {
+
+using testutil::Filter;
+
+std::vector<QueryPlanStrategy> Strategies(const QueryPlan& plan) {
+  std::vector<QueryPlanStrategy> result;
+  for (const QueryPlanCandidate& candidate : plan.candidates()) {
+    result.push_back(candidate.strategy);
+  }
+  return result;
+}
+
+core::Query FilteredQuery() {
+  return testutil::Query("coll").AddingFilter(Filter("a", "==", 1));
+}
+
+}  // namespace
+
+TEST(QueryPlannerTest, UnfilteredQueryOnlyScansCollection) {
+  QueryPlanner planner;
+  QueryPlanInputs inputs;
+  inputs.index_type = IndexManager::IndexType::FULL;
+  inputs.remote_keys_available = true;
+  inputs.remote_key_count = 1;
+  inputs.collection_size = 1000;
+
+  QueryPlan plan = planner.Plan(testutil::Query("coll"), inputs);
+  EXPECT_THAT(Strategies(plan),
+              testing::ElementsAre(QueryPlanStrategy::kFullCollectionScan));
+}
+
+TEST(QueryPlannerTest, UsesFixedOrderWithoutStatistics) {
+  QueryPlanner planner;
+  QueryPlanInputs inputs;
+  inputs.index_type = IndexManager::IndexType::PARTIAL;
+  inputs.remote_keys_available = true;
+  inputs.remote_key_count = 5000;
+
+  QueryPlan plan = planner.Plan(FilteredQuery(), inputs);
+  EXPECT_FALSE(plan.cost_based());
+  EXPECT_THAT(Strategies(plan),
+              testing::ElementsAre(QueryPlanStrategy::kIndex,
+                                   QueryPlanStrategy::kRemoteKeys,
+                                   QueryPlanStrategy::kFullCollectionScan));
+  EXPECT_FALSE(plan.candidates()[2].estimated_cost.has_value());
+}
+
+TEST(QueryPlannerTest, UsesFixedOrderForSmallCollections) {
+  QueryPlanner planner;
+  QueryPlanInputs inputs;
+  inputs.remote_keys_available = true;
+  inputs.remote_key_count = 50;
+  inputs.collection_size = 50;
+
+  QueryPlan plan = planner.Plan(FilteredQuery(), inputs);
+  EXPECT_FALSE(plan.cost_based());
+  EXPECT_THAT(Strategies(plan),
+              testing::ElementsAre(QueryPlanStrategy::kRemoteKeys,
+                                   QueryPlanStrategy::kFullCollectionScan));
+}
+
+TEST(QueryPlannerTest, PrefersRemoteKeysWhenFewKeysMatched) {
+  QueryPlanner planner;
+  QueryPlanInputs inputs;
+  inputs.remote_keys_available = true;
+  inputs.remote_key_count = 10;
+  inputs.collection_size = 1000;
+
+  QueryPlan plan = planner.Plan(FilteredQuery(), inputs);
+  EXPECT_TRUE(plan.cost_based());
+  EXPECT_THAT(Strategies(plan),
+              testing::ElementsAre(QueryPlanStrategy::kRemoteKeys,
+                                   QueryPlanStrategy::kFullCollectionScan));
+  EXPECT_EQ(plan.candidates()[0].estimated_cost, 20.0);
+  EXPECT_EQ(plan.candidates()[1].estimated_cost, 1000.0);
+}
+
+TEST(QueryPlannerTest, PrefersCollectionScanWhenMostKeysMatched) {
+  QueryPlanner planner;
+  QueryPlanInputs inputs;
+  inputs.remote_keys_available = true;
+  inputs.remote_key_count = 900;
+  inputs.collection_size = 1000;
+
+  QueryPlan plan = planner.Plan(FilteredQuery(), inputs);
+  EXPECT_TRUE(plan.cost_based());
+  EXPECT_THAT(Strategies(plan),
+              testing::ElementsAre(QueryPlanStrategy::kFullCollectionScan,
+                                   QueryPlanStrategy::kRemoteKeys));
+}
+
+TEST(QueryPlannerTest, UsesObservedIndexMatchCount) {
+  QueryPlanner planner;
+  QueryPlanInputs inputs;
+  inputs.index_type = IndexManager::IndexType::PARTIAL;
+  inputs.index_match_count = 800;
+  inputs.collection_size = 1000;
+
+  QueryPlan plan = planner.Plan(FilteredQuery(), inputs);
+  EXPECT_TRUE(plan.cost_based());
+  EXPECT_THAT(Strategies(plan),
+              testing::ElementsAre(QueryPlanStrategy::kFullCollectionScan,
+                                   QueryPlanStrategy::kIndex));
+  EXPECT_EQ(plan.candidates()[1].estimated_documents_read, 800.0);
+}
+
+TEST(QueryPlannerTest, EstimatesSelectivityOfFullIndex) {
+  QueryPlanner planner;
+  QueryPlanInputs inputs;
+  inputs.index_type = IndexManager::IndexType::FULL;
+  inputs.collection_size = 1000;
+
+  QueryPlan plan = planner.Plan(FilteredQuery(), inputs);
+  EXPECT_TRUE(plan.cost_based());
+  EXPECT_THAT(Strategies(plan),
+              testing::ElementsAre(QueryPlanStrategy::kIndex,
+                                   QueryPlanStrategy::kFullCollectionScan));
+  EXPECT_EQ(plan.candidates()[0].estimated_documents_read, 100.0);
+}
+
+TEST(QueryPlannerTest, RelativeIndexCostIsConfigurable) {
+  QueryPlanner planner;
+  planner.set_relative_index_read_cost_per_document(20);
+  QueryPlanInputs inputs;
+  inputs.index_type = IndexManager::IndexType::FULL;
+  inputs.collection_size = 1000;
+
+  QueryPlan plan = planner.Plan(FilteredQuery(), inputs);
+  EXPECT_THAT(Strategies(plan),
+              testing::ElementsAre(QueryPlanStrategy::kFullCollectionScan,
+                                   QueryPlanStrategy::kIndex));
+}
+
+TEST(QueryPlannerTest, DescribesPlan) {
+  QueryPlanner planner;
+  QueryPlanInputs inputs;
+  inputs.remote_keys_available = true;
+  inputs.remote_key_count = 10;
+  inputs.collection_size = 1000;
+
+  QueryPlan plan = planner.Plan(FilteredQuery(), inputs);
+  plan.RecordExecution(QueryPlanStrategy::kRemoteKeys, 10, 7);
+
+  EXPECT_EQ(plan.ToString(),
+            "QueryPlan(cost_based=true)\n"
+            "  1. REMOTE_KEYS estimated_documents_read=10 estimated_cost=20\n"
+            "  2. FULL_COLLECTION_SCAN estimated_documents_read=1000 "
+            "estimated_cost=1000\n"
+            "  executed: REMOTE_KEYS documents_read=10 result_count=7");
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -232,6 +232,48 @@ TEST_P(RemoteDocumentCacheTest, DocumentsMatchingQuerySinceReadTime) {
   });
 }
 
+TEST_P(RemoteDocumentCacheTest, GetAllForCollectionGroupSinceOffset) {
+  persistence_->Run("test_get_all_for_collection_group_since_offset", [&] {
+    SetTestDocument("a/1/coll/old", /* updateTime= */ 1, /* readTime= */ 11);
+    SetTestDocument("b/2/coll/current", /* updateTime= */ 2,
+                    /* readTime= */ 12);
+    SetTestDocument("b/2/coll/new", /* updateTime= */ 3, /* readTime= */ 13);
+    SetTestDocument("b/2/other/new", /* updateTime= */ 3, /* readTime= */ 13);
+
+    model::IndexOffset offset(Version(11), Key("a/1/coll/old"), -1);
+    MutableDocumentMap results = cache_->GetAll("coll", offset, 10);
+    std::vector<MutableDocument> docs = {
+        Doc("b/2/coll/current", 2, Map("a", 1, "b", 2)),
+        Doc("b/2/coll/new", 3, Map("a", 1, "b", 2)),
+    };
+    EXPECT_THAT(results, HasExactlyDocs(docs));
+
+    results = cache_->GetAll("coll", offset, 1);
+    docs = {Doc("b/2/coll/current", 2, Map("a", 1, "b", 2))};
+    EXPECT_THAT(results, HasExactlyDocs(docs));
+  });
+}
+
+TEST_P(RemoteDocumentCacheTest, GetAllForCollectionGroupInReadTimeOrder) {
+  persistence_->Run(
+      "test_get_all_for_collection_group_in_read_time_order", [&] {
+        SetTestDocument("a/1/coll/late", /* updateTime= */ 1,
+                        /* readTime= */ 13);
+        SetTestDocument("b/2/coll/early", /* updateTime= */ 2,
+                        /* readTime= */ 11);
+        SetTestDocument("c/3/coll/middle", /* updateTime= */ 3,
+                        /* readTime= */ 12);
+
+        MutableDocumentMap results =
+            cache_->GetAll("coll", model::IndexOffset::None(), 2);
+        std::vector<MutableDocument> docs = {
+            Doc("b/2/coll/early", 2, Map("a", 1, "b", 2)),
+            Doc("c/3/coll/middle", 3, Map("a", 1, "b", 2)),
+        };
+        EXPECT_THAT(results, HasExactlyDocs(docs));
+      });
+}
+
 TEST_P(RemoteDocumentCacheTest, DocumentsMatchingUsesReadTimeNotUpdateTime) {
   persistence_->Run(
       "test_documents_matching_query_uses_read_time_not_update_time", [&] {
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <string>
+
+#include "Firestore/core/src/model/object_value.h"
+#include "Firestore/core/src/nanopb/arena.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "benchmark/benchmark.h"
+
+using firebase::firestore::model::ObjectValue;
+using firebase::firestore::nanopb::Arena;
+using firebase::firestore::testutil::Array;
+using firebase::firestore::testutil::Field;
+using firebase::firestore::testutil::Map;
+
+// Builds an object with `range` fields, each holding a small nested map.
+static ObjectValue MakeObject(int64_t range) {
+  ObjectValue result;
+  for (int64_t i = 0; i < range; ++i) {
+    result.Set(Field("field" + std::to_string(i)),
+               Map("name", "some string value", "count", i, "tags",
+                   Array("a", "b", "c")));
+  }
+  return result;
+}
+
+static void BM_HeapCopy(benchmark::State& state) {
+  ObjectValue object = MakeObject(state.range(0));
+  for (auto _ : state) {
+    ObjectValue copy{object};
+    benchmark::DoNotOptimize(copy);
+  }
+}
+BENCHMARK(BM_HeapCopy)->Range(8, 1 << 10);
+
+static void BM_ArenaCopy(benchmark::State& state) {
+  ObjectValue object =
+      MakeObject(state.range(0)).CloneToArena(std::make_shared<Arena>());
+  for (auto _ : state) {
+    ObjectValue copy{object};
+    benchmark::DoNotOptimize(copy);
+  }
+}
+BENCHMARK(BM_ArenaCopy)->Range(8, 1 << 10);
+
+static void BM_CloneToArena(benchmark::State& state) {
+  ObjectValue object = MakeObject(state.range(0));
+  for (auto _ : state) {
+    ObjectValue copy = object.CloneToArena(std::make_shared<Arena>());
+    benchmark::DoNotOptimize(copy);
+  }
+}
+BENCHMARK(BM_CloneToArena)->Range(8, 1 << 10);
@@ -16,7 +16,11 @@
 
 #include "Firestore/core/src/model/object_value.h"
 
+#include <memory>
+#include <utility>
+
 #include "Firestore/core/src/model/value_util.h"
+#include "Firestore/core/src/nanopb/arena.h"
 #include "Firestore/core/src/remote/serializer.h"
 #include "Firestore/core/test/unit/testutil/testutil.h"
 #include "gtest/gtest.h"
@@ -33,6 +37,7 @@ namespace {
 using absl::nullopt;
 using testutil::DbId;
 using testutil::Field;
+using testutil::Array;
 using testutil::Map;
 using testutil::Value;
 using testutil::WrapObject;
@@ -335,6 +340,106 @@ TEST_F(ObjectValueTest, DoesNotRequireSortedInserts) {
   EXPECT_EQ(*Value(2), *object_value.Get(Field("nested.nested.c")));
 }
 
+TEST_F(ObjectValueTest, ClonesToArena) {
+  ObjectValue object_value =
+      WrapObject("a", Map("b", kFooString, "c", Array(1, "bar")), "d", 2);
+  auto arena = std::make_shared<nanopb::Arena>();
+
+  ObjectValue arena_value = object_value.CloneToArena(arena);
+  EXPECT_TRUE(arena_value.is_arena_backed());
+  EXPECT_FALSE(object_value.is_arena_backed());
+  EXPECT_EQ(object_value, arena_value);
+  EXPECT_EQ(arena->block_count(), 1u);
+}
+
+TEST_F(ObjectValueTest, ClonesEmptyKeysToArena) {
+  // Empty keys are encoded as null byte arrays.
+  ObjectValue object_value = WrapObject("", 1, "a", Map("", kFooString));
+  auto arena = std::make_shared<nanopb::Arena>();
+
+  ObjectValue arena_value = object_value.CloneToArena(arena);
+  EXPECT_TRUE(arena_value.is_arena_backed());
+  EXPECT_EQ(object_value, arena_value);
+}
+
+TEST_F(ObjectValueTest, CopiesShareArena) {
+  auto arena = std::make_shared<nanopb::Arena>();
+  ObjectValue arena_value =
+      WrapObject("a", Map("b", kFooString)).CloneToArena(arena);
+
+  ObjectValue copy{arena_value};
+  EXPECT_TRUE(copy.is_arena_backed());
+  EXPECT_EQ(arena_value, copy);
+  EXPECT_EQ(arena_value.Get().map_value.fields,
+            copy.Get().map_value.fields);
+}
+
+TEST_F(ObjectValueTest, CopiesOutliveArena) {
+  absl::optional<ObjectValue> copy;
+  {
+    auto arena = std::make_shared<nanopb::Arena>();
+    ObjectValue arena_value = WrapObject("a", kFooString).CloneToArena(arena);
+    copy.emplace(arena_value);
+  }
+  EXPECT_EQ(*Value(kFooString), *copy->Get(Field("a")));
+}
+
+TEST_F(ObjectValueTest, MutatingArenaCopyDoesNotAffectOtherCopies) {
+  auto arena = std::make_shared<nanopb::Arena>();
+  ObjectValue arena_value =
+      WrapObject("a", Map("b", kFooString), "c", kBarString)
+          .CloneToArena(arena);
+  ObjectValue set_copy{arena_value};
+  ObjectValue delete_copy{arena_value};
+
+  set_copy.Set(Field("a.b"), Value(kBarString));
+  delete_copy.Delete(Field("c"));
+
+  EXPECT_FALSE(set_copy.is_arena_backed());
+  EXPECT_FALSE(delete_copy.is_arena_backed());
+  EXPECT_EQ(WrapObject("a", Map("b", kFooString), "c", kBarString),
+            arena_value);
+  EXPECT_EQ(WrapObject("a", Map("b", kBarString), "c", kBarString), set_copy);
+  EXPECT_EQ(WrapObject("a", Map("b", kFooString)), delete_copy);
+}
+
+TEST_F(ObjectValueTest, FingerprintTracksModifications) {
+  ObjectValue object_value = WrapObject("a", Map("b", kFooString), "c", 1);
+  uint64_t original = object_value.Fingerprint();
+  EXPECT_EQ(WrapObject("c", 1, "a", Map("b", kFooString)).Fingerprint(),
+            original);
+
+  object_value.Set(Field("a.b"), Value(kBarString));
+  EXPECT_NE(object_value.Fingerprint(), original);
+  EXPECT_EQ(WrapObject("a", Map("b", kBarString), "c", 1).Fingerprint(),
+            object_value.Fingerprint());
+
+  object_value.Delete(Field("c"));
+  EXPECT_EQ(WrapObject("a", Map("b", kBarString)).Fingerprint(),
+            object_value.Fingerprint());
+
+  TransformMap data;
+  data.emplace(Field("a.b"), Value(kFooString));
+  data.emplace(Field("c"), Value(1));
+  object_value.SetAll(std::move(data));
+  EXPECT_EQ(object_value.Fingerprint(), original);
+}
+
+TEST_F(ObjectValueTest, CopiesKeepFingerprint) {
+  ObjectValue object_value = WrapObject("a", Map("b", kFooString));
+  uint64_t fingerprint = object_value.Fingerprint();
+
+  ObjectValue copy{object_value};
+  EXPECT_EQ(copy.Fingerprint(), fingerprint);
+  copy.Set(Field("a.b"), Value(kBarString));
+  EXPECT_NE(copy.Fingerprint(), fingerprint);
+  EXPECT_EQ(object_value.Fingerprint(), fingerprint);
+  EXPECT_NE(object_value, copy);
+
+  ObjectValue moved{std::move(object_value)};
+  EXPECT_EQ(moved.Fingerprint(), fingerprint);
+}
+
 }  // namespace
 
 }  // namespace model
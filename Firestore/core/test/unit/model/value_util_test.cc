@@ -112,6 +112,12 @@ class ValueUtilTest : public ::testing::Test {
             << CanonicalId(left->values[i]) << "' and '"
             << CanonicalId(right->values[j]) << "' (expected "
             << static_cast<int>(util::ReverseOrder(expected_result)) << ")";
+        if (expected_result == ComparisonResult::Same) {
+          EXPECT_EQ(Fingerprint(left->values[i]), Fingerprint(right->values[j]))
+              << "Fingerprint check failed for '"
+              << CanonicalId(left->values[i]) << "' and '"
+              << CanonicalId(right->values[j]) << "'";
+        }
       }
     }
   }
@@ -559,6 +565,27 @@ TEST_F(ValueUtilTest, CompareMaps) {
   EXPECT_EQ(model::Compare(*left_4, *right_4), ComparisonResult::Ascending);
 }
 
+TEST_F(ValueUtilTest, Fingerprint) {
+  // Values that compare the same have the same fingerprint, regardless of
+  // their representation.
+  EXPECT_EQ(Fingerprint(*Value(1)), Fingerprint(*Value(1.0)));
+  EXPECT_EQ(Fingerprint(*Value(0.0)), Fingerprint(*Value(-0.0)));
+  EXPECT_EQ(Fingerprint(*Value(std::nan("1"))),
+            Fingerprint(*Value(ToDouble(kAlternateNanBits))));
+  EXPECT_EQ(Fingerprint(*Map("a", 1, "b", Map("c", 2, "d", 3))),
+            Fingerprint(*Map("b", Map("d", 3, "c", 2.0), "a", 1)));
+
+  EXPECT_NE(Fingerprint(*Value(1)), Fingerprint(*Value(1.5)));
+  EXPECT_NE(Fingerprint(*Value(1)), Fingerprint(*Value(true)));
+  EXPECT_NE(Fingerprint(*Value("a")), Fingerprint(*Value(BlobValue('a'))));
+  EXPECT_NE(Fingerprint(*Value(Array(1, 2))),
+            Fingerprint(*Value(Array(2, 1))));
+  EXPECT_NE(Fingerprint(*Map("a", 1, "b", 2)),
+            Fingerprint(*Map("a", 2, "b", 1)));
+  EXPECT_NE(Fingerprint(*Map("a", Map("b", 1))),
+            Fingerprint(*Map("a", Map("b", 1, "c", 1))));
+}
+
 }  // namespace
 
 }  // namespace model
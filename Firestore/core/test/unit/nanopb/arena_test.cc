@@ -0,0 +1,105 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/nanopb/arena.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace nanopb {
+namespace {
+
+bool IsAligned(const void* pointer) {
+  return reinterpret_cast<uintptr_t>(pointer) % alignof(std::max_align_t) ==
+         0;
+}
+
+TEST(ArenaTest, StartsEmpty) {
+  Arena arena;
+  EXPECT_EQ(arena.capacity(), 0u);
+  EXPECT_EQ(arena.block_count(), 0u);
+}
+
+TEST(ArenaTest, AllocatesAlignedMemoryFromOneBlock) {
+  Arena arena;
+  void* first = arena.Allocate(3);
+  void* second = arena.Allocate(5);
+
+  EXPECT_TRUE(IsAligned(first));
+  EXPECT_TRUE(IsAligned(second));
+  EXPECT_EQ(static_cast<char*>(second) - static_cast<char*>(first),
+            static_cast<ptrdiff_t>(Arena::AllocationSize(3)));
+  EXPECT_EQ(arena.block_count(), 1u);
+  EXPECT_EQ(arena.capacity(), Arena::kDefaultBlockSize);
+}
+
+TEST(ArenaTest, AddsBlocksWhenFull) {
+  Arena arena{64};
+  for (int i = 0; i < 10; ++i) {
+    arena.Allocate(32);
+  }
+  EXPECT_EQ(arena.block_count(), 5u);
+}
+
+TEST(ArenaTest, ServesLargeAllocationsFromDedicatedBlocks) {
+  Arena arena{64};
+  arena.Allocate(1000);
+  EXPECT_EQ(arena.block_count(), 1u);
+  EXPECT_GE(arena.capacity(), 1000u);
+}
+
+TEST(ArenaTest, ReserveKeepsAllocationsInOneBlock) {
+  Arena arena{64};
+  arena.Allocate(16);
+  arena.Reserve(Arena::AllocationSize(100) * 3);
+  size_t blocks = arena.block_count();
+
+  arena.Allocate(100);
+  arena.Allocate(100);
+  arena.Allocate(100);
+  EXPECT_EQ(arena.block_count(), blocks);
+}
+
+TEST(ArenaTest, MakesZeroedArrays) {
+  Arena arena;
+  EXPECT_EQ(arena.MakeArray<int64_t>(0), nullptr);
+
+  int64_t* values = arena.MakeArray<int64_t>(4);
+  ASSERT_NE(values, nullptr);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(values[i], 0);
+  }
+}
+
+TEST(ArenaTest, MakesNullTerminatedBytesArrays) {
+  Arena arena;
+  EXPECT_EQ(arena.MakeBytesArray("", 0), nullptr);
+
+  pb_bytes_array_t* bytes = arena.MakeBytesArray("hello", 5);
+  ASSERT_NE(bytes, nullptr);
+  EXPECT_EQ(bytes->size, 5u);
+  EXPECT_EQ(std::strcmp(reinterpret_cast<const char*>(bytes->bytes), "hello"),
+            0);
+}
+
+}  // namespace
+}  // namespace nanopb
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,136 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/test/unit/remote/fake_write_stream.h"
+
+#include <utility>
+
+#include "Firestore/core/src/nanopb/message.h"
+#include "Firestore/core/src/util/hard_assert.h"
+#include "Firestore/core/src/util/status.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+using credentials::AppCheckCredentialsProvider;
+using credentials::AuthCredentialsProvider;
+using model::Mutation;
+using model::MutationResult;
+using model::SnapshotVersion;
+using util::AsyncQueue;
+using util::Status;
+
+FakeWriteStream::FakeWriteStream(
+    const std::shared_ptr<AsyncQueue>& worker_queue,
+    std::shared_ptr<AuthCredentialsProvider> auth_credentials_provider,
+    std::shared_ptr<AppCheckCredentialsProvider> app_check_credentials_provider,
+    Serializer serializer,
+    GrpcConnection* grpc_connection,
+    WriteStreamCallback* callback)
+    : WriteStream(worker_queue,
+                  std::move(auth_credentials_provider),
+                  std::move(app_check_credentials_provider),
+                  std::move(serializer),
+                  grpc_connection,
+                  callback),
+      callback_(callback) {
+}
+
+void FakeWriteStream::Start() {
+  HARD_ASSERT(!started_, "Write stream already started");
+  started_ = true;
+  callback_->OnWriteStreamOpen();
+}
+
+void FakeWriteStream::Stop() {
+  started_ = false;
+  SetHandshakeComplete(false);
+  next_request_ = requests_.size();
+}
+
+bool FakeWriteStream::IsStarted() const {
+  return started_;
+}
+
+bool FakeWriteStream::IsOpen() const {
+  return started_;
+}
+
+void FakeWriteStream::WriteHandshake() {
+  SetHandshakeComplete();
+  callback_->OnWriteStreamHandshakeComplete();
+}
+
+void FakeWriteStream::WriteMutations(const std::vector<Mutation>& mutations) {
+  HARD_ASSERT(started_ && handshake_complete(),
+              "Mutations written before the handshake completed");
+  requests_.push_back(mutations);
+}
+
+void FakeWriteStream::AckNextRequest(const SnapshotVersion& commit_version) {
+  HARD_ASSERT(pending_requests() > 0, "No write request to acknowledge");
+  const std::vector<Mutation>& request = requests_[next_request_++];
+
+  std::vector<MutationResult> results;
+  for (size_t i = 0; i < request.size(); ++i) {
+    results.emplace_back(commit_version,
+                         nanopb::Message<google_firestore_v1_ArrayValue>{});
+  }
+  callback_->OnWriteStreamMutationResult(commit_version, std::move(results));
+}
+
+void FakeWriteStream::FailStream(const Status& status) {
+  HARD_ASSERT(started_, "Write stream not started");
+  started_ = false;
+  next_request_ = requests_.size();
+  callback_->OnWriteStreamClose(status);
+
+  // The callback may already have restarted the stream.
+  if (!started_) {
+    SetHandshakeComplete(false);
+  }
+}
+
+FakeWriteStreamDatastore::FakeWriteStreamDatastore(
+    const core::DatabaseInfo& database_info,
+    const std::shared_ptr<AsyncQueue>& worker_queue,
+    std::shared_ptr<AuthCredentialsProvider> auth_credentials,
+    std::shared_ptr<AppCheckCredentialsProvider> app_check_credentials,
+    ConnectivityMonitor* connectivity_monitor,
+    FirebaseMetadataProvider* firebase_metadata_provider)
+    : Datastore(database_info,
+                worker_queue,
+                auth_credentials,
+                app_check_credentials,
+                connectivity_monitor,
+                firebase_metadata_provider),
+      worker_queue_(worker_queue),
+      auth_credentials_(std::move(auth_credentials)),
+      app_check_credentials_(std::move(app_check_credentials)) {
+}
+
+std::shared_ptr<WriteStream> FakeWriteStreamDatastore::CreateWriteStream(
+    WriteStreamCallback* callback) {
+  write_stream_ = std::make_shared<FakeWriteStream>(
+      worker_queue_, auth_credentials_, app_check_credentials_,
+      Serializer(database_info().database_id()), grpc_connection(), callback);
+  return write_stream_;
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_TEST_UNIT_REMOTE_FAKE_WRITE_STREAM_H_
+#define FIRESTORE_CORE_TEST_UNIT_REMOTE_FAKE_WRITE_STREAM_H_
+
+#include <memory>
+#include <vector>
+
+#include "Firestore/core/src/model/mutation.h"
+#include "Firestore/core/src/model/snapshot_version.h"
+#include "Firestore/core/src/remote/datastore.h"
+#include "Firestore/core/src/remote/write_stream.h"
+#include "Firestore/core/src/util/status_fwd.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+/**
+ * A `WriteStream` that never talks to the backend. Starting the stream opens
+ * it and completes the handshake synchronously; write requests are recorded
+ * and only answered when the test calls `AckNextRequest` or `FailStream`.
+ */
+class FakeWriteStream : public WriteStream {
+ public:
+  FakeWriteStream(const std::shared_ptr<util::AsyncQueue>& worker_queue,
+                  std::shared_ptr<credentials::AuthCredentialsProvider>
+                      auth_credentials_provider,
+                  std::shared_ptr<credentials::AppCheckCredentialsProvider>
+                      app_check_credentials_provider,
+                  Serializer serializer,
+                  GrpcConnection* grpc_connection,
+                  WriteStreamCallback* callback);
+
+  void Start() override;
+  void Stop() override;
+  bool IsStarted() const override;
+  bool IsOpen() const override;
+
+  void WriteHandshake() override;
+  void WriteMutations(const std::vector<model::Mutation>& mutations) override;
+
+  /** All write requests sent on this stream, across restarts. */
+  const std::vector<std::vector<model::Mutation>>& requests() const {
+    return requests_;
+  }
+
+  /** The number of write requests that haven't been answered yet. */
+  size_t pending_requests() const {
+    return requests_.size() - next_request_;
+  }
+
+  /**
+   * Acknowledges the oldest unanswered write request, with one result per
+   * mutation in the request.
+   */
+  void AckNextRequest(const model::SnapshotVersion& commit_version);
+
+  /**
+   * Closes the stream with the given error. Requests that haven't been
+   * answered are dropped, as they would be by the backend.
+   */
+  void FailStream(const util::Status& status);
+
+ private:
+  WriteStreamCallback* callback_ = nullptr;
+  bool started_ = false;
+  std::vector<std::vector<model::Mutation>> requests_;
+  size_t next_request_ = 0;
+};
+
+/** A `Datastore` whose write streams are `FakeWriteStream`s. */
+class FakeWriteStreamDatastore : public Datastore {
+ public:
+  FakeWriteStreamDatastore(
+      const core::DatabaseInfo& database_info,
+      const std::shared_ptr<util::AsyncQueue>& worker_queue,
+      std::shared_ptr<credentials::AuthCredentialsProvider> auth_credentials,
+      std::shared_ptr<credentials::AppCheckCredentialsProvider>
+          app_check_credentials,
+      ConnectivityMonitor* connectivity_monitor,
+      FirebaseMetadataProvider* firebase_metadata_provider);
+
+  std::shared_ptr<WriteStream> CreateWriteStream(
+      WriteStreamCallback* callback) override;
+
+  /** The most recently created write stream. */
+  FakeWriteStream* write_stream() {
+    return write_stream_.get();
+  }
+
+ private:
+  std::shared_ptr<util::AsyncQueue> worker_queue_;
+  std::shared_ptr<credentials::AuthCredentialsProvider> auth_credentials_;
+  std::shared_ptr<credentials::AppCheckCredentialsProvider>
+      app_check_credentials_;
+  std::shared_ptr<FakeWriteStream> write_stream_;
+};
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_TEST_UNIT_REMOTE_FAKE_WRITE_STREAM_H_
@@ -0,0 +1,182 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "Firestore/Protos/nanopb/google/firestore/v1/firestore.nanopb.h"
+#include "Firestore/core/src/model/object_value.h"
+#include "Firestore/core/src/nanopb/byte_string.h"
+#include "Firestore/core/src/nanopb/message.h"
+#include "Firestore/core/src/nanopb/reader.h"
+#include "Firestore/core/src/nanopb/writer.h"
+#include "Firestore/core/src/remote/grpc_nanopb.h"
+#include "Firestore/core/src/remote/serializer.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "benchmark/benchmark.h"
+#include "grpcpp/support/byte_buffer.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+namespace {
+
+using model::ObjectValue;
+using nanopb::ByteStringWriter;
+using nanopb::Message;
+using nanopb::StringReader;
+using testutil::Field;
+using testutil::Map;
+
+// gRPC typically hands over received messages in slices of this size.
+const size_t kSliceSize = 16 * 1024;
+
+/**
+ * Returns a `ListenResponse` with a document change for a document of about
+ * `size` bytes.
+ */
+Message<google_firestore_v1_ListenResponse> MakeListenResponse(int64_t size) {
+  ObjectValue data;
+  const std::string text(100, 'x');
+  for (int64_t i = 0; i * 128 < size; ++i) {
+    data.Set(Field("field" + std::to_string(i)),
+             Map("text", text, "count", i));
+  }
+
+  Serializer serializer{testutil::DbId()};
+  Message<google_firestore_v1_ListenResponse> response;
+  response->which_response_type =
+      google_firestore_v1_ListenResponse_document_change_tag;
+  response->document_change.document =
+      serializer.EncodeDocument(testutil::Key("coll/doc"), data);
+  return response;
+}
+
+/**
+ * Encodes a `ListenResponse` with a document change for a document of about
+ * `size` bytes, split into slices as if received from the network.
+ */
+grpc::ByteBuffer MakeDocumentChange(int64_t size) {
+  std::vector<grpc::Slice> encoded;
+  MakeByteBuffer(MakeListenResponse(size)).Dump(&encoded);
+  std::string bytes;
+  for (const grpc::Slice& slice : encoded) {
+    bytes.append(reinterpret_cast<const char*>(slice.begin()), slice.size());
+  }
+
+  std::vector<grpc::Slice> slices;
+  for (size_t i = 0; i < bytes.size(); i += kSliceSize) {
+    slices.emplace_back(bytes.data() + i,
+                        std::min(kSliceSize, bytes.size() - i));
+  }
+  return grpc::ByteBuffer{slices.data(), slices.size()};
+}
+
+void BM_DecodeFromSlices(benchmark::State& state) {
+  grpc::ByteBuffer buffer = MakeDocumentChange(state.range(0));
+  for (auto _ : state) {
+    ByteBufferReader reader{buffer};
+    auto response =
+        Message<google_firestore_v1_ListenResponse>::TryParse(&reader);
+    benchmark::DoNotOptimize(response);
+  }
+  state.SetBytesProcessed(state.iterations() * buffer.Length());
+}
+BENCHMARK(BM_DecodeFromSlices)->Range(1 << 20, 16 << 20);
+
+/** Decodes after copying the slices into a contiguous buffer first. */
+void BM_DecodeFromCopy(benchmark::State& state) {
+  grpc::ByteBuffer buffer = MakeDocumentChange(state.range(0));
+  for (auto _ : state) {
+    std::vector<grpc::Slice> slices;
+    buffer.Dump(&slices);
+    ByteStringWriter writer;
+    writer.Reserve(buffer.Length());
+    for (const grpc::Slice& slice : slices) {
+      writer.Append(slice.begin(), slice.size());
+    }
+    nanopb::ByteString bytes = writer.Release();
+
+    StringReader reader{bytes};
+    auto response =
+        Message<google_firestore_v1_ListenResponse>::TryParse(&reader);
+    benchmark::DoNotOptimize(response);
+  }
+  state.SetBytesProcessed(state.iterations() * buffer.Length());
+}
+BENCHMARK(BM_DecodeFromCopy)->Range(1 << 20, 16 << 20);
+
+/**
+ * Encodes into a new slice for every chunk nanopb emits, the way
+ * `ByteBufferWriter` used to.
+ */
+class SlicePerWriteWriter : public nanopb::Writer {
+ public:
+  SlicePerWriteWriter() {
+    stream_.callback = Append;
+    stream_.state = &slices_;
+    stream_.max_size = SIZE_MAX;
+  }
+
+  grpc::ByteBuffer Release() {
+    grpc::ByteBuffer result{slices_.data(), slices_.size()};
+    slices_.clear();
+    return result;
+  }
+
+ private:
+  static bool Append(pb_ostream_t* stream,
+                     const pb_byte_t* buf,
+                     size_t count) {
+    auto slices = static_cast<std::vector<grpc::Slice>*>(stream->state);
+    slices->emplace_back(buf, count);
+    return true;
+  }
+
+  std::vector<grpc::Slice> slices_;
+};
+
+void BM_EncodeIntoPresizedSlice(benchmark::State& state) {
+  auto response = MakeListenResponse(state.range(0));
+  size_t size = 0;
+  for (auto _ : state) {
+    grpc::ByteBuffer buffer = MakeByteBuffer(response);
+    size = buffer.Length();
+    benchmark::DoNotOptimize(buffer);
+  }
+  state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_EncodeIntoPresizedSlice)->Range(1 << 10, 16 << 20);
+
+void BM_EncodeIntoSlicePerWrite(benchmark::State& state) {
+  auto response = MakeListenResponse(state.range(0));
+  size_t size = 0;
+  for (auto _ : state) {
+    SlicePerWriteWriter writer;
+    writer.Write(response.fields(), response.get());
+    grpc::ByteBuffer buffer = writer.Release();
+    size = buffer.Length();
+    benchmark::DoNotOptimize(buffer);
+  }
+  state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_EncodeIntoSlicePerWrite)->Range(1 << 10, 16 << 20);
+
+}  // namespace
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/remote/grpc_nanopb.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "Firestore/Protos/nanopb/google/firestore/v1/firestore.nanopb.h"
+#include "Firestore/core/src/nanopb/message.h"
+#include "Firestore/core/src/nanopb/nanopb_util.h"
+#include "Firestore/core/test/unit/testutil/status_testing.h"
+#include "grpcpp/support/byte_buffer.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+namespace {
+
+using nanopb::MakeBytesArray;
+using nanopb::MakeStringView;
+using nanopb::Message;
+
+using Proto = google_firestore_v1_WriteResponse;
+
+const char kStreamId[] = "stream_id";
+
+grpc::ByteBuffer Encode(const std::string& stream_token) {
+  Message<Proto> message;
+  message->stream_id = MakeBytesArray(kStreamId);
+  message->stream_token = MakeBytesArray(stream_token);
+  return MakeByteBuffer(message);
+}
+
+/** Returns the contents of `buffer` split into slices of `slice_size`. */
+grpc::ByteBuffer Resplice(const grpc::ByteBuffer& buffer, size_t slice_size) {
+  std::vector<grpc::Slice> slices;
+  EXPECT_TRUE(buffer.Dump(&slices).ok());
+  std::string bytes;
+  for (const grpc::Slice& slice : slices) {
+    bytes.append(reinterpret_cast<const char*>(slice.begin()), slice.size());
+  }
+
+  std::vector<grpc::Slice> result;
+  for (size_t i = 0; i < bytes.size(); i += slice_size) {
+    size_t size = std::min(slice_size, bytes.size() - i);
+    result.emplace_back(bytes.data() + i, size);
+  }
+  return grpc::ByteBuffer{result.data(), result.size()};
+}
+
+void ExpectDecodes(const grpc::ByteBuffer& buffer,
+                   const std::string& stream_token) {
+  ByteBufferReader reader{buffer};
+  auto message = Message<Proto>::TryParse(&reader);
+  ASSERT_OK(reader.status());
+  EXPECT_EQ(MakeStringView(message->stream_id), kStreamId);
+  EXPECT_EQ(MakeStringView(message->stream_token), stream_token);
+}
+
+TEST(ByteBufferWriterTest, EncodesIntoSingleSlice) {
+  std::string token(100000, 'a');
+  grpc::ByteBuffer buffer = Encode(token);
+
+  std::vector<grpc::Slice> slices;
+  ASSERT_TRUE(buffer.Dump(&slices).ok());
+  EXPECT_EQ(slices.size(), 1u);
+  ExpectDecodes(buffer, token);
+}
+
+TEST(ByteBufferWriterTest, EncodesEmptyMessage) {
+  Message<Proto> message;
+  grpc::ByteBuffer buffer = MakeByteBuffer(message);
+  EXPECT_EQ(buffer.Length(), 0u);
+}
+
+TEST(ByteBufferReaderTest, DecodesSingleSlice) {
+  std::string token(1000, 'a');
+  ExpectDecodes(Resplice(Encode(token), 1 << 20), token);
+}
+
+TEST(ByteBufferReaderTest, DecodesAcrossSlices) {
+  std::string token(1000, 'a');
+  grpc::ByteBuffer buffer = Encode(token);
+  for (size_t slice_size : {1, 3, 7, 64, 999}) {
+    ExpectDecodes(Resplice(buffer, slice_size), token);
+  }
+}
+
+TEST(ByteBufferReaderTest, DecodesEmptyBuffer) {
+  grpc::ByteBuffer buffer{nullptr, 0};
+  ByteBufferReader reader{buffer};
+  auto message = Message<Proto>::TryParse(&reader);
+  ASSERT_OK(reader.status());
+  EXPECT_EQ(message->stream_id, nullptr);
+}
+
+TEST(ByteBufferReaderTest, FailsOnTruncatedInput) {
+  grpc::ByteBuffer full = Resplice(Encode(std::string(100, 'a')), 16);
+  std::vector<grpc::Slice> slices;
+  ASSERT_TRUE(full.Dump(&slices).ok());
+  slices.pop_back();
+  grpc::ByteBuffer truncated{slices.data(), slices.size()};
+
+  ByteBufferReader reader{truncated};
+  auto message = Message<Proto>::TryParse(&reader);
+  EXPECT_NOT_OK(reader.status());
+}
+
+}  // namespace
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
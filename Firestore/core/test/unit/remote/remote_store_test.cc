@@ -0,0 +1,278 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/remote/remote_store.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/include/firebase/firestore/firestore_errors.h"
+#include "Firestore/core/src/core/database_info.h"
+#include "Firestore/core/src/credentials/empty_credentials_provider.h"
+#include "Firestore/core/src/credentials/user.h"
+#include "Firestore/core/src/local/local_store.h"
+#include "Firestore/core/src/local/local_write_result.h"
+#include "Firestore/core/src/local/memory_persistence.h"
+#include "Firestore/core/src/local/query_engine.h"
+#include "Firestore/core/src/model/database_id.h"
+#include "Firestore/core/src/model/mutation_batch_result.h"
+#include "Firestore/core/src/model/set_mutation.h"
+#include "Firestore/core/src/remote/firebase_metadata_provider.h"
+#include "Firestore/core/src/remote/firebase_metadata_provider_noop.h"
+#include "Firestore/core/src/util/async_queue.h"
+#include "Firestore/core/src/util/status.h"
+#include "Firestore/core/test/unit/remote/create_noop_connectivity_monitor.h"
+#include "Firestore/core/test/unit/remote/fake_write_stream.h"
+#include "Firestore/core/test/unit/testutil/async_testing.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "absl/memory/memory.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+namespace {
+
+using core::DatabaseInfo;
+using credentials::EmptyAppCheckCredentialsProvider;
+using credentials::EmptyAuthCredentialsProvider;
+using credentials::User;
+using local::LocalStore;
+using local::MemoryPersistence;
+using local::QueryEngine;
+using model::BatchId;
+using model::DatabaseId;
+using model::DocumentKeySet;
+using model::Mutation;
+using model::MutationBatchResult;
+using model::OnlineState;
+using model::TargetId;
+using testing::ElementsAre;
+using testing::IsEmpty;
+using testutil::Map;
+using testutil::Version;
+using util::AsyncQueue;
+using util::Status;
+
+/**
+ * Applies acknowledged and rejected writes to the `LocalStore`, the way the
+ * `SyncEngine` does, and records their batch IDs.
+ */
+class FakeRemoteStoreCallback : public RemoteStoreCallback {
+ public:
+  explicit FakeRemoteStoreCallback(LocalStore* local_store)
+      : local_store_(local_store) {
+  }
+
+  void ApplyRemoteEvent(const RemoteEvent&) override {
+  }
+  void HandleRejectedListen(TargetId, Status) override {
+  }
+  void HandleSuccessfulWrite(MutationBatchResult batch_result) override {
+    acknowledged.push_back(batch_result.batch().batch_id());
+    local_store_->AcknowledgeBatch(batch_result);
+  }
+  void HandleRejectedWrite(BatchId batch_id, Status) override {
+    rejected.push_back(batch_id);
+    local_store_->RejectBatch(batch_id);
+  }
+  void HandleOnlineStateChange(OnlineState) override {
+  }
+  DocumentKeySet GetRemoteKeys(TargetId) const override {
+    return DocumentKeySet{};
+  }
+
+  std::vector<BatchId> acknowledged;
+  std::vector<BatchId> rejected;
+
+ private:
+  LocalStore* local_store_ = nullptr;
+};
+
+std::vector<size_t> RequestSizes(const FakeWriteStream& stream) {
+  std::vector<size_t> result;
+  for (const std::vector<Mutation>& request : stream.requests()) {
+    result.push_back(request.size());
+  }
+  return result;
+}
+
+}  // namespace
+
+class RemoteStoreTest : public testing::Test {
+ public:
+  RemoteStoreTest()
+      : worker_queue_(testutil::AsyncQueueForTesting()),
+        persistence_(MemoryPersistence::WithEagerGarbageCollector()),
+        local_store_(
+            persistence_.get(), &query_engine_, User::Unauthenticated()),
+        connectivity_monitor_(CreateNoOpConnectivityMonitor()),
+        firebase_metadata_provider_(CreateFirebaseMetadataProviderNoOp()),
+        callback_(&local_store_) {
+    worker_queue_->EnqueueBlocking([&] {
+      local_store_.Start();
+
+      datastore_ = std::make_shared<FakeWriteStreamDatastore>(
+          DatabaseInfo{DatabaseId{"p", "d"}, "", "localhost", false},
+          worker_queue_, std::make_shared<EmptyAuthCredentialsProvider>(),
+          std::make_shared<EmptyAppCheckCredentialsProvider>(),
+          connectivity_monitor_.get(), firebase_metadata_provider_.get());
+      remote_store_ = absl::make_unique<RemoteStore>(
+          &local_store_, datastore_, worker_queue_,
+          connectivity_monitor_.get(), [](OnlineState) {});
+      remote_store_->set_sync_engine(&callback_);
+      remote_store_->Start();
+    });
+  }
+
+  ~RemoteStoreTest() override {
+    worker_queue_->EnqueueBlocking([&] {
+      remote_store_->Shutdown();
+      remote_store_.reset();
+    });
+  }
+
+ protected:
+  void EnableWriteCoalescing() {
+    worker_queue_->EnqueueBlocking(
+        [&] { remote_store_->set_write_coalescing_enabled(true); });
+  }
+
+  /**
+   * Writes `count` batches of `mutations_per_batch` mutations each and then
+   * fills the write pipeline once.
+   */
+  void WriteBatches(int count, int mutations_per_batch = 1) {
+    worker_queue_->EnqueueBlocking([&] {
+      for (int i = 0; i < count; ++i) {
+        std::vector<Mutation> mutations;
+        for (int j = 0; j < mutations_per_batch; ++j) {
+          mutations.push_back(testutil::SetMutation(
+              "coll/doc" + std::to_string(i) + "_" + std::to_string(j),
+              Map("batch", i)));
+        }
+        local_store_.WriteLocally(std::move(mutations));
+      }
+      remote_store_->FillWritePipeline();
+    });
+  }
+
+  void AckNextRequest() {
+    worker_queue_->EnqueueBlocking(
+        [&] { write_stream().AckNextRequest(Version(++commit_version_)); });
+  }
+
+  void FailStream(const Status& status) {
+    worker_queue_->EnqueueBlocking([&] { write_stream().FailStream(status); });
+  }
+
+  FakeWriteStream& write_stream() {
+    return *datastore_->write_stream();
+  }
+
+  std::shared_ptr<AsyncQueue> worker_queue_;
+  std::unique_ptr<MemoryPersistence> persistence_;
+  QueryEngine query_engine_;
+  LocalStore local_store_;
+  std::unique_ptr<ConnectivityMonitor> connectivity_monitor_;
+  std::unique_ptr<FirebaseMetadataProvider> firebase_metadata_provider_;
+  FakeRemoteStoreCallback callback_;
+  std::shared_ptr<FakeWriteStreamDatastore> datastore_;
+  std::unique_ptr<RemoteStore> remote_store_;
+  int64_t commit_version_ = 0;
+};
+
+TEST_F(RemoteStoreTest, SendsOneRequestPerBatchByDefault) {
+  WriteBatches(3);
+  EXPECT_THAT(RequestSizes(write_stream()), ElementsAre(1, 1, 1));
+
+  AckNextRequest();
+  AckNextRequest();
+  AckNextRequest();
+  EXPECT_THAT(callback_.acknowledged, ElementsAre(1, 2, 3));
+}
+
+TEST_F(RemoteStoreTest, CoalescesBatchesIntoOneRequest) {
+  EnableWriteCoalescing();
+  WriteBatches(3);
+  EXPECT_THAT(RequestSizes(write_stream()), ElementsAre(3));
+
+  AckNextRequest();
+  EXPECT_THAT(callback_.acknowledged, ElementsAre(1, 2, 3));
+  EXPECT_EQ(local_store_.GetHighestUnacknowledgedBatchId(),
+            model::kBatchIdUnknown);
+}
+
+TEST_F(RemoteStoreTest, CoalescesBatchesWrittenWhileStreamIsOpen) {
+  EnableWriteCoalescing();
+  WriteBatches(1);
+  WriteBatches(2);
+  WriteBatches(2, 2);
+  EXPECT_THAT(RequestSizes(write_stream()), ElementsAre(1, 2, 4));
+
+  AckNextRequest();
+  AckNextRequest();
+  EXPECT_THAT(callback_.acknowledged, ElementsAre(1, 2, 3));
+
+  AckNextRequest();
+  EXPECT_THAT(callback_.acknowledged, ElementsAre(1, 2, 3, 4, 5));
+}
+
+TEST_F(RemoteStoreTest, LimitsMutationsPerCoalescedRequest) {
+  EnableWriteCoalescing();
+  WriteBatches(3, 200);
+  EXPECT_THAT(RequestSizes(write_stream()), ElementsAre(400, 200));
+}
+
+TEST_F(RemoteStoreTest, ResendsCoalescedRequestAfterTransientError) {
+  EnableWriteCoalescing();
+  WriteBatches(2);
+  FailStream(Status{Error::kErrorUnavailable, "Unavailable"});
+  EXPECT_THAT(RequestSizes(write_stream()), ElementsAre(2, 2));
+
+  AckNextRequest();
+  EXPECT_THAT(callback_.acknowledged, ElementsAre(1, 2));
+  EXPECT_THAT(callback_.rejected, IsEmpty());
+}
+
+TEST_F(RemoteStoreTest, RejectsOnlyTheOffendingBatchOfACoalescedRequest) {
+  EnableWriteCoalescing();
+  WriteBatches(3);
+  EXPECT_THAT(RequestSizes(write_stream()), ElementsAre(3));
+
+  // The coalesced request is split up into one request per batch.
+  FailStream(Status{Error::kErrorInvalidArgument, "Invalid"});
+  EXPECT_THAT(callback_.rejected, IsEmpty());
+  EXPECT_THAT(RequestSizes(write_stream()), ElementsAre(3, 1, 1, 1));
+
+  FailStream(Status{Error::kErrorInvalidArgument, "Invalid"});
+  EXPECT_THAT(callback_.rejected, ElementsAre(1));
+
+  AckNextRequest();
+  AckNextRequest();
+  EXPECT_THAT(callback_.acknowledged, ElementsAre(2, 3));
+
+  // Batches written after the rejection are coalesced again.
+  WriteBatches(2);
+  EXPECT_THAT(RequestSizes(write_stream()), ElementsAre(3, 1, 1, 1, 1, 1, 2));
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/util/lru_cache.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+TEST(LruCacheTest, GetReturnsStoredValues) {
+  LruCache<std::string, int> cache(2);
+  EXPECT_EQ(cache.Get("a"), nullptr);
+
+  cache.Put("a", 1);
+  ASSERT_NE(cache.Get("a"), nullptr);
+  EXPECT_EQ(*cache.Get("a"), 1);
+
+  cache.Put("a", 2);
+  EXPECT_EQ(*cache.Get("a"), 2);
+  EXPECT_EQ(cache.size(), 1u);
+}
+
+TEST(LruCacheTest, EvictsLeastRecentlyUsedEntry) {
+  LruCache<std::string, int> cache(2);
+  cache.Put("a", 1);
+  cache.Put("b", 2);
+
+  // Reading "a" makes "b" the least recently used entry.
+  cache.Get("a");
+  cache.Put("c", 3);
+
+  EXPECT_EQ(cache.size(), 2u);
+  EXPECT_NE(cache.Get("a"), nullptr);
+  EXPECT_EQ(cache.Get("b"), nullptr);
+  EXPECT_NE(cache.Get("c"), nullptr);
+}
+
+TEST(LruCacheTest, ReplacingAnEntryMarksItAsUsed) {
+  LruCache<std::string, int> cache(2);
+  cache.Put("a", 1);
+  cache.Put("b", 2);
+  cache.Put("a", 3);
+  cache.Put("c", 4);
+
+  EXPECT_EQ(*cache.Get("a"), 3);
+  EXPECT_EQ(cache.Get("b"), nullptr);
+}
+
+TEST(LruCacheTest, ErasesEntries) {
+  LruCache<std::string, int> cache(3);
+  cache.Put("a", 1);
+  cache.Put("b", 2);
+  cache.Put("c", 3);
+
+  cache.Erase("b");
+  cache.Erase("missing");
+  EXPECT_EQ(cache.Get("b"), nullptr);
+  EXPECT_EQ(cache.size(), 2u);
+
+  cache.EraseIf([](const std::string&, int value) { return value == 3; });
+  EXPECT_EQ(cache.Get("c"), nullptr);
+  EXPECT_EQ(cache.size(), 1u);
+
+  cache.Clear();
+  EXPECT_EQ(cache.size(), 0u);
+  EXPECT_EQ(cache.Get("a"), nullptr);
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase